@@ -6,6 +6,9 @@ IPlugConvoEngine::IPlugConvoEngine(const InstanceInfo& info)
 {
   GetParam(kParamDry)->InitDouble("Dry", 0., 0., 1., 0.001);
   GetParam(kParamWet)->InitDouble("Wet", 1., 0., 1., 0.001);
+
+  // The tail is set to the length of the IR in OnReset(), so processing can stop once the reverb has decayed
+  SetSilenceSkipping(true);
 }
 
 #if IPLUG_DSP
@@ -50,26 +53,43 @@ void IPlugConvoEngine::OnReset()
 
     static constexpr int irLength = sizeof(mIR) / sizeof(mIR[0]);
     static constexpr double irSampleRate = 44100.;
-    mImpulse.SetNumChannels(1);
+    static const uint64_t irHash = SharedImpulseStore::Hash(mIR, sizeof(mIR));
+
+    // Only the first instance at this sample rate resamples and transforms the IR, the rest share its partitions
+    SharedImpulseStore::EntryPtr pImpulse = SharedImpulseStore::Get().Acquire(irHash, mSampleRate, -1, [&](WDL_ImpulseBuffer& impulse) {
+      impulse.SetNumChannels(1);
 
 #if defined USE_WDL_RESAMPLER
-    mResampler.SetMode(false, 0, true); // Sinc, default size
-    mResampler.SetFeedMode(true); // Input driven
+      mResampler.SetMode(false, 0, true); // Sinc, default size
+      mResampler.SetFeedMode(true); // Input driven
 #elif defined USE_R8BRAIN
-    mResampler = std::make_unique<CDSPResampler16IR>(irSampleRate, mSampleRate, mBlockLength);
+      mResampler = std::make_unique<CDSPResampler16IR>(irSampleRate, mSampleRate, mBlockLength);
 #endif
 
-    // Resample the impulse response.
-    auto len = mImpulse.SetLength(ResampleLength(irLength, irSampleRate, mSampleRate));
-    if (len)
+      // Resample the impulse response.
+      auto len = impulse.SetLength(ResampleLength(irLength, irSampleRate, mSampleRate));
+      if (len)
+      {
+        Resample(mIR, irLength, irSampleRate, impulse.impulses[0].Get(), len, mSampleRate);
+      }
+    });
+
+    // Tie the impulse response to the convolution engine, before the previous entry is released, since the engine points to its partitions
+    if (pImpulse)
     {
-      Resample(mIR, irLength, irSampleRate, mImpulse.impulses[0].Get(), len, mSampleRate);
+      mEngine.SetImpulseShared(pImpulse->GetEngine());
+      SetLatency(pImpulse->GetLatency());
+      SetTailSize(ResampleLength(irLength, irSampleRate, mSampleRate));
     }
-    
-    // Tie the impulse response to the convolution engine.
-    mEngine.SetImpulse(&mImpulse);
-    
-    SetLatency(mEngine.GetLatency());
+    else
+    {
+      WDL_ImpulseBuffer empty;
+      mEngine.SetImpulse(&empty);
+      SetLatency(0);
+      SetTailSize(0);
+    }
+
+    mSharedImpulse = pImpulse;
   }
 }
 
@@ -10,6 +10,7 @@
 #endif
 
 #include "convoengine.h"
+#include "SharedImpulseStore.h"
 
 #if defined USE_WDL_RESAMPLER
   #include "resample.h"
@@ -48,8 +49,8 @@ private:
   
   static const float mIR[512];
 
-  WDL_ImpulseBuffer mImpulse;
-//  WDL_ConvolutionEngine_Div mEngine; // < low latency version
+  // The resampled, FFT'd IR is shared by all instances running at the same sample rate
+  SharedImpulseStore::EntryPtr mSharedImpulse;
   WDL_ConvolutionEngine mEngine;
   
   static constexpr int mBlockLength = 64;
@@ -116,10 +116,12 @@ public:
 #pragma mark -
   IPlugInstrumentDSP(int nVoices)
   {
+    mSynth.ReserveVoices(nVoices);
+
     for (auto i = 0; i < nVoices; i++)
     {
-      // add a voice to Zone 0.
-      mSynth.AddVoice(new Voice(), 0);
+      // add a voice to Zone 0, stored in the synth
+      mSynth.EmplaceVoice(0);
     }
 
     // some MidiSynth API examples:
@@ -185,8 +187,8 @@ public:
       case kParamRelease:
       {
         EEnvStage stage = static_cast<EEnvStage>(EEnvStage::kAttack + (paramIdx - kParamAttack));
-        mSynth.ForEachVoice([stage, value](SynthVoice& voice) {
-          dynamic_cast<IPlugInstrumentDSP::Voice&>(voice).mAMPEnv.SetStageTime(stage, value);
+        mSynth.ForEachVoice([stage, value](Voice& voice) {
+          voice.mAMPEnv.SetStageTime(stage, value);
         });
         break;
       }
@@ -211,7 +213,7 @@ public:
   }
   
 public:
-  MidiSynth mSynth { VoiceAllocator::kPolyModePoly, MidiSynth::kDefaultBlockSize };
+  MidiSynthT<Voice> mSynth { VoiceAllocator::kPolyModePoly, MidiSynth::kDefaultBlockSize };
   WDL_TypedBuf<T> mModulationsData; // Sample data for global modulations (e.g. smoothed sustain)
   WDL_PtrList<T> mModulations; // Ptrlist for global modulations
   LogParamSmooth<T, kNumModulations> mParamSmoother;
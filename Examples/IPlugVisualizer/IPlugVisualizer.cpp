@@ -9,6 +9,10 @@ IPlugVisualizer::IPlugVisualizer(const InstanceInfo& info)
 {
   GetParam(kOctaveGain)->InitDouble("OctaveGain", 0.0, 0., 12.0, 0.1, "dB");
   
+#if IPLUG_DSP
+  mProducer.Subscribe(kCtrlTagSpectrumAnalyzer);
+#endif
+  
 #if IPLUG_EDITOR // http://bit.ly/2S64BDd
   mMakeGraphicsFunc = [&]() {
     return MakeGraphics(*this, PLUG_WIDTH, PLUG_HEIGHT, PLUG_FPS, GetScaleForScreen(PLUG_WIDTH, PLUG_HEIGHT));
@@ -46,7 +50,7 @@ bool IPlugVisualizer::OnMessage(int msgTag, int ctrlTag, int dataSize, const voi
   if (msgTag == IVSpectrumAnalyzerControl<>::kMsgTagFFTSize)
   {
     int fftSize = *reinterpret_cast<const int*>(pData);
-    mSender.SetFFTSize(fftSize);
+    mProducer.SetFFTSize(fftSize);
     return true;
   }
 
@@ -55,12 +59,23 @@ bool IPlugVisualizer::OnMessage(int msgTag, int ctrlTag, int dataSize, const voi
 
 void IPlugVisualizer::OnIdle()
 {
-  mSender.TransmitData(*this);
+  mProducer.TransmitData(*this);
+}
+
+void IPlugVisualizer::OnUIOpen()
+{
+  Plugin::OnUIOpen();
+  mProducer.Start();
+}
+
+void IPlugVisualizer::OnUIClose()
+{
+  mProducer.Stop();
 }
 
 void IPlugVisualizer::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 {
-  mSender.ProcessBlock(inputs, nFrames, kCtrlTagSpectrumAnalyzer, NInChansConnected());
+  mProducer.ProcessBlock(inputs, nFrames, NInChansConnected());
   const int nChans = NOutChansConnected();
   
   for (int s = 0; s < nFrames; s++) {
@@ -73,7 +88,8 @@ void IPlugVisualizer::ProcessBlock(sample** inputs, sample** outputs, int nFrame
 void IPlugVisualizer::OnReset()
 {
   auto sr = GetSampleRate();
-  auto fftSize = mSender.GetFFTSize();
+  auto fftSize = mProducer.GetFFTSize();
+  mProducer.SetSampleRate(sr);
   SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagSampleRate, sizeof(double), &sr);
   SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagFFTSize, sizeof(int), &fftSize);
 }
@@ -85,8 +101,10 @@ void IPlugVisualizer::OnParamChangeUI(int paramIdx, EParamSource source)
 {
   if (paramIdx == kOctaveGain)
   {
-    double octaveGain = GetParam(kOctaveGain)->Value();
-    SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagOctaveGain, sizeof(double), &octaveGain);
+    // The producer applies the tilt before smoothing, the control draws its frames as they are
+#if IPLUG_DSP
+    mProducer.SetTilt(static_cast<float>(GetParam(kOctaveGain)->Value()));
+#endif
   }
 }
 #endif
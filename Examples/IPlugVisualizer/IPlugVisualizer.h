@@ -1,7 +1,7 @@
 #pragma once
 
 #include "IPlug_include_in_plug_hdr.h"
-#include "ISender.h"
+#include "ISpectrumProducer.h"
 
 const int kNumPresets = 1;
 
@@ -22,9 +22,11 @@ public:
 #if IPLUG_DSP // http://bit.ly/2S64BDd
   void OnReset() override;
   void OnIdle() override;
+  void OnUIOpen() override;
+  void OnUIClose() override;
   void ProcessBlock(sample** inputs, sample** outputs, int nFrames) override;
   bool OnMessage(int msgTag, int ctrlTag, int dataSize, const void* pData) override;
-  ISpectrumSender<2> mSender;
+  ISpectrumProducer<2> mProducer;
 #endif
 #if IPLUG_EDITOR
   void OnParamChangeUI(int paramIdx, EParamSource source) override;
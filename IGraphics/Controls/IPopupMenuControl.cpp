@@ -16,6 +16,9 @@
 
 #include "IPopupMenuControl.h"
 
+#include <algorithm>
+#include <cctype>
+
 #ifdef IGRAPHICS_NANOVG
 #include "nanovg.h"
 #endif
@@ -23,6 +26,26 @@
 using namespace iplug;
 using namespace igraphics;
 
+static bool ContainsNoCase(const char* str, const char* sub)
+{
+  for (; *str; str++)
+  {
+    const char* a = str;
+    const char* b = sub;
+    
+    while (*a && *b && tolower((unsigned char) *a) == tolower((unsigned char) *b))
+    {
+      a++;
+      b++;
+    }
+    
+    if (!*b)
+      return true;
+  }
+  
+  return !*sub;
+}
+
 IPopupMenuControl::IPopupMenuControl(int paramIdx, IText text, IRECT collapsedBounds, IRECT expandedBounds)
 : IControl(collapsedBounds, paramIdx)
 , mSpecifiedCollapsedBounds(collapsedBounds)
@@ -92,11 +115,10 @@ void IPopupMenuControl::Draw(IGraphics& g)
       DrawPanelShadow(g, pMenuPanel);
       DrawPanelBackground(g, pMenuPanel); 
       
-      int nItems = pMenuPanel->mMenu.NItems();
+      int nItems = pMenuPanel->NVisibleItems();
       int nCells = pMenuPanel->mCellBounds.GetSize();
       int startCell = 0;
       int endCell = nCells-1;
-      int cellOffset = 0;
 
       if(nItems > nCells)
       {
@@ -126,10 +148,10 @@ void IPopupMenuControl::Draw(IGraphics& g)
       for(auto i = startCell; i <= endCell; i++)
       {
         IRECT* pCellRect = pMenuPanel->mCellBounds.Get(i);
-        IPopupMenu::Item* pMenuItem = pMenuPanel->mMenu.GetItem(startCell + pMenuPanel->mScrollItemOffset + cellOffset++);
+        IPopupMenu::Item* pMenuItem = pMenuPanel->GetItemForCell(i);
     
-        if(!pMenuItem)
-          return;
+        if(!pMenuItem) // the filter leaves fewer items than cells
+          break;
     
         if(pMenuItem->GetIsSeparator())
           DrawSeparator(g, *pCellRect, &pMenuPanel->mBlend);
@@ -224,10 +246,12 @@ void IPopupMenuControl::OnMouseOver(float x, float y, const IMouseMod& mod)
     if(mMouseCellBounds == mActiveMenuPanel->mCellBounds.Get(0))
     {
       mActiveMenuPanel->ScrollUp();
+      MeasurePanel(*mActiveMenuPanel);
     }
     else if (mMouseCellBounds == mActiveMenuPanel->mCellBounds.Get((mActiveMenuPanel->mCellBounds.GetSize()-1)))
     {
       mActiveMenuPanel->ScrollDown();
+      MeasurePanel(*mActiveMenuPanel);
     }
   }
   
@@ -256,6 +280,123 @@ void IPopupMenuControl::OnMouseWheel(float x, float y, const IMouseMod& mod, flo
 //  }
 }
 
+bool IPopupMenuControl::OnKeyDown(float x, float y, const IKeyPress& key)
+{
+  if(GetState() != kExpanded || !mActiveMenuPanel)
+    return false;
+  
+  WDL_String filter(mActiveMenuPanel->mFilter);
+  
+  switch (key.VK)
+  {
+    case kVK_ESCAPE:
+      if(filter.GetLength())
+        SetFilter("");
+      else
+      {
+        mMouseCellBounds = nullptr;
+        CollapseEverything();
+      }
+      return true;
+    case kVK_RETURN:
+      if(mMouseCellBounds == nullptr) // choose the first item that passes the filter
+      {
+        for (auto i = 0; i < mActiveMenuPanel->mCellBounds.GetSize(); i++)
+        {
+          IPopupMenu::Item* pItem = mActiveMenuPanel->GetItemForCell(i);
+          
+          if(pItem && pItem->GetIsChoosable())
+          {
+            mMouseCellBounds = mActiveMenuPanel->mCellBounds.Get(i);
+            break;
+          }
+        }
+      }
+      CollapseEverything();
+      return true;
+    case kVK_BACK:
+    {
+      if(!mTypeToFilter || !filter.GetLength())
+        return false;
+      
+      int len = filter.GetLength() - 1;
+      
+      while (len > 0 && (filter.Get()[len] & 0xC0) == 0x80) // remove a whole UTF8 character
+        len--;
+      
+      filter.SetLen(len);
+      SetFilter(filter.Get());
+      return true;
+    }
+    default:
+      if(mTypeToFilter && !key.C && !key.A && static_cast<unsigned char>(key.utf8[0]) >= 0x20)
+      {
+        filter.Append(key.utf8);
+        SetFilter(filter.Get());
+        return true;
+      }
+      return false;
+  }
+}
+
+void IPopupMenuControl::SetFilter(const char* str)
+{
+  if(!mActiveMenuPanel)
+    return;
+  
+  MenuPanel& panel = *mActiveMenuPanel;
+  std::vector<int>& visible = panel.mVisibleItems;
+  
+  if(!CStringHasContents(str))
+    visible.clear();
+  else if(panel.mFilter.GetLength() && ContainsNoCase(str, panel.mFilter.Get()))
+  {
+    // the new filter is narrower, so only the items that passed the old one need to be tested
+    visible.erase(std::remove_if(visible.begin(), visible.end(), [&](int idx) {
+      return !ContainsNoCase(panel.mMenu.GetItem(idx)->GetText(), str);
+    }), visible.end());
+  }
+  else
+  {
+    visible.clear();
+    
+    for (auto i = 0; i < panel.mMenu.NItems(); i++)
+    {
+      IPopupMenu::Item* pItem = panel.mMenu.GetItem(i);
+      
+      if(!pItem->GetIsSeparator() && ContainsNoCase(pItem->GetText(), str))
+        visible.push_back(i);
+    }
+  }
+  
+  panel.mFilter.Set(str);
+  panel.mScrollItemOffset = 0;
+  panel.mHighlightedCell = nullptr;
+  mMouseCellBounds = nullptr;
+  
+  // cells may now show different items, so close any submenus of this panel
+  const int panelIdx = mMenuPanels.Find(mActiveMenuPanel);
+  
+  for (auto mr = 0; mr < mMenuPanels.GetSize(); mr++)
+  {
+    MenuPanel* pMenuPanel = mMenuPanels.Get(mr);
+    
+    if(pMenuPanel->mParentIdx == panelIdx)
+    {
+      pMenuPanel->mShouldDraw = false;
+      mSubMenuOpened = false;
+    }
+  }
+  
+  MeasurePanel(panel);
+  SetDirty(false);
+}
+
+const char* IPopupMenuControl::GetFilter() const
+{
+  return mActiveMenuPanel ? mActiveMenuPanel->mFilter.Get() : "";
+}
+
 void IPopupMenuControl::DrawCalloutArrow(IGraphics& g, const IRECT& bounds, IBlend* pBlend)
 {
   float trisize = bounds.H();
@@ -461,15 +602,20 @@ IRECT IPopupMenuControl::GetLargestCellRectForMenu(IPopupMenu& menu, float x, fl
 {
   IRECT span;
   
-  for (auto i = 0; i < menu.NItems(); ++i)
+  const int nItems = menu.NItems();
+  int nToMeasure = nItems;
+  bool rowsKnown = !mScrollIfTooBig; // a menu that doesn't scroll lays every item out in columns, so they are all measured
+  
+  // When scrolling, items beyond the first screenful (plus a margin) are only measured if they are scrolled into view, see MeasurePanel()
+  for (auto i = 0; i < nToMeasure; ++i)
   {
-    IPopupMenu::Item* pItem = menu.GetItem(i);
-    IRECT textBounds;
-    
-    const IGraphics* pGraphics = GetUI();
+    span = span.Union(MeasureItem(menu.GetItem(i)));
     
-    pGraphics->MeasureText(mText, pItem->GetText(), textBounds);
-    span = span.Union(textBounds);
+    if (!rowsKnown && span.H() > 0.f)
+    {
+      nToMeasure = std::min(nItems, GetMaxRows(span.H()) + MEASURE_MARGIN);
+      rowsKnown = true;
+    }
   }
   
   span.HPad(TEXT_HPAD); // add some padding because we don't want to be flush to the edges
@@ -478,6 +624,65 @@ IRECT IPopupMenuControl::GetLargestCellRectForMenu(IPopupMenu& menu, float x, fl
   return IRECT(x, y, x + span.W(), y + span.H());
 }
 
+IRECT IPopupMenuControl::MeasureItem(const IPopupMenu::Item* pItem) const
+{
+  if (mText.mSize != mMeasuredTextSize || strcmp(mText.mFont, mMeasuredFont.Get()))
+  {
+    mTextBoundsCache.clear();
+    mMeasuredTextSize = mText.mSize;
+    mMeasuredFont.Set(mText.mFont);
+  }
+  
+  const char* str = pItem->GetText();
+  auto it = mTextBoundsCache.find(str);
+  
+  if (it != mTextBoundsCache.end())
+    return it->second;
+  
+  IRECT textBounds;
+  GetUI()->MeasureText(mText, str, textBounds);
+  
+  // the position depends on the text alignment, which DrawCellText() changes, so only keep the size
+  const IRECT size(0.f, 0.f, textBounds.W(), textBounds.H());
+  
+  if (static_cast<int>(mTextBoundsCache.size()) >= MAX_CACHED_MEASUREMENTS)
+    mTextBoundsCache.clear();
+  
+  mTextBoundsCache.emplace(str, size);
+  return size;
+}
+
+int IPopupMenuControl::GetMaxRows(float cellHeight) const
+{
+  const float maxTop = mMaxBounds.T + PAD + mDropShadowSize;
+  const float maxBottom = mMaxBounds.B - PAD;// - mDropShadowSize;
+  return static_cast<int>((maxBottom - maxTop) / (cellHeight + mCellGap)); // maximum cell rows (full height, not with separators)
+}
+
+void IPopupMenuControl::MeasurePanel(MenuPanel& panel)
+{
+  const int nCells = panel.mCellBounds.GetSize();
+  const int start = std::max(panel.mScrollItemOffset - MEASURE_MARGIN, 0);
+  const int end = std::min(panel.mScrollItemOffset + nCells + MEASURE_MARGIN, panel.NVisibleItems());
+  
+  IRECT span;
+  
+  for (auto pos = start; pos < end; pos++)
+  {
+    span = span.Union(MeasureItem(panel.mMenu.GetItem(panel.GetItemIdx(pos))));
+  }
+  
+  span.HPad(TEXT_HPAD);
+  span.Pad(TICK_SIZE, 0, ARROW_SIZE, 0);
+  
+  if (span.W() > panel.CellWidth())
+  {
+    panel.SetCellWidth(*this, span.W());
+    SetTargetRECT(mTargetRECT.Union(panel.mTargetRECT));
+    SetRECT(mRECT.Union(panel.mRECT));
+  }
+}
+
 void IPopupMenuControl::GetPanelDimensions(IPopupMenu&menu, float& width, float& height) const
 {
   IRECT maxCell = GetLargestCellRectForMenu(menu, 0, 0);
@@ -513,8 +718,8 @@ void IPopupMenuControl::CalculateMenuPanels(float x, float y)
   for(auto i = 0; i < mActiveMenuPanel->mCellBounds.GetSize(); i++)
   {
     IRECT* pCellRect = mActiveMenuPanel->mCellBounds.Get(i);
-    IPopupMenu::Item* pMenuItem = mActiveMenuPanel->mMenu.GetItem(i);
-    IPopupMenu* pSubMenu = pMenuItem->GetSubmenu();
+    IPopupMenu::Item* pMenuItem = mActiveMenuPanel->GetItemForCell(i);
+    IPopupMenu* pSubMenu = pMenuItem ? pMenuItem->GetSubmenu() : nullptr;
     
     if(pCellRect == mMouseCellBounds)
     {
@@ -810,10 +1015,10 @@ void IPopupMenuControl::CollapseEverything()
     
     if (mMouseCellBounds == pR)
     {
-      int itemChosen = mActiveMenuPanel->mScrollItemOffset + i;
+      int itemChosen = mActiveMenuPanel->GetItemIdxForCell(i);
       IPopupMenu::Item* pItem = pClickedMenu->GetItem(itemChosen);
 
-      if (pItem->GetIsChoosable())
+      if (pItem && pItem->GetIsChoosable())
       {
         pClickedMenu->SetChosenItemIdx(itemChosen);
         mActiveMenuPanel->mClickedCell = pR;
@@ -924,9 +1129,7 @@ IPopupMenuControl::MenuPanel::MenuPanel(IPopupMenuControl& control, IPopupMenu&
       if(control.mScrollIfTooBig)
       {
         const float maxTop = control.mMaxBounds.T + control.PAD + control.mDropShadowSize;
-        const float maxBottom = control.mMaxBounds.B - control.PAD;// - control.mDropShadowSize;
-        const float maxH = (maxBottom - maxTop);
-        mScrollMaxRows = static_cast<int>(maxH  / (CellHeight() + control.mCellGap)); // maximum cell rows (full height, not with separators)
+        mScrollMaxRows = control.GetMaxRows(CellHeight());
         
         // clear everything added so far
         mCellBounds.Empty(true);
@@ -977,6 +1180,38 @@ IPopupMenuControl::MenuPanel::MenuPanel(IPopupMenuControl& control, IPopupMenu&
     top = bottom + control.mCellGap;
   }
   
+  UpdateBounds(control);
+}
+
+void IPopupMenuControl::MenuPanel::SetCellWidth(IPopupMenuControl& control, float width)
+{
+  mSingleCellBounds.R = mSingleCellBounds.L + width;
+  
+  float right = 0.f;
+  
+  for(auto i = 0; i < mCellBounds.GetSize(); i++)
+  {
+    IRECT* pR = mCellBounds.Get(i);
+    pR->R = pR->L + width;
+    right = std::max(right, pR->R);
+  }
+  
+  // don't let a wider panel go off the right of the max bounds
+  const float overflow = right + control.PAD + control.mDropShadowSize - control.mMaxBounds.R;
+  
+  if(overflow > 0.f)
+  {
+    for(auto i = 0; i < mCellBounds.GetSize(); i++)
+    {
+      mCellBounds.Get(i)->Translate(-overflow, 0.f);
+    }
+  }
+  
+  UpdateBounds(control);
+}
+
+void IPopupMenuControl::MenuPanel::UpdateBounds(IPopupMenuControl& control)
+{
   IRECT span;
   
   if(mCellBounds.GetSize())
@@ -1011,8 +1246,14 @@ IRECT* IPopupMenuControl::MenuPanel::HitTestCells(float x, float y) const
   for(auto i = 0; i < mCellBounds.GetSize(); i++)
   {
     IRECT* pR = mCellBounds.Get(i);
-    if(pR->Contains(x, y) && mMenu.GetItem(i)->GetEnabled())
-      return pR;
+    
+    if(pR->Contains(x, y))
+    {
+      IPopupMenu::Item* pItem = GetItemForCell(i);
+      
+      if(IsScrollArrowCell(i) || (pItem && pItem->GetEnabled()))
+        return pR;
+    }
   }
   return nullptr;
 }
@@ -16,12 +16,18 @@
  * @copydoc IPopupMenuControl
  */
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "IControl.h"
 
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
 
 /** A base control for a pop-up menu/drop-down list that stays within the bounds of the IGraphics context.
+ * Menus that are too long for the context scroll. Only the rows that are on screen (plus a small margin) are measured and laid out, so menus with
+ * thousands of items open quickly. Text measurements are cached, and typing while a menu is open filters the active panel's items.
  * This is mainly used as a special control that lives outside the main IGraphics control stack.
  * For replacing generic menus this can be added with IGraphics::AttachPopupMenu().
  * If used in the main IControl stack, you probably want it to be the very last control that is added, so that it gets drawn on top.
@@ -66,6 +72,7 @@ public:
   void OnMouseOver(float x, float y, const IMouseMod& mod) override;
   void OnMouseOut() override;
   void OnMouseWheel(float x, float y, const IMouseMod& mod, float d) override;
+  bool OnKeyDown(float x, float y, const IKeyPress& key) override;
   void OnEndAnimation() override;
 
   //IPopupMenuControl
@@ -138,9 +145,29 @@ public:
   /** Set the bounds that the menu can potentially occupy, if not the full graphics context */
   void SetMaxBounds(const IRECT& bounds) { mMaxBounds = bounds; }
 
+  /** Filter the items of the active menu panel, to those whose text contains a string (case insensitive). This is called as the user types
+   * @param str The string to filter by, or an empty string to show all items */
+  void SetFilter(const char* str);
+
+  /** @return The string that the active menu panel is filtered by */
+  const char* GetFilter() const;
+
+  /** Enable or disable filtering the menu by typing while it is open */
+  void SetTypeToFilter(bool enable) { mTypeToFilter = enable; }
+
 private:
-  /** Get an IRECT represents the maximum dimensions of the longest text item in the menu */
+  /** Get an IRECT represents the maximum dimensions of the longest text item in the menu that may be visible before scrolling */
   IRECT GetLargestCellRectForMenu(IPopupMenu& menu, float x, float y) const;
+
+  /** Measure the text of an item, using the cache of measurements if the text has been measured before with the same font
+   * @return An IRECT at the origin with the size of the text */
+  IRECT MeasureItem(const IPopupMenu::Item* pItem) const;
+
+  /** @return The number of rows of cells that fit in mMaxBounds */
+  int GetMaxRows(float cellHeight) const;
+
+  /** Measure the items that are visible in a panel (plus a margin) and widen the panel if any of them don't fit */
+  void MeasurePanel(MenuPanel& panel);
   
   /** Sets the values of two variables for the length and width of the specified menu panel.
    * @param menu The menu to get dimensions of
@@ -172,9 +199,48 @@ private:
     /** Gets the height of a cell */
     float CellHeight() const { return mSingleCellBounds.H(); }
 
-    void ScrollUp() { mScrollItemOffset--; mScrollItemOffset = Clip(mScrollItemOffset, 0, mCellBounds.GetSize()-1); }
+    void ScrollUp() { mScrollItemOffset = std::max(mScrollItemOffset - 1, 0); }
+
+    void ScrollDown() { mScrollItemOffset = std::max(std::min(mScrollItemOffset + 1, NVisibleItems() - mCellBounds.GetSize()), 0); }
+
+    /** @return The number of items that pass the filter */
+    int NVisibleItems() const { return mFilter.GetLength() ? static_cast<int>(mVisibleItems.size()) : mMenu.NItems(); }
 
-    void ScrollDown() { mScrollItemOffset++; mScrollItemOffset = Clip(mScrollItemOffset, 0, mMenu.NItems()-mCellBounds.GetSize()); }
+    /** @return The index in mMenu of the item at a position in the filtered list, or -1 */
+    int GetItemIdx(int pos) const
+    {
+      if (pos < 0 || pos >= NVisibleItems())
+        return -1;
+
+      return mFilter.GetLength() ? mVisibleItems[pos] : pos;
+    }
+
+    /** @return \c true if a cell is showing a scroll arrow rather than an item */
+    bool IsScrollArrowCell(int cellIdx) const
+    {
+      const int nCells = mCellBounds.GetSize();
+
+      if (NVisibleItems() <= nCells)
+        return false;
+
+      return (cellIdx == 0 && mScrollItemOffset > 0) || (cellIdx == nCells - 1 && mScrollItemOffset < NVisibleItems() - nCells);
+    }
+
+    /** @return The index in mMenu of the item a cell is showing, or -1 if it is empty or a scroll arrow */
+    int GetItemIdxForCell(int cellIdx) const { return IsScrollArrowCell(cellIdx) ? -1 : GetItemIdx(cellIdx + mScrollItemOffset); }
+
+    /** @return The item a cell is showing, or nullptr if it is empty or a scroll arrow */
+    IPopupMenu::Item* GetItemForCell(int cellIdx) const
+    {
+      const int idx = GetItemIdxForCell(cellIdx);
+      return idx > -1 ? mMenu.GetItem(idx) : nullptr;
+    }
+
+    /** Set the width of all cells, and update the panel bounds */
+    void SetCellWidth(IPopupMenuControl& control, float width);
+
+    /** Update mTargetRECT and mRECT from the cell bounds, keeping the panel within the control's max bounds */
+    void UpdateBounds(IPopupMenuControl& control);
 
     /** Checks if any of the expanded cells for this panel contain a x, y coordinate, and if so returns an IRECT pointer to the cell bounds
      * @param x X position to test
@@ -198,6 +264,8 @@ private:
     int mParentIdx = 0; // An index into the IPopupMenuControl::mMenuPanels lists, representing the parent menu panel
     bool mScroller = false;
     int mScrollItemOffset = 0;
+    WDL_String mFilter; // Only items whose text contains this are shown
+    std::vector<int> mVisibleItems; // Indices of the items that pass mFilter, if it is not empty
       
 #ifndef IGRAPHICS_NANOVG
     ILayerPtr mShadowLayer;
@@ -218,6 +286,11 @@ private:
   bool mForcedSouth = true; // if set true, a menu in the lower half of the GUI will appear below it's control if there is enough room for it.
   bool mSubmenuOnRight = true; // If set true, the submenu will be drawn on the right of the parent menu.... on the left if false.
   bool mSubMenuOpened = false; // Is set true when a submenu panel is open and false when menu is collapsed.
+  bool mTypeToFilter = true; // If set true, typing while the menu is open filters the active panel
+
+  mutable std::unordered_map<std::string, IRECT> mTextBoundsCache; // Text measurements, which are valid for mMeasuredTextSize and mMeasuredFont
+  mutable float mMeasuredTextSize = 0.f;
+  mutable WDL_String mMeasuredFont;
 
   float mCellGap = 2.f; // The gap between cells in pixels
   float mSeparatorSize = 2.; // The size in pixels of a separator. This could be width or height
@@ -231,6 +304,8 @@ private:
   const float ARROW_SIZE = 8; // The width of the area on the right of the cell where an arrow appears for new submenus
   const float PAD = 5.; // How much white space between the background and the cells
   const float CALLOUT_SPACE = 8; // The space between start bounds and callout
+  const int MEASURE_MARGIN = 8; // How many rows either side of the visible rows are measured
+  const int MAX_CACHED_MEASUREMENTS = 16384; // The text measurement cache is cleared when it gets bigger than this
   IRECT mAnchorArea; // The area where the menu was triggered; menu will be adjacent, but won't occupy it.
   EArrowDir mCalloutArrowDir = kEast;
   IRECT mCalloutArrowBounds; // The rectangle in which the CallOut arrow is drawn.
@@ -33,6 +33,9 @@ public:
   : IControl(bounds)
   , IVectorBase(style)
   , mBuffer(bufferSize, defaultVal)
+  , mPlotValues(bufferSize)
+  , mDecimatedValues(bufferSize)
+  , mDecimatedPositions(bufferSize)
   , mLoValue(lo)
   , mHiValue(hi)
   , mStrokeThickness(strokeThickness)
@@ -73,32 +76,52 @@ public:
     float h = mPlotBounds.H();
     
     const int sz = static_cast<int>(mBuffer.size());
-
-    auto getPlotPos = [&](int pos, float axis, float extrem) {
-      float v = mBuffer[(mReadPos+pos) % sz];
-      v = (v - mLoValue) / (mHiValue - mLoValue);
-      return axis + extrem - (v * extrem);
+    const float range = mHiValue - mLoValue;
+    
+    // Unwrap the ring buffer, oldest value first
+    int p = 0;
+    for (int i = mReadPos; i < sz; i++)
+      mPlotValues[p++] = (mBuffer[i] - mLoValue) / range;
+    for (int i = 0; i < mReadPos; i++)
+      mPlotValues[p++] = (mBuffer[i] - mLoValue) / range;
+    
+    const float* pValues = mPlotValues.data();
+    const float* pPositions = nullptr;
+    int nPoints = sz;
+    
+    // Only keep the min/max envelope per pixel if there are more values than pixels
+    const int nColumns = static_cast<int>(std::ceil((mDirection == EDirection::Horizontal ? w : h) * g.GetTotalScale()));
+    
+    if (nColumns > 0 && sz > 4 * nColumns)
+    {
+      nPoints = DecimateMinMax(mPlotValues.data(), nullptr, sz, nColumns, mDecimatedValues.data(), mDecimatedPositions.data());
+      pValues = mDecimatedValues.data();
+      pPositions = mDecimatedPositions.data();
+    }
+    
+    auto getPosition = [&](int i) {
+      return pPositions ? pPositions[i] : (float) i / (sz - 1);
     };
     
     if(mDirection == EDirection::Horizontal)
     {
-      g.PathMoveTo(x, getPlotPos(0, y, h));
+      g.PathMoveTo(x, y + h - (pValues[0] * h));
       
-      for (int i = 0; i < sz; i++)
+      for (int i = 0; i < nPoints; i++)
       {
-        float vx = x + ((float)i/(sz-1)) * w;
-        float vy = getPlotPos(i, y, h);
+        float vx = x + getPosition(i) * w;
+        float vy = y + h - (pValues[i] * h);
         g.PathLineTo(vx, vy);
       }
     }
     else
     {
-      g.PathMoveTo(getPlotPos(0, x, w), y);
+      g.PathMoveTo(x + w - (pValues[0] * w), y);
       
-      for (int i = 0; i < sz; i++)
+      for (int i = 0; i < nPoints; i++)
       {
-        float vx = getPlotPos(i, x, w);
-        float vy = y + ((float)i/(sz-1)) * h;
+        float vx = x + w - (pValues[i] * w);
+        float vy = y + getPosition(i) * h;
         g.PathLineTo(vx, vy);
       }
     }
@@ -128,6 +151,8 @@ public:
   
 private:
   std::vector<float> mBuffer;
+  std::vector<float> mPlotValues; // normalized, unwrapped copy of mBuffer
+  std::vector<float> mDecimatedValues, mDecimatedPositions;
   float mLoValue = 0.f;
   float mHiValue = 1.f;
   int mReadPos = 0;
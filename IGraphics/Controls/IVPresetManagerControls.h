@@ -217,6 +217,8 @@ public:
   void OnAttached() override
   {
     auto prevPresetFunc = [&](IControl* pCaller) {
+      UpdateMenu();
+
       if (NItems())
       {
         mSelectedItemIndex--;
@@ -229,6 +231,8 @@ public:
     };
 
     auto nextPresetFunc = [&](IControl* pCaller) {
+      UpdateMenu();
+
       if (NItems())
       {
         mSelectedItemIndex++;
@@ -259,6 +263,7 @@ public:
     };
 
     auto choosePresetFunc = [&](IControl* pCaller) {
+      UpdateMenu();
       CheckSelectedItem();
       pCaller->GetUI()->CreatePopupMenu(*this, mMainMenu, pCaller->GetRECT());
     };
@@ -282,11 +287,14 @@ public:
 
   void LoadPresetAtCurrentIndex()
   {
-    if (mSelectedItemIndex > -1 && 
-        mSelectedItemIndex < mItems.GetSize())
-    {
-      WDL_String fileName;
+    WDL_String fileName;
+
+    // The selection may be a file that the background scan has not found yet
+    if (mSelectedItemIndex < mItems.GetSize())
       GetSelectedFile(fileName);
+
+    if (fileName.GetLength())
+    {
       if (!mShowFileExtensions)
       {
         fileName.remove_fileext();
@@ -303,7 +311,7 @@ public:
       // chosen item index to mSelectedItemIndex
       // in order to pop up the menu at the
       // correct location
-      if (!mMainMenu.HasSubMenus())
+      if (!mMainMenu.HasSubMenus() && mSelectedItemIndex > -1)
       {
         mMainMenu.SetChosenItemIdx(mSelectedItemIndex);
       }
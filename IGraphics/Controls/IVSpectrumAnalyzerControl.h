@@ -18,6 +18,7 @@
 
 #include "IControl.h"
 #include "ISender.h"
+#include "ISpectrumProducer.h"
 #include "IPlugStructs.h"
 
 BEGIN_IPLUG_NAMESPACE
@@ -25,6 +26,8 @@ BEGIN_IGRAPHICS_NAMESPACE
 
 /** Vectorial multi-channel capable spectrum analyzer control
  * @ingroup IControls
+ * The control either receives FFT frames from an ISpectrumSender, and maps and smooths them itself,
+ * or subscribes to an ISpectrumProducer, which sends frames that are already log-binned and smoothed and are drawn as they are
  * Derived from work by Alex Harker and Matthew Witmer
  */
 template <int MAXNC = 2, int MAX_FFT_SIZE = 4096>
@@ -164,6 +167,15 @@ public:
         CalculateYPoints(c, d.vals[c]);
       }
     }
+    else if (!IsDisabled() && msgTag == ISpectrumProducer<>::kFrameMessage)
+    {
+      ISpectrumFrameHeader header;
+      const int pos = stream.Get(&header, 0);
+      const int nValues = header.nChans * header.nBands;
+
+      if (pos > 0 && header.nBands > 0 && nValues > 0 && dataSize >= pos + nValues * static_cast<int>(sizeof(float)))
+        SetBinnedFrame(header, reinterpret_cast<const float*>(static_cast<const uint8_t*>(pData) + pos));
+    }
     else if (msgTag == kMsgTagSampleRate)
     {
       double sr;
@@ -288,6 +300,9 @@ private:
     assert(fftSize <= MAX_FFT_SIZE);
     mFFTSize = fftSize;
     
+    if (mNumBands) // the producer owns the band layout
+      return;
+
     ResizePoints();
     CalculateXPoints();
     SetFreqRange(FirstBinFreq(), NyquistFreq());
@@ -298,6 +313,10 @@ private:
   void SetSampleRate(double sampleRate)
   {
     mSampleRate = sampleRate;
+
+    if (mNumBands)
+      return;
+
     SetFreqRange(FirstBinFreq(), NyquistFreq());
     SetSmoothing(mAttackTimeMs, mDecayTimeMs);
     SetDirty(false);
@@ -368,15 +387,63 @@ protected:
   void CalculateXPoints()
   {
     const auto numBins = NumBins();
-    const auto xIncr = (1.0f / static_cast<float>(numBins-1)) * NyquistFreq();
-    mXPoints[0] = 0.0f;
-    for (auto i = 1; i < numBins; i++)
+
+    if (mNumBands)
+    {
+      // Log-spaced bands from an ISpectrumProducer, placed at their centre frequencies
+      const auto ratio = mFreqHi / mFreqLo;
+      for (auto i = 0; i < numBins; i++)
+      {
+        mXPoints[i] = CalcXNorm(mFreqLo * std::pow(ratio, (float(i) + 0.5f) / float(numBins)), mFreqScale);
+      }
+    }
+    else
+    {
+      const auto xIncr = (1.0f / static_cast<float>(numBins-1)) * NyquistFreq();
+      mXPoints[0] = 0.0f;
+      for (auto i = 1; i < numBins; i++)
+      {
+        auto xVal = CalcXNorm(float(i) * xIncr, mFreqScale);
+        mXPoints[i] = xVal;
+      }
+    }
+
+    if (FillCurves())
     {
-      auto xVal = CalcXNorm(float(i) * xIncr, mFreqScale);
-      mXPoints[i] = xVal;
+      mXPoints[numBins] = mXPoints[numBins-1];
+      mXPoints[numBins+1] = mXPoints[0];
     }
-    mXPoints[numBins] = mXPoints[numBins-1];
-    mXPoints[numBins+1] = mXPoints[0];
+  }
+  
+  void SetBinnedFrame(const ISpectrumFrameHeader& header, const float* pValues)
+  {
+    if (header.nBands != mNumBands || header.freqLo != mFreqLo || header.freqHi != mFreqHi)
+    {
+      mNumBands = header.nBands;
+      SetFreqRange(header.freqLo, header.freqHi);
+      ResizePoints();
+      CalculateXPoints();
+    }
+
+    SetAmpRange(DBToAmp(header.dBLo), DBToAmp(header.dBHi));
+
+    const auto nChans = std::min(header.nChans, MAXNC);
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      std::copy(pValues + c * mNumBands, pValues + (c + 1) * mNumBands, mYPoints[c].begin());
+      
+      if (FillCurves())
+      {
+        // Used to close the path outside the bounds of the control
+        auto offset = mCurveThickness/mWidgetBounds.H();
+
+        mYPoints[c][mNumBands] = -offset;
+        mYPoints[c][mNumBands+1] = -offset;
+      }
+    }
+    
+    SetDirty(false);
   }
   
   void CalculateYPoints(int ch, const TDataPacket& powerSpectrum)
@@ -466,7 +533,7 @@ protected:
   }
 
   int NumPoints() const { return FillCurves() ? NumBins() + numExtraPoints : NumBins(); }
-  int NumBins() const { return mFFTSize / 2; }
+  int NumBins() const { return mNumBands ? mNumBands : mFFTSize / 2; }
   double FirstBinFreq() const { return NyquistFreq()/mFFTSize; }
   double NyquistFreq() const { return mSampleRate * 0.5; }
   bool FillCurves() const { return mFillOpacity > 0.0f; }
@@ -478,6 +545,7 @@ private:
 
   double mSampleRate = 44100.0;
   int mFFTSize = 1024;
+  int mNumBands = 0; // non-zero when drawing frames from an ISpectrumProducer
   float mOctaveGain = 0.0;
   float mFreqLo = 20.0;
   float mFreqHi = 22050.0;
@@ -74,6 +74,7 @@ public:
   {
     if (mButtonRect.Contains(x, y))
     {
+      UpdateMenu();
       GetUI()->CreatePopupMenu(*this, mMainMenu, x, y);
     }
     else if (mUsePlatformMenuButtonRect.Contains(x, y))
@@ -42,7 +42,13 @@
       #error Define either IGRAPHICS_GL2 or IGRAPHICS_GL3 when using IGRAPHICS_GL and IGRAPHICS_NANOVG with OS_WIN
     #endif
   #elif defined OS_LINUX
-    #error NOT IMPLEMENTED
+    #if defined IGRAPHICS_GL2
+      #define NANOVG_GL2_IMPLEMENTATION
+    #elif defined IGRAPHICS_GL3
+      #define NANOVG_GL3_IMPLEMENTATION
+    #else
+      #error Define either IGRAPHICS_GL2 or IGRAPHICS_GL3 when using IGRAPHICS_GL and IGRAPHICS_NANOVG with OS_LINUX
+    #endif
   #elif defined OS_WEB
     #if defined IGRAPHICS_GLES2
       #define NANOVG_GLES2_IMPLEMENTATION
@@ -64,6 +70,7 @@
   #error you must define either IGRAPHICS_GL2, IGRAPHICS_GLES2 etc or IGRAPHICS_METAL when using IGRAPHICS_NANOVG
 #endif
 
+#include <algorithm>
 #include <string>
 #include <map>
 
@@ -72,6 +79,16 @@ using namespace igraphics;
 
 #pragma mark - Private Classes and Structs
 
+// Retrieving pixels
+static void nvgReadPixels(NVGcontext* pContext, int image, int x, int y, int width, int height, void* pData)
+{
+#if defined(IGRAPHICS_GL)
+  glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pData);
+#elif defined(IGRAPHICS_METAL)
+  mnvgReadPixels(pContext, image, x, y, width, height, pData);
+#endif
+}
+
 class IGraphicsNanoVG::Bitmap : public APIBitmap
 {
 public:
@@ -80,13 +97,42 @@ public:
   Bitmap(NVGcontext* pContext, int width, int height, const uint8_t* pData, float scale, float drawScale);
   virtual ~Bitmap();
   NVGframebuffer* GetFBO() const { return mFBO; }
+
+  /** Keep where a loaded bitmap came from, so that its texture can be created again in a new context.
+   * Data loaded from memory is copied, as the caller's buffer only has to outlive the call that loaded it */
+  void SetSource(const char* fileNameOrResID, EResourceLocation location, const char* ext);
+  void SetSource(const void* pData, int dataSize);
+
+  /** Delete the texture before the context is destroyed, keeping the size and scale of the bitmap.
+   * A bitmap that was drawn into a framebuffer (e.g. by ScaleBitmap()) has no source to load again, so its pixels are read back first */
+  void ReleaseTexture();
+
+  /** Use a texture created from the source in a new context */
+  void RestoreTexture(NVGcontext* pContext, int nvgImageID);
+
+  /** Create a texture from the bitmap's source in a new context
+   * @return The NanoVG image ID, or 0 if the bitmap has no source */
+  int CreateTextureFromSource(IGraphicsNanoVG* pGraphics, NVGcontext* pContext);
+
+  NVGcontext* GetContext() const { return mVG; }
 private:
   IGraphicsNanoVG *mGraphics = nullptr;
   NVGcontext* mVG;
   NVGframebuffer* mFBO = nullptr;
   bool mSharedTexture = false;
+  WDL_String mSourcePath;
+  WDL_String mSourceExt;
+  EResourceLocation mSourceLocation = EResourceLocation::kNotFound;
+  WDL_TypedBuf<uint8_t> mSourceData; // the encoded image, for bitmaps loaded from memory
+  WDL_TypedBuf<uint8_t> mSourcePixels; // RGBA pixels read back from a framebuffer when the texture was released
 };
 
+#if defined IGRAPHICS_GL
+static constexpr int kFramebufferImageFlags = NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED; // as nvgluCreateFramebuffer() creates the image
+#else
+static constexpr int kFramebufferImageFlags = NVG_IMAGE_PREMULTIPLIED; // as mnvgCreateFramebuffer() creates the image
+#endif
+
 IGraphicsNanoVG::Bitmap::Bitmap(NVGcontext* pContext, const char* path, double sourceScale, int nvgImageID, bool shared)
 {
   assert(nvgImageID > 0);
@@ -130,7 +176,7 @@ IGraphicsNanoVG::Bitmap::Bitmap(NVGcontext* pContext, int width, int height, con
 
 IGraphicsNanoVG::Bitmap::~Bitmap()
 {
-  if(!mSharedTexture)
+  if(!mSharedTexture && mVG)
   {
     if(mFBO)
       mGraphics->DeleteFBO(mFBO);
@@ -139,21 +185,64 @@ IGraphicsNanoVG::Bitmap::~Bitmap()
   }
 }
 
-// Fonts
-static StaticStorage<IFontData> sFontCache;
+void IGraphicsNanoVG::Bitmap::SetSource(const char* fileNameOrResID, EResourceLocation location, const char* ext)
+{
+  mSourcePath.Set(fileNameOrResID);
+  mSourceExt.Set(ext);
+  mSourceLocation = location;
+}
 
-extern std::map<std::string, MTLTexturePtr> gTextureMap;
+void IGraphicsNanoVG::Bitmap::SetSource(const void* pData, int dataSize)
+{
+  mSourceData.Resize(dataSize, false);
+  memcpy(mSourceData.Get(), pData, dataSize);
+}
 
-// Retrieving pixels
-static void nvgReadPixels(NVGcontext* pContext, int image, int x, int y, int width, int height, void* pData)
+void IGraphicsNanoVG::Bitmap::ReleaseTexture()
 {
-#if defined(IGRAPHICS_GL)
-  glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pData);
-#elif defined(IGRAPHICS_METAL)
-  mnvgReadPixels(pContext, image, x, y, width, height, pData);
-#endif
+  if (!mVG)
+    return;
+
+  if (mFBO)
+  {
+    mSourcePixels.Resize(GetWidth() * GetHeight() * 4, false);
+    nvgBindFramebuffer(mFBO);
+    nvgReadPixels(mVG, GetBitmap(), 0, 0, GetWidth(), GetHeight(), mSourcePixels.Get());
+    nvgBindFramebuffer(nullptr);
+    nvgDeleteFramebuffer(mFBO);
+    mFBO = nullptr;
+  }
+  else if (!mSharedTexture)
+    nvgDeleteImage(mVG, GetBitmap());
+
+  mVG = nullptr;
+  // Until it is restored the bitmap draws nothing, rather than whatever texture has its ID in the next context
+  SetBitmap(0, GetWidth(), GetHeight(), GetScale(), GetDrawScale());
+}
+
+void IGraphicsNanoVG::Bitmap::RestoreTexture(NVGcontext* pContext, int nvgImageID)
+{
+  mVG = pContext;
+  SetBitmap(nvgImageID, GetWidth(), GetHeight(), GetScale(), GetDrawScale());
+}
+
+int IGraphicsNanoVG::Bitmap::CreateTextureFromSource(IGraphicsNanoVG* pGraphics, NVGcontext* pContext)
+{
+  if (mSourceData.GetSize())
+    return nvgCreateImageMem(pContext, 0, mSourceData.Get(), mSourceData.GetSize());
+  else if (mSourcePixels.GetSize())
+    return nvgCreateImageRGBA(pContext, GetWidth(), GetHeight(), kFramebufferImageFlags, mSourcePixels.Get());
+  else if (mSourceLocation != EResourceLocation::kNotFound)
+    return pGraphics->CreateImage(mSourcePath.Get(), mSourceLocation, mSourceExt.Get());
+
+  return 0;
 }
 
+// Fonts
+static StaticStorage<IFontData> sFontCache;
+
+extern std::map<std::string, MTLTexturePtr> gTextureMap;
+
 #pragma mark - Utilities
 
 BEGIN_IPLUG_NAMESPACE
@@ -308,7 +397,62 @@ IBitmap IGraphicsNanoVG::LoadBitmap(const char* name, int nStates, bool framesAr
   return IBitmap(pAPIBitmap, nStates, framesAreHorizontal, name);
 }
 
+IBitmap IGraphicsNanoVG::LoadBitmap(const char* name, const void* pData, int dataSize, int nStates, bool framesAreHorizontal, int targetScale)
+{
+  if (targetScale == 0)
+    targetScale = GetRoundedScreenScale();
+
+  // As for files, the bitmap is kept in the context's cache rather than the global static cache
+  StaticStorage<APIBitmap>::Accessor storage(mBitmapCache);
+  APIBitmap* pAPIBitmap = storage.Find(name, targetScale);
+
+  if (!pAPIBitmap)
+  {
+    const char* ext = name + strlen(name) - 1;
+    while (ext >= name && *ext != '.') --ext;
+    ++ext;
+
+    if (!BitmapExtSupported(ext))
+      return IBitmap(); // return invalid IBitmap
+
+    // Data in memory has no other scales, so load it with scale = 1
+    pAPIBitmap = storage.Find(name, 1);
+
+    if (!pAPIBitmap)
+    {
+      pAPIBitmap = LoadAPIBitmap(name, pData, dataSize, 1);
+      assert(pAPIBitmap && "Bitmap not loaded");
+      storage.Add(pAPIBitmap, name, 1);
+    }
+
+    // N.B. - scaling retains in the cache
+    if (targetScale != 1)
+      return ScaleBitmap(IBitmap(pAPIBitmap, nStates, framesAreHorizontal, name), name, targetScale);
+  }
+
+  return IBitmap(pAPIBitmap, nStates, framesAreHorizontal, name);
+}
+
+void IGraphicsNanoVG::ReleaseBitmap(const IBitmap& bitmap)
+{
+  StaticStorage<APIBitmap>::Accessor storage(mBitmapCache);
+  storage.Remove(bitmap.GetAPIBitmap());
+}
+
+void IGraphicsNanoVG::RetainBitmap(const IBitmap& bitmap, const char* cacheName)
+{
+  StaticStorage<APIBitmap>::Accessor storage(mBitmapCache);
+  storage.Add(bitmap.GetAPIBitmap(), cacheName, bitmap.GetScale());
+}
+
 APIBitmap* IGraphicsNanoVG::LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext)
+{
+  Bitmap* pBitmap = new Bitmap(mVG, fileNameOrResID, scale, CreateImage(fileNameOrResID, location, ext), location == EResourceLocation::kPreloadedTexture);
+  pBitmap->SetSource(fileNameOrResID, location, ext);
+  return pBitmap;
+}
+
+int IGraphicsNanoVG::CreateImage(const char* fileNameOrResID, EResourceLocation location, const char* ext)
 {
   int idx = 0;
   int nvgImageFlags = 0;
@@ -343,29 +487,21 @@ APIBitmap* IGraphicsNanoVG::LoadAPIBitmap(const char* fileNameOrResID, int scale
     idx = nvgCreateImage(mVG, fileNameOrResID, nvgImageFlags);
   }
 
-  return new Bitmap(mVG, fileNameOrResID, scale, idx, location == EResourceLocation::kPreloadedTexture);
+  return idx;
 }
 
 APIBitmap* IGraphicsNanoVG::LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale)
 {
-  StaticStorage<APIBitmap>::Accessor storage(mBitmapCache);
-  APIBitmap* pBitmap = storage.Find(name, scale);
+  int idx = 0;
+  int nvgImageFlags = 0;
 
-  if (!pBitmap)
   {
-    int idx = 0;
-    int nvgImageFlags = 0;
-
-    {
-      ScopedGLContext scopedGLCtx {this};
-      idx = nvgCreateImageMem(mVG, nvgImageFlags, (unsigned char*)pData, dataSize);
-    }
-    
-    pBitmap = new Bitmap(mVG, name, scale, idx, false);
-
-    storage.Add(pBitmap, name, scale);
+    ScopedGLContext scopedGLCtx {this};
+    idx = nvgCreateImageMem(mVG, nvgImageFlags, (unsigned char*)pData, dataSize);
   }
 
+  Bitmap* pBitmap = new Bitmap(mVG, name, scale, idx, false);
+  pBitmap->SetSource(pData, dataSize);
   return pBitmap;
 }
 
@@ -455,16 +591,29 @@ void IGraphicsNanoVG::OnViewInitialized(void* pContext)
 #endif
 
   if (mVG == nullptr)
+  {
     DBGMSG("Could not init nanovg.\n");
+    return;
+  }
+
+  // A persistent graphics context kept its bitmaps and fonts when the window closed, but their textures belonged to the old context
+  RestoreBitmapsAndFonts();
 }
 
 void IGraphicsNanoVG::OnViewDestroyed()
 {
-  // need to remove all the controls to free framebuffers, before deleting context
-  RemoveAllControls();
+  // need to remove all the controls (or the layers of a persistent graphics context) to free framebuffers, before deleting context
+  ReleaseViewResources();
 
   StaticStorage<APIBitmap>::Accessor storage(mBitmapCache);
-  storage.Clear();
+
+  if (GetPersistent())
+    storage.ForEach([](APIBitmap* pBitmap) { static_cast<Bitmap*>(pBitmap)->ReleaseTexture(); });
+  else
+  {
+    storage.Clear();
+    mFontIDs.clear();
+  }
   
   if(mMainFrameBuffer != nullptr)
     nvgDeleteFramebuffer(mMainFrameBuffer);
@@ -477,6 +626,31 @@ void IGraphicsNanoVG::OnViewDestroyed()
   mVG = nullptr;
 }
 
+void IGraphicsNanoVG::RestoreBitmapsAndFonts()
+{
+  ScopedGLContext scopedGLCtx {this};
+
+  StaticStorage<APIBitmap>::Accessor bitmapStorage(mBitmapCache);
+
+  bitmapStorage.ForEach([this](APIBitmap* pAPIBitmap) {
+    Bitmap* pBitmap = static_cast<Bitmap*>(pAPIBitmap);
+
+    // A bitmap that can't be created again stays empty and draws nothing
+    if (int idx = pBitmap->CreateTextureFromSource(this, mVG))
+      pBitmap->RestoreTexture(mVG, idx);
+    else
+      DBGMSG("Could not restore a bitmap of size %i x %i\n", pBitmap->GetWidth(), pBitmap->GetHeight());
+  });
+
+  StaticStorage<IFontData>::Accessor fontStorage(sFontCache);
+
+  for (auto& fontID : mFontIDs)
+  {
+    if (IFontData* pData = fontStorage.Find(fontID.c_str()))
+      nvgCreateFontFaceMem(mVG, fontID.c_str(), pData->Get(), pData->GetSize(), pData->GetFaceIdx(), 0);
+  }
+}
+
 void IGraphicsNanoVG::DrawResize()
 {
   ScopedGLContext scopedGLCtx {this};
@@ -641,9 +815,17 @@ void IGraphicsNanoVG::PrepareAndMeasureText(const IText& text, const char* str,
   }
   
   nvgTextAlign(mVG, align);
-  nvgTextBounds(mVG, x, y, str, NULL, fbounds);
   
-  r = IRECT(fbounds[0], fbounds[1], fbounds[2], fbounds[3]);
+  // Bounds relative to the anchor point only depend on font, size, alignment and string
+  IRECT* pOffsets = mTextBoundsCache.Find(text.mFont, text.mSize, align, str);
+  
+  if (!pOffsets)
+  {
+    nvgTextBounds(mVG, 0.f, 0.f, str, NULL, fbounds);
+    pOffsets = &mTextBoundsCache.Add(text.mFont, text.mSize, align, str, IRECT(fbounds[0], fbounds[1], fbounds[2], fbounds[3]));
+  }
+  
+  r = pOffsets->GetTranslated((float) x, (float) y);
 }
 
 float IGraphicsNanoVG::DoMeasureText(const IText& text, const char* str, IRECT& bounds) const
@@ -746,6 +928,7 @@ bool IGraphicsNanoVG::LoadAPIFont(const char* fontID, const PlatformFontPtr& fon
   if (cached)
   {
     nvgCreateFontFaceMem(mVG, fontID, cached->Get(), cached->GetSize(), cached->GetFaceIdx(), 0);
+    AddFontID(fontID);
     return true;
   }
     
@@ -754,12 +937,19 @@ bool IGraphicsNanoVG::LoadAPIFont(const char* fontID, const PlatformFontPtr& fon
   if (data->IsValid() && nvgCreateFontFaceMem(mVG, fontID, data->Get(), data->GetSize(), data->GetFaceIdx(), 0) != -1)
   {
     storage.Add(data.release(), fontID);
+    AddFontID(fontID);
     return true;
   }
 
   return false;
 }
 
+void IGraphicsNanoVG::AddFontID(const char* fontID)
+{
+  if (std::find(mFontIDs.begin(), mFontIDs.end(), fontID) == mFontIDs.end())
+    mFontIDs.push_back(fontID);
+}
+
 void IGraphicsNanoVG::UpdateLayer()
 {
   if (mLayers.empty())
@@ -783,6 +973,17 @@ void IGraphicsNanoVG::UpdateLayer()
   }
 }
 
+void IGraphicsNanoVG::ClearLayer()
+{
+  // The layer's framebuffer is bound by UpdateLayer(), and nothing has been drawn to it yet
+#ifdef IGRAPHICS_METAL
+  mnvgClearWithColor(mVG, nvgRGBAf(0, 0, 0, 0));
+#else
+  glClearColor(0.f, 0.f, 0.f, 0.f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+#endif
+}
+
 void IGraphicsNanoVG::PathTransformSetMatrix(const IMatrix& m)
 {
   double xTranslate = 0.0;
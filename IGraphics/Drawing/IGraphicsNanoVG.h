@@ -16,6 +16,8 @@
 #include "nanovg.h"
 #include "mutex.h"
 #include <stack>
+#include <string>
+#include <vector>
 
 // Thanks to Olli Wang/MOUI for much of this macro magic  https://github.com/ollix/moui
 
@@ -119,8 +121,9 @@ public:
   void* GetDrawContext() override { return (void*) mVG; }
     
   IBitmap LoadBitmap(const char* name, int nStates, bool framesAreHorizontal, int targetScale) override;
-  void ReleaseBitmap(const IBitmap& bitmap) override { }; // NO-OP
-  void RetainBitmap(const IBitmap& bitmap, const char * cacheName) override { }; // NO-OP
+  IBitmap LoadBitmap(const char* name, const void* pData, int dataSize, int nStates, bool framesAreHorizontal, int targetScale) override;
+  void ReleaseBitmap(const IBitmap& bitmap) override;
+  void RetainBitmap(const IBitmap& bitmap, const char * cacheName) override;
   bool BitmapExtSupported(const char* ext) override;
 
   void DeleteFBO(NVGframebuffer* pBuffer);
@@ -154,12 +157,25 @@ private:
   void PathTransformSetMatrix(const IMatrix& m) override;
   void SetClipRegion(const IRECT& r) override;
   void UpdateLayer() override;
+  void ClearLayer() override;
   void ClearFBOStack();
+
+  /** Create a texture from a bitmap file or resource, in the current context
+   * @return The NanoVG image ID, or 0 on failure */
+  int CreateImage(const char* fileNameOrResID, EResourceLocation location, const char* ext);
+
+  /** Create the textures and fonts of a persistent graphics context again, after the window has opened with a new context */
+  void RestoreBitmapsAndFonts();
+
+  /** Remember a font that was loaded into the context, so that it can be loaded into a new context */
+  void AddFontID(const char* fontID);
   
   bool mInDraw = false;
   WDL_Mutex mFBOMutex;
   std::stack<NVGframebuffer*> mFBOStack; // A stack of FBOs that requires freeing at the end of the frame
-  StaticStorage<APIBitmap> mBitmapCache; //not actually static (doesn't require retaining or releasing)
+  StaticStorage<APIBitmap> mBitmapCache; // not actually static, since the textures belong to this context (retained bitmaps go here too)
+  std::vector<std::string> mFontIDs; // fonts loaded into the context
+  mutable TextLayoutCache<IRECT> mTextBoundsCache; // text bounds relative to the aligned anchor point
   NVGcontext* mVG = nullptr;
   NVGframebuffer* mMainFrameBuffer = nullptr;
   int mInitialFBO = 0;
@@ -63,7 +63,8 @@
     #pragma comment(lib, "skunicode_icu.lib")
   #endif
 
-
+#elif defined OS_LINUX
+  #include "include/ports/SkFontMgr_empty.h"
 #endif
 
 #if defined IGRAPHICS_GL
@@ -306,6 +307,9 @@ static sk_sp<SkFontMgr> SFontMgrFactory()
   return SkFontMgr_New_CoreText(nullptr);
 #elif defined OS_WIN
   return SkFontMgr_New_DirectWrite();
+#elif defined OS_LINUX
+  // No system fonts, so that offscreen rendering is the same on every machine
+  return SkFontMgr_New_Custom_Empty();
 #else
   #error "Not supported"
 #endif
@@ -445,7 +449,8 @@ void IGraphicsSkia::OnViewInitialized(void* pContext)
 
 void IGraphicsSkia::OnViewDestroyed()
 {
-  RemoveAllControls();
+  // Bitmaps and fonts are not linked to the GrContext, so a persistent graphics context keeps them
+  ReleaseViewResources();
 
 #if defined IGRAPHICS_GL
   mSurface = nullptr;
@@ -572,6 +577,8 @@ void IGraphicsSkia::EndFrame()
     StretchDIBits(hdc, 0, 0, w, h, 0, 0, w, h, bmpInfo->bmiColors, bmpInfo, DIB_RGB_COLORS, SRCCOPY);
     ReleaseDC(hWnd, hdc);
     EndPaint(hWnd, &ps);
+  #elif defined OS_LINUX
+    // Offscreen: nothing to present, the platform class reads mSurface back on demand
   #else
     #error NOT IMPLEMENTED
   #endif
@@ -671,7 +678,10 @@ bool IGraphicsSkia::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
   Font* cached = storage.Find(fontID);
   
   if (cached)
+  {
+    mFontHandles.Insert(fontID, cached);
     return true;
+  }
   
   IFontDataPtr data = font->GetFontData();
   
@@ -681,7 +691,9 @@ bool IGraphicsSkia::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
     auto typeFace = SkFontMgrRefDefault()->makeFromData(wrappedData);
     if (typeFace)
     {
-      storage.Add(new Font(std::move(data), typeFace), fontID);
+      Font* pFont = new Font(std::move(data), typeFace);
+      storage.Add(pFont, fontID);
+      mFontHandles.Insert(fontID, pFont);
       return true;
     }
   }
@@ -689,30 +701,58 @@ bool IGraphicsSkia::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
   return false;
 }
 
-void IGraphicsSkia::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y, SkFont& font) const
+IGraphicsSkia::Font* IGraphicsSkia::FindFont(const char* fontID) const
 {
-  SkFontMetrics metrics;
-  SkPaint paint;
-  //SkRect bounds;
+  // Fonts stay in sFontCache while this context retains it, so the handle can be used without locking
+  Font* pFont = mFontHandles.Get(fontID);
   
-  StaticStorage<Font>::Accessor storage(sFontCache);
-  Font* pFont = storage.Find(text.mFont);
+  if (!pFont)
+  {
+    // Loaded by another context
+    StaticStorage<Font>::Accessor storage(sFontCache);
+    pFont = storage.Find(fontID);
+    
+    if (pFont)
+      mFontHandles.Insert(fontID, pFont);
+  }
   
-  assert(pFont && "No font found - did you forget to load it?");
+  return pFont;
+}
 
-  font.setTypeface(pFont->mTypeface);
-  font.setHinting(SkFontHinting::kSlight);
-  font.setForceAutoHinting(false);
-  font.setSubpixel(true);
-  font.setSize(text.mSize * pFont->mData->GetHeightEMRatio());
+IGraphicsSkia::TextLayout& IGraphicsSkia::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const
+{
+  TextLayout* pLayout = mTextLayoutCache.Find(text.mFont, text.mSize, 0, str);
   
-  // Draw / measure
-  const double textWidth = font.measureText(str, strlen(str), SkTextEncoding::kUTF8, nullptr/* &bounds*/);
-  font.getMetrics(&metrics);
+  if (!pLayout)
+  {
+    Font* pFont = FindFont(text.mFont);
+    
+    assert(pFont && "No font found - did you forget to load it?");
+    
+    TextLayout layout;
+    SkFont& font = layout.mFont;
+    SkFontMetrics metrics;
+    
+    font.setEdging(SkFont::Edging::kSubpixelAntiAlias);
+    font.setTypeface(pFont->mTypeface);
+    font.setHinting(SkFontHinting::kSlight);
+    font.setForceAutoHinting(false);
+    font.setSubpixel(true);
+    font.setSize(text.mSize * pFont->mData->GetHeightEMRatio());
+    
+    // Measure
+    layout.mWidth = font.measureText(str, strlen(str), SkTextEncoding::kUTF8, nullptr);
+    font.getMetrics(&metrics);
+    layout.mAscender = metrics.fAscent;
+    layout.mDescender = metrics.fDescent;
+    
+    pLayout = &mTextLayoutCache.Add(text.mFont, text.mSize, 0, str, std::move(layout));
+  }
   
+  const double textWidth = pLayout->mWidth;
   const double textHeight = text.mSize;
-  const double ascender = metrics.fAscent;
-  const double descender = metrics.fDescent;
+  const double ascender = pLayout->mAscender;
+  const double descender = pLayout->mDescender;
   
   switch (text.mAlign)
   {
@@ -729,16 +769,15 @@ void IGraphicsSkia::PrepareAndMeasureText(const IText& text, const char* str, IR
   }
   
   r = IRECT((float) x, (float) y + ascender, (float) (x + textWidth), (float) (y + ascender + textHeight));
+  
+  return *pLayout;
 }
 
 float IGraphicsSkia::DoMeasureText(const IText& text, const char* str, IRECT& bounds) const
 {
-  SkFont font;
-  font.setEdging(SkFont::Edging::kSubpixelAntiAlias);
-
   IRECT r = bounds;
   double x, y;
-  PrepareAndMeasureText(text, str, bounds, x, y, font);
+  PrepareAndMeasureText(text, str, bounds, x, y);
   DoMeasureTextRotation(text, r, bounds);
   return bounds.W();
 }
@@ -747,17 +786,19 @@ void IGraphicsSkia::DoDrawText(const IText& text, const char* str, const IRECT&
 {
   IRECT measured = bounds;
   
-  SkFont font;
-  font.setEdging(SkFont::Edging::kSubpixelAntiAlias);
-
   double x, y;
 
-  PrepareAndMeasureText(text, str, measured, x, y, font);
+  TextLayout& layout = PrepareAndMeasureText(text, str, measured, x, y);
+  
+  if (!layout.mBlob)
+    layout.mBlob = SkTextBlob::MakeFromText(str, strlen(str), layout.mFont, SkTextEncoding::kUTF8);
+  
   PathTransformSave();
   DoTextRotation(text, bounds, measured);
   SkPaint paint;
   paint.setColor(SkiaColor(text.mFGColor, pBlend));
-  mCanvas->drawSimpleText(str, strlen(str), SkTextEncoding::kUTF8, x, y, font, paint);
+  if (layout.mBlob)
+    mCanvas->drawTextBlob(layout.mBlob, x, y, paint);
   PathTransformRestore();
 }
 
@@ -979,6 +1020,11 @@ void IGraphicsSkia::UpdateLayer()
   mCanvas = mLayers.empty() ? mSurface->getCanvas() : mLayers.top()->GetAPIBitmap()->GetBitmap()->mSurface->getCanvas();
 }
 
+void IGraphicsSkia::ClearLayer()
+{
+  mCanvas->clear(SK_ColorTRANSPARENT);
+}
+
 static size_t CalcRowBytes(int width)
 {
   width = ((width + 7) & (-8));
@@ -18,9 +18,13 @@
 #include "include/core/SkPath.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkImage.h"
+#include "include/core/SkFont.h"
+#include "include/core/SkTextBlob.h"
 #include "include/gpu/GrDirectContext.h"
 #pragma warning( pop )
 
+#include "assocarray.h"
+
 namespace skia::textlayout {
 class FontCollection;
 }
@@ -127,6 +131,7 @@ public:
   void ApplyShadowMask(ILayerPtr& layer, RawBitmapData& mask, const IShadow& shadow) override;
 
   void UpdateLayer() override;
+  void ClearLayer() override;
   
   void DrawMultiLineText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend) override;
 
@@ -139,8 +144,19 @@ protected:
 
   APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
   APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
-private:  
-  void PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y, SkFont& font) const;
+private:
+  /** A measured (and once drawn, shaped) string, cached per graphics context */
+  struct TextLayout
+  {
+    SkFont mFont;
+    double mWidth = 0.;
+    double mAscender = 0.;
+    double mDescender = 0.;
+    sk_sp<SkTextBlob> mBlob; // created the first time the string is drawn
+  };
+
+  TextLayout& PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const;
+  Font* FindFont(const char* fontID) const;
 
   void PathTransformSetMatrix(const IMatrix& m) override;
   void SetClipRegion(const IRECT& r) override;
@@ -175,6 +191,9 @@ private:
 #endif
 
   static StaticStorage<Font> sFontCache;
+
+  mutable WDL_StringKeyedArray<Font*> mFontHandles; // this context's view of sFontCache, looked up without the mutex
+  mutable TextLayoutCache<TextLayout> mTextLayoutCache;
 };
 
 END_IGRAPHICS_NAMESPACE
@@ -1032,6 +1032,7 @@ void IDirBrowseControlBase::AddPath(const char* path, const char* label)
 
   mPaths.Add(new WDL_String(path));
   mPathLabels.Add(new WDL_String(label));
+  mIndex.AddRoot(path);
 }
 
 void IDirBrowseControlBase::CollectSortedItems(IPopupMenu* pMenu)
@@ -1051,41 +1052,80 @@ void IDirBrowseControlBase::CollectSortedItems(IPopupMenu* pMenu)
 
 void IDirBrowseControlBase::SetupMenu()
 {
+  if (mIndex.IsRunning())
+    mIndex.Rescan();
+  else
+    mIndex.Start();
+
+  BuildMenu();
+}
+
+void IDirBrowseControlBase::BuildMenu()
+{
+  WDL_String selectedFile;
+  GetSelectedFile(selectedFile);
+
   mFiles.Empty(true);
   mItems.Empty(false);
   
   mMainMenu.Clear();
   mSelectedItemIndex = -1;
+  mMenuVersion = mIndex.GetVersion();
 
-  int idx = 0;
+  mIndex.Read([&](const IFileIndex& index) {
+    int idx = 0;
 
-  if (mPaths.GetSize() == 1)
-  {
-    ScanDirectory(mPaths.Get(0)->Get(), mMainMenu);
-  }
-  else
-  {
-    for (int p = 0; p<mPaths.GetSize(); p++)
+    if (mPaths.GetSize() == 1)
     {
-      IPopupMenu* pNewMenu = new IPopupMenu();
-      mMainMenu.AddItem(mPathLabels.Get(p)->Get(), idx++, pNewMenu);
-      ScanDirectory(mPaths.Get(p)->Get(), *pNewMenu);
+      AddDirectoryToMenu(index, mPaths.Get(0)->Get(), mMainMenu);
     }
-  }
+    else
+    {
+      for (int p = 0; p<mPaths.GetSize(); p++)
+      {
+        IPopupMenu* pNewMenu = new IPopupMenu();
+        mMainMenu.AddItem(mPathLabels.Get(p)->Get(), idx++, pNewMenu);
+        AddDirectoryToMenu(index, mPaths.Get(p)->Get(), *pNewMenu);
+      }
+    }
+  });
   
   CollectSortedItems(&mMainMenu);
+
+  if (selectedFile.GetLength())
+    SetSelectedFile(selectedFile.Get());
+}
+
+void IDirBrowseControlBase::UpdateMenu()
+{
+  if (mIndex.GetVersion() != mMenuVersion)
+    BuildMenu();
+}
+
+bool IDirBrowseControlBase::IsDirty()
+{
+  // While scanning, the menu is only rebuilt when it is used, see UpdateMenu(), rather than each time the index changes
+  if (!mIndex.IsScanning() && !(GetUI() && GetUI()->PopupMenuIsOpen()))
+    UpdateMenu();
+
+  return IContainerBase::IsDirty();
 }
 
 void IDirBrowseControlBase::ClearPathList()
 {
+  mIndex.Stop();
+  mIndex.ClearRoots();
   mPaths.Empty(true);
   mPathLabels.Empty(true);
   mFiles.Empty(true);
   mItems.Empty(false);
+  mPendingSelection.Set("");
 }
 
 void IDirBrowseControlBase::SetSelectedFile(const char* filePath)
 {
+  mPendingSelection.Set("");
+
   for (auto fileIdx = 0; fileIdx < mFiles.GetSize(); fileIdx ++)
   {
     if (strcmp(mFiles.Get(fileIdx)->Get(), filePath) == 0)
@@ -1104,6 +1144,10 @@ void IDirBrowseControlBase::SetSelectedFile(const char* filePath)
   }
   
   mSelectedItemIndex = -1;
+
+  // The file may not have been found yet
+  if (mIndex.IsScanning())
+    mPendingSelection.Set(filePath);
 }
 
 void IDirBrowseControlBase::GetSelectedFile(WDL_String& path) const
@@ -1115,7 +1159,7 @@ void IDirBrowseControlBase::GetSelectedFile(WDL_String& path) const
   }
   else
   {
-    path.Set("");
+    path.Set(mPendingSelection.Get());
   }
 }
 
@@ -1128,64 +1172,37 @@ void IDirBrowseControlBase::CheckSelectedItem()
   }
 }
 
-void IDirBrowseControlBase::ScanDirectory(const char* path, IPopupMenu& menuToAddTo)
+void IDirBrowseControlBase::AddDirectoryToMenu(const IFileIndex& index, const std::string& path, IPopupMenu& menuToAddTo)
 {
-  WDL_DirScan d;
+  std::string dirPath(path);
+
+  while (dirPath.size() > 1 && (dirPath.back() == '/' || dirPath.back() == '\\'))
+    dirPath.pop_back();
+
+  const IFileIndexDir* pDir = index.FindDir(dirPath);
 
-  if (!d.First(path))
+  if (!pDir)
+    return;
+
+  for (const auto& subdir : pDir->mSubdirs)
   {
-    do
-    {
-      const char* f = d.GetCurrentFN();
-      if (f && f[0] != '.')
-      {
-        if (mScanRecursively && d.GetCurrentIsDirectory())
-        {
-          WDL_String subdir;
-          d.GetCurrentFullFN(&subdir);
-          IPopupMenu* pNewMenu = new IPopupMenu();
-          menuToAddTo.AddItem(d.GetCurrentFN(), pNewMenu, -2);
-          ScanDirectory(subdir.Get(), *pNewMenu);
-        }
-        else
-        {
-          // Find the last occurrence of str2 in str1.
-          // Return a pointer to the first character of the match.
-          // Return a pointer to the start of str1 if str2 is empty.
-          // Return a nullptr if str2 isn't found in str1.
-          auto strrstr = [](const char* str1, const char* str2) -> const char* {
-            if (*str2 == '\0')
-              return str1;
-
-            const char* result = nullptr;
-
-            while (*str1 != '\0') {
-              if (std::strncmp(str1, str2, std::strlen(str2)) == 0)
-                result = str1;
-
-              str1++;
-            }
-
-            return result;
-          };
-
-          const char* a = strrstr(f, mExtension.Get());
-          if (a && a > f && strlen(a) == strlen(mExtension.Get()))
-          {
-            WDL_String menuEntry {f};
-            
-            if (!mShowFileExtensions)
-              menuEntry.Set(f, (int) (a - f) - 1);
-            
-            IPopupMenu::Item* pItem = new IPopupMenu::Item(menuEntry.Get(), IPopupMenu::Item::kNoFlags, mFiles.GetSize());
-            menuToAddTo.AddItem(pItem, -2 /* sort alphabetically */);
-            WDL_String* pFullPath = new WDL_String("");
-            d.GetCurrentFullFN(pFullPath);
-            mFiles.Add(pFullPath);
-          }
-        }
-      }
-    } while (!d.Next());
+    IPopupMenu* pNewMenu = new IPopupMenu();
+    menuToAddTo.AddItem(subdir.c_str(), pNewMenu, -2);
+    AddDirectoryToMenu(index, dirPath + WDL_DIRCHAR_STR + subdir, *pNewMenu);
+  }
+
+  const int extLen = mExtension.GetLength();
+
+  for (const auto& file : pDir->mFiles)
+  {
+    WDL_String menuEntry {file.c_str()};
+
+    if (!mShowFileExtensions)
+      menuEntry.SetLen(static_cast<int>(file.size()) - extLen - 1);
+
+    IPopupMenu::Item* pItem = new IPopupMenu::Item(menuEntry.Get(), IPopupMenu::Item::kNoFlags, mFiles.GetSize());
+    menuToAddTo.AddItem(pItem, -2 /* sort alphabetically */);
+    mFiles.Add(new WDL_String((dirPath + WDL_DIRCHAR_STR + file).c_str()));
   }
 
   if (!mShowEmptySubmenus)
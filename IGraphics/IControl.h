@@ -33,6 +33,7 @@
 #include "ptrlist.h"
 
 #include "IGraphics.h"
+#include "IPlugFileIndex.h"
 
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
@@ -1898,8 +1899,9 @@ protected:
 
 /** An abstract IControl base class that you can inherit from in order to make a control that pops up a menu to browse files
  * Optionally with a specific extension. Add paths which will appear as subfolders at the root level menu.
- * If only one path is added there will be no submenu. When you call SetupMenu() the added paths are scanned and any
- * matching files in those paths are added to the menu.
+ * If only one path is added there will be no submenu. When you call SetupMenu() the added paths are indexed on a background thread
+ * by an IFileIndex and the menu is rebuilt from the index as directories are found, so the UI doesn't wait for large or slow folders.
+ * Set a cache file with SetIndexCachePath() to make the menu available straight away next time, while only the folders that changed are listed again.
  */
 class IDirBrowseControlBase : public IContainerBase
 {
@@ -1916,6 +1918,7 @@ public:
   , mShowFileExtensions(showFileExtensions)
   , mScanRecursively(scanRecursively)
   , mShowEmptySubmenus(showEmptySubmenus)
+  , mIndex(extension, scanRecursively)
   {
   }
 
@@ -1931,10 +1934,21 @@ public:
   /** Clear the menu */
   void ClearPathList();
 
-  /** Call after adding one or more paths, to populate the menu */
+  /** Call after adding one or more paths, to populate the menu. The menu is built from what has already been indexed (e.g. loaded from the cache file),
+   * and is rebuilt when the background scan has finished, or when UpdateMenu() is called during the scan */
   void SetupMenu();
+
+  /** Set a file to persist the index of the paths in, so that the menu can be built without scanning next time. Call before SetupMenu()
+   * @param path The full path to the cache file. Its folder must exist */
+  void SetIndexCachePath(const char* path) { mIndex.SetCachePath(path); }
+
+  /** @return \c true while the paths are being scanned in the background */
+  bool IsScanning() const { return mIndex.IsScanning(); }
+
+  /** @return The file index, e.g. to search it with IFileIndex::Search() */
+  IFileIndex& GetIndex() { return mIndex; }
   
-  /** Set the selected file based on a file path. Does nothing if the file has not been added */
+  /** Set the selected file based on a file path. If the file has not been added, it is selected once the background scan finds it */
   void SetSelectedFile(const char* filePath);
   
   /** Get the full path to the file if something has been selected in the menu */
@@ -1943,8 +1957,16 @@ public:
   /** Check the currently selected menu item. Does nothing if mSelectedItemIndex == -1 */
   void CheckSelectedItem();
 
+  /** Rebuild the menu if the index has changed since it was built. Call before opening the menu or using mItems, so that files found by a scan
+   * that is still running are listed */
+  void UpdateMenu();
+
+  /** Rebuilds the menu once the scan has finished, if the index has changed and the menu is not open */
+  bool IsDirty() override;
+
 private:
-  void ScanDirectory(const char* path, IPopupMenu& menuToAddTo);
+  void BuildMenu();
+  void AddDirectoryToMenu(const IFileIndex& index, const std::string& path, IPopupMenu& menuToAddTo);
   void CollectSortedItems(IPopupMenu* pMenu);
   
 protected:
@@ -1958,6 +1980,11 @@ protected:
   WDL_PtrList<WDL_String> mFiles;
   WDL_PtrList<IPopupMenu::Item> mItems; // ptr to item for each file
   WDL_String mExtension;
+
+private:
+  IFileIndex mIndex;
+  uint32_t mMenuVersion = 0; // version of mIndex that the menu was built from
+  WDL_String mPendingSelection; // a file passed to SetSelectedFile() that has not been indexed yet
 };
 
 /**@}*/
@@ -123,6 +123,29 @@ void IGraphics::SetLayoutOnResize(bool layoutOnResize)
   mLayoutOnResize = layoutOnResize;
 }
 
+void IGraphics::LayoutUIOnOpen()
+{
+  // A persistent graphics context that has been opened before already has its controls
+  if (!mPersistent || !NControls())
+    GetDelegate()->LayoutUI(this);
+}
+
+void IGraphics::ReleaseViewResources()
+{
+  if (!mPersistent)
+  {
+    RemoveAllControls();
+    return;
+  }
+
+  // The platform view, and any text entry or popup menu it showed, has gone
+  ReleaseMouseCapture();
+  ClearMouseOver();
+  ClearInTextEntryControl();
+  mInPopupMenu = nullptr;
+  mLayerPool.ReleaseAll();
+}
+
 void IGraphics::SetScaleConstraints(float lo, float hi)
 {
   mMinScale = std::min(lo, hi);
@@ -209,6 +232,9 @@ void IGraphics::RemoveAllControls()
   
   mCtrlTags.clear();
   mControls.Empty(true);
+
+  // Free the bitmaps that the controls' layers returned to the pool, which may be before the drawing context is destroyed
+  mLayerPool.Clear();
 }
 
 void IGraphics::SetControlPosition(IControl* pControl, float x, float y)
@@ -972,6 +998,7 @@ void IGraphics::Draw(IRECTList& rects)
       Draw(rects.Get(i), scale);
   }
   
+  mLayerPool.Trim();
   EndFrame();
 }
 
@@ -1999,7 +2026,18 @@ void IGraphics::StartLayer(IControl* pControl, const IRECT& r, bool cacheable)
   const int w = static_cast<int>(std::ceil(pixelBackingScale * std::ceil(alignedBounds.W())));
   const int h = static_cast<int>(std::ceil(pixelBackingScale * std::ceil(alignedBounds.H())));
 
-  PushLayer(new ILayer(CreateAPIBitmap(w, h, GetScreenScale(), GetDrawScale(), cacheable), alignedBounds, pControl, pControl ? pControl->GetRECT() : IRECT()));
+  APIBitmap* pBitmap = mLayerPool.Acquire(w, h, GetScreenScale(), GetDrawScale(), cacheable);
+  const bool reused = pBitmap != nullptr;
+
+  if (!reused)
+    pBitmap = CreateAPIBitmap(w, h, GetScreenScale(), GetDrawScale(), cacheable);
+
+  ILayer* pLayer = new ILayer(pBitmap, alignedBounds, pControl, pControl ? pControl->GetRECT() : IRECT());
+  mLayerPool.Add(*pLayer, cacheable);
+  PushLayer(pLayer);
+
+  if (reused)
+    ClearLayer();
 }
 
 void IGraphics::ResumeLayer(ILayerPtr& layer)
@@ -2057,11 +2095,15 @@ bool IGraphics::CheckLayer(const ILayerPtr& layer)
     layer->Invalidate();
   }
 
+  if (pBitmap)
+    mLayerPool.Touch(*layer);
+
   return pBitmap && !layer->mInvalid && pBitmap->GetDrawScale() == GetDrawScale() && pBitmap->GetScale() == GetScreenScale();
 }
 
 void IGraphics::DrawLayer(const ILayerPtr& layer, const IBlend* pBlend)
 {
+  mLayerPool.Touch(*layer);
   PathTransformSave();
   PathTransformReset();
   DrawBitmap(layer->GetBitmap(), layer->Bounds(), 0, 0, pBlend);
@@ -2070,6 +2112,7 @@ void IGraphics::DrawLayer(const ILayerPtr& layer, const IBlend* pBlend)
 
 void IGraphics::DrawFittedLayer(const ILayerPtr& layer, const IRECT& bounds, const IBlend* pBlend)
 {
+  mLayerPool.Touch(*layer);
   IBitmap bitmap = layer->GetBitmap();
   IRECT layerBounds = layer->Bounds();
   PathTransformSave();
@@ -2082,6 +2125,7 @@ void IGraphics::DrawFittedLayer(const ILayerPtr& layer, const IRECT& bounds, con
 
 void IGraphics::DrawRotatedLayer(const ILayerPtr& layer, double angle)
 {
+  mLayerPool.Touch(*layer);
   PathTransformSave();
   PathTransformReset();
   IBitmap bitmap = layer->GetBitmap();
@@ -2171,7 +2215,7 @@ void IGraphics::ApplyLayerDropShadow(ILayerPtr& layer, const IShadow& shadow)
   kernel.Resize(iSize);
         
   for (int i = 0; i < iSize; i++)
-    kernel.Get()[i] = static_cast<uint8_t>(std::round(255.f * std::expf(-(i * i) * blurConst)));
+    kernel.Get()[i] = static_cast<uint8_t>(std::round(255.f * std::exp(-(i * i) * blurConst)));
   
   // Kernel normalisation
   int normFactor = kernel.Get()[0];
@@ -2470,6 +2514,26 @@ void IGraphics::DrawData(const IColor& color, const IRECT& bounds, float* normYP
   if (nPoints == 0)
     return;
   
+  const int nColumns = static_cast<int>(std::ceil(bounds.W() * GetBackingPixelScale()));
+  
+  if (nColumns > 0 && nPoints > 4 * nColumns)
+  {
+    if (mDecimatedYPoints.size() < static_cast<size_t>(4 * nColumns))
+    {
+      mDecimatedYPoints.resize(4 * nColumns);
+      mDecimatedXPoints.resize(4 * nColumns);
+    }
+    
+    const int nDecimated = DecimateMinMax(normYPoints, normXPoints, nPoints, nColumns, mDecimatedYPoints.data(), mDecimatedXPoints.data());
+    
+    if (nDecimated > 0) // -1 if normXPoints doesn't ascend, which is drawn as is
+    {
+      nPoints = nDecimated;
+      normYPoints = mDecimatedYPoints.data();
+      normXPoints = mDecimatedXPoints.data();
+    }
+  }
+  
   PathClear();
   
   float xPos = bounds.L;
@@ -488,7 +488,8 @@ public:
    * @param thickness Optional line thickness */
   virtual void DrawGrid(const IColor& color, const IRECT& bounds, float gridSizeH, float gridSizeV, const IBlend* pBlend = 0, float thickness = 1.f);
 
-  /** Draw a line between a collection of normalized points
+  /** Draw a line between a collection of normalized points. If there are more points than the line can show at the
+   * current backing pixel width, and normXPoints is nullptr or ascending, they are first reduced to the min/max envelope of each pixel column, see DecimateMinMax()
    * @param color The color to draw the line with
    * @param bounds The rectangular region to draw the line in
    * @param normYPoints Ptr to float array - the normalized Y positions of the points
@@ -561,6 +562,14 @@ public:
   * @param shadow - the shadow to add */
   virtual void ApplyLayerDropShadow(ILayerPtr& layer, const IShadow& shadow);
 
+  /** Set the memory that layer bitmaps can use. At the end of each frame, idle pooled bitmaps and then the bitmaps of the least recently drawn layers
+   * are freed until the total is within the budget. A layer that loses its bitmap fails CheckLayer(), so it is drawn again when it is next needed
+   * @param bytes The budget in bytes */
+  void SetLayerBudget(size_t bytes) { mLayerPool.SetBudget(bytes); }
+
+  /** @return Statistics for the pool of layer bitmaps, including the hit rate and the bytes in use */
+  const ILayerPoolStats& GetLayerPoolStats() const { return mLayerPool.GetStats(); }
+
   /** Get the contents of a layer as Raw RGBA bitmap data
    * NOTE: you should only call this within IControl::Draw()
    * @param layer The layer to get the data from
@@ -577,6 +586,9 @@ protected:
   /** Implemented by a graphics backend to prepare for drawing to the layer at the top of the stack */
   virtual void UpdateLayer() {}
 
+  /** Implemented by a graphics backend to clear the layer at the top of the stack to transparent, when StartLayer() reuses a pooled bitmap */
+  virtual void ClearLayer() {}
+
   /** Push a layer on to the stack.
    * @param pLayer The new layer */
   void PushLayer(ILayer* pLayer);
@@ -584,6 +596,13 @@ protected:
   /** Pop a layer off the stack.
    * @return ILayer* The layer that came off the stack */
   ILayer* PopLayer();
+
+  /** Called by the platform classes when the window opens, to call IGEditorDelegate::LayoutUI(), unless the controls were kept from the last time it was open */
+  void LayoutUIOnOpen();
+
+  /** Called by the graphics backends in OnViewDestroyed(), before they destroy their drawing context. Removes all of the controls,
+   * unless the graphics context is persistent, in which case the controls are kept and only the bitmaps of their layers are freed */
+  void ReleaseViewResources();
   
 #pragma mark - Drawing API path support
 public:
@@ -1092,6 +1111,14 @@ public:
   /* Enables layout on resize. This means IGEditorDelegate:LayoutUI() will be called when the GUI is resized */
   void SetLayoutOnResize(bool layoutOnResize);
 
+  /** Keep the controls, loaded bitmaps and fonts and the layout when the window is closed, so that when it opens again only the platform view and drawing context
+   * are created and IGEditorDelegate::LayoutUI() is not called. Layers are freed with the drawing context and drawn again. See IGEditorDelegate::SetPersistentGraphics()
+   * @param persistent Set \c true to keep the controls when the window is closed */
+  void SetPersistent(bool persistent) { mPersistent = persistent; }
+
+  /** @return \c true if the controls are kept when the window is closed, see SetPersistent() */
+  bool GetPersistent() const { return mPersistent; }
+
   /** Gets the width of the graphics context
    * @return A whole number representing the width of the graphics context in pixels on a 1:1 screen */
   int Width() const { return mWidth; }
@@ -1431,6 +1458,9 @@ public:
   /* Get the first control in the control list, the background */
   IControl* GetBackgroundControl() { return GetControl(0);  }
   
+  /** @return \c true if a pop-up menu is open, so that the IPopupMenu it was created from must not be changed */
+  bool PopupMenuIsOpen() const { return mInPopupMenu != nullptr; }
+
   /** @return Pointer to the special pop-up menu control, if one has been attached */
   IPopupMenuControl* GetPopupMenuControl() { return mPopupControl.get(); }
   
@@ -1817,6 +1847,9 @@ private:
   
   IPopupMenu mPromptPopupMenu;
   
+  std::vector<float> mDecimatedYPoints; // scratch space for DrawData()
+  std::vector<float> mDecimatedXPoints;
+  
   IRECT mPerfDisplayBounds;
   
   WDL_String mSharedResourcesSubPath;
@@ -1854,6 +1887,7 @@ private:
   bool mShowAreaDrawn = false;
   bool mResizingInProcess = false;
   bool mLayoutOnResize = false;
+  bool mPersistent = false;
   bool mEnableMultiTouch = false;
   EUIResizerMode mGUISizeMode = EUIResizerMode::Scale;
   double mPrevTimestamp = 0.;
@@ -1876,6 +1910,7 @@ protected:
   friend class ITextEntryControl;
   
   std::stack<ILayer*> mLayers;
+  ILayerPool mLayerPool;
 
   IRECT mClipRECT;
   IMatrix mTransform;
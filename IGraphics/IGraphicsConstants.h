@@ -37,6 +37,11 @@ static constexpr int MAX_IMG_SCALE = 3;
 static constexpr int DEFAULT_TEXT_ENTRY_LEN = 7;
 static constexpr double DEFAULT_GEARING = 4.0;
 
+// The memory that layer bitmaps can use before the least recently used are freed, see IGraphics::SetLayerBudget()
+#ifndef DEFAULT_LAYER_BUDGET
+static constexpr size_t DEFAULT_LAYER_BUDGET = 128 * 1024 * 1024;
+#endif
+
 static constexpr double DEFAULT_MIN_DRAW_SCALE = 0.5;
 static constexpr double DEFAULT_MAX_DRAW_SCALE = 4.0;
 
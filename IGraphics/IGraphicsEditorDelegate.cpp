@@ -32,9 +32,26 @@ void* IGEditorDelegate::OpenWindow(void* pParent)
     if (mLastWidth && mLastHeight && mLastScale)
       GetUI()->Resize(mLastWidth, mLastHeight, mLastScale);
   }
+  else
+  {
+    // A persistent graphics context may have missed parameter changes while it was closed
+    for (int c = 0; c < mGraphics->NControls(); c++)
+    {
+      IControl* pControl = mGraphics->GetControl(c);
+
+      for (int v = 0; v < pControl->NVals(); v++)
+      {
+        if (const IParam* pParam = pControl->GetParam(v))
+          pControl->SetValueFromDelegate(pParam->GetNormalized(), v);
+      }
+    }
+  }
   
   if(mGraphics)
+  {
+    mGraphics->SetPersistent(mPersistentGraphics);
     return mGraphics->OpenWindow(pParent);
+  }
   else
     return nullptr;
 }
@@ -52,13 +69,28 @@ void IGEditorDelegate::CloseWindow()
       mLastHeight = mGraphics->Height();
       mLastScale = mGraphics->GetDrawScale();
       mGraphics->CloseWindow();
-      mGraphics = nullptr;
+
+      if (!mPersistentGraphics)
+        mGraphics = nullptr;
     }
     
     mClosing = false;
   }
 }
 
+void IGEditorDelegate::SetPersistentGraphics(bool persistent)
+{
+  mPersistentGraphics = persistent;
+
+  if (mGraphics)
+  {
+    if (mGraphics->WindowIsOpen())
+      mGraphics->SetPersistent(persistent);
+    else if (!persistent)
+      mGraphics = nullptr;
+  }
+}
+
 void IGEditorDelegate::OnParentWindowResize(int width, int height)
 {
   if (auto* pGraphics = GetUI()) 
@@ -73,6 +73,16 @@ public:
       mLayoutFunc(pGraphics);
   }
   
+  /** Keep the IGraphics context when the editor is closed, with its controls, loaded bitmaps and fonts and layout, so that opening the editor again
+   * only creates the platform view and drawing context and doesn't call LayoutUI(). This makes opening the editor much faster, at the cost of the memory that
+   * the IGraphics context uses while it is closed. GetUI() stays valid while the editor is closed, use IGraphics::WindowIsOpen() to check if it is open.
+   * Switching this off while the editor is closed frees the IGraphics context
+   * @param persistent Set \c true to keep the IGraphics context when the editor is closed */
+  void SetPersistentGraphics(bool persistent);
+
+  /** @return \c true if the IGraphics context is kept when the editor is closed, see SetPersistentGraphics() */
+  bool GetPersistentGraphics() const { return mPersistentGraphics; }
+
   /** Get a pointer to the IGraphics context */
   IGraphics* GetUI() { return mGraphics.get(); };
 
@@ -99,6 +109,7 @@ private:
   int mLastHeight = 0;
   float mLastScale = 0.f;
   bool mClosing = false; // used to prevent re-entrancy on closing
+  bool mPersistentGraphics = false;
 };
 
 END_IGRAPHICS_NAMESPACE
@@ -18,6 +18,8 @@
 #include <codecvt>
 #include <string>
 #include <memory>
+#include <list>
+#include <unordered_map>
 
 #include "mutex.h"
 #include "wdlstring.h"
@@ -73,7 +75,7 @@
 #elif defined OS_WIN
   #include "wingdi.h"
   #define FONT_DESCRIPTOR_TYPE HFONT
-#elif defined OS_WEB
+#elif defined OS_WEB || defined OS_LINUX
   #define FONT_DESCRIPTOR_TYPE std::pair<WDL_String, WDL_String>*
 #else 
   // NO_IGRAPHICS
@@ -508,6 +510,7 @@ public:
     void Clear()                                              { return mStorage.Clear(); }
     void Retain()                                             { return mStorage.Retain(); }
     void Release()                                            { return mStorage.Release(); }
+    template <class F> void ForEach(F func)                   { return mStorage.ForEach(func); }
       
   private:
     StaticStorage& mStorage;
@@ -604,6 +607,15 @@ private:
     mDatas.Empty(true);
   };
 
+  /** Call a function for each item in the storage
+   * @param func A function that takes a T* */
+  template <class F>
+  void ForEach(F func)
+  {
+    for (int i = 0; i < mDatas.GetSize(); ++i)
+      func(mDatas.Get(i)->data.get());
+  }
+
   /** \todo  */
   void Retain()
   {
@@ -622,6 +634,113 @@ private:
   WDL_PtrList<DataKey> mDatas;
 };
 
+/** Used internally by the drawing backends to cache text measurements (and any shaped glyph data) per graphics context.
+ * Entries are keyed on font, size, alignment and string, and the least recently used entry is evicted when full.
+ * Not thread safe, only use it from the thread that draws */
+template <class T>
+class TextLayoutCache
+{
+public:
+  TextLayoutCache(size_t capacity = 256)
+  : mCapacity(capacity)
+  {}
+
+  TextLayoutCache(const TextLayoutCache&) = delete;
+  TextLayoutCache& operator=(const TextLayoutCache&) = delete;
+
+  /** Find a cached entry, marking it as most recently used
+   * @param font The font identifier
+   * @param size The font size
+   * @param align Any alignment flags the cached data depends on
+   * @param str The string
+   * @return Pointer to the cached entry, or nullptr if not found */
+  T* Find(const char* font, float size, int align, const char* str)
+  {
+    // Reuse the lookup key's string storage so that lookups don't allocate
+    mLookupKey.font.assign(font);
+    mLookupKey.str.assign(str);
+    mLookupKey.size = size;
+    mLookupKey.align = align;
+
+    auto it = mMap.find(mLookupKey);
+
+    if (it == mMap.end())
+      return nullptr;
+
+    mItems.splice(mItems.begin(), mItems, it->second);
+    return &it->second->second;
+  }
+
+  /** Add an entry, evicting the least recently used entry if the cache is full
+   * @return A reference to the cached copy of value */
+  T& Add(const char* font, float size, int align, const char* str, T&& value)
+  {
+    Key key {font, str, size, align};
+
+    auto it = mMap.find(key);
+
+    if (it != mMap.end())
+    {
+      it->second->second = std::move(value);
+      mItems.splice(mItems.begin(), mItems, it->second);
+      return it->second->second;
+    }
+
+    if (mItems.size() >= mCapacity)
+    {
+      mMap.erase(mItems.back().first);
+      mItems.pop_back();
+    }
+
+    mItems.emplace_front(std::move(key), std::move(value));
+    mMap[mItems.front().first] = mItems.begin();
+    return mItems.front().second;
+  }
+
+  /** Remove all entries */
+  void Clear()
+  {
+    mMap.clear();
+    mItems.clear();
+  }
+
+  /** @return The number of cached entries */
+  size_t Size() const { return mItems.size(); }
+
+private:
+  struct Key
+  {
+    std::string font;
+    std::string str;
+    float size;
+    int align;
+
+    bool operator==(const Key& other) const
+    {
+      return size == other.size && align == other.align && str == other.str && font == other.font;
+    }
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      size_t hash = std::hash<std::string>()(key.str);
+      hash ^= std::hash<std::string>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      hash ^= std::hash<float>()(key.size) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      hash ^= std::hash<int>()(key.align) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      return hash;
+    }
+  };
+
+  using ItemList = std::list<std::pair<Key, T>>;
+
+  size_t mCapacity;
+  Key mLookupKey;
+  ItemList mItems;
+  std::unordered_map<Key, typename ItemList::iterator, KeyHash> mMap;
+};
+
 /** Encapsulate an xy point in one struct */
 struct IVec2
 {
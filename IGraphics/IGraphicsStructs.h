@@ -18,7 +18,9 @@
 
 #include <functional>
 #include <chrono>
+#include <map>
 #include <numeric>
+#include <tuple>
 
 #include "IPlugUtilities.h"
 #include "IPlugLogger.h"
@@ -33,6 +35,7 @@ BEGIN_IGRAPHICS_NAMESPACE
 
 class IGraphics;
 class IControl;
+class ILayerPool;
 class ILambdaControl;
 class IPopupMenu;
 struct IRECT;
@@ -462,7 +465,7 @@ struct IColor
     };
 
     IColor col;
-    h = std::fmodf(h, 1.0f);
+    h = std::fmod(h, 1.0f);
     if (h < 0.0f) h += 1.0f;
     s = Clip(s, 0.0f, 1.0f);
     l = Clip(l, 0.0f, 1.0f);
@@ -2328,6 +2331,7 @@ struct IPattern
 class ILayer
 {
   friend IGraphics;
+  friend ILayerPool;
   
 public:
   /** Create a layer/offscreen context (used internally)
@@ -2345,6 +2349,9 @@ public:
 
   ILayer(const ILayer&) = delete;
   ILayer operator=(const ILayer&) = delete;
+
+  /** If the layer was created by IGraphics::StartLayer(), its bitmap goes back to the layer pool to be reused */
+  ~ILayer();
   
   /** Mark the layer as needing its contents redrawn  */
   void Invalidate() { mInvalid = true; }
@@ -2364,11 +2371,225 @@ private:
   IRECT mControlRECT;
   IRECT mRECT;
   bool mInvalid;
+  ILayerPool* mPool = nullptr;
+  bool mCacheable = false;
+  size_t mBytes = 0;
+  uint64_t mLastUsed = 0;
 };
 
 /** ILayerPtr is a managed pointer for transferring the ownership of layers */
 using ILayerPtr = std::unique_ptr<ILayer>;
 
+/** Statistics for the pool of layer bitmaps, see IGraphics::GetLayerPoolStats() */
+struct ILayerPoolStats
+{
+  int64_t mHits = 0; // Layers started with a pooled bitmap
+  int64_t mMisses = 0; // Layers started with a new bitmap
+  int64_t mEvictions = 0; // Layers whose bitmaps were freed to stay within the budget
+  size_t mBytesInUse = 0; // Bitmaps that belong to layers
+  size_t mBytesPooled = 0; // Idle bitmaps, waiting to be reused
+  size_t mBudget = DEFAULT_LAYER_BUDGET;
+
+  /** @return The proportion of layers that were started with a pooled bitmap */
+  float GetHitRate() const
+  {
+    const int64_t n = mHits + mMisses;
+    return n ? static_cast<float>(mHits) / static_cast<float>(n) : 0.f;
+  }
+};
+
+/** Reuses the bitmaps of layers, and keeps the memory used by layers within a budget (used internally by IGraphics).
+ * When a layer that was created with IGraphics::StartLayer() is destroyed, its bitmap becomes idle, and the next layer of exactly the same size,
+ * scale and cacheability reuses it, rather than allocating a new surface or framebuffer.
+ * Trim() frees idle bitmaps, oldest first, then the bitmaps of the least recently drawn cacheable layers, until the total is within the budget.
+ * A layer that has lost its bitmap fails IGraphics::CheckLayer(), so its control draws it again when it is next drawn.
+ * Layers that were not started as cacheable keep their bitmaps. */
+class ILayerPool
+{
+public:
+  ILayerPool() = default;
+  ILayerPool(const ILayerPool&) = delete;
+  ILayerPool& operator=(const ILayerPool&) = delete;
+
+  ~ILayerPool()
+  {
+    Clear();
+
+    for (auto pLayer : mLayers)
+      pLayer->mPool = nullptr;
+  }
+
+  /** Take an idle bitmap
+   * @return The bitmap, or \c nullptr if there is no idle bitmap of this size, in which case the caller should create one */
+  APIBitmap* Acquire(int width, int height, float scale, float drawScale, bool cacheable)
+  {
+    auto it = mIdle.find(Key { width, height, scale, drawScale, cacheable });
+
+    if (it != mIdle.end() && !it->second.empty())
+    {
+      APIBitmap* pBitmap = it->second.back().mBitmap;
+      it->second.pop_back();
+      mStats.mBytesPooled -= GetBytes(pBitmap);
+      mStats.mHits++;
+      return pBitmap;
+    }
+
+    mStats.mMisses++;
+    return nullptr;
+  }
+
+  /** Track a layer, so that its bitmap comes back to the pool when it is destroyed */
+  void Add(ILayer& layer, bool cacheable)
+  {
+    layer.mPool = this;
+    layer.mCacheable = cacheable;
+    layer.mBytes = GetBytes(layer.mBitmap.get());
+    layer.mLastUsed = ++mTick;
+    mStats.mBytesInUse += layer.mBytes;
+    mLayers.push_back(&layer);
+  }
+
+  /** Mark a layer as recently used, so that it is evicted last */
+  void Touch(ILayer& layer)
+  {
+    layer.mLastUsed = ++mTick;
+  }
+
+  /** Called when a tracked layer is destroyed */
+  void Release(ILayer& layer)
+  {
+    auto it = std::find(mLayers.begin(), mLayers.end(), &layer);
+
+    if (it != mLayers.end())
+    {
+      *it = mLayers.back();
+      mLayers.pop_back();
+    }
+
+    mStats.mBytesInUse -= layer.mBytes;
+
+    if (layer.mBitmap)
+    {
+      const APIBitmap* pBitmap = layer.mBitmap.get();
+      mIdle[Key { pBitmap->GetWidth(), pBitmap->GetHeight(), pBitmap->GetScale(), pBitmap->GetDrawScale(), layer.mCacheable }].push_back({ layer.mBitmap.release(), ++mTick });
+      mStats.mBytesPooled += layer.mBytes;
+    }
+
+    layer.mPool = nullptr;
+    layer.mBytes = 0;
+  }
+
+  /** Free bitmaps until the total is within the budget. This should not be called while layers are being drawn */
+  void Trim()
+  {
+    while (mStats.mBytesPooled && mStats.mBytesInUse + mStats.mBytesPooled > mStats.mBudget)
+    {
+      auto oldest = mIdle.end();
+
+      for (auto it = mIdle.begin(); it != mIdle.end(); ++it)
+      {
+        if (!it->second.empty() && (oldest == mIdle.end() || it->second.front().mTick < oldest->second.front().mTick))
+          oldest = it;
+      }
+
+      auto& bucket = oldest->second;
+      mStats.mBytesPooled -= GetBytes(bucket.front().mBitmap);
+      delete bucket.front().mBitmap;
+      bucket.erase(bucket.begin());
+
+      if (bucket.empty())
+        mIdle.erase(oldest);
+    }
+
+    if (mStats.mBytesInUse <= mStats.mBudget)
+      return;
+
+    std::vector<ILayer*> layers(mLayers);
+    std::sort(layers.begin(), layers.end(), [](const ILayer* a, const ILayer* b) { return a->mLastUsed < b->mLastUsed; });
+
+    for (auto pLayer : layers)
+    {
+      if (mStats.mBytesInUse <= mStats.mBudget)
+        break;
+
+      if (pLayer->mCacheable && pLayer->mBitmap)
+      {
+        pLayer->mBitmap = nullptr;
+        mStats.mBytesInUse -= pLayer->mBytes;
+        pLayer->mBytes = 0;
+        mStats.mEvictions++;
+      }
+    }
+  }
+
+  /** Free all of the idle bitmaps */
+  void Clear()
+  {
+    for (auto& bucket : mIdle)
+    {
+      for (auto& idle : bucket.second)
+        delete idle.mBitmap;
+    }
+
+    mIdle.clear();
+    mStats.mBytesPooled = 0;
+  }
+
+  /** Free all of the bitmaps, idle or in use, before the drawing context that they belong to is destroyed.
+   * The layers are kept, and fail IGraphics::CheckLayer() so that their controls draw them again */
+  void ReleaseAll()
+  {
+    Clear();
+
+    for (auto pLayer : mLayers)
+    {
+      pLayer->mBitmap = nullptr;
+      pLayer->mBytes = 0;
+    }
+
+    mStats.mBytesInUse = 0;
+  }
+
+  void SetBudget(size_t bytes) { mStats.mBudget = bytes; }
+
+  const ILayerPoolStats& GetStats() const { return mStats; }
+
+private:
+  struct Key
+  {
+    int mWidth, mHeight;
+    float mScale, mDrawScale;
+    bool mCacheable;
+
+    bool operator<(const Key& other) const
+    {
+      return std::tie(mWidth, mHeight, mScale, mDrawScale, mCacheable) < std::tie(other.mWidth, other.mHeight, other.mScale, other.mDrawScale, other.mCacheable);
+    }
+  };
+
+  struct IdleBitmap
+  {
+    APIBitmap* mBitmap;
+    uint64_t mTick; // When it became idle
+  };
+
+  static size_t GetBytes(const APIBitmap* pBitmap)
+  {
+    return pBitmap ? static_cast<size_t>(pBitmap->GetWidth()) * static_cast<size_t>(pBitmap->GetHeight()) * 4 : 0;
+  }
+
+  std::map<Key, std::vector<IdleBitmap>> mIdle; // Buckets of idle bitmaps, each oldest first
+  std::vector<ILayer*> mLayers; // Layers that have been added and not yet destroyed
+  ILayerPoolStats mStats;
+  uint64_t mTick = 0;
+};
+
+inline ILayer::~ILayer()
+{
+  if (mPool)
+    mPool->Release(*this);
+}
+
 /** Used to specify properties of a drop-shadow to a layer. Use with IGraphics::ApplyLayerDropShadow() */
 struct IShadow
 {
@@ -13,6 +13,7 @@
 #include "IGraphicsConstants.h"
 
 #include <cmath>
+#include <algorithm>
 
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
@@ -79,6 +80,77 @@ static float GetLineCrossing(IVec2 p0, IVec2 p1, IVec2 p2, IVec2 p3)
   return -(d.x * b.y - d.y * b.x) / m;
 }
 
+/** Reduce a polyline to at most four points per pixel column (first, min, max and last, in their original order),
+ * which rasterizes identically to the full line at that width, but is much cheaper to tessellate.
+ * Only lines whose x positions ascend can be reduced this way, a line that goes back to an earlier column (e.g. an XY scope) is not decimated.
+ * NOTE: outYPoints and outXPoints must have room for 4 * nColumns points
+ * @param yPoints The y values of the points
+ * @param xPoints Optional normalized x positions of the points, if nullptr the points are evenly spaced
+ * @param nPoints The number of points in yPoints / xPoints
+ * @param nColumns The number of pixel columns the line will be drawn across
+ * @param outYPoints The decimated y values
+ * @param outXPoints The normalized x positions of the decimated points
+ * @return The number of points written to outYPoints / outXPoints, or -1 if the x positions don't ascend, in which case the line should be drawn as is */
+static inline int DecimateMinMax(const float* yPoints, const float* xPoints, int nPoints, int nColumns, float* outYPoints, float* outXPoints)
+{
+  const int maxOut = 4 * nColumns;
+  int nOut = 0;
+  int first = 0, last = 0, lo = 0, hi = 0;
+  int column = -1;
+  const float xStep = nPoints > 1 ? 1.f / static_cast<float>(nPoints - 1) : 0.f;
+
+  auto getX = [&](int i) {
+    return xPoints ? xPoints[i] : static_cast<float>(i) * xStep;
+  };
+
+  auto flush = [&]() {
+    int idx[4] = {first, std::min(lo, hi), std::max(lo, hi), last};
+    int prev = -1;
+
+    for (auto i : idx)
+    {
+      if (i != prev && nOut < maxOut)
+      {
+        outYPoints[nOut] = yPoints[i];
+        outXPoints[nOut] = getX(i);
+        nOut++;
+        prev = i;
+      }
+    }
+  };
+
+  for (auto i = 0; i < nPoints; i++)
+  {
+    const int c = std::min(std::max(static_cast<int>(getX(i) * nColumns), 0), nColumns - 1);
+
+    if (c < column)
+      return -1;
+
+    if (c != column)
+    {
+      if (column >= 0)
+        flush();
+
+      column = c;
+      first = last = lo = hi = i;
+    }
+    else
+    {
+      last = i;
+
+      if (yPoints[i] < yPoints[lo])
+        lo = i;
+      else if (yPoints[i] > yPoints[hi])
+        hi = i;
+    }
+  }
+
+  if (column >= 0)
+    flush();
+
+  return nOut;
+}
+
 END_IGRAPHICS_NAMESPACE
 END_IPLUG_NAMESPACE
 
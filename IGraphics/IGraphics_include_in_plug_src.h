@@ -72,6 +72,11 @@
     gGraphics = new IGraphicsWeb(dlg, w, h, fps, scale);
     return gGraphics;
   }
+  #elif defined OS_LINUX
+  IGraphics* MakeGraphics(IGEditorDelegate& dlg, int w, int h, int fps = 0, float scale = 1.)
+  {
+    return new IGraphicsLinux(dlg, w, h, fps, scale);
+  }
   #else
     #error "No OS defined!"
   #endif
@@ -8,4 +8,253 @@
  ==============================================================================
 */
 
-/\todo
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+#include "IGraphicsLinux.h"
+
+#include "include/core/SkPixmap.h"
+#include "include/core/SkStream.h"
+#include "include/encode/SkPngEncoder.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+#pragma mark - Private Classes and Structs
+
+class IGraphicsLinux::Font : public PlatformFont
+{
+public:
+  Font(const char* fontName, const char* fontStyle)
+  : PlatformFont(true), mDescriptor{fontName, fontStyle}
+  {}
+
+  FontDescriptor GetDescriptor() override { return &mDescriptor; }
+
+private:
+  std::pair<WDL_String, WDL_String> mDescriptor;
+};
+
+class IGraphicsLinux::FileFont : public Font
+{
+public:
+  FileFont(const char* fontName, const char* fontStyle, const char* fontPath)
+  : Font(fontName, fontStyle), mPath(fontPath)
+  {
+    mSystem = false;
+  }
+
+  IFontDataPtr GetFontData() override;
+
+private:
+  WDL_String mPath;
+};
+
+IFontDataPtr IGraphicsLinux::FileFont::GetFontData()
+{
+  IFontDataPtr fontData(new IFontData());
+  FILE* fp = fopen(mPath.Get(), "rb");
+
+  if (!fp)
+    return fontData;
+
+  fseek(fp, 0, SEEK_END);
+  fontData = std::make_unique<IFontData>((int) ftell(fp));
+
+  if (fontData->GetSize())
+  {
+    fseek(fp, 0, SEEK_SET);
+    size_t readSize = fread(fontData->Get(), 1, fontData->GetSize(), fp);
+
+    if (readSize && readSize == fontData->GetSize())
+      fontData->SetFaceIdx(0);
+  }
+
+  fclose(fp);
+  return fontData;
+}
+
+class IGraphicsLinux::MemoryFont : public Font
+{
+public:
+  MemoryFont(const char* fontName, const char* fontStyle, const void* pData, int dataSize)
+  : Font(fontName, fontStyle)
+  {
+    mSystem = false;
+    mData.Set((const uint8_t*)pData, dataSize);
+  }
+
+  IFontDataPtr GetFontData() override
+  {
+    return IFontDataPtr(new IFontData(mData.Get(), mData.GetSize(), 0));
+  }
+
+private:
+  WDL_TypedBuf<uint8_t> mData;
+};
+
+#pragma mark -
+
+IGraphicsLinux::IGraphicsLinux(IGEditorDelegate& dlg, int w, int h, int fps, float scale)
+: IGRAPHICS_DRAW_CLASS(dlg, w, h, fps, scale)
+{
+}
+
+IGraphicsLinux::~IGraphicsLinux()
+{
+  CloseWindow();
+}
+
+void* IGraphicsLinux::OpenWindow(void* pParent)
+{
+  mWindowOpen = true;
+
+  OnViewInitialized(nullptr /* not used */);
+
+  SetScreenScale(1.f);
+
+  LayoutUIOnOpen();
+  GetDelegate()->OnUIOpen();
+
+  return GetWindow();
+}
+
+void IGraphicsLinux::CloseWindow()
+{
+  if (mWindowOpen)
+  {
+    OnViewDestroyed();
+    mWindowOpen = false;
+  }
+}
+
+bool IGraphicsLinux::RenderFrame(bool forceFullRedraw)
+{
+  if (!mWindowOpen)
+    return false;
+
+  if (forceFullRedraw)
+    SetAllControlsDirty();
+
+  IRECTList rects;
+
+  if (IsDirty(rects))
+  {
+    SetAllControlsClean();
+    Draw(rects);
+    return true;
+  }
+
+  return false;
+}
+
+bool IGraphicsLinux::GetSurfacePixels(RawBitmapData& data, int& width, int& height)
+{
+  SkCanvas* pCanvas = static_cast<SkCanvas*>(GetDrawContext());
+
+  if (!mWindowOpen || !pCanvas)
+    return false;
+
+  const SkISize size = pCanvas->getBaseLayerSize();
+  const SkImageInfo info = SkImageInfo::Make(size.width(), size.height(), kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+
+  width = size.width();
+  height = size.height();
+  data.Resize(static_cast<int>(info.computeMinByteSize()), false);
+
+  return pCanvas->readPixels(info, data.Get(), info.minRowBytes(), 0, 0);
+}
+
+bool IGraphicsLinux::SaveSurfacePNG(const char* path)
+{
+  RawBitmapData data;
+  int width, height;
+
+  if (!GetSurfacePixels(data, width, height))
+    return false;
+
+  SkFILEWStream stream(path);
+
+  if (!stream.isValid())
+    return false;
+
+  const SkImageInfo info = SkImageInfo::Make(width, height, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+  const SkPixmap pixmap(info, data.Get(), info.minRowBytes());
+
+  return SkPngEncoder::Encode(&stream, pixmap, {});
+}
+
+EMsgBoxResult IGraphicsLinux::ShowMessageBox(const char* str, const char* title, EMsgBoxType type, IMsgBoxCompletionHandlerFunc completionHandler)
+{
+  ReleaseMouseCapture();
+
+  DBGMSG("%s: %s\n", title ? title : "", str ? str : "");
+
+  // Nobody can answer, so behave as if the default (first) button was pressed
+  EMsgBoxResult result = kNoResult;
+
+  switch (type)
+  {
+    case kMB_OK:
+    case kMB_OKCANCEL: result = kOK; break;
+    case kMB_YESNO:
+    case kMB_YESNOCANCEL: result = kYES; break;
+    case kMB_RETRYCANCEL: result = kRETRY; break;
+    default: break;
+  }
+
+  if (completionHandler)
+    completionHandler(result);
+
+  return result;
+}
+
+void IGraphicsLinux::PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext, IFileDialogCompletionHandlerFunc completionHandler)
+{
+  // No file dialogs offscreen
+  fileName.Set("");
+}
+
+void IGraphicsLinux::PromptForDirectory(WDL_String& path, IFileDialogCompletionHandlerFunc completionHandler)
+{
+  path.Set("");
+}
+
+IPopupMenu* IGraphicsLinux::CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT bounds, bool& isAsync)
+{
+  // Use AttachPopupMenuControl() to get menus that can be drawn and tested offscreen
+  isAsync = false;
+  return nullptr;
+}
+
+PlatformFontPtr IGraphicsLinux::LoadPlatformFont(const char* fontID, const char* fileNameOrResID)
+{
+  WDL_String fullPath;
+  const EResourceLocation fontLocation = LocateResource(fileNameOrResID, "ttf", fullPath, GetBundleID(), nullptr, GetSharedResourcesSubPath());
+
+  if (fontLocation == kNotFound)
+    return nullptr;
+
+  return PlatformFontPtr(new FileFont(fontID, "", fullPath.Get()));
+}
+
+PlatformFontPtr IGraphicsLinux::LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style)
+{
+  // System fonts are deliberately not available, see the class documentation
+  DBGMSG("IGraphicsLinux: system font %s is not available, load it from a file or memory instead\n", fontName);
+  return nullptr;
+}
+
+PlatformFontPtr IGraphicsLinux::LoadPlatformFont(const char* fontID, void* pData, int dataSize)
+{
+  return PlatformFontPtr(new MemoryFont(fontID, "", pData, dataSize));
+}
+
+#ifndef NO_IGRAPHICS
+#if defined IGRAPHICS_SKIA
+  #include "IGraphicsSkia.cpp"
+#else
+  #error
+#endif
+#endif
@@ -10,49 +10,90 @@
 
 #pragma once
 
+#include "IPlugPlatform.h"
+
 #include "IGraphics_select.h"
 
+#if !defined IGRAPHICS_SKIA || !defined IGRAPHICS_CPU
+  #error IGraphicsLinux is an offscreen platform, it requires IGRAPHICS_SKIA and IGRAPHICS_CPU
+#endif
+
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
 
-/** IGraphics platform class for linux
+/** IGraphics platform class for linux.
+ * There is no window system integration yet: the UI is rendered with the Skia CPU raster backend into a memory surface,
+ * which makes it possible to run, profile and regression-test the whole draw pipeline on headless machines.
+ * "Opening the window" creates the surface, frames are rendered on demand with RenderFrame() and the result can be read
+ * back with GetSurfacePixels() or written to disk with SaveSurfacePNG().
+ * Only fonts loaded from files or memory are available, so that output does not depend on the fonts installed on the machine
 *   @ingroup PlatformClasses
 */
 class IGraphicsLinux final : public IGRAPHICS_DRAW_CLASS
 {
+  class Font;
+  class FileFont;
+  class MemoryFont;
 public:
   IGraphicsLinux(IGEditorDelegate& dlg, int w, int h, int fps, float scale);
-  virtual ~IGraphicsLinux);
+  ~IGraphicsLinux();
 
-  void* OpenWindow(void* pWindow) override;
+  void* OpenWindow(void* pParent) override;
   void CloseWindow() override;
-  bool WindowIsOpen() override;
-  void PlatformResize(bool parentHasResized) override;
+  void* GetWindow() override { return mWindowOpen ? this : nullptr; }
+  bool WindowIsOpen() override { return mWindowOpen; }
 
-  void HideMouseCursor() override;
-  void ShowMouseCursor() override;
+  void HideMouseCursor(bool hide, bool lock) override { mCursorHidden = hide; }
+  void MoveMouseCursor(float x, float y) override { mCursorX = x; mCursorY = y; }
+  void GetMouseLocation(float& x, float&y) const override { x = mCursorX; y = mCursorY; }
 
   EMsgBoxResult ShowMessageBox(const char* str, const char* title, EMsgBoxType type, IMsgBoxCompletionHandlerFunc completionHandler) override;
-  void ForceEndUserEdit() override;
+  void ForceEndUserEdit() override {}
+
+  const char* GetPlatformAPIStr() override { return "Linux (offscreen)"; }
+
+  void UpdateTooltips() override {}
+
+  void PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext, IFileDialogCompletionHandlerFunc completionHandler) override;
+  void PromptForDirectory(WDL_String& path, IFileDialogCompletionHandlerFunc completionHandler) override;
+  bool PromptForColor(IColor& color, const char* str, IColorPickerHandlerFunc func) override { return false; }
 
-  const char* GetPlatformAPIStr() override;
+  bool OpenURL(const char* url, const char* msgWindowTitle, const char* confirmMsg, const char* errMsgOnFailure) override { return false; }
 
-  void UpdateTooltips() override;
+  bool GetTextFromClipboard(WDL_String& str) override { str.Set(mClipboardText.Get()); return true; }
+  bool SetTextInClipboard(const char* str) override { mClipboardText.Set(str); return true; }
 
-  bool RevealPathInExplorerOrFinder(WDL_String& path, bool select) override;
-  void PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action,  const char* ext, IColorPickerHandlerFunc func) override;
-  bool PromptForColor(IColor& color, const char* str) override;
+  //IGraphicsLinux
+  /** Draw the dirty regions of the UI into the offscreen surface, as a platform timer would do
+   * @param forceFullRedraw Mark all controls dirty first, so that the whole UI is redrawn
+   * @return \c true if anything was drawn */
+  bool RenderFrame(bool forceFullRedraw = false);
 
-  bool OpenURL(const char* url, const char* msgWindowTitle, const char* confirmMsg, const char* errMsgOnFailure) override;
+  /** Copy the contents of the offscreen surface
+   * @param data Receives width * height pixels as unpremultiplied 8-bit RGBA, top row first
+   * @param width Receives the width of the surface in pixels (the UI width multiplied by the draw and screen scales)
+   * @param height Receives the height of the surface in pixels
+   * @return \c true on success */
+  bool GetSurfacePixels(RawBitmapData& data, int& width, int& height);
 
-  static int GetUserOSVersion();
-  bool GetTextFromClipboard(WDL_String& str) override;
-  bool SetTextInClipboard(const char* str) override { return false; } // TODO
+  /** Write the contents of the offscreen surface to disk
+   * @param path The path of the .png file to write
+   * @return \c true on success */
+  bool SaveSurfacePNG(const char* path);
 
 protected:
-  IPopupMenu* CreatePlatformPopupMenu(const IPopupMenu& menu, IRECT& bounds) override;
-  void CreatePlatformTextEntry(int paramIdx, const IText& text, const IRECT& bounds, int length, const char* str) override;
-}
+  IPopupMenu* CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT bounds, bool& isAsync) override;
+  void CreatePlatformTextEntry(int paramIdx, const IText& text, const IRECT& bounds, int length, const char* str) override {}
+
+private:
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fileNameOrResID) override;
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style) override;
+  PlatformFontPtr LoadPlatformFont(const char* fontID, void* pData, int dataSize) override;
+  void CachePlatformFont(const char* fontID, const PlatformFontPtr& font) override {}
+
+  WDL_String mClipboardText;
+  bool mWindowOpen = false;
+};
 
 END_IGRAPHICS_NAMESPACE
 END_IPLUG_NAMESPACE
@@ -96,7 +96,7 @@ void* IGraphicsMac::OpenWindow(void* pParent)
   ActivateGLContext();
   OnViewInitialized([pView layer]);
   SetScreenScale([[NSScreen mainScreen] backingScaleFactor]);
-  GetDelegate()->LayoutUI(this);
+  LayoutUIOnOpen();
   UpdateTooltips();
   GetDelegate()->OnUIOpen();
   
@@ -1070,7 +1070,7 @@ void* IGraphicsWin::OpenWindow(void* pParent)
 
   SetScreenScale(screenScale); // resizes draw context
 
-  GetDelegate()->LayoutUI(this);
+  LayoutUIOnOpen();
 
   if (MultiTouchEnabled() && GetSystemMetrics(SM_DIGITIZER) & NID_MULTI_INPUT)
   {
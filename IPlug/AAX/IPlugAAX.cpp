@@ -109,6 +109,7 @@ IPlugAAX::IPlugAAX(const InstanceInfo& info, const Config& config)
   SetBlockSize(DEFAULT_BLOCK_SIZE);
   InitLatencyDelay();
   ResizeBypassFadeBuffers(GetBlockSize());
+  mMidiOutputQueue.Resize(kMaxRenderBlockSize);
 
   mMaxNChansForMainInputBus = MaxNChannelsForBus(kInput, 0);
   
@@ -119,6 +119,8 @@ public:
   void DirtyPTCompareState() { mNumPlugInChanges++; }
 
 private:
+  static constexpr int kMaxRenderBlockSize = 1024; // the largest block Pro Tools renders AAX Native plug-ins with
+
   void ResizeBypassFadeBuffers(int blockSize);
 
   AAX_CParameter<bool>* mBypassParameter = nullptr;
@@ -1684,6 +1684,10 @@ OSStatus IPlugAU::RenderProc(void* pPlug, AudioUnitRenderActionFlags* pFlags, co
           for (int c = 0, chIdx = pInBus->mPlugChannelStartIdx; c < pInBus->mNHostChannels; ++c, ++chIdx)
           {
             _this->AttachBuffers(ERoute::kInput, chIdx, 1, (AudioSampleType**) &(pInBufList->mBuffers[c].mData), nFrames);
+
+            // Pass on the upstream unit's silence hint, so that the channel is not scanned
+            if (flags & kAudioUnitRenderAction_OutputIsSilence)
+              _this->SetInputIsSilent(chIdx, true);
           }
         }
       }
@@ -1757,6 +1761,18 @@ OSStatus IPlugAU::RenderProc(void* pPlug, AudioUnitRenderActionFlags* pFlags, co
       ENTER_PARAMS_MUTEX_STATIC
       _this->ProcessBuffers((AudioSampleType) 0, nFrames);
       LEAVE_PARAMS_MUTEX_STATIC
+
+      // Tell the host if this bus is silent, so that it can skip processing downstream
+      if (!_this->IsMidiEffect() && !_this->GetBypassed())
+      {
+        bool outputSilent = true;
+
+        for (int c = 0, chIdx = _this->mOutBuses.Get(outputBusIdx)->mPlugChannelStartIdx; c < pOutBufList->mNumberBuffers && outputSilent; ++c, ++chIdx)
+          outputSilent = _this->GetOutputIsSilent(chIdx);
+
+        if (outputSilent)
+          *pFlags |= kAudioUnitRenderAction_OutputIsSilence;
+      }
     }
   }
 
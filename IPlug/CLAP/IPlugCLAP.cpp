@@ -53,6 +53,14 @@ IPlugCLAP::IPlugCLAP(const InstanceInfo& info, const Config& config)
   CreateTimer();
 }
 
+IPlugCLAP::~IPlugCLAP()
+{
+#if defined OS_LINUX
+  if (mHostTimerID != CLAP_INVALID_ID)
+    GetClapHost().timerSupportUnregister(mHostTimerID);
+#endif
+}
+
 uint32_t IPlugCLAP::tailGet() const noexcept
 {
   return GetTailIsInfinite() ? std::numeric_limits<uint32_t>::max() : GetTailSize();
@@ -148,13 +156,33 @@ bool IPlugCLAP::init() noexcept
 {
   SetDefaultConfig();
   
+#if defined OS_LINUX
+  // The timers, and so OnTimer(), run when the host's main thread timer polls the timer service
+  if (GetClapHost().canUseTimerSupport())
+  {
+    const uint32_t heartbeatMs = TimerService::Get().GetHeartbeatMs();
+
+    if (!GetClapHost().timerSupportRegister(heartbeatMs ? heartbeatMs : IDLE_TIMER_RATE, &mHostTimerID))
+      mHostTimerID = CLAP_INVALID_ID;
+  }
+#endif
+
   return true;
 }
 
+#if defined OS_LINUX
+void IPlugCLAP::onTimer(clap_id timerId) noexcept
+{
+  if (timerId == mHostTimerID)
+    TimerService::Get().Poll();
+}
+#endif
+
 bool IPlugCLAP::activate(double sampleRate, uint32_t minFrameCount, uint32_t maxFrameCount) noexcept
 {
   SetBlockSize(maxFrameCount);
   SetSampleRate(sampleRate);
+  mMidiToHost.Resize(maxFrameCount);
   OnActivate(true);
   OnParamReset(kReset);
   OnReset();
@@ -185,12 +213,10 @@ const T* ClapEventCast(const clap_event_header_t* event)
 }
 
 template <typename T>
-bool InputIsSilent(const T* data, int nFrames)
+bool ChannelIsSilent(const clap_audio_buffer_t& bus, uint32_t chan, const T* data, int nFrames)
 {
-  // For local tail processing find non-zero inputs
-  auto isZero = [](T x) { return x == T(0); };
-
-  return std::find_if_not(data, data + nFrames, isZero) == (data + nFrames);
+  // A constant channel is silent if its first sample is zero
+  return (chan < 64) && (bus.constant_mask & (uint64_t(1) << chan)) && (!nFrames || data[0] == T(0));
 }
 
 clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
@@ -253,10 +279,6 @@ clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
   int nOuts = 0;
   int nFrames = pProcess->frames_count;
   
-  // Local tail handling
-  bool localTail = !mHostHasTail && !GetTailIsInfinite() && GetTailSize();
-  bool insQuiet = true;
-  
   // Sum IO channels
   for (uint32_t i = 0; i < pProcess->audio_inputs_count; i++)
     nIns += static_cast<int>(pProcess->audio_inputs[i].channel_count);
@@ -300,14 +322,7 @@ clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
         auto bus = pProcess->audio_inputs[i];
         
         for (uint32_t j = 0; j < bus.channel_count; j++, k++)
-        {
           mAudioIO64.Get()[k] = bus.data64[j];
-          
-          // For local tail processing check for non-zero inputs
-
-          if (localTail && insQuiet)
-            insQuiet = InputIsSilent(bus.data64[j], nFrames);
-        }
       }
       
       AttachBuffers(ERoute::kInput, 0, nIns, mAudioIO64.Get(), nFrames);
@@ -319,17 +334,23 @@ clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
         auto bus = pProcess->audio_inputs[i];
 
         for (uint32_t j = 0; j < bus.channel_count; j++, k++)
-        {
           mAudioIO32.Get()[k] = bus.data32[j];
-          
-          // For local tail processing check for non-zero inputs
-          if (localTail && insQuiet)
-            insQuiet = InputIsSilent(bus.data32[j], nFrames);
-        }
       }
       
       AttachBuffers(ERoute::kInput, 0, nIns, mAudioIO32.Get(), nFrames);
     }
+
+    // Pass on the host's silence hints, so that these channels are not scanned
+    for (uint32_t i = 0, k = 0; i < pProcess->audio_inputs_count; i++)
+    {
+      auto bus = pProcess->audio_inputs[i];
+
+      for (uint32_t j = 0; j < bus.channel_count; j++, k++)
+      {
+        if (format64 ? ChannelIsSilent(bus, j, bus.data64[j], nFrames) : ChannelIsSilent(bus, j, bus.data32[j], nFrames))
+          SetInputIsSilent(k, true);
+      }
+    }
   }
 
   SetChannelConnections(ERoute::kOutput, 0, MaxNChannels(ERoute::kOutput), false);
@@ -366,6 +387,19 @@ clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
     ProcessBuffers(0.0, nFrames);
   else
     ProcessBuffers(0.f, nFrames);
+
+  // Report silent outputs to the host
+  for (uint32_t i = 0, k = 0; i < pProcess->audio_outputs_count; i++)
+  {
+    auto& bus = pProcess->audio_outputs[i];
+    bus.constant_mask = 0;
+
+    for (uint32_t j = 0; j < bus.channel_count; j++, k++)
+    {
+      if (!GetBypassed() && j < 64 && GetOutputIsSilent(k))
+        bus.constant_mask |= uint64_t(1) << j;
+    }
+  }
     
   // Send Events Out (Parameters and MIDI)
   ProcessOutputEvents(pProcess->out_events, nFrames);
@@ -391,6 +425,11 @@ clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
     return CLAP_PROCESS_CONTINUE;
   
   // Finite tail
+  bool insQuiet = true;
+
+  for (int i = 0; i < nIns && insQuiet; i++)
+    insQuiet = GetInputIsSilent(i);
+
   mTailCount = insQuiet ? std::min(mTailCount + nFrames, GetTailSize()) : 0;
   
   return mTailCount < GetTailSize() ? CLAP_PROCESS_CONTINUE : CLAP_PROCESS_SLEEP;
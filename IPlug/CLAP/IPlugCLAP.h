@@ -84,6 +84,7 @@ class IPlugCLAP : public IPlugAPIBase
   
 public:
   IPlugCLAP(const InstanceInfo& info, const Config& config);
+  ~IPlugCLAP();
 
   // IPlugAPIBase
   void BeginInformHostOfParamChange(int idx) override;
@@ -98,6 +99,8 @@ public:
   bool SendSysEx(const ISysEx& msg) override;
 
 private:
+  static constexpr int kSysExToHostSize = 16; // SysEx messages that can be sent to the host per block, each SysExData is over 500 bytes
+
   // clap_plugin
   bool init() noexcept override;
   bool activate(double sampleRate, uint32_t minFrameCount, uint32_t maxFrameCount) noexcept override;
@@ -154,6 +157,12 @@ private:
   void paramsFlush(const clap_input_events* pInputParamChanges, const clap_output_events* pOutputParamChanges) noexcept override;
   bool isValidParamId(clap_id paramIdx) const noexcept override { return paramIdx < NParams(); }
 
+#if defined OS_LINUX
+  // clap_plugin_timer_support
+  bool implementsTimerSupport() const noexcept override { return true; }
+  void onTimer(clap_id timerId) noexcept override;
+#endif
+
   // clap_plugin_gui
   bool implementsGui() const noexcept override;
   bool guiCreate(const char* api, bool isFloating) noexcept override;
@@ -195,7 +204,7 @@ private:
   uint32_t NChannels(ERoute direction, uint32_t bus, int configIdx) const;
   
   IPlugQueue<ParamToHost> mParamValuesToHost {PARAM_TRANSFER_SIZE};
-  IMidiQueueBase<SysExData> mSysExToHost;
+  IMidiQueueBase<SysExData> mSysExToHost {kSysExToHostSize};
   IMidiQueue mMidiToHost;
   WDL_TypedBuf<float *> mAudioIO32;
   WDL_TypedBuf<double *> mAudioIO64;
@@ -204,6 +213,7 @@ private:
   bool mHostHasTail = false;
   bool mTailUpdate = false;
   bool mLatencyUpdate = false;
+  clap_id mHostTimerID = CLAP_INVALID_ID; // the host timer that polls the timer service
   
   void* mWindow = nullptr;
   bool mGUIOpen = false;
@@ -0,0 +1,219 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file Compressed and incremental (delta) plug-in state.
+ * Uses the zlib in WDL/zlib: add WDL/zlib/{adler32,compress,crc32,deflate,inffast,inflate,inftrees,trees,uncompr,zutil}.c to the project,
+ * or link against another copy of zlib
+ */
+
+#include <vector>
+
+#include "zlib/zlib.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugStructs.h"
+#include "IPlugPluginBase.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+static constexpr int kCompressedChunkMagic = 'IPzc';
+static constexpr int kParamDeltaMagic = 'IPdl';
+
+/** Checks whether a compressed block written by CompressChunk() starts at a position in a chunk
+ * @param chunk The chunk to look in
+ * @param startPos The position to look at
+ * @return \c true if the data at startPos is compressed */
+static bool IsCompressedChunk(const IByteChunk& chunk, int startPos)
+{
+  int magic = 0;
+  return chunk.Get(&magic, startPos) > startPos && magic == kCompressedChunkMagic;
+}
+
+/** Deflates a chunk and appends the result to another one. The compressed block is self describing, so it can be
+ * followed by other data and read back with DecompressChunk()
+ * @param src The data to compress, for example the result of IPluginBase::SerializeState()
+ * @param dst The chunk to append the compressed block to
+ * @param level The zlib compression level, from Z_BEST_SPEED (1) to Z_BEST_COMPRESSION (9)
+ * @return \c true on success */
+static bool CompressChunk(const IByteChunk& src, IByteChunk& dst, int level = Z_BEST_SPEED)
+{
+  const int srcSize = src.Size();
+  uLongf compressedSize = compressBound(static_cast<uLong>(srcSize));
+  const int headerPos = dst.Size();
+  const int dataPos = headerPos + 3 * sizeof(int);
+
+  // Reserve the worst case once, then shrink to what was written
+  dst.Resize(dataPos + static_cast<int>(compressedSize));
+
+  if (compress2(dst.GetData() + dataPos, &compressedSize, src.GetData(), static_cast<uLong>(srcSize), level) != Z_OK)
+  {
+    dst.Resize(headerPos);
+    return false;
+  }
+
+  const int header[3] = { kCompressedChunkMagic, srcSize, static_cast<int>(compressedSize) };
+  memcpy(dst.GetData() + headerPos, header, sizeof(header));
+  dst.Resize(dataPos + static_cast<int>(compressedSize));
+
+  return true;
+}
+
+/** Inflates a block written by CompressChunk() and appends the result to another chunk
+ * @param src The chunk holding the compressed block
+ * @param startPos The position of the compressed block in src
+ * @param dst The chunk to append the decompressed data to
+ * @return The position in src after the compressed block, or -1 if the data is not valid */
+static int DecompressChunk(const IByteChunk& src, int startPos, IByteChunk& dst)
+{
+  int header[3] = {};
+  const int dataPos = src.GetBytes(header, sizeof(header), startPos);
+
+  if (dataPos < 0 || header[0] != kCompressedChunkMagic || header[1] < 0 || header[2] < 0 || header[2] > src.Size() - dataPos)
+    return -1;
+
+  const int dstPos = dst.Size();
+  uLongf uncompressedSize = static_cast<uLongf>(header[1]);
+  dst.Resize(dstPos + header[1]);
+
+  if (uncompress(dst.GetData() + dstPos, &uncompressedSize, src.GetData() + dataPos, static_cast<uLong>(header[2])) != Z_OK
+      || uncompressedSize != static_cast<uLongf>(header[1]))
+  {
+    dst.Resize(dstPos);
+    return -1;
+  }
+
+  return dataPos + header[2];
+}
+
+/** Serializes parameter values relative to a base snapshot, so that frequent saves (undo history, autosave) only store the parameters
+ * that changed. A delta holds the number of parameters and an (index, value) pair per changed parameter, so it can only be applied
+ * together with the snapshot it was made against.
+ *
+ * A typical undo history keeps a full SerializeState() chunk every now and then, calls SetBase() at the same time,
+ * and stores a delta for each edit in between */
+class ParamDeltaState
+{
+public:
+  /** Takes a snapshot of the current parameter values, that later deltas are relative to
+   * @param plug The plug-in to read the parameters from */
+  void SetBase(const IPluginBase& plug)
+  {
+    const int n = plug.NParams();
+    mBase.resize(n);
+
+    for (int i = 0; i < n; i++)
+      mBase[i] = plug.GetParam(i)->Value();
+  }
+
+  /** Sets the snapshot from a chunk written by IPluginBase::SerializeParams()
+   * @param plug The plug-in the chunk belongs to, for the number of parameters
+   * @param chunk The chunk holding the parameter values
+   * @param startPos The position of the first value in the chunk
+   * @return The position after the last value, or -1 if the chunk is too short */
+  int SetBase(const IPluginBase& plug, const IByteChunk& chunk, int startPos)
+  {
+    const int n = plug.NParams();
+    mBase.resize(n);
+    return n ? chunk.GetBytes(mBase.data(), n * sizeof(double), startPos) : startPos;
+  }
+
+  /** @return \c true if a snapshot has been taken */
+  bool HasBase() const { return !mBase.empty(); }
+
+  /** @return The number of parameters in the snapshot that differ from the current values */
+  int NumChanged(const IPluginBase& plug) const
+  {
+    int nChanged = 0;
+
+    if (static_cast<int>(mBase.size()) == plug.NParams())
+    {
+      for (int i = 0; i < plug.NParams(); i++)
+        nChanged += plug.GetParam(i)->Value() != mBase[i];
+    }
+
+    return nChanged;
+  }
+
+  /** Appends the parameters that differ from the snapshot to a chunk
+   * @param plug The plug-in to read the parameters from
+   * @param chunk The chunk to append the delta to
+   * @return \c false if there is no snapshot or the number of parameters has changed */
+  bool SerializeDelta(const IPluginBase& plug, IByteChunk& chunk) const
+  {
+    const int n = plug.NParams();
+
+    if (static_cast<int>(mBase.size()) != n || !n)
+      return false;
+
+    const int nChanged = NumChanged(plug);
+    const int header[3] = { kParamDeltaMagic, n, nChanged };
+
+    chunk.Reserve(sizeof(header) + nChanged * (sizeof(int) + sizeof(double)));
+    chunk.PutBytes(header, sizeof(header));
+
+    for (int i = 0; i < n; i++)
+    {
+      const double v = plug.GetParam(i)->Value();
+
+      if (v != mBase[i])
+      {
+        chunk.Put(&i);
+        chunk.Put(&v);
+      }
+    }
+
+    return true;
+  }
+
+  /** Sets all parameters to the snapshot with a delta applied, via IPluginBase::UnserializeParams()
+   * so that the parameter mutex and OnParamReset() behave as when a full state is restored
+   * @param plug The plug-in to set the parameters of
+   * @param chunk The chunk holding a delta written by SerializeDelta()
+   * @param startPos The position of the delta in the chunk
+   * @return The position after the delta, or -1 if it is not valid or doesn't match the snapshot */
+  int UnserializeDelta(IPluginBase& plug, const IByteChunk& chunk, int startPos)
+  {
+    int header[3] = {};
+    int pos = chunk.GetBytes(header, sizeof(header), startPos);
+    const int n = static_cast<int>(mBase.size());
+
+    if (pos < 0 || header[0] != kParamDeltaMagic || header[1] != n || n != plug.NParams() || header[2] < 0 || header[2] > n)
+      return -1;
+
+    mScratch.Clear();
+    mScratch.PutBytes(mBase.data(), n * sizeof(double));
+    double* pValues = reinterpret_cast<double*>(mScratch.GetData());
+
+    for (int i = 0; i < header[2] && pos >= 0; i++)
+    {
+      int idx = -1;
+      double v = 0.;
+      pos = chunk.Get(&idx, pos);
+      pos = pos >= 0 ? chunk.Get(&v, pos) : pos;
+
+      if (pos < 0 || idx < 0 || idx >= n)
+        return -1;
+
+      memcpy(pValues + idx, &v, sizeof(double));
+    }
+
+    plug.UnserializeParams(mScratch, 0);
+    return pos;
+  }
+
+private:
+  std::vector<double> mBase;
+  IByteChunk mScratch;
+};
+
+END_IPLUG_NAMESPACE
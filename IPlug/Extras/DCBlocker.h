@@ -9,59 +9,133 @@
 */
 #pragma once
 
-#include "denormal.h"
+#include <cassert>
+
+#include "wdltypes.h"
+
 #include "IPlugConstants.h"
+#include "SIMDLanes.h"
 
 BEGIN_IPLUG_NAMESPACE
 
+/** A one zero, one pole DC blocking filter for NC channels
+ * y[n] = x[n] - x[n-1] + 0.995 * y[n-1]
+ * Groups of SIMDLanes<T>::kN channels are processed together, one channel per lane, and the rest are interleaved.
+ * The filter state is flushed of denormals at the end of each block, which keeps the flush out of the recursion */
 template<typename T, int NC = 1>
 class DCBlocker
 {
-private:
-  // one pole IIR
-  // y[n] = x[n] + a[n] * y[n-1]
-  class rpole {
-    T y_m1 = 0;
-  public:
-    inline T process(T x, T a) { 
-      const T y = y_m1 = x + a * y_m1;
-      denormal_fix(&y_m1);
-      return y;
-    }
-  };
-
-  // one zero FIR
-  // y[n] = x[n] - b[n] * x[n-1]
-  class rzero {
-    T x_m1 = 0;
-  public:
-    inline T process(T x, T b) {
-      const T y = x - b * x_m1;
-      x_m1 = x;
-      denormal_fix(&x_m1);
-      return y;
+public:
+  void ProcessBlock(T** inputs, T** outputs, int nChans, int nFrames)
+  {
+    assert(nChans <= NC);
+
+    int c = 0;
+
+    for (; c + Lanes::kN <= nChans; c += Lanes::kN)
+      ProcessLanes(inputs + c, outputs + c, c, nFrames);
+
+    if (c < nChans)
+      ProcessPartialLanes(inputs + c, outputs + c, c, nChans - c, nFrames);
+  }
+
+  void Reset()
+  {
+    for (auto c = 0; c < NC; c++)
+    {
+      mX1[c] = T(0);
+      mY1[c] = T(0);
     }
-  };
+  }
 
-  rpole mPole[NC];
-  rzero mZero[NC];
+private:
+  using Lanes = SIMDLanes<T>;
+  using V = typename Lanes::V;
 
-public:
+  static constexpr T kPole = T(0.995);
 
-  void ProcessBlock(T** inputs, T** outputs, int nChans, int nFrames)
+  /** Filters kN channels at once, kN frames at a time, in place if inputs == outputs */
+  void ProcessLanes(T** inputs, T** outputs, int chanOffset, int nFrames)
   {
-    assert(nChans <= NC);
+    constexpr int N = Lanes::kN;
+    const V a = Lanes::Set1(kPole);
+    V x1 = Lanes::Load(mX1 + chanOffset);
+    V y1 = Lanes::Load(mY1 + chanOffset);
+    int s = 0;
 
-    for (auto s=0; s<nFrames; s++)
+    for (; s + N <= nFrames; s += N)
     {
-      for (auto c = 0; c < nChans; c++)
+      V v[N];
+      Lanes::LoadTransposed(inputs, s, v);
+
+      for (int i = 0; i < N; i++)
       {
-        const auto x = inputs[c][s];
-        outputs[c][s] = mPole[c].process(mZero[c].process(x, T(1.0)), T(0.995));
+        const V y = Lanes::Add(Lanes::Sub(v[i], x1), Lanes::Mul(a, y1));
+        x1 = v[i];
+        y1 = y;
+        v[i] = y;
       }
+
+      Lanes::StoreTransposed(outputs, s, v);
+    }
+
+    for (; s < nFrames; s++)
+    {
+      const V x = Lanes::Gather(inputs, s);
+      const V y = Lanes::Add(Lanes::Sub(x, x1), Lanes::Mul(a, y1));
+      x1 = x;
+      y1 = y;
+      Lanes::Scatter(outputs, s, y);
+    }
+
+    Lanes::Store(mX1 + chanOffset, Lanes::FlushDenormals(x1));
+    Lanes::Store(mY1 + chanOffset, Lanes::FlushDenormals(y1));
+  }
+
+  /** Filters the n < kN channels left over in the lanes of one vector, the spare lanes filter a copy of the last channel */
+  void ProcessPartialLanes(T** inputs, T** outputs, int chanOffset, int n, int nFrames)
+  {
+    constexpr int N = Lanes::kN;
+    const V a = Lanes::Set1(kPole);
+    const T* laneInputs[N];
+    alignas(16) T state[2][N] = {};
+
+    for (int i = 0; i < N; i++)
+      laneInputs[i] = inputs[std::min(i, n - 1)];
+
+    for (int i = 0; i < n; i++)
+    {
+      state[0][i] = mX1[chanOffset + i];
+      state[1][i] = mY1[chanOffset + i];
+    }
+
+    V x1 = Lanes::Load(state[0]);
+    V y1 = Lanes::Load(state[1]);
+    alignas(16) T y[N];
+
+    for (auto s = 0; s < nFrames; s++)
+    {
+      const V x = Lanes::Gather(laneInputs, s);
+      y1 = Lanes::Add(Lanes::Sub(x, x1), Lanes::Mul(a, y1));
+      x1 = x;
+      Lanes::Store(y, y1);
+
+      for (int i = 0; i < n; i++)
+        outputs[i][s] = y[i];
+    }
+
+    Lanes::Store(state[0], Lanes::FlushDenormals(x1));
+    Lanes::Store(state[1], Lanes::FlushDenormals(y1));
+
+    for (int i = 0; i < n; i++)
+    {
+      mX1[chanOffset + i] = state[0][i];
+      mY1[chanOffset + i] = state[1][i];
     }
   }
 
+  T mX1[NC] = {}; // previous input
+  T mY1[NC] = {}; // previous output
 } WDL_FIXALIGN;
 
 END_IPLUG_NAMESPACE
@@ -0,0 +1,323 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include "IPlugEEL.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+using namespace iplug;
+
+#ifndef IPLUG_EEL_NO_HOSTSTUBS
+static std::recursive_mutex& GetEELMutex()
+{
+  static std::recursive_mutex sMutex;
+  return sMutex;
+}
+
+// NS-EEL only takes this when compiling, or when a VM allocates memory, which programs do up front
+void NSEEL_HOSTSTUB_EnterMutex() { GetEELMutex().lock(); }
+void NSEEL_HOSTSTUB_LeaveMutex() { GetEELMutex().unlock(); }
+#endif
+
+/** A compiled program, with its own VM */
+struct EELModMatrix::Program
+{
+  ~Program()
+  {
+    // @init is compiled with NSEEL_CODE_COMPILE_FLAG_COMMONFUNCS, so it is freed last
+    if (mSample) NSEEL_code_free(mSample);
+    if (mBlock) NSEEL_code_free(mBlock);
+    if (mInit) NSEEL_code_free(mInit);
+    if (mVM) NSEEL_VM_free(mVM);
+  }
+
+  NSEEL_VMCTX mVM = nullptr;
+  NSEEL_CODEHANDLE mInit = nullptr;
+  NSEEL_CODEHANDLE mBlock = nullptr;
+  NSEEL_CODEHANDLE mSample = nullptr;
+  double* mSampleRate = nullptr;
+  std::vector<double*> mSources;
+  std::vector<double*> mDests;
+};
+
+namespace
+{
+  enum ESection { kInit = 0, kBlock, kSample, kNumSections };
+
+  const char* const kSectionNames[kNumSections] = { "init", "block", "sample" };
+
+  /** The code of a section, and the line it starts on */
+  struct Section
+  {
+    std::string mCode;
+    int mLine = 0;
+  };
+
+  bool IsBlank(const std::string& code)
+  {
+    return code.find_first_not_of(" \t\r\n") == std::string::npos;
+  }
+
+  /** Split code into sections at lines that start with @init, @block or @sample. Code before the first of them is part of @block */
+  bool SplitSections(const char* code, Section (&sections)[kNumSections], WDL_String& error)
+  {
+    bool seen[kNumSections] = {};
+    ESection current = kBlock;
+    int line = 0;
+
+    for (const char* pLine = code; *pLine; line++)
+    {
+      const char* pEnd = strchr(pLine, '\n');
+      const int len = static_cast<int>(pEnd ? pEnd - pLine : strlen(pLine));
+
+      if (pLine[0] == '@')
+      {
+        int nameLen = 1;
+
+        while (nameLen < len && static_cast<unsigned char>(pLine[nameLen]) > ' ')
+          nameLen++;
+
+        int s = 0;
+
+        while (s < kNumSections && !(static_cast<int>(strlen(kSectionNames[s])) == nameLen - 1 && !strncmp(pLine + 1, kSectionNames[s], nameLen - 1)))
+          s++;
+
+        if (s == kNumSections || seen[s])
+        {
+          error.SetFormatted(256, "line %d: %s section '%.*s'", line + 1, s == kNumSections ? "unknown" : "duplicate", nameLen, pLine);
+          return false;
+        }
+
+        current = static_cast<ESection>(s);
+        seen[s] = true;
+        sections[current].mLine = line + 1;
+      }
+      else
+      {
+        sections[current].mCode.append(pLine, len);
+        sections[current].mCode.push_back('\n');
+      }
+
+      pLine += pEnd ? len + 1 : len;
+    }
+
+    return true;
+  }
+}
+
+EELModMatrix::EELModMatrix(int ramSize)
+: mRAMSize(ramSize)
+{
+}
+
+EELModMatrix::~EELModMatrix()
+{
+  delete mActive;
+  delete mPending.exchange(nullptr);
+  CollectRetired();
+}
+
+int EELModMatrix::AddSource(const char* name)
+{
+  assert(NSources() < kMaxSources && !mPending.load() && !mActive);
+  mSourceNames.push_back(name);
+  mSourceValues.push_back(0.);
+  return NSources() - 1;
+}
+
+int EELModMatrix::AddDestination(const char* name)
+{
+  assert(NDestinations() < kMaxDestinations && !mPending.load() && !mActive);
+  mDestNames.push_back(name);
+  mDestValues.push_back(0.);
+  return NDestinations() - 1;
+}
+
+bool EELModMatrix::Compile(const char* code, WDL_String& error)
+{
+  CollectRetired();
+
+  Section sections[kNumSections];
+
+  if (!SplitSections(code, sections, error))
+    return false;
+
+  std::unique_ptr<Program> pProgram(new Program());
+  pProgram->mVM = NSEEL_VM_alloc();
+
+  if (!pProgram->mVM)
+  {
+    error.Set("could not allocate an EEL VM");
+    return false;
+  }
+
+  NSEEL_VM_setramsize(pProgram->mVM, mRAMSize);
+  NSEEL_VM_preallocram(pProgram->mVM, -1);
+
+  pProgram->mSampleRate = NSEEL_VM_regvar(pProgram->mVM, "srate");
+  *pProgram->mSampleRate = mSampleRate;
+
+  for (auto& name : mSourceNames)
+    pProgram->mSources.push_back(NSEEL_VM_regvar(pProgram->mVM, name.c_str()));
+
+  for (auto& name : mDestNames)
+    pProgram->mDests.push_back(NSEEL_VM_regvar(pProgram->mVM, name.c_str()));
+
+  NSEEL_CODEHANDLE* handles[kNumSections] = { &pProgram->mInit, &pProgram->mBlock, &pProgram->mSample };
+
+  for (int s = 0; s < kNumSections; s++)
+  {
+    if (IsBlank(sections[s].mCode))
+      continue;
+
+    const int flags = NSEEL_CODE_COMPILE_FLAG_NOFPSTATE | (s == kInit ? NSEEL_CODE_COMPILE_FLAG_COMMONFUNCS : 0);
+    *handles[s] = NSEEL_code_compile_ex(pProgram->mVM, sections[s].mCode.c_str(), sections[s].mLine, flags);
+
+    if (!*handles[s])
+    {
+      const char* pError = NSEEL_code_getcodeerror(pProgram->mVM);
+      error.SetFormatted(1024, "@%s: %s", kSectionNames[s], pError ? pError : "compile error");
+      return false;
+    }
+  }
+
+  if (pProgram->mInit)
+    NSEEL_code_execute(pProgram->mInit);
+
+  mCode = code;
+  mHasSampleSection.store(pProgram->mSample != nullptr);
+  delete mPending.exchange(pProgram.release()); // one that the audio thread didn't pick up yet
+  return true;
+}
+
+void EELModMatrix::UpdateProgram()
+{
+  if (!mPending.load(std::memory_order_acquire))
+    return;
+
+  // Compile() collects both slots before it publishes, and at most two programs are swapped in before it is called again:
+  // one it left pending, and the one it publishes. Only this thread fills a slot, so a slot seen empty stays empty
+  std::atomic<Program*>* pSlot = nullptr;
+
+  for (auto& slot : mRetired)
+  {
+    if (!slot.load(std::memory_order_acquire))
+    {
+      pSlot = &slot;
+      break;
+    }
+  }
+
+  if (!pSlot)
+    return;
+
+  if (Program* pProgram = mPending.exchange(nullptr, std::memory_order_acq_rel))
+  {
+    pSlot->store(mActive, std::memory_order_release);
+    mActive = pProgram;
+  }
+}
+
+void EELModMatrix::CollectRetired()
+{
+  for (auto& slot : mRetired)
+    delete slot.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void EELModMatrix::ProcessBlock()
+{
+  UpdateProgram();
+
+  if (!mActive || !mActive->mBlock)
+    return;
+
+  const int nSources = NSources();
+  const int nDests = NDestinations();
+
+  *mActive->mSampleRate = mSampleRate;
+
+  for (int i = 0; i < nSources; i++)
+    *mActive->mSources[i] = mSourceValues[i];
+
+  NSEEL_code_execute(mActive->mBlock);
+
+  for (int i = 0; i < nDests; i++)
+    mDestValues[i] = *mActive->mDests[i];
+}
+
+void EELModMatrix::ProcessSamples(const double* const* sources, double** destinations, int nFrames)
+{
+  UpdateProgram();
+
+  const int nSources = NSources();
+  const int nDests = NDestinations();
+
+  if (!mActive || !mActive->mSample)
+  {
+    // Destinations hold their @block value
+    for (int i = 0; i < nDests; i++)
+    {
+      if (destinations && destinations[i])
+        std::fill(destinations[i], destinations[i] + nFrames, mDestValues[i]);
+    }
+
+    return;
+  }
+
+  // Gather the buffers that are used, so the loop doesn't test for nullptr
+  double* sourceVars[kMaxSources];
+  const double* sourceBufs[kMaxSources];
+  double* destVars[kMaxDestinations];
+  double* destBufs[kMaxDestinations];
+  int nSourceBufs = 0;
+  int nDestBufs = 0;
+
+  *mActive->mSampleRate = mSampleRate;
+
+  for (int i = 0; i < nSources; i++)
+  {
+    if (sources && sources[i])
+    {
+      sourceVars[nSourceBufs] = mActive->mSources[i];
+      sourceBufs[nSourceBufs++] = sources[i];
+    }
+    else
+      *mActive->mSources[i] = mSourceValues[i];
+  }
+
+  for (int i = 0; i < nDests; i++)
+  {
+    if (destinations && destinations[i])
+    {
+      destVars[nDestBufs] = mActive->mDests[i];
+      destBufs[nDestBufs++] = destinations[i];
+    }
+  }
+
+  NSEEL_CODEHANDLE sample = mActive->mSample;
+
+  for (int s = 0; s < nFrames; s++)
+  {
+    for (int i = 0; i < nSourceBufs; i++)
+      *sourceVars[i] = sourceBufs[i][s];
+
+    NSEEL_code_execute(sample);
+
+    for (int i = 0; i < nDestBufs; i++)
+      destBufs[i][s] = *destVars[i];
+  }
+
+  for (int i = 0; i < nDests; i++)
+    mDestValues[i] = *mActive->mDests[i];
+}
@@ -0,0 +1,136 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file IPlug EEL2 expressions - a scriptable modulation matrix and parameter mapping layer
+ */
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "eel2/ns-eel.h"
+#include "wdlstring.h"
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A modulation matrix and parameter mapping layer whose routes are user editable EEL2 code, which NS-EEL compiles to native code.
+ * Sources (LFOs, envelopes, macros, normalized parameter values...) and destinations are named EEL variables, declared before the code is compiled.
+ * The code is split in sections, as in JSFX:
+ * - \c @init runs once when the code is compiled, on the thread that calls Compile(). Functions defined here can be called from the other sections
+ * - \c @block runs once per block, in ProcessBlock(). Code before any section marker is also part of \c @block
+ * - \c @sample runs once per sample frame, in ProcessSamples()
+ *
+ * For example:
+ * @code
+ * @init
+ * function curve(x, k) ( (exp(k * x) - 1) / (exp(k) - 1) );
+ * @block
+ * cutoff = 20 * 1000 ^ curve(macro1, 3);
+ * @sample
+ * gain = 1 - depth * (0.5 + 0.5 * lfo);
+ * @endcode
+ *
+ * Compile() can be called on the UI thread while the audio thread is processing: the new program is handed over lock-free at the start of the next block,
+ * and the old one is freed on the next call to Compile() or when the matrix is destroyed. Each program has its own VM and preallocated memory,
+ * so the audio thread never allocates or waits, unless the code uses \c gmem[], which is allocated the first time it is used. The variable \c srate holds the sample rate.
+ *
+ * The NS-EEL sources in WDL/eel2 need to be compiled into the plug-in: nseel-caltab.c, nseel-cfunc.c, nseel-compiler.c, nseel-eval.c, nseel-lextab.c,
+ * nseel-ram.c and nseel-yylex.c. The JIT is native on x86_64 and arm64/aarch64. On x86_64 it also needs asm-nseel-x64-sse.asm, which is prebuilt for
+ * Windows (asm-nseel-x64.obj) and macOS (asm-nseel-multi-macho.o), and assembled on Linux with `nasm -D AMD64ABI -f elf64 asm-nseel-x64-sse.asm`.
+ * Other targets can define EEL_TARGET_PORTABLE, which interprets byte code instead, about eight times slower.
+ * IPlugEEL.cpp defines the NS-EEL host mutex stubs, define IPLUG_EEL_NO_HOSTSTUBS if the plug-in already defines them */
+class EELModMatrix
+{
+public:
+  static constexpr int kMaxSources = 64;
+  static constexpr int kMaxDestinations = 64;
+
+  /** @param ramSize The number of EEL_F values of memory (\c x[0] etc) each program can use, preallocated when it is compiled */
+  EELModMatrix(int ramSize = 65536);
+  ~EELModMatrix();
+
+  EELModMatrix(const EELModMatrix&) = delete;
+  EELModMatrix& operator=(const EELModMatrix&) = delete;
+
+  /** Declare a source, which the code reads as a variable. Must be called before Compile()
+   * @param name The variable name, such as "lfo1" or "macro1"
+   * @return The index to pass to SetSource(), and the position of its buffer in ProcessSamples() */
+  int AddSource(const char* name);
+
+  /** Declare a destination, which the code writes as a variable. Must be called before Compile()
+   * @param name The variable name, such as "cutoff"
+   * @return The index to pass to GetDestination(), and the position of its buffer in ProcessSamples() */
+  int AddDestination(const char* name);
+
+  /** @return The number of sources declared with AddSource() */
+  int NSources() const { return static_cast<int>(mSourceNames.size()); }
+
+  /** @return The number of destinations declared with AddDestination() */
+  int NDestinations() const { return static_cast<int>(mDestNames.size()); }
+
+  /** Compile code and hand it to the audio thread, which starts using it at its next ProcessBlock() or ProcessSamples().
+   * This allocates and runs the \c @init section, don't call it on the audio thread
+   * @param code The EEL2 code, with optional \c @init, \c @block and \c @sample sections
+   * @param error Set to the compiler error, with the section and line, on failure
+   * @return \c true on success. On failure the current program keeps running */
+  bool Compile(const char* code, WDL_String& error);
+
+  /** @return The code that was last compiled successfully */
+  const char* GetCode() const { return mCode.c_str(); }
+
+  /** Set the sample rate, which the code reads as \c srate. \c @init sees the sample rate at the time it is compiled */
+  void SetSampleRate(double sampleRate) { mSampleRate = sampleRate; }
+
+  /** Set the value of a source, for ProcessBlock() and for ProcessSamples() when the source has no buffer. Realtime safe */
+  void SetSource(int idx, double value) { mSourceValues[idx] = value; }
+
+  /** @return The value of a destination after the last ProcessBlock(), or the last sample frame of ProcessSamples(). Realtime safe */
+  double GetDestination(int idx) const { return mDestValues[idx]; }
+
+  /** Run the \c @block section, with the values from SetSource(). Realtime safe */
+  void ProcessBlock();
+
+  /** Run the \c @sample section once per sample frame. Realtime safe
+   * @param sources One buffer per source, a source whose buffer is \c nullptr keeps its SetSource() value
+   * @param destinations One buffer per destination, filled with the values written by the code. A buffer can be \c nullptr if it is not needed
+   * @param nFrames The number of sample frames */
+  void ProcessSamples(const double* const* sources, double** destinations, int nFrames);
+
+  /** @return \c true if the code that is running, or about to run, has a \c @sample section */
+  bool HasSampleSection() const { return mHasSampleSection.load(); }
+
+private:
+  struct Program;
+
+  /** Swaps in a newly compiled program, if there is one and a retired slot is free */
+  void UpdateProgram();
+
+  void CollectRetired();
+
+  const int mRAMSize;
+  std::vector<std::string> mSourceNames;
+  std::vector<std::string> mDestNames;
+  std::vector<double> mSourceValues;
+  std::vector<double> mDestValues;
+  std::string mCode;
+  double mSampleRate = 44100.;
+  std::atomic<bool> mHasSampleSection {false};
+
+  Program* mActive = nullptr; // only touched by the audio thread, once compiled
+  std::atomic<Program*> mPending {nullptr}; // compiled, waiting for the audio thread
+  std::atomic<Program*> mRetired[2] {}; // replaced by the audio thread, waiting to be freed
+};
+
+END_IPLUG_NAMESPACE
@@ -66,6 +66,10 @@
     #include "simde/x86/sse2.h"
   #else
     #include <emmintrin.h>
+    #if defined(__AVX__)
+      #include <immintrin.h>
+      #define IPLUG_LANCZOS_AVX 1
+    #endif
   #endif
 #endif
 
@@ -80,6 +84,11 @@ namespace iplug
  * include the SIMDE library in your search paths in order to translate intel
  * intrinsics to e.g. arm64
  *
+ * The input history is stored contiguously (and duplicated, so reads never wrap), so the
+ * SIMD path reads taps with vector loads. When compiled with AVX and 4 < NCHANS <= 8, the
+ * history is stored frame-interleaved instead, so all channels are filtered in the lanes of
+ * a single register rather than one after another.
+ *
  * See https://en.wikipedia.org/wiki/Lanczos_resampling
  *
  * @tparam T the sampletype
@@ -94,7 +103,16 @@ class LanczosResampler
 private:
 #if IPLUG_SIMDE
   static_assert(std::is_same<T, float>::value, "LanczosResampler requires T to be float when using SIMD instructions");
+  static_assert(A % 4 == 0, "LanczosResampler requires A to be a multiple of 4 when using SIMD instructions");
+#endif
+
+#if IPLUG_LANCZOS_AVX
+  // Store the history as 8-lane frames, so up to 8 channels are filtered at once
+  static constexpr bool kInterleaved = NCHANS > 4 && NCHANS <= 8;
+#else
+  static constexpr bool kInterleaved = false;
 #endif
+  static constexpr int kFrameLanes = 8;
 
   // The buffer size. This needs to be at least as large as the largest block of samples
   // that the input side will see.
@@ -172,10 +190,21 @@ public:
   {
     for (auto s=0; s<nFrames; s++)
     {
-      for (auto c=0; c<nChans; c++)
+      if constexpr (kInterleaved)
+      {
+        for (auto c=0; c<nChans; c++)
+        {
+          mFrameBuffer[mWritePos][c] = inputs[c][s];
+          mFrameBuffer[mWritePos + kBufferSize][c] = inputs[c][s]; // this way we can always wrap
+        }
+      }
+      else
       {
-        mInputBuffer[c][mWritePos] = inputs[c][s];
-        mInputBuffer[c][mWritePos + kBufferSize] = inputs[c][s]; // this way we can always wrap
+        for (auto c=0; c<nChans; c++)
+        {
+          mInputBuffer[c][mWritePos] = inputs[c][s];
+          mInputBuffer[c][mWritePos + kBufferSize] = inputs[c][s]; // this way we can always wrap
+        }
       }
       
       mWritePos = (mWritePos + 1) & (kBufferSize - 1);
@@ -183,15 +212,25 @@ public:
     }
   }
   
-  size_t PopBlock(T** outputs, size_t max, int nChans)
+  /** Get the number of output samples that can be popped with the input pushed so far */
+  inline size_t GetNumSamplesAvailable() const
   {
-    int populated = 0;
-    while (populated < max && (mPhaseIn - mPhaseOut) > A + 1)
+    size_t count = 0;
+    double phaseOut = mPhaseOut;
+    while ((mPhaseIn - phaseOut) > A + 1)
     {
-      ReadSamples((mPhaseIn - mPhaseOut), outputs, populated, nChans);
-      mPhaseOut += mPhaseOutIncr;
-      populated++;
+      phaseOut += mPhaseOutIncr;
+      count++;
     }
+    return count;
+  }
+  
+  /** Resample up to max output samples per channel in one call
+   * @return The number of samples written to each channel of outputs */
+  size_t PopBlock(T** outputs, size_t max, int nChans)
+  {
+    const size_t populated = std::min(GetNumSamplesAvailable(), max);
+    ReadBlock(outputs, static_cast<int>(populated), nChans);
     return populated;
   }
   
@@ -208,10 +247,74 @@ public:
   
   void ClearBuffer()
   {
-    memset(mInputBuffer, 0, NCHANS * kBufferSize * 2 * sizeof(T));
+    memset(mInputBuffer, 0, sizeof(mInputBuffer));
+    memset(mFrameBuffer, 0, sizeof(mFrameBuffer));
   }
   
 private:
+  /** Read nOutputs consecutive output samples, advancing the output phase */
+  inline void ReadBlock(T** outputs, int nOutputs, int nChans)
+  {
+    double phaseOut = mPhaseOut;
+
+    for (auto s=0; s<nOutputs; s++)
+    {
+#if IPLUG_LANCZOS_AVX
+      if constexpr (kInterleaved)
+        ReadSamplesInterleaved(mPhaseIn - phaseOut, outputs, s, nChans);
+      else
+#endif
+        ReadSamples(mPhaseIn - phaseOut, outputs, s, nChans);
+
+      phaseOut += mPhaseOutIncr;
+    }
+
+    mPhaseOut = phaseOut;
+  }
+
+#if IPLUG_LANCZOS_AVX
+  inline void ReadSamplesInterleaved(double xBack, T** outputs, int s, int nChans) const
+  {
+    float bufferReadPosition = static_cast<float>(mWritePos - xBack);
+    int bufferReadIndex = static_cast<int>(std::floor(bufferReadPosition));
+    float bufferFracPosition = 1.0f - (bufferReadPosition - static_cast<float>(bufferReadIndex));
+    
+    bufferReadIndex = (bufferReadIndex + kBufferSize) & (kBufferSize - 1);
+    bufferReadIndex += (bufferReadIndex <= static_cast<int>(A)) * kBufferSize;
+    
+    float tablePosition = bufferFracPosition * kTablePoints;
+    int tableIndex = static_cast<int>(tablePosition);
+    float tableFracPosition = (tablePosition - tableIndex);
+    
+    // Interpolate all filter coefficients up front
+    alignas(32) float coefs[kFilterWidth];
+    const __m256 tfp = _mm256_set1_ps(tableFracPosition);
+    for (size_t i=0; i<kFilterWidth; i+=8)
+    {
+      const __m256 f = _mm256_loadu_ps(&sTable[tableIndex][i]);
+      const __m256 df = _mm256_loadu_ps(&sDeltaTable[tableIndex][i]);
+      _mm256_store_ps(&coefs[i], _mm256_add_ps(f, _mm256_mul_ps(df, tfp)));
+    }
+    
+    // Each frame holds one sample of every channel, so every tap is a single aligned load
+    const float* pFrame = mFrameBuffer[bufferReadIndex - A];
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (size_t i=0; i<kFilterWidth; i+=2)
+    {
+      sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_set1_ps(coefs[i]), _mm256_load_ps(pFrame + i * kFrameLanes)));
+      sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_set1_ps(coefs[i + 1]), _mm256_load_ps(pFrame + (i + 1) * kFrameLanes)));
+    }
+    
+    alignas(32) float result[kFrameLanes];
+    _mm256_store_ps(result, _mm256_add_ps(sum0, sum1));
+    for (int c=0; c<nChans; c++)
+    {
+      outputs[c][s] = result[c];
+    }
+  }
+#endif
+
 #ifdef IPLUG_SIMDE
   inline void ReadSamples(double xBack, T** outputs, int s, int nChans) const
   {
@@ -246,15 +349,9 @@ private:
       
       for (int c=0; c<nChans; c++)
       {
-        // Load input data
-        __m128 d0 = _mm_set_ps(mInputBuffer[c][bufferReadIndex - A + i + 3],
-                               mInputBuffer[c][bufferReadIndex - A + i + 2],
-                               mInputBuffer[c][bufferReadIndex - A + i + 1],
-                               mInputBuffer[c][bufferReadIndex - A + i]);
-        __m128 d1 = _mm_set_ps(mInputBuffer[c][bufferReadIndex + i + 3],
-                               mInputBuffer[c][bufferReadIndex + i + 2],
-                               mInputBuffer[c][bufferReadIndex + i + 1],
-                               mInputBuffer[c][bufferReadIndex + i]);
+        // Load input data, the history is contiguous so this doesn't need a gather
+        __m128 d0 = _mm_loadu_ps(&mInputBuffer[c][bufferReadIndex - A + i]);
+        __m128 d1 = _mm_loadu_ps(&mInputBuffer[c][bufferReadIndex + i]);
         
         // Perform multiplication and accumulate
         __m128 result0 = _mm_mul_ps(f0, d0);
@@ -317,7 +414,8 @@ private:
   static T sDeltaTable alignas(16)[kTablePoints + 1][kFilterWidth];
   static bool sTablesInitialized;
   
-  T mInputBuffer[NCHANS][kBufferSize * 2];
+  alignas(32) T mInputBuffer[kInterleaved ? 1 : NCHANS][kBufferSize * 2];
+  alignas(32) T mFrameBuffer[kInterleaved ? kBufferSize * 2 : 1][kFrameLanes];
   int mWritePos = 0;
   const float mInputSampleRate;
   const float mOutputSamplerate;
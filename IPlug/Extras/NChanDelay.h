@@ -9,7 +9,15 @@
 */
 
 #pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
 #include "IPlugPlatform.h"
+#include "heapbuf.h"
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -65,4 +73,371 @@ private:
   uint32_t mDTSamples = 0;
 } WDL_FIXALIGN;
 
+/** A multichannel delay line with fractional, modulated delay times and several read taps, for chorus, flanger and latency compensation.
+ * The buffer is allocated once with Allocate(), so changing the delay time or the interpolation is realtime safe.
+ * Each channel is stored contiguously (channel-blocked) in a power of two sized ring, so wrapping is a mask rather than a modulo, and
+ * there are guard samples either side of each ring so that the interpolators never need to wrap. A block is split at most once where the ring wraps,
+ * and each span is processed in a plain loop over contiguous samples, which the compiler vectorises.
+ *
+ * Write a block with Write() first, then read it back with Read() (one delay time for the block) or ReadModulated() (one delay time per sample),
+ * once per tap. Delay times are in samples, and are clamped to GetMinDelay() ... GetMaxDelay().
+ * The all-pass interpolator is recursive, so each tap that uses it keeps its own state, and should be read with a consistent tapIdx */
+template<typename T>
+class NChanModDelayLine
+{
+public:
+  enum class EInterp
+  {
+    None,     // Delay times are rounded to the nearest sample
+    Linear,
+    Lagrange, // 3rd order Lagrange, flatter than linear at the cost of 4 taps per sample
+    Allpass   // 1st order Thiran all-pass, flat magnitude response, best for slowly modulated delays
+  };
+
+  NChanModDelayLine(int nChans = 2, EInterp interp = EInterp::Linear, int nTaps = 1)
+  : mNChans(nChans)
+  , mNTaps(std::max(nTaps, 1))
+  , mInterp(interp)
+  {}
+
+  /** Allocate and clear the buffers. This is not realtime safe
+   * @param maxDelaySamples The longest delay time that will be used
+   * @param maxBlockSize The largest block that will be passed to Write() */
+  void Allocate(int maxDelaySamples, int maxBlockSize)
+  {
+    mMaxBlockSize = std::max(maxBlockSize, 1);
+
+    const int minSize = std::max(maxDelaySamples, 0) + mMaxBlockSize + kGuard;
+    mSize = 1;
+
+    while (mSize < minSize)
+      mSize <<= 1;
+
+    mMask = mSize - 1;
+    mStride = kPreGuard + mSize + kGuard;
+    mBuffer.Resize(mNChans * mStride);
+    mIdx.Resize(mMaxBlockSize);
+    mCoeffs.Resize(mMaxBlockSize * 4);
+    mAllpassState.Resize(mNTaps * mNChans);
+    mInPtrs.resize(mNChans);
+    mOutPtrs.resize(mNChans);
+    Clear();
+  }
+
+  /** Clear the delayed signal and the interpolator state */
+  void Clear()
+  {
+    memset(mBuffer.Get(), 0, mBuffer.GetSize() * sizeof(T));
+    memset(mAllpassState.Get(), 0, mAllpassState.GetSize() * sizeof(T));
+    mWritePos = mBlockStart = 0;
+  }
+
+  /** Change the interpolation, which resets the all-pass state */
+  void SetInterpolation(EInterp interp)
+  {
+    mInterp = interp;
+    memset(mAllpassState.Get(), 0, mAllpassState.GetSize() * sizeof(T));
+  }
+
+  EInterp GetInterpolation() const { return mInterp; }
+
+  int NChans() const { return mNChans; }
+
+  int GetMaxBlockSize() const { return mMaxBlockSize; }
+
+  /** @return The shortest delay that is possible with the current interpolation, reading only samples that have been written */
+  T GetMinDelay() const
+  {
+    switch (mInterp)
+    {
+      case EInterp::Lagrange: return T(1);
+      case EInterp::Allpass: return T(0.5);
+      default: return T(0);
+    }
+  }
+
+  /** @return The longest delay that is possible with the allocated buffer */
+  T GetMaxDelay() const { return static_cast<T>(std::max(mSize - mMaxBlockSize - 3, 0)); }
+
+  /** Write a block of input, to be read with Read() or ReadModulated() before the next Write()
+   * @param inputs One pointer per channel
+   * @param nFrames The block size, which must not be larger than the max block size */
+  void Write(const T* const* inputs, int nFrames)
+  {
+    assert(nFrames <= mMaxBlockSize);
+    const int n1 = std::min(nFrames, mSize - mWritePos);
+
+    for (int c = 0; c < mNChans; c++)
+    {
+      T* pChan = GetChannel(c);
+      memcpy(pChan + mWritePos, inputs[c], n1 * sizeof(T));
+      memcpy(pChan, inputs[c] + n1, (nFrames - n1) * sizeof(T));
+
+      // Refresh the guards
+      pChan[-1] = pChan[mMask];
+      memcpy(pChan + mSize, pChan, kGuard * sizeof(T));
+    }
+
+    mBlockStart = mWritePos;
+    mWritePos = (mWritePos + nFrames) & mMask;
+  }
+
+  /** Read the last block written, with a fixed delay time
+   * @param outputs One pointer per channel
+   * @param nFrames The size of the last block written
+   * @param delay The delay time in samples
+   * @param tapIdx The tap, which only matters for the all-pass interpolator */
+  void Read(T** outputs, int nFrames, T delay, int tapIdx = 0)
+  {
+    delay = ClampDelay(delay);
+
+    int offset;
+    T frac;
+    GetOffset(delay, offset, frac);
+
+    const int readPos = (mBlockStart - offset) & mMask;
+    const int n1 = std::min(nFrames, mSize - readPos);
+
+    for (int c = 0; c < mNChans; c++)
+    {
+      const T* pChan = GetChannel(c);
+
+      if (mInterp == EInterp::Allpass)
+      {
+        T& state = mAllpassState.Get()[tapIdx * mNChans + c];
+        ReadAllpass(pChan + readPos, outputs[c], n1, frac, state);
+        ReadAllpass(pChan, outputs[c] + n1, nFrames - n1, frac, state);
+      }
+      else
+      {
+        ReadSpan(pChan + readPos, outputs[c], n1, frac);
+        ReadSpan(pChan, outputs[c] + n1, nFrames - n1, frac);
+      }
+    }
+  }
+
+  /** Read the last block written, with a delay time for each sample, as for chorus and flanger. The positions and interpolation coefficients
+   * are computed once per sample and shared by all of the channels
+   * @param outputs One pointer per channel
+   * @param delays The delay time in samples for each sample in the block
+   * @param nFrames The size of the last block written
+   * @param tapIdx The tap, which only matters for the all-pass interpolator */
+  void ReadModulated(T** outputs, const T* delays, int nFrames, int tapIdx = 0)
+  {
+    int* pIdx = mIdx.Get();
+    T* pCoeffs = mCoeffs.Get();
+
+    const T minDelay = GetMinDelay();
+    const T maxDelay = GetMaxDelay();
+
+    switch (mInterp)
+    {
+      case EInterp::None:
+        for (int s = 0; s < nFrames; s++)
+          pIdx[s] = (mBlockStart + s - static_cast<int>(std::min(std::max(delays[s], minDelay), maxDelay) + T(0.5))) & mMask;
+        break;
+      case EInterp::Allpass:
+        for (int s = 0; s < nFrames; s++)
+        {
+          const T delay = std::min(std::max(delays[s], minDelay), maxDelay);
+          const int offset = static_cast<int>(delay + T(0.5)); // delay >= 0.5, so this is floor(delay - 0.5) + 1
+          const T frac = delay - static_cast<T>(offset - 1);
+          pIdx[s] = (mBlockStart + s - offset) & mMask;
+          pCoeffs[s] = (T(1) - frac) / (T(1) + frac);
+        }
+        break;
+      default:
+        for (int s = 0; s < nFrames; s++)
+        {
+          // Written as x[i] + frac * (x[i + 1] - x[i]) with i one sample further back, so there is no branch for integer delays
+          const T delay = std::min(std::max(delays[s], minDelay), maxDelay);
+          const int offset = static_cast<int>(delay) + 1;
+          const T frac = static_cast<T>(offset) - delay;
+          pIdx[s] = (mBlockStart + s - offset) & mMask;
+
+          if (mInterp == EInterp::Lagrange)
+            GetLagrangeCoeffs(frac, pCoeffs + s * 4);
+          else
+            pCoeffs[s] = frac;
+        }
+        break;
+    }
+
+    for (int c = 0; c < mNChans; c++)
+    {
+      const T* pChan = GetChannel(c);
+      T* pOut = outputs[c];
+
+      switch (mInterp)
+      {
+        case EInterp::None:
+          for (int s = 0; s < nFrames; s++)
+            pOut[s] = pChan[pIdx[s]];
+          break;
+        case EInterp::Linear:
+          for (int s = 0; s < nFrames; s++)
+          {
+            const T* x = pChan + pIdx[s];
+            pOut[s] = x[0] + pCoeffs[s] * (x[1] - x[0]);
+          }
+          break;
+        case EInterp::Lagrange:
+          for (int s = 0; s < nFrames; s++)
+          {
+            const T* x = pChan + pIdx[s];
+            const T* h = pCoeffs + s * 4;
+            pOut[s] = h[0] * x[-1] + h[1] * x[0] + h[2] * x[1] + h[3] * x[2];
+          }
+          break;
+        case EInterp::Allpass:
+        {
+          T& state = mAllpassState.Get()[tapIdx * mNChans + c];
+          T y = state;
+
+          for (int s = 0; s < nFrames; s++)
+          {
+            const T* x = pChan + pIdx[s];
+            y = pCoeffs[s] * (x[1] - y) + x[0];
+            pOut[s] = y;
+          }
+
+          state = y;
+          break;
+        }
+      }
+    }
+  }
+
+  /** Write a block and read it back with a fixed delay time, in chunks of the max block size. The outputs can be the inputs
+   * @param inputs One pointer per channel
+   * @param outputs One pointer per channel
+   * @param nFrames The block size, which can be larger than the max block size
+   * @param delay The delay time in samples */
+  void ProcessBlock(T** inputs, T** outputs, int nFrames, T delay)
+  {
+    for (int pos = 0; pos < nFrames; pos += mMaxBlockSize)
+    {
+      const int n = std::min(nFrames - pos, mMaxBlockSize);
+
+      for (int c = 0; c < mNChans; c++)
+      {
+        mInPtrs[c] = inputs[c] + pos;
+        mOutPtrs[c] = outputs[c] + pos;
+      }
+
+      Write(mInPtrs.data(), n);
+      Read(mOutPtrs.data(), n, delay);
+    }
+  }
+
+private:
+  static constexpr int kPreGuard = 1; // x[-1] for the Lagrange interpolator
+  static constexpr int kGuard = 4;
+
+  T* GetChannel(int c) { return mBuffer.Get() + c * mStride + kPreGuard; }
+
+  T ClampDelay(T delay) const { return std::min(std::max(delay, GetMinDelay()), GetMaxDelay()); }
+
+  /** Split a delay into a sample offset from the write position, and an interpolation parameter.
+   * For None, Linear and Lagrange the output is between x[i] and x[i + 1] at frac, where i is the write position - offset.
+   * For Allpass the output is x[i + 1] delayed by frac, which is kept between 0.5 and 1.5 so that the all-pass coefficient is well away from -1 */
+  void GetOffset(T delay, int& offset, T& frac) const
+  {
+    switch (mInterp)
+    {
+      case EInterp::None:
+        offset = static_cast<int>(delay + T(0.5));
+        frac = T(0);
+        break;
+      case EInterp::Allpass:
+        offset = static_cast<int>(std::floor(delay - T(0.5))) + 1;
+        frac = delay - static_cast<T>(offset - 1);
+        break;
+      default:
+      {
+        offset = static_cast<int>(delay);
+        const T fd = delay - static_cast<T>(offset);
+
+        if (fd > T(0))
+        {
+          offset++;
+          frac = T(1) - fd;
+        }
+        else
+          frac = T(0);
+
+        break;
+      }
+    }
+  }
+
+  static void GetLagrangeCoeffs(T f, T* h)
+  {
+    const T fm1 = f - T(1);
+    const T fm2 = f - T(2);
+    const T fp1 = f + T(1);
+    h[0] = -f * fm1 * fm2 * T(1. / 6.);
+    h[1] = fp1 * fm1 * fm2 * T(0.5);
+    h[2] = -fp1 * f * fm2 * T(0.5);
+    h[3] = fp1 * f * fm1 * T(1. / 6.);
+  }
+
+  /** Read a contiguous span with a fixed delay, for all but the all-pass interpolator */
+  void ReadSpan(const T* x, T* pOut, int n, T frac) const
+  {
+    if (n <= 0)
+      return;
+
+    if (frac == T(0))
+    {
+      memcpy(pOut, x, n * sizeof(T));
+      return;
+    }
+
+    if (mInterp == EInterp::Lagrange)
+    {
+      T h[4];
+      GetLagrangeCoeffs(frac, h);
+
+      for (int s = 0; s < n; s++)
+        pOut[s] = h[0] * x[s - 1] + h[1] * x[s] + h[2] * x[s + 1] + h[3] * x[s + 2];
+    }
+    else
+    {
+      for (int s = 0; s < n; s++)
+        pOut[s] = x[s] + frac * (x[s + 1] - x[s]);
+    }
+  }
+
+  static void ReadAllpass(const T* x, T* pOut, int n, T frac, T& state)
+  {
+    const T eta = (T(1) - frac) / (T(1) + frac);
+    T y = state;
+
+    for (int s = 0; s < n; s++)
+    {
+      y = eta * (x[s + 1] - y) + x[s];
+      pOut[s] = y;
+    }
+
+    state = y;
+  }
+
+  WDL_TypedBuf<T> mBuffer;
+  WDL_TypedBuf<int> mIdx;
+  WDL_TypedBuf<T> mCoeffs;
+  WDL_TypedBuf<T> mAllpassState;
+  std::vector<const T*> mInPtrs;
+  std::vector<T*> mOutPtrs;
+  const int mNChans;
+  const int mNTaps;
+  EInterp mInterp;
+  int mMaxBlockSize = 0;
+  int mSize = 0; // A power of two
+  int mMask = 0;
+  int mStride = 0;
+  int mWritePos = 0;
+  int mBlockStart = 0; // The position of the first sample of the last block written
+};
+
 END_IPLUG_NAMESPACE
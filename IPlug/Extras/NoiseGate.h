@@ -25,16 +25,29 @@
  * @brief Multichannel NoiseGate
  */
 
-#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 #include "IPlugUtilities.h"
+#include "SIMDLanes.h"
 
 BEGIN_IPLUG_NAMESPACE
 
+/** A noise gate for NC channels, with an envelope follower on a trigger signal, hold, and attack and release smoothing of the gain.
+ * The envelope is computed for chunks of kChunkSize frames with coefficients that are only recalculated when a setting changes,
+ * then applied to each channel with SIMD multiplies. The envelope state is flushed of denormals once per chunk */
 template<typename T, int NC = 1>
 class NoiseGate
 {
 public:
+  static constexpr int kChunkSize = 64;
+
+  NoiseGate()
+  {
+    UpdateCoefficients();
+  }
+
   void SetThreshold(double thresholdDB)
   {
     mThreshold = DBToAmp(thresholdDB);
@@ -43,73 +56,133 @@ public:
   void SetSampleRate(double sampleRate)
   {
     mSampleRate = sampleRate;
+    UpdateCoefficients();
   }
   
   void SetAttackTime(double attackTime)
   {
     mAttackTime = std::max(attackTime, (1.0 / mSampleRate));
     mMinRate = std::min(mAttackTime, mReleaseTime);
+    UpdateCoefficients();
   }
   
   void SetHoldTime(double holdTime)
   {
     mHoldTime = std::max(holdTime, (1.0 / mSampleRate));
+    UpdateCoefficients();
   }
   
   void SetReleaseTime(double releaseTime)
   {
     mReleaseTime = std::max(releaseTime, (1.0 / mSampleRate));
     mMinRate = std::min(mAttackTime, mReleaseTime);
+    UpdateCoefficients();
   }
 
+  /** Gate the channels with the envelope of a sidechain. inputs and outputs can be the same buffers */
   void ProcessBlock(T** inputs, T** outputs, T* sidechain, int nChans, int nFrames)
   {
     assert(nChans <= NC);
 
-    for (auto s=0; s <nFrames; s++)
+    T gain[kChunkSize];
+
+    for (auto s = 0; s < nFrames; s += kChunkSize)
     {
-      auto trigger = sidechain[s];
-      auto gain = processSample(trigger);
-      for (auto c=0; c<nChans; c++)
+      const int n = std::min(kChunkSize, nFrames - s);
+      ProcessGain(sidechain + s, gain, n);
+
+      for (auto c = 0; c < nChans; c++)
+        MultiplyBlock(inputs[c] + s, gain, outputs[c] + s, n);
+    }
+  }
+
+  /** Gate the channels together, with the envelope of the loudest channel. inputs and outputs can be the same buffers */
+  void ProcessBlock(T** inputs, T** outputs, int nChans, int nFrames)
+  {
+    assert(nChans <= NC);
+
+    using Lanes = SIMDLanes<T>;
+    T trigger[kChunkSize];
+    T gain[kChunkSize];
+
+    for (auto s = 0; s < nFrames; s += kChunkSize)
+    {
+      const int n = std::min(kChunkSize, nFrames - s);
+      int i = 0;
+
+      for (; i + Lanes::kN <= n; i += Lanes::kN)
       {
-        outputs[c][s] = inputs[c][s] * gain;
+        auto peak = Lanes::Set1(T(0));
+
+        for (auto c = 0; c < nChans; c++)
+          peak = Lanes::Max(peak, Lanes::Abs(Lanes::Load(inputs[c] + s + i)));
+
+        Lanes::Store(trigger + i, peak);
       }
+
+      for (; i < n; i++)
+      {
+        T peak = T(0);
+
+        for (auto c = 0; c < nChans; c++)
+          peak = std::max(peak, std::abs(inputs[c][s + i]));
+
+        trigger[i] = peak;
+      }
+
+      ProcessGain(trigger, gain, n);
+
+      for (auto c = 0; c < nChans; c++)
+        MultiplyBlock(inputs[c] + s, gain, outputs[c] + s, n);
     }
   }
 
 private:
-  inline T processSample(T sample) 
+  void UpdateCoefficients()
   {
-    auto ampFollower = [](T x, T& y, double att, double rel, double sr) {
-      auto tau2pole = [](double tau, double sr) {
-        return std::exp(-1.0 / (tau * sr));
-      };
-      const auto absX = std::abs(x);
-      const auto coeff = (absX > y) ? T(tau2pole(att, sr)) : T(tau2pole(rel, sr));
-      y = (T(1) - coeff) * absX + coeff * y;
-      return y;
+    auto tau2pole = [](double tau, double sr) {
+      return std::exp(-1.0 / (tau * sr));
     };
-    
-    auto rawGate = ampFollower(sample, mHistory2, mMinRate, mMinRate, mSampleRate) > mThreshold;
-    
-    if (rawGate < mPrevGate)
-    {
-      mHoldCounter = int(mHoldTime * mSampleRate);
-    }
-    else 
+
+    mDetectorCoeff = T(tau2pole(mMinRate, mSampleRate));
+    mAttackCoeff = T(tau2pole(mAttackTime, mSampleRate));
+    mReleaseCoeff = T(tau2pole(mReleaseTime, mSampleRate));
+    mHoldSamples = int(mHoldTime * mSampleRate);
+  }
+
+  /** Computes the gain for n frames of the trigger signal */
+  void ProcessGain(const T* trigger, T* gain, int n)
+  {
+    const T detectorCoeff = mDetectorCoeff;
+    const T attackCoeff = mAttackCoeff;
+    const T releaseCoeff = mReleaseCoeff;
+    T detector = mHistory2;
+    T smoothed = mHistory1;
+    bool prevGate = mPrevGate;
+    int holdCounter = mHoldCounter;
+
+    for (auto s = 0; s < n; s++)
     {
-      if (mHoldCounter > 0)
-      {
-        mHoldCounter--;
-      }
+      detector = (T(1) - detectorCoeff) * std::abs(trigger[s]) + detectorCoeff * detector;
+
+      const bool rawGate = detector > mThreshold;
+
+      if (rawGate < prevGate)
+        holdCounter = mHoldSamples;
+      else if (holdCounter > 0)
+        holdCounter--;
+
+      const T heldGate = (rawGate || holdCounter > 0) ? T(1) : T(0);
+      const T coeff = heldGate > smoothed ? attackCoeff : releaseCoeff;
+      smoothed = (T(1) - coeff) * heldGate + coeff * smoothed;
+      prevGate = rawGate;
+      gain[s] = smoothed;
     }
-    
-    const auto heldGate = std::max(rawGate, mHoldCounter > 0);
-    const auto smoothed = ampFollower(T(heldGate), mHistory1, mAttackTime, mReleaseTime, mSampleRate);
 
-    mPrevGate = rawGate;
-    
-    return smoothed;
+    mHistory2 = FlushDenormal(detector);
+    mHistory1 = FlushDenormal(smoothed);
+    mPrevGate = prevGate;
+    mHoldCounter = holdCounter;
   }
 
   double mThreshold = 0.5;
@@ -118,7 +191,12 @@ private:
   double mHoldTime = 0.01f;
   double mReleaseTime = 0.01f;
   double mMinRate = mAttackTime;
-  T mHistory1, mHistory2 = 0.0f;
+  T mDetectorCoeff = T(0);
+  T mAttackCoeff = T(0);
+  T mReleaseCoeff = T(0);
+  int mHoldSamples = 0;
+  T mHistory1 = T(0); // smoothed gain
+  T mHistory2 = T(0); // detector envelope
   bool mPrevGate = false;
   int mHoldCounter = 0;
 };
@@ -0,0 +1,257 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include "IPlugOSC_thread.h"
+
+#if defined __linux__
+#include <sys/uio.h>
+#endif
+
+using namespace iplug;
+
+static constexpr int kReceiveBatchSize = 32;
+static constexpr int kMaxDatagramSize = 16384;
+static constexpr int kMaxBundleDepth = 8;
+static constexpr int kPollTimeoutMs = 100; // how long Stop() can take to be noticed
+static constexpr double kNTPToUnixEpoch = 2208988800.;
+
+static uint32_t ReadUInt32BE(const char* pData)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(pData);
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+OSCReceiverThread::OSCReceiverThread(int queueSize)
+: mEvents(queueSize)
+{
+  mScheduled.Resize(queueSize);
+}
+
+OSCReceiverThread::~OSCReceiverThread()
+{
+  Stop();
+}
+
+int OSCReceiverThread::AddAddress(const char* address)
+{
+  assert(!IsRunning() && "Addresses must be added before Start()");
+
+  if (IsRunning())
+    return -1;
+
+  return mAddresses.Add(address);
+}
+
+bool OSCReceiverThread::Start(int port, WDL_String& log)
+{
+  Stop();
+
+  JNL::open_socketlib();
+
+  mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (mSocket == INVALID_SOCKET)
+  {
+    log.AppendFormatted(1024, "Error creating OSC socket\r\n");
+    return false;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY;
+  addr.sin_port = htons(port);
+
+  // A large kernel buffer absorbs bursts while the thread is busy dispatching
+  int bufferSize = 1 << 20;
+  setsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, (char*) &bufferSize, sizeof(bufferSize));
+
+  if (bind(mSocket, (struct sockaddr*) &addr, sizeof(addr)))
+  {
+    closesocket(mSocket);
+    mSocket = INVALID_SOCKET;
+    log.AppendFormatted(1024, "Error listening for OSC on port %i\r\n", port);
+    return false;
+  }
+
+  SET_SOCK_BLOCK(mSocket, false);
+
+  const double systemNow = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  mSystemToSteadyOffset = Now() - systemNow;
+
+  mReceiveBuffers.Resize(kReceiveBatchSize * kMaxDatagramSize);
+  mNumReceived = 0;
+  mNumDropped = 0;
+  mRunning = true;
+  mThread = std::thread(&OSCReceiverThread::ThreadFunc, this);
+
+  log.AppendFormatted(1024, "Listening for OSC on port %i (network thread)\r\n", port);
+  return true;
+}
+
+void OSCReceiverThread::Stop()
+{
+  mRunning = false;
+
+  if (mThread.joinable())
+    mThread.join();
+
+  if (mSocket != INVALID_SOCKET)
+  {
+    closesocket(mSocket);
+    mSocket = INVALID_SOCKET;
+  }
+}
+
+void OSCReceiverThread::ThreadFunc()
+{
+  char* pBuffers = mReceiveBuffers.Get();
+
+#if defined __linux__
+  struct mmsghdr msgs[kReceiveBatchSize];
+  struct iovec iovecs[kReceiveBatchSize];
+  memset(msgs, 0, sizeof(msgs));
+
+  for (int i = 0; i < kReceiveBatchSize; i++)
+  {
+    iovecs[i].iov_base = pBuffers + i * kMaxDatagramSize;
+    iovecs[i].iov_len = kMaxDatagramSize;
+    msgs[i].msg_hdr.msg_iov = &iovecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+#endif
+
+  while (mRunning.load(std::memory_order_relaxed))
+  {
+    // Block until something arrives, with a timeout so that Stop() is noticed
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(mSocket, &readSet);
+    struct timeval timeout = {0, kPollTimeoutMs * 1000};
+
+    if (select((int) mSocket + 1, &readSet, nullptr, nullptr, &timeout) <= 0)
+      continue;
+
+    // Drain everything that is queued, one batch at a time
+    for (;;)
+    {
+      const double arrivalTime = Now();
+      int nReceived = 0;
+
+#if defined __linux__
+      nReceived = recvmmsg(mSocket, msgs, kReceiveBatchSize, MSG_DONTWAIT, nullptr);
+
+      for (int i = 0; i < nReceived; i++)
+        ParseElement(pBuffers + i * kMaxDatagramSize, static_cast<int>(msgs[i].msg_len), arrivalTime, 0);
+#else
+      for (; nReceived < kReceiveBatchSize; nReceived++)
+      {
+        char* pBuffer = pBuffers + nReceived * kMaxDatagramSize;
+        const int len = (int) recvfrom(mSocket, pBuffer, kMaxDatagramSize, 0, nullptr, nullptr);
+
+        if (len < 1)
+          break;
+
+        ParseElement(pBuffer, len, arrivalTime, 0);
+      }
+#endif
+
+      if (nReceived < kReceiveBatchSize)
+        break;
+    }
+  }
+}
+
+double OSCReceiverThread::TimeTagToTime(uint64_t timeTag, double arrivalTime) const
+{
+  if (timeTag <= 1) // 1 means "immediately"
+    return arrivalTime;
+
+  const double seconds = static_cast<double>(timeTag >> 32) + static_cast<double>(timeTag & 0xFFFFFFFF) / 4294967296.;
+  return seconds - kNTPToUnixEpoch + mSystemToSteadyOffset;
+}
+
+void OSCReceiverThread::ParseElement(char* pData, int size, double time, int depth)
+{
+  if (size >= 16 && !memcmp(pData, "#bundle", 8))
+  {
+    if (depth >= kMaxBundleDepth)
+      return;
+
+    const uint64_t timeTag = (uint64_t(ReadUInt32BE(pData + 8)) << 32) | ReadUInt32BE(pData + 12);
+    const double bundleTime = TimeTagToTime(timeTag, time);
+    int pos = 16;
+
+    while (pos + 4 <= size)
+    {
+      const int elementSize = static_cast<int>(ReadUInt32BE(pData + pos));
+      pos += 4;
+
+      if (elementSize <= 0 || elementSize > size - pos)
+        break;
+
+      ParseElement(pData + pos, elementSize, bundleTime, depth + 1);
+      pos += elementSize;
+    }
+  }
+  else if (size > 0 && pData[0] == '/')
+  {
+    OnMessage(pData, size, time);
+  }
+}
+
+void OSCReceiverThread::OnMessage(char* pData, int size, double time)
+{
+  OscMessageRead msg(pData, size); // byte swaps the arguments in place
+  const char* pAddress = msg.GetMessage();
+
+  if (!pAddress || !*pAddress)
+    return;
+
+  mNumReceived.fetch_add(1, std::memory_order_relaxed);
+
+  OSCEvent event;
+  event.mTime = time;
+
+  const int nArgs = msg.GetNumArgs();
+
+  for (int i = 0; i < nArgs && event.mNumArgs < OSCEvent::kMaxArgs; i++)
+  {
+    char type = 0;
+    const void* pArg = msg.GetIndexedArg(i, &type);
+
+    if (!pArg)
+      break;
+
+    if (type == 'i')
+    {
+      int value;
+      memcpy(&value, pArg, sizeof(value));
+      event.mArgs[event.mNumArgs] = static_cast<float>(value);
+    }
+    else if (type == 'f')
+    {
+      memcpy(&event.mArgs[event.mNumArgs], pArg, sizeof(float));
+    }
+    else
+    {
+      continue;
+    }
+
+    event.mTypes[event.mNumArgs++] = type;
+  }
+
+  mAddresses.Match(pAddress, [&](int id) {
+    event.mAddressID = id;
+
+    if (!mEvents.Push(event))
+      mNumDropped.fetch_add(1, std::memory_order_relaxed);
+  });
+}
@@ -0,0 +1,180 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file IPlug Open Sound Control (OSC) support - receiving on a dedicated network thread
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "jnetlib/jnetlib.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugQueue.h"
+#include "IPlugOSC_msg.h"
+#include "IPlugOSC_trie.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** An OSC message delivered by OSCReceiverThread, small enough to be copied through a lock-free queue */
+struct OSCEvent
+{
+  static constexpr int kMaxArgs = 8;
+
+  int mAddressID = -1; // ID returned by OSCReceiverThread::AddAddress()
+  int mNumArgs = 0;
+  double mTime = 0.; // seconds on the OSCReceiverThread::Now() clock, either the bundle time tag or the time of arrival
+  char mTypes[kMaxArgs] = {}; // 'i' or 'f', other argument types are skipped
+  float mArgs[kMaxArgs] = {}; // int arguments are converted to float
+};
+
+/** Receives OSC on its own thread, instead of polling on the UI timer like OSCReceiver.
+ * The thread blocks until datagrams arrive, reads them in batches (one recvmmsg() call per batch on Linux), parses messages and (nested) bundles,
+ * and resolves the address pattern of each message against an OSCAddressTrie built before Start().
+ * One OSCEvent per matching address is pushed into a lock-free queue, which a single consumer, typically the audio thread, reads with ProcessEvents().
+ * Events are timestamped, so that the consumer can place them at a sample offset that doesn't depend on when the block was processed */
+class OSCReceiverThread
+{
+public:
+  /** @param queueSize The maximum number of events waiting for the consumer, further events are dropped. As many events can be held for a later block */
+  OSCReceiverThread(int queueSize = 4096);
+  ~OSCReceiverThread();
+
+  OSCReceiverThread(const OSCReceiverThread&) = delete;
+  OSCReceiverThread& operator=(const OSCReceiverThread&) = delete;
+
+  /** Register an address to receive, must be called before Start()
+   * @param address An OSC address such as "/synth/1/cutoff"
+   * @return The ID that OSCEvent::mAddressID will have, or -1 if the address is not valid */
+  int AddAddress(const char* address);
+
+  /** Open the socket and start the network thread
+   * @param port The UDP port to listen on
+   * @param log Receives a description of what happened
+   * @return \c true on success */
+  bool Start(int port, WDL_String& log);
+
+  /** Stop the network thread and close the socket */
+  void Stop();
+
+  /** @return \c true if the network thread is running */
+  bool IsRunning() const { return mRunning.load(); }
+
+  /** Set the delay between the time of an event and the time it is rendered. Events that arrive during a block
+   * are only rendered in a later block, so a delay of about one block length gives sample accurate timing without jitter
+   * @param seconds The delay, 0 to render events as early as possible */
+  void SetRenderDelay(double seconds) { mRenderDelay = seconds; }
+
+  /** Call func(int offset, const OSCEvent& event) for each event due in the block that is about to be processed.
+   * Call this once per block from the consumer thread, at the start of ProcessBlock(). It doesn't allocate or lock.
+   * Events that are due in a later block are kept until then, each by its own time, so an event with a far time tag doesn't hold back
+   * the ones that arrive after it. Events in the past are delivered at offset 0
+   * @param nFrames The number of frames in the block
+   * @param sampleRate The sample rate
+   * @param func Called in timestamp order for events that arrived in order */
+  template <typename F>
+  void ProcessEvents(int nFrames, double sampleRate, F&& func)
+  {
+    const double blockStart = Now() - mRenderDelay;
+    OSCEvent* pScheduled = mScheduled.Get();
+
+    auto getOffset = [&](const OSCEvent& event) {
+      return (event.mTime - blockStart) * sampleRate;
+    };
+
+    auto deliver = [&](const OSCEvent& event) {
+      const double offset = getOffset(event);
+      func(offset > 0. ? static_cast<int>(offset) : 0, event);
+    };
+
+    while (mEvents.ElementsAvailable())
+    {
+      const OSCEvent& event = mEvents.Peek();
+
+      if (!mNumScheduled && getOffset(event) < nFrames)
+      {
+        deliver(event);
+        OSCEvent popped;
+        mEvents.Pop(popped);
+        continue;
+      }
+
+      // Later events wait in the queue once the scheduled events fill the buffer
+      if (mNumScheduled == mScheduled.GetSize())
+        break;
+
+      // Insertion sort, events usually arrive in timestamp order so this doesn't move anything
+      int pos = mNumScheduled++;
+
+      for (; pos > 0 && pScheduled[pos - 1].mTime > event.mTime; pos--)
+        pScheduled[pos] = pScheduled[pos - 1];
+
+      mEvents.Pop(pScheduled[pos]);
+    }
+
+    int nDue = 0;
+
+    while (nDue < mNumScheduled && getOffset(pScheduled[nDue]) < nFrames)
+      deliver(pScheduled[nDue++]);
+
+    if (nDue)
+    {
+      std::copy(pScheduled + nDue, pScheduled + mNumScheduled, pScheduled);
+      mNumScheduled -= nDue;
+    }
+  }
+
+  /** Pop the next event regardless of its timestamp, for consumers that are not rendering audio
+   * @return \c true if an event was popped */
+  bool PopEvent(OSCEvent& event) { return mEvents.Pop(event); }
+
+  /** @return The address space, to look up IDs or address strings */
+  const OSCAddressTrie& GetAddresses() const { return mAddresses; }
+
+  /** @return The number of OSC messages received since Start() */
+  uint64_t NumMessagesReceived() const { return mNumReceived.load(); }
+
+  /** @return The number of events dropped because the queue was full */
+  uint64_t NumEventsDropped() const { return mNumDropped.load(); }
+
+  /** @return The current time in seconds, on the clock used for OSCEvent::mTime */
+  static double Now()
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+private:
+  void ThreadFunc();
+  void ParseElement(char* pData, int size, double time, int depth);
+  void OnMessage(char* pData, int size, double time);
+  double TimeTagToTime(uint64_t timeTag, double arrivalTime) const;
+
+  OSCAddressTrie mAddresses;
+  IPlugQueue<OSCEvent> mEvents;
+  WDL_TypedBuf<OSCEvent> mScheduled; // popped by ProcessEvents() and due in a later block, in timestamp order
+  int mNumScheduled = 0;
+  std::thread mThread;
+  std::atomic<bool> mRunning {false};
+  std::atomic<uint64_t> mNumReceived {0};
+  std::atomic<uint64_t> mNumDropped {0};
+  SOCKET mSocket = INVALID_SOCKET;
+  WDL_TypedBuf<char> mReceiveBuffers;
+  std::atomic<double> mRenderDelay {0.};
+  double mSystemToSteadyOffset = 0.; // add to a system_clock time to get a steady_clock time
+};
+
+END_IPLUG_NAMESPACE
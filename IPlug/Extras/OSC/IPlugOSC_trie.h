@@ -0,0 +1,310 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file IPlug Open Sound Control (OSC) support - address space
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Match a single part of an OSC address (the text between two '/') against a part of an OSC address pattern.
+ * Supports the OSC 1.0 wildcards: '?', '*', '[abc]', '[a-z]', '[!abc]' and '{foo,bar}'
+ * @param pattern The pattern part, not null terminated
+ * @param patternLen Length of the pattern part
+ * @param str The address part, not null terminated
+ * @param strLen Length of the address part
+ * @return \c true if the pattern matches the whole address part */
+static bool OSCPatternMatch(const char* pattern, int patternLen, const char* str, int strLen)
+{
+  int p = 0, s = 0;
+
+  while (p < patternLen)
+  {
+    switch (pattern[p])
+    {
+      case '*':
+      {
+        while (p < patternLen && pattern[p] == '*')
+          p++;
+
+        if (p == patternLen)
+          return true;
+
+        for (int i = s; i <= strLen; i++)
+        {
+          if (OSCPatternMatch(pattern + p, patternLen - p, str + i, strLen - i))
+            return true;
+        }
+        return false;
+      }
+      case '?':
+      {
+        if (s >= strLen)
+          return false;
+
+        p++; s++;
+        break;
+      }
+      case '[':
+      {
+        if (s >= strLen)
+          return false;
+
+        int end = p + 1;
+        while (end < patternLen && pattern[end] != ']')
+          end++;
+
+        if (end == patternLen)
+          return false; // unterminated
+
+        int i = p + 1;
+        const bool negate = i < end && pattern[i] == '!';
+        if (negate) i++;
+
+        bool found = false;
+        for (; i < end; i++)
+        {
+          if (i + 2 < end && pattern[i + 1] == '-')
+          {
+            if (str[s] >= pattern[i] && str[s] <= pattern[i + 2])
+              found = true;
+            i += 2;
+          }
+          else if (pattern[i] == str[s])
+          {
+            found = true;
+          }
+        }
+
+        if (found == negate)
+          return false;
+
+        p = end + 1; s++;
+        break;
+      }
+      case '{':
+      {
+        int end = p + 1;
+        while (end < patternLen && pattern[end] != '}')
+          end++;
+
+        if (end == patternLen)
+          return false; // unterminated
+
+        int optionStart = p + 1;
+        for (int i = p + 1; i <= end; i++)
+        {
+          if (i == end || pattern[i] == ',')
+          {
+            const int optionLen = i - optionStart;
+
+            if (optionLen <= strLen - s && !strncmp(pattern + optionStart, str + s, optionLen)
+                && OSCPatternMatch(pattern + end + 1, patternLen - end - 1, str + s + optionLen, strLen - s - optionLen))
+              return true;
+
+            optionStart = i + 1;
+          }
+        }
+        return false;
+      }
+      default:
+      {
+        if (s >= strLen || pattern[p] != str[s])
+          return false;
+
+        p++; s++;
+        break;
+      }
+    }
+  }
+
+  return s == strLen;
+}
+
+/** A trie of OSC addresses (e.g. "/synth/1/cutoff"), which are registered up front and given integer IDs.
+ * Incoming address patterns are matched one part at a time, so the cost of a dispatch depends on the depth of the address space rather than on the number of addresses.
+ * Parts without wildcards are found by binary search in the sorted children of each node.
+ * Add() allocates and must be called before the trie is shared, Match() does not allocate and can be called from any thread once the trie has been built */
+class OSCAddressTrie
+{
+public:
+  OSCAddressTrie()
+  {
+    mNodes.emplace_back(); // root
+  }
+
+  /** Register an address
+   * @param address The address, starting with '/', without wildcards
+   * @return The ID of the address, or -1 if it is not valid. Registering the same address twice returns the same ID */
+  int Add(const char* address)
+  {
+    if (!address || address[0] != '/')
+      return -1;
+
+    int node = 0;
+    const char* pPart = address + 1;
+
+    while (true)
+    {
+      const char* pEnd = strchr(pPart, '/');
+      const int len = pEnd ? static_cast<int>(pEnd - pPart) : static_cast<int>(strlen(pPart));
+
+      if (!len || HasReservedChars(pPart, len))
+        return -1;
+
+      node = FindOrAddChild(node, pPart, len);
+
+      if (!pEnd)
+        break;
+
+      pPart = pEnd + 1;
+    }
+
+    if (mNodes[node].mID < 0)
+    {
+      mNodes[node].mID = mNumAddresses++;
+      mAddresses.emplace_back(address);
+    }
+
+    return mNodes[node].mID;
+  }
+
+  /** Call func(int id) for every registered address that matches an address pattern
+   * @param pattern The address pattern, as received in an OSC message
+   * @param func Called with the ID of each matching address
+   * @return The number of matching addresses */
+  template <typename F>
+  int Match(const char* pattern, F&& func) const
+  {
+    if (!pattern || pattern[0] != '/')
+      return 0;
+
+    return MatchNode(0, pattern + 1, func);
+  }
+
+  /** @return The ID of an exact address, or -1 if it is not registered */
+  int Find(const char* address) const
+  {
+    int id = -1;
+    Match(address, [&id](int matchID) { id = matchID; });
+    return id;
+  }
+
+  /** @return The address registered with an ID */
+  const char* GetAddress(int id) const { return (id >= 0 && id < mNumAddresses) ? mAddresses[id].c_str() : ""; }
+
+  /** @return The number of registered addresses */
+  int NumAddresses() const { return mNumAddresses; }
+
+private:
+  struct Node
+  {
+    std::string mName;
+    std::vector<int> mChildren; // sorted by name
+    int mID = -1;
+  };
+
+  static bool HasReservedChars(const char* pPart, int len)
+  {
+    for (int i = 0; i < len; i++)
+    {
+      if (strchr("*?[]{},# ", pPart[i]))
+        return true;
+    }
+
+    return false;
+  }
+
+  int FindOrAddChild(int node, const char* name, int len)
+  {
+    auto& children = mNodes[node].mChildren;
+    auto it = std::lower_bound(children.begin(), children.end(), std::string(name, len), [this](int child, const std::string& str) {
+      return mNodes[child].mName < str;
+    });
+
+    if (it != children.end() && mNodes[*it].mName.compare(0, std::string::npos, name, len) == 0)
+      return *it;
+
+    const int newNode = static_cast<int>(mNodes.size());
+    const auto insertPos = it - children.begin();
+    mNodes.emplace_back();
+    mNodes.back().mName.assign(name, len);
+    mNodes[node].mChildren.insert(mNodes[node].mChildren.begin() + insertPos, newNode);
+    return newNode;
+  }
+
+  template <typename F>
+  int MatchNode(int node, const char* pPart, F& func) const
+  {
+    const char* pEnd = strchr(pPart, '/');
+    const int len = pEnd ? static_cast<int>(pEnd - pPart) : static_cast<int>(strlen(pPart));
+    const auto& children = mNodes[node].mChildren;
+    int nMatches = 0;
+
+    auto onMatch = [&](int child) {
+      if (pEnd)
+        nMatches += MatchNode(child, pEnd + 1, func);
+      else if (mNodes[child].mID >= 0)
+      {
+        func(mNodes[child].mID);
+        nMatches++;
+      }
+    };
+
+    if (!HasReservedChars(pPart, len))
+    {
+      // Binary search without building a string
+      int lo = 0, hi = static_cast<int>(children.size()) - 1;
+
+      while (lo <= hi)
+      {
+        const int mid = (lo + hi) / 2;
+        const int cmp = mNodes[children[mid]].mName.compare(0, std::string::npos, pPart, len);
+
+        if (cmp == 0)
+        {
+          onMatch(children[mid]);
+          break;
+        }
+        else if (cmp < 0)
+          lo = mid + 1;
+        else
+          hi = mid - 1;
+      }
+    }
+    else
+    {
+      for (int child : children)
+      {
+        const std::string& name = mNodes[child].mName;
+
+        if (OSCPatternMatch(pPart, len, name.c_str(), static_cast<int>(name.size())))
+          onMatch(child);
+      }
+    }
+
+    return nMatches;
+  }
+
+  std::vector<Node> mNodes;
+  std::vector<std::string> mAddresses;
+  int mNumAddresses = 0;
+};
+
+END_IPLUG_NAMESPACE
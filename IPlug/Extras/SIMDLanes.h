@@ -0,0 +1,292 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @brief SIMD vectors of float or double for the block kernels in IPlug/Extras
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define IPLUG_LANES_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define IPLUG_LANES_NEON 1
+#endif
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Operations on a SIMD vector of kN values of T, SSE2 on x86 and NEON on arm64, one value wide on other targets.
+ * Kernels use it either along time, with Load() and Store(), or with one channel per lane, with Gather() and Scatter() for one sample frame,
+ * or LoadTransposed() and StoreTransposed() for kN frames of kN channels at once.
+ * FlushDenormals() zeroes denormals like denormal_fix(), with a compare and a mask instead of a branch, so it doesn't depend on the FTZ/DAZ state of the thread */
+template <typename T>
+struct SIMDLanes
+{
+  using V = T;
+  static constexpr int kN = 1;
+
+  static inline V Set1(T x) { return x; }
+  static inline V Load(const T* p) { return *p; }
+  static inline void Store(T* p, V v) { *p = v; }
+  static inline V Add(V a, V b) { return a + b; }
+  static inline V Sub(V a, V b) { return a - b; }
+  static inline V Mul(V a, V b) { return a * b; }
+  static inline V Max(V a, V b) { return a > b ? a : b; }
+  static inline V Abs(V a) { return std::abs(a); }
+  static inline V FlushDenormals(V a) { return std::abs(a) < std::numeric_limits<T>::min() ? T(0) : a; }
+  static inline V Gather(const T* const* chans, int s) { return chans[0][s]; }
+  static inline void Scatter(T* const* chans, int s, V v) { chans[0][s] = v; }
+  static inline void LoadTransposed(const T* const* chans, int s, V* v) { v[0] = chans[0][s]; }
+  static inline void StoreTransposed(T* const* chans, int s, const V* v) { chans[0][s] = v[0]; }
+};
+
+#if defined IPLUG_LANES_SSE2
+template <>
+struct SIMDLanes<float>
+{
+  using V = __m128;
+  static constexpr int kN = 4;
+
+  static inline V Set1(float x) { return _mm_set1_ps(x); }
+  static inline V Load(const float* p) { return _mm_loadu_ps(p); }
+  static inline void Store(float* p, V v) { _mm_storeu_ps(p, v); }
+  static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+  static inline V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+  static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+  static inline V Max(V a, V b) { return _mm_max_ps(a, b); }
+  static inline V Abs(V a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+  static inline V FlushDenormals(V a) { return _mm_andnot_ps(_mm_cmplt_ps(Abs(a), _mm_set1_ps(FLT_MIN)), a); }
+
+  static inline V Gather(const float* const* chans, int s)
+  {
+    return _mm_set_ps(chans[3][s], chans[2][s], chans[1][s], chans[0][s]);
+  }
+
+  static inline void Scatter(float* const* chans, int s, V v)
+  {
+    alignas(16) float x[4];
+    _mm_store_ps(x, v);
+    chans[0][s] = x[0]; chans[1][s] = x[1]; chans[2][s] = x[2]; chans[3][s] = x[3];
+  }
+
+  static inline void LoadTransposed(const float* const* chans, int s, V* v)
+  {
+    v[0] = _mm_loadu_ps(chans[0] + s);
+    v[1] = _mm_loadu_ps(chans[1] + s);
+    v[2] = _mm_loadu_ps(chans[2] + s);
+    v[3] = _mm_loadu_ps(chans[3] + s);
+    _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+  }
+
+  static inline void StoreTransposed(float* const* chans, int s, const V* v)
+  {
+    V t0 = v[0], t1 = v[1], t2 = v[2], t3 = v[3];
+    _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+    _mm_storeu_ps(chans[0] + s, t0);
+    _mm_storeu_ps(chans[1] + s, t1);
+    _mm_storeu_ps(chans[2] + s, t2);
+    _mm_storeu_ps(chans[3] + s, t3);
+  }
+};
+
+template <>
+struct SIMDLanes<double>
+{
+  using V = __m128d;
+  static constexpr int kN = 2;
+
+  static inline V Set1(double x) { return _mm_set1_pd(x); }
+  static inline V Load(const double* p) { return _mm_loadu_pd(p); }
+  static inline void Store(double* p, V v) { _mm_storeu_pd(p, v); }
+  static inline V Add(V a, V b) { return _mm_add_pd(a, b); }
+  static inline V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+  static inline V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+  static inline V Max(V a, V b) { return _mm_max_pd(a, b); }
+  static inline V Abs(V a) { return _mm_and_pd(a, _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL))); }
+  static inline V FlushDenormals(V a) { return _mm_andnot_pd(_mm_cmplt_pd(Abs(a), _mm_set1_pd(DBL_MIN)), a); }
+  static inline V Gather(const double* const* chans, int s) { return _mm_set_pd(chans[1][s], chans[0][s]); }
+
+  static inline void Scatter(double* const* chans, int s, V v)
+  {
+    _mm_storel_pd(chans[0] + s, v);
+    _mm_storeh_pd(chans[1] + s, v);
+  }
+
+  static inline void LoadTransposed(const double* const* chans, int s, V* v)
+  {
+    const V a = _mm_loadu_pd(chans[0] + s);
+    const V b = _mm_loadu_pd(chans[1] + s);
+    v[0] = _mm_unpacklo_pd(a, b);
+    v[1] = _mm_unpackhi_pd(a, b);
+  }
+
+  static inline void StoreTransposed(double* const* chans, int s, const V* v)
+  {
+    _mm_storeu_pd(chans[0] + s, _mm_unpacklo_pd(v[0], v[1]));
+    _mm_storeu_pd(chans[1] + s, _mm_unpackhi_pd(v[0], v[1]));
+  }
+};
+#elif defined IPLUG_LANES_NEON
+template <>
+struct SIMDLanes<float>
+{
+  using V = float32x4_t;
+  static constexpr int kN = 4;
+
+  static inline V Set1(float x) { return vdupq_n_f32(x); }
+  static inline V Load(const float* p) { return vld1q_f32(p); }
+  static inline void Store(float* p, V v) { vst1q_f32(p, v); }
+  static inline V Add(V a, V b) { return vaddq_f32(a, b); }
+  static inline V Sub(V a, V b) { return vsubq_f32(a, b); }
+  static inline V Mul(V a, V b) { return vmulq_f32(a, b); }
+  static inline V Max(V a, V b) { return vmaxq_f32(a, b); }
+  static inline V Abs(V a) { return vabsq_f32(a); }
+
+  static inline V FlushDenormals(V a)
+  {
+    const uint32x4_t denormal = vcltq_f32(vabsq_f32(a), vdupq_n_f32(FLT_MIN));
+    return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a), denormal));
+  }
+
+  static inline V Gather(const float* const* chans, int s)
+  {
+    const float x[4] = { chans[0][s], chans[1][s], chans[2][s], chans[3][s] };
+    return vld1q_f32(x);
+  }
+
+  static inline void Scatter(float* const* chans, int s, V v)
+  {
+    vst1q_lane_f32(chans[0] + s, v, 0);
+    vst1q_lane_f32(chans[1] + s, v, 1);
+    vst1q_lane_f32(chans[2] + s, v, 2);
+    vst1q_lane_f32(chans[3] + s, v, 3);
+  }
+
+  static inline void Transpose(V& r0, V& r1, V& r2, V& r3)
+  {
+    const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+  }
+
+  static inline void LoadTransposed(const float* const* chans, int s, V* v)
+  {
+    v[0] = vld1q_f32(chans[0] + s);
+    v[1] = vld1q_f32(chans[1] + s);
+    v[2] = vld1q_f32(chans[2] + s);
+    v[3] = vld1q_f32(chans[3] + s);
+    Transpose(v[0], v[1], v[2], v[3]);
+  }
+
+  static inline void StoreTransposed(float* const* chans, int s, const V* v)
+  {
+    V t0 = v[0], t1 = v[1], t2 = v[2], t3 = v[3];
+    Transpose(t0, t1, t2, t3);
+    vst1q_f32(chans[0] + s, t0);
+    vst1q_f32(chans[1] + s, t1);
+    vst1q_f32(chans[2] + s, t2);
+    vst1q_f32(chans[3] + s, t3);
+  }
+};
+
+template <>
+struct SIMDLanes<double>
+{
+  using V = float64x2_t;
+  static constexpr int kN = 2;
+
+  static inline V Set1(double x) { return vdupq_n_f64(x); }
+  static inline V Load(const double* p) { return vld1q_f64(p); }
+  static inline void Store(double* p, V v) { vst1q_f64(p, v); }
+  static inline V Add(V a, V b) { return vaddq_f64(a, b); }
+  static inline V Sub(V a, V b) { return vsubq_f64(a, b); }
+  static inline V Mul(V a, V b) { return vmulq_f64(a, b); }
+  static inline V Max(V a, V b) { return vmaxq_f64(a, b); }
+  static inline V Abs(V a) { return vabsq_f64(a); }
+
+  static inline V FlushDenormals(V a)
+  {
+    const uint64x2_t denormal = vcltq_f64(vabsq_f64(a), vdupq_n_f64(DBL_MIN));
+    return vreinterpretq_f64_u64(vbicq_u64(vreinterpretq_u64_f64(a), denormal));
+  }
+
+  static inline V Gather(const double* const* chans, int s) { return vcombine_f64(vld1_f64(chans[0] + s), vld1_f64(chans[1] + s)); }
+
+  static inline void Scatter(double* const* chans, int s, V v)
+  {
+    vst1q_lane_f64(chans[0] + s, v, 0);
+    vst1q_lane_f64(chans[1] + s, v, 1);
+  }
+
+  static inline void LoadTransposed(const double* const* chans, int s, V* v)
+  {
+    const V a = vld1q_f64(chans[0] + s);
+    const V b = vld1q_f64(chans[1] + s);
+    v[0] = vzip1q_f64(a, b);
+    v[1] = vzip2q_f64(a, b);
+  }
+
+  static inline void StoreTransposed(double* const* chans, int s, const V* v)
+  {
+    vst1q_f64(chans[0] + s, vzip1q_f64(v[0], v[1]));
+    vst1q_f64(chans[1] + s, vzip2q_f64(v[0], v[1]));
+  }
+};
+#endif
+
+/** Zero a denormal value like denormal_fix(), but without a branch */
+template <typename T>
+static inline T FlushDenormal(T x)
+{
+  return std::abs(x) < std::numeric_limits<T>::min() ? T(0) : x;
+}
+
+/** Multiply a buffer by a gain per sample. pIn and pOut can be the same buffer */
+template <typename T>
+static inline void MultiplyBlock(const T* pIn, const T* pGain, T* pOut, int nFrames)
+{
+  using Lanes = SIMDLanes<T>;
+  int s = 0;
+
+  for (; s + Lanes::kN <= nFrames; s += Lanes::kN)
+    Lanes::Store(pOut + s, Lanes::Mul(Lanes::Load(pIn + s), Lanes::Load(pGain + s)));
+
+  for (; s < nFrames; s++)
+    pOut[s] = pIn[s] * pGain[s];
+}
+
+/** Multiply a buffer by a constant gain. pIn and pOut can be the same buffer */
+template <typename T>
+static inline void MultiplyBlock(const T* pIn, T gain, T* pOut, int nFrames)
+{
+  using Lanes = SIMDLanes<T>;
+  const typename Lanes::V g = Lanes::Set1(gain);
+  int s = 0;
+
+  for (; s + Lanes::kN <= nFrames; s += Lanes::kN)
+    Lanes::Store(pOut + s, Lanes::Mul(Lanes::Load(pIn + s), g));
+
+  for (; s < nFrames; s++)
+    pOut[s] = pIn[s] * gain;
+}
+
+END_IPLUG_NAMESPACE
@@ -0,0 +1,167 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "IPlugPlatform.h"
+
+#include "convoengine.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Shares prepared (resampled and FFT'd) impulse responses between all instances of a plug-in in the same process.
+ * Entries are keyed by a hash of the source IR content, the target sample rate and the FFT size requested.
+ * The first instance to Acquire() a key builds the entry, subsequent instances get the same read-only partitions,
+ * which they attach to their own WDL_ConvolutionEngine via WDL_ConvolutionEngine::SetImpulseShared().
+ * An entry is freed when the last EntryPtr referencing it is released.
+ * Define WDL_FFT_REALSIZE before including this file, as for convoengine.h */
+class SharedImpulseStore
+{
+public:
+  /** A prepared impulse, owned by the store and shared read-only between instances */
+  class Entry
+  {
+  public:
+    /** @return The engine holding the FFT'd partitions, pass this to WDL_ConvolutionEngine::SetImpulseShared() */
+    const WDL_ConvolutionEngine* GetEngine() const { return &mEngine; }
+
+    /** @return The latency of an engine sharing this impulse, in samples */
+    int GetLatency() const { return mLatency; }
+
+    /** @return The sample rate the impulse was prepared for */
+    double GetSampleRate() const { return mSampleRate; }
+
+  private:
+    friend class SharedImpulseStore;
+    WDL_ConvolutionEngine mEngine;
+    int mLatency = 0;
+    double mSampleRate = 0.;
+  };
+
+  using EntryPtr = std::shared_ptr<const Entry>;
+
+  /** A function that fills the impulse buffer (sample rate, channel count and length) for a key that is not in the store yet */
+  using FillFunc = std::function<void(WDL_ImpulseBuffer& impulse)>;
+
+  /** @return The store shared by every instance in this binary */
+  static SharedImpulseStore& Get()
+  {
+    static SharedImpulseStore sStore;
+    return sStore;
+  }
+
+  /** Hash raw IR data, to be used as the contentHash argument to Acquire()
+   * @param pData Pointer to the IR data
+   * @param sizeInBytes Size of the IR data in bytes
+   * @param seed Previous hash, when combining several channels or buffers
+   * @return A 64-bit FNV-1a hash of the data */
+  static uint64_t Hash(const void* pData, size_t sizeInBytes, uint64_t seed = 14695981039346656037ULL)
+  {
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < sizeInBytes; i++)
+    {
+      hash ^= pBytes[i];
+      hash *= 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
+  /** Get the entry for a key, building it with fillFunc if no instance holds it yet.
+   * Building is serialised, so concurrent instances asking for the same IR only resample and transform it once.
+   * This allocates and may be slow on a miss, don't call it on the audio thread
+   * @param contentHash Hash of the source IR content, see Hash()
+   * @param sampleRate The sample rate the IR is prepared for
+   * @param fftSize The FFT size to pass to WDL_ConvolutionEngine::SetImpulse(), -1 for automatic
+   * @param fillFunc Called on a miss, to fill the impulse buffer at sampleRate
+   * @return The shared entry, or nullptr if fillFunc produced an empty impulse */
+  EntryPtr Acquire(uint64_t contentHash, double sampleRate, int fftSize, const FillFunc& fillFunc)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const Key key {contentHash, sampleRate, fftSize};
+
+    auto it = mEntries.find(key);
+    if (it != mEntries.end())
+    {
+      if (auto pExisting = it->second.lock())
+        return pExisting;
+    }
+
+    WDL_ImpulseBuffer impulse;
+    impulse.samplerate = sampleRate;
+    fillFunc(impulse);
+
+    if (!impulse.GetLength())
+      return nullptr;
+
+    auto pEntry = std::make_shared<Entry>();
+    pEntry->mSampleRate = sampleRate;
+    pEntry->mEngine.SetImpulse(&impulse, fftSize);
+    pEntry->mLatency = pEntry->mEngine.GetLatency();
+
+    // Purge stale keys while the lock is held anyway
+    for (auto itr = mEntries.begin(); itr != mEntries.end();)
+    {
+      if (itr->second.expired())
+        itr = mEntries.erase(itr);
+      else
+        ++itr;
+    }
+
+    mEntries[key] = pEntry;
+    return pEntry;
+  }
+
+  /** @return The number of entries currently held by at least one instance */
+  int NumEntries() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    int count = 0;
+
+    for (auto& entry : mEntries)
+    {
+      if (!entry.second.expired())
+        count++;
+    }
+
+    return count;
+  }
+
+private:
+  SharedImpulseStore() = default;
+  SharedImpulseStore(const SharedImpulseStore&) = delete;
+  SharedImpulseStore& operator=(const SharedImpulseStore&) = delete;
+
+  struct Key
+  {
+    uint64_t hash;
+    double sampleRate;
+    int fftSize;
+
+    bool operator<(const Key& other) const
+    {
+      return std::tie(hash, sampleRate, fftSize) < std::tie(other.hash, other.sampleRate, other.fftSize);
+    }
+  };
+
+  mutable std::mutex mMutex;
+  std::map<Key, std::weak_ptr<Entry>> mEntries;
+};
+
+END_IPLUG_NAMESPACE
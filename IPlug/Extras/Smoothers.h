@@ -9,8 +9,12 @@
 */
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+
 #include "denormal.h"
 #include "IPlugConstants.h"
+#include "SIMDLanes.h"
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -42,6 +46,11 @@ public:
     return mOutM1[0];
   }
 
+  inline T GetValue(int chan = 0) const
+  {
+    return mOutM1[chan];
+  }
+
   inline void SetValue(T value)
   {
     for (auto i = 0; i < NC; i++)
@@ -87,10 +96,15 @@ public:
 
 } WDL_FIXALIGN;
 
+/** Applies a gain to a number of channels, smoothed with a LogParamSmooth when it changes.
+ * The ramp is computed for chunks of kChunkSize frames and applied to each channel with SIMD multiplies.
+ * Once the ramp has settled the gain is applied as a constant, and skipped when it is unity and processing is in place */
 template<typename T>
 class SmoothedGain
 {
 public:
+  static constexpr int kChunkSize = 64;
+
   SmoothedGain(double smoothingTime = 5.0)
   : mSmoothingTime(smoothingTime)
   {
@@ -98,13 +112,30 @@ public:
   
   void ProcessBlock(T** inputs, T** outputs, int nChans, int nFrames, double gainValue)
   {
-    for (auto s = 0; s < nFrames; ++s)
+    T gain[kChunkSize];
+
+    for (auto s = 0; s < nFrames; s += kChunkSize)
     {
-      const T smoothedGain = static_cast<T>(mSmoother.Process(gainValue));
-      
-      for (auto c = 0; c < nChans; c++)
+      const int n = std::min(kChunkSize, nFrames - s);
+
+      if (std::abs(mSmoother.GetValue() - gainValue) < kSettled)
+      {
+        mSmoother.SetValue(gainValue);
+        const T constantGain = static_cast<T>(gainValue);
+
+        for (auto c = 0; c < nChans; c++)
+        {
+          if (constantGain != T(1) || inputs[c] != outputs[c])
+            MultiplyBlock(inputs[c] + s, constantGain, outputs[c] + s, n);
+        }
+      }
+      else
       {
-        outputs[c][s] = inputs[c][s] * smoothedGain;
+        for (auto i = 0; i < n; i++)
+          gain[i] = static_cast<T>(mSmoother.Process(gainValue));
+
+        for (auto c = 0; c < nChans; c++)
+          MultiplyBlock(inputs[c] + s, gain, outputs[c] + s, n);
       }
     }
   }
@@ -115,6 +146,8 @@ public:
   }
   
 private:
+  static constexpr double kSettled = 1e-7; // -140dB, the ramp is snapped to the target within this
+
   const double mSmoothingTime;
   LogParamSmooth<double, 1> mSmoother;
 } WDL_FIXALIGN;
@@ -139,6 +139,12 @@ public:
     }
   }
 
+  // true if no glide is in progress and Process() would leave the output ramp unchanged.
+  bool IsSettled() const
+  {
+    return !mSamplesRemaining && (mpOutput.startValue == mpOutput.endValue);
+  }
+
   // set the next target for the glide without writing directly to the ramp.
   void SetTarget(double targetValue, int startOffset, int glideSamples, int blockSize)
   {
@@ -12,11 +12,9 @@
 
 using namespace iplug;
 
-MidiSynth::MidiSynth(VoiceAllocator::EPolyMode mode, int blockSize)
+MidiSynthBase::MidiSynthBase(int blockSize)
 : mBlockSize(blockSize)
 {
-  SetPolyMode(mode);
-
   for(int i=0; i<128; i++)
   {
     mVelocityLUT[i] = i / 127.f;
@@ -31,11 +29,7 @@ MidiSynth::MidiSynth(VoiceAllocator::EPolyMode mode, int blockSize)
   }
 }
 
-MidiSynth::~MidiSynth()
-{
-}
-
-VoiceInputEvent MidiSynth::MidiMessageToEventBasic(const IMidiMsg& msg)
+VoiceInputEvent MidiSynthBase::MidiMessageToEventBasic(const IMidiMsg& msg)
 {
   VoiceInputEvent event{};
 
@@ -127,7 +121,7 @@ VoiceInputEvent MidiSynth::MidiMessageToEventBasic(const IMidiMsg& msg)
 }
 
 // Here we handle the MIDI messages used by MPE as listed in the MPE spec, page 7
-VoiceInputEvent MidiSynth::MidiMessageToEventMPE(const IMidiMsg& msg)
+VoiceInputEvent MidiSynthBase::MidiMessageToEventMPE(const IMidiMsg& msg)
 {
   VoiceInputEvent event{};
   IMidiMsg::EStatusMsg status = msg.StatusMsg();
@@ -256,13 +250,13 @@ VoiceInputEvent MidiSynth::MidiMessageToEventMPE(const IMidiMsg& msg)
   return event;
 }
 
-VoiceInputEvent MidiSynth::MidiMessageToEvent(const IMidiMsg& msg)
+VoiceInputEvent MidiSynthBase::MidiMessageToEvent(const IMidiMsg& msg)
 {
   return (mMPEMode ? MidiMessageToEventMPE(msg) : MidiMessageToEventBasic(msg));
 }
 
 // sets the number of channels in the lo or hi MPE zones.
-void MidiSynth::SetMPEZones(int channel, int nChans)
+void MidiSynthBase::SetMPEZones(int channel, int nChans)
 {
   // total channels = member channels + the master channel, or 0 if there is no Zone.
   // totalChannels is never 1.
@@ -311,7 +305,7 @@ void MidiSynth::SetMPEZones(int channel, int nChans)
   std::cout << "MPE channels: \n    lo: " << mMPELowerZoneChannels << " hi " << mMPEUpperZoneChannels << "\n";
 }
 
-void MidiSynth::SetChannelPitchBendRange(int channelParam, int rangeParam)
+void MidiSynthBase::SetChannelPitchBendRange(int channelParam, int rangeParam)
 {
   int channelLo, channelHi;
   if(IsInLowerZone(channelParam))
@@ -337,14 +331,14 @@ void MidiSynth::SetChannelPitchBendRange(int channelParam, int rangeParam)
   }
 }
 
-bool IsRPNMessage(IMidiMsg msg)
+bool MidiSynthBase::IsRPNMessage(const IMidiMsg& msg)
 {
   if(msg.StatusMsg() != IMidiMsg::kControlChange) return false;
   int cc = msg.mData1;
   return(cc == 0x64)||(cc == 0x65)||(cc == 0x26)||(cc == 0x06);
 }
 
-void MidiSynth::HandleRPN(IMidiMsg msg)
+void MidiSynthBase::HandleRPN(IMidiMsg msg)
 {
   int channel = msg.Channel();
   ChannelState& state = mChannelStates[channel];
@@ -399,91 +393,5 @@ void MidiSynth::HandleRPN(IMidiMsg msg)
   }
 }
 
-bool MidiSynth::ProcessBlock(sample** inputs, sample** outputs, int nInputs, int nOutputs, int nFrames)
-{
-  assert(NVoices());
-
-  if (mVoicesAreActive | !mMidiQueue.Empty())
-  {
-    int blockSize = mBlockSize;
-    int samplesRemaining = nFrames;
-    int startIndex = 0;
-
-    while(samplesRemaining > 0)
-    {
-      if(samplesRemaining < blockSize)
-        blockSize = samplesRemaining;
-
-      while (!mMidiQueue.Empty())
-      {
-        IMidiMsg msg = mMidiQueue.Peek();
-
-        // we assume the messages are in chronological order. If we find one later than the current block we are done.
-        if (msg.mOffset > startIndex + blockSize) break;
-
-        if(IsRPNMessage(msg))
-        {
-          HandleRPN(msg);
-        }
-        else
-        {
-          // send performance messages to the voice allocator
-          // message offset is relative to the start of this processSamples() block
-          msg.mOffset -= startIndex;
-          mVoiceAllocator.AddEvent(MidiMessageToEvent(msg));
-        }
-        mMidiQueue.Remove();
-      }
-
-      mVoiceAllocator.ProcessEvents(blockSize, mSampleTime);
-      mVoiceAllocator.ProcessVoices(inputs, outputs, nInputs, nOutputs, startIndex, blockSize);
-
-      samplesRemaining -= blockSize;
-      startIndex += blockSize;
-      mSampleTime += blockSize;
-    }
-
-    bool voicesbusy = false;
-    int activeCount = 0;
-
-    for(int v = 0; v < NVoices(); v++)
-    {
-      bool busy = GetVoice(v)->GetBusy();
-      voicesbusy |= busy;
-
-      activeCount += (busy==true);
-#if DEBUG_VOICE_COUNT
-      if(GetVoice(v)->GetBusy()) printf("X");
-      else DBGMSG("_");
-    }
-    DBGMSG("\n");
-    DBGMSG("Num Voices busy %i\n", activeCount);
-#else
-    }
-#endif
-
-    mVoicesAreActive = voicesbusy;
-
-    mMidiQueue.Flush(nFrames);
-  }
-  else // empty block
-  {
-    return true;
-  }
-
-  return false; // made some noise
-}
-
-void MidiSynth::SetSampleRateAndBlockSize(double sampleRate, int blockSize)
-{
-  Reset();
-
-  mSampleRate = sampleRate;
-  mMidiQueue.Resize(blockSize);
-  mVoiceAllocator.SetSampleRateAndBlockSize(sampleRate, blockSize);
-
-  for(int v = 0; v < NVoices(); v++)
-  {
-    GetVoice(v)->SetSampleRateAndBlockSize(sampleRate, blockSize);
-  }
-}
+// MidiSynth, for SynthVoice pointers
+template class iplug::MidiSynthT<SynthVoice>;
@@ -16,6 +16,7 @@
  */
 
 #include <array>
+#include <cstdlib>
 #include <vector>
 #include <stdint.h>
 
@@ -32,30 +33,18 @@
 
 BEGIN_IPLUG_NAMESPACE
 
-/** A monophonic/polyphonic synthesiser base class which can be supplied with a custom voice.
- *  Supports different kinds of after touch, pitch bend, velocity and after touch curves, unison (currently monophonic mode only) */
-class MidiSynth
+/** The MIDI and MPE handling of MidiSynthT, which doesn't depend on the voice type */
+class MidiSynthBase
 {
 public:
   /** This defines the size in samples of a single block of processing that will be done by the synth. */
   static constexpr int kDefaultBlockSize = 32;
   static constexpr int kDefaultPitchBendRange = 12;
 
-#pragma mark - MidiSynth class
+  MidiSynthBase(int blockSize);
 
-  MidiSynth(VoiceAllocator::EPolyMode mode, int blockSize = kDefaultBlockSize);
-  ~MidiSynth();
-
-  MidiSynth(const MidiSynth&) = delete;
-  MidiSynth& operator=(const MidiSynth&) = delete;
-    
-  void Reset()
-  {
-    mSampleTime = 0;
-    mVoiceAllocator.Clear();
-  }
-
-  void SetSampleRateAndBlockSize(double sampleRate, int blockSize);
+  MidiSynthBase(const MidiSynthBase&) = delete;
+  MidiSynthBase& operator=(const MidiSynthBase&) = delete;
 
   /** If you are using this class in a non-traditional mode of polyphony (e.g.to stack loads of voices) you might want to manually SetVoicesActive()
    * usually this would happen when you trigger notes
@@ -84,12 +73,113 @@ public:
     }
   }
 
-  void SetPolyMode(VoiceAllocator::EPolyMode mode)
+  void AddMidiMsgToQueue(const IMidiMsg& msg)
+  {
+    mMidiQueue.Add(msg);
+  }
+
+protected:
+
+  // maintain the state for one MIDI channel including RPN receipt state and pitch bend range.
+  struct ChannelState
+  {
+    uint8_t paramMSB;
+    uint8_t paramLSB;
+    uint8_t valueMSB;
+    uint8_t valueLSB;
+    uint8_t pitchBendRange; // in semitones
+    float pitchBend;
+    float pressure;
+    float timbre;
+  };
+
+  // MPE helper functions
+  const int kMPELowerZoneMasterChannel = 0;
+  const int kMPEUpperZoneMasterChannel = 15;
+  inline bool IsMasterChannel(int c) const { return ((c == 0)||(c == 15)); }
+  bool IsInLowerZone(int c) const { return ((c > 0)&&(c < mMPELowerZoneChannels)); }
+  bool IsInUpperZone(int c) const { return ((c < 15)&&(c > 15 - mMPEUpperZoneChannels)); }
+  int MasterChannelFor(int memberChan) const { return IsInUpperZone(memberChan) ? kMPEUpperZoneMasterChannel : kMPELowerZoneMasterChannel; }
+  int MasterZoneFor(int memberChan) const { return IsInUpperZone(memberChan) ? 1 : 0; }
+
+  // handy functions for writing loops on lower and upper Zone member channels
+  int LowerZoneStart() const { return 1; }
+  int LowerZoneEnd() const { return mMPELowerZoneChannels - 1; }
+  int UpperZoneStart() const {  return 15 - mMPEUpperZoneChannels; }
+  int UpperZoneEnd() const { return 15; }
+
+  void SetMPEZones(int channel, int nChans);
+  void SetChannelPitchBendRange(int channel, int range);
+
+  VoiceInputEvent MidiMessageToEventBasic(const IMidiMsg& msg);
+  VoiceInputEvent MidiMessageToEventMPE(const IMidiMsg& msg);
+  VoiceInputEvent MidiMessageToEvent(const IMidiMsg& msg);
+  static bool IsRPNMessage(const IMidiMsg& msg);
+  void HandleRPN(IMidiMsg msg);
+
+  // basic MIDI data
+  uint16_t mUnisonVoices{1};
+  IMidiQueue mMidiQueue;
+  float mVelocityLUT[128];
+  float mAfterTouchLUT[128];
+  ChannelState mChannelStates[16]{};
+  int mBlockSize;
+  int64_t mSampleTime{0};
+  double mSampleRate = DEFAULT_SAMPLE_RATE;
+  bool mVoicesAreActive = false;
+  int mNonMPEPitchBendRange = kDefaultPitchBendRange;
+  
+  // the synth will startup in basic MIDI mode. When an MPE Zone setup message is received, MPE mode is entered.
+  // To leave MPE mode, use RPNs to set all MPE zone channel counts to 0 as per the MPE spec.
+  bool mMPEMode{false};
+
+  // MPE state - channels in zone including master channels.
+  int mMPELowerZoneChannels{0};
+  int mMPEUpperZoneChannels{0};
+};
+
+/** A monophonic/polyphonic synthesiser base class which can be supplied with a custom voice.
+ *  Supports different kinds of after touch, pitch bend, velocity and after touch curves, unison (currently monophonic mode only)
+ *  MidiSynth takes voices of any SynthVoice subclass by pointer. MidiSynthT<MyVoice> can also own MyVoice objects stored contiguously
+ *  (see ReserveVoices() and EmplaceVoice()) and calls them without virtual dispatch, which matters when voices are cheap and sub-blocks are small */
+template <typename VoiceT>
+class MidiSynthT : public MidiSynthBase
+{
+public:
+#pragma mark - MidiSynth class
+
+  MidiSynthT(VoiceAllocatorBase::EPolyMode mode, int blockSize = kDefaultBlockSize)
+  : MidiSynthBase(blockSize)
+  {
+    SetPolyMode(mode);
+  }
+
+  void Reset()
+  {
+    mSampleTime = 0;
+    mVoiceAllocator.Clear();
+  }
+
+  void SetSampleRateAndBlockSize(double sampleRate, int blockSize)
+  {
+    Reset();
+
+    mSampleRate = sampleRate;
+    mMidiQueue.Resize(blockSize);
+    mVoiceAllocator.SetSampleRateAndBlockSize(sampleRate, blockSize);
+
+    for(int v = 0; v < static_cast<int>(NVoices()); v++)
+    {
+      GetVoice(v)->SetSampleRateAndBlockSize(sampleRate, blockSize);
+    }
+  }
+
+  void SetPolyMode(VoiceAllocatorBase::EPolyMode mode)
   {
     mVoiceAllocator.mPolyMode = mode;
   }
 
-  void SetATMode(VoiceAllocator::EATMode mode)
+  void SetATMode(VoiceAllocatorBase::EATMode mode)
   {
     mVoiceAllocator.mATMode = mode;
   }
@@ -118,14 +208,14 @@ public:
     mVoiceAllocator.SetControlGlideTime(t);
   }
 
-  SynthVoice* GetVoice(int voiceIdx)
+  VoiceT* GetVoice(int voiceIdx)
   {
     return mVoiceAllocator.GetVoice(voiceIdx);
   }
   
-  void ForEachVoice(std::function<void(SynthVoice& voice)> func)
+  void ForEachVoice(std::function<void(VoiceT& voice)> func)
   {
-    for (auto v = 0; v < NVoices(); v++)
+    for (int v = 0; v < static_cast<int>(NVoices()); v++)
       func(*GetVoice(v));
   }
   
@@ -135,14 +225,22 @@ public:
   }
 
   /** adds a SynthVoice to this MidiSynth, taking ownership of the object. */
-  void AddVoice(SynthVoice* pVoice, uint8_t zone)
+  void AddVoice(VoiceT* pVoice, uint8_t zone)
   {
     mVoiceAllocator.AddVoice(pVoice, zone);
   }
 
-  void AddMidiMsgToQueue(const IMidiMsg& msg)
+  /** Reserve storage for voices constructed with EmplaceVoice(). Call once, before adding voices */
+  void ReserveVoices(int nVoices)
   {
-    mMidiQueue.Add(msg);
+    mVoiceAllocator.ReserveVoices(nVoices);
+  }
+
+  /** Construct a voice in contiguous storage owned by the synth, see VoiceAllocatorT::EmplaceVoice() */
+  template <typename... Args>
+  VoiceT& EmplaceVoice(uint8_t zone, Args&&... args)
+  {
+    return mVoiceAllocator.EmplaceVoice(zone, std::forward<Args>(args)...);
   }
 
   /** Processes a block of audio samples
@@ -155,64 +253,86 @@ public:
   bool ProcessBlock(sample** inputs, sample** outputs, int nInputs, int nOutputs, int nFrames);
 
 private:
+  VoiceAllocatorT<VoiceT> mVoiceAllocator;
+};
 
-  // maintain the state for one MIDI channel including RPN receipt state and pitch bend range.
-  struct ChannelState
+/** The MidiSynth for SynthVoice pointers, with virtual dispatch */
+using MidiSynth = MidiSynthT<SynthVoice>;
+
+template <typename VoiceT>
+bool MidiSynthT<VoiceT>::ProcessBlock(sample** inputs, sample** outputs, int nInputs, int nOutputs, int nFrames)
+{
+  assert(NVoices());
+
+  if (mVoicesAreActive | !mMidiQueue.Empty())
   {
-    uint8_t paramMSB;
-    uint8_t paramLSB;
-    uint8_t valueMSB;
-    uint8_t valueLSB;
-    uint8_t pitchBendRange; // in semitones
-    float pitchBend;
-    float pressure;
-    float timbre;
-  };
+    int blockSize = mBlockSize;
+    int samplesRemaining = nFrames;
+    int startIndex = 0;
 
-  // MPE helper functions
-  const int kMPELowerZoneMasterChannel = 0;
-  const int kMPEUpperZoneMasterChannel = 15;
-  inline bool IsMasterChannel(int c) const { return ((c == 0)||(c == 15)); }
-  bool IsInLowerZone(int c) const { return ((c > 0)&&(c < mMPELowerZoneChannels)); }
-  bool IsInUpperZone(int c) const { return ((c < 15)&&(c > 15 - mMPEUpperZoneChannels)); }
-  int MasterChannelFor(int memberChan) const { return IsInUpperZone(memberChan) ? kMPEUpperZoneMasterChannel : kMPELowerZoneMasterChannel; }
-  int MasterZoneFor(int memberChan) const { return IsInUpperZone(memberChan) ? 1 : 0; }
+    // pick up voices that were triggered outside the allocator
+    mVoiceAllocator.UpdateActiveVoices();
 
-  // handy functions for writing loops on lower and upper Zone member channels
-  int LowerZoneStart() const { return 1; }
-  int LowerZoneEnd() const { return mMPELowerZoneChannels - 1; }
-  int UpperZoneStart() const {  return 15 - mMPEUpperZoneChannels; }
-  int UpperZoneEnd() const { return 15; }
+    while(samplesRemaining > 0)
+    {
+      if(samplesRemaining < blockSize)
+        blockSize = samplesRemaining;
 
-  void SetMPEZones(int channel, int nChans);
-  void SetChannelPitchBendRange(int channel, int range);
+      while (!mMidiQueue.Empty())
+      {
+        IMidiMsg msg = mMidiQueue.Peek();
+
+        // we assume the messages are in chronological order. If we find one later than the current block we are done.
+        if (msg.mOffset > startIndex + blockSize) break;
+
+        if(IsRPNMessage(msg))
+        {
+          HandleRPN(msg);
+        }
+        else
+        {
+          // send performance messages to the voice allocator
+          // message offset is relative to the start of this processSamples() block
+          msg.mOffset -= startIndex;
+          mVoiceAllocator.AddEvent(MidiMessageToEvent(msg));
+        }
+        mMidiQueue.Remove();
+      }
 
-  VoiceInputEvent MidiMessageToEventBasic(const IMidiMsg& msg);
-  VoiceInputEvent MidiMessageToEventMPE(const IMidiMsg& msg);
-  VoiceInputEvent MidiMessageToEvent(const IMidiMsg& msg);
-  void HandleRPN(IMidiMsg msg);
+      mVoiceAllocator.ProcessEvents(blockSize, mSampleTime);
+      mVoiceAllocator.ProcessVoices(inputs, outputs, nInputs, nOutputs, startIndex, blockSize);
 
-  // basic MIDI data
-  VoiceAllocator mVoiceAllocator;
-  uint16_t mUnisonVoices{1};
-  IMidiQueue mMidiQueue;
-  float mVelocityLUT[128];
-  float mAfterTouchLUT[128];
-  ChannelState mChannelStates[16]{};
-  int mBlockSize;
-  int64_t mSampleTime{0};
-  double mSampleRate = DEFAULT_SAMPLE_RATE;
-  bool mVoicesAreActive = false;
-  int mNonMPEPitchBendRange = kDefaultPitchBendRange;
-  
-  // the synth will startup in basic MIDI mode. When an MPE Zone setup message is received, MPE mode is entered.
-  // To leave MPE mode, use RPNs to set all MPE zone channel counts to 0 as per the MPE spec.
-  bool mMPEMode{false};
+      samplesRemaining -= blockSize;
+      startIndex += blockSize;
+      mSampleTime += blockSize;
+    }
 
-  // MPE state - channels in zone including master channels.
-  int mMPELowerZoneChannels{0};
-  int mMPEUpperZoneChannels{0};
-};
+    const int activeCount = mVoiceAllocator.UpdateActiveVoices();
+
+#if DEBUG_VOICE_COUNT
+    for(int v = 0; v < static_cast<int>(NVoices()); v++)
+    {
+      if(GetVoice(v)->GetBusy()) printf("X");
+      else DBGMSG("_");
+    }
+    DBGMSG("\n");
+    DBGMSG("Num Voices busy %i\n", activeCount);
+#endif
+
+    mVoicesAreActive = activeCount > 0;
+
+    mMidiQueue.Flush(nFrames);
+  }
+  else // empty block
+  {
+    return true;
+  }
+
+  return false; // made some noise
+}
+
+// MidiSynth is compiled once, in MidiSynth.cpp
+extern template class MidiSynthT<SynthVoice>;
 
 END_IPLUG_NAMESPACE
 
@@ -111,8 +111,8 @@ protected:
   double mBasePitch{0.};
   double mGain{0.}; // used by voice allocator to hard-kill voices.
 
-  friend class MidiSynth;
-  friend class VoiceAllocator;
+  template <typename VoiceT> friend class MidiSynthT;
+  template <typename VoiceT> friend class VoiceAllocatorT;
 };
 
 END_IPLUG_NAMESPACE
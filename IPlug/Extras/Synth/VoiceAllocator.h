@@ -20,6 +20,11 @@
 #include <stdint.h>
 #include <functional>
 #include <bitset>
+#include <climits>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 //#include <iostream>
 
 #include "IPlugLogger.h"
@@ -78,10 +83,10 @@ struct VoiceInputEvent
 
 #pragma mark - VoiceAllocator class
 
-class VoiceAllocator final
+/** The parts of the voice allocator that don't depend on the voice type */
+class VoiceAllocatorBase
 {
 public:
-
   enum EATMode
   {
     kATModeChannel = 0,
@@ -100,12 +105,24 @@ public:
 
   // one voice worth of ramp generators
   using VoiceControlRamps = ControlRampProcessor::ProcessorArray<kNumVoiceControlRamps>;
+};
 
-  VoiceAllocator();
-  ~VoiceAllocator();
+/** Allocates voices of type VoiceT to notes and drives them.
+ * VoiceAllocator (VoiceT = SynthVoice) works with any SynthVoice, added by pointer, and calls it through its virtual methods.
+ * With VoiceT a concrete SynthVoice subclass, voices can be stored contiguously by value in the allocator (ReserveVoices() and EmplaceVoice())
+ * and the voice methods are called statically, so that they can be inlined.
+ * Either way, only the voices in a compact list of active voices are rendered in each sub-block */
+template <typename VoiceT>
+class VoiceAllocatorT final : public VoiceAllocatorBase
+{
+public:
+  static_assert(std::is_base_of<SynthVoice, VoiceT>::value, "VoiceT must derive from SynthVoice");
 
-  VoiceAllocator(const VoiceAllocator&) = delete;
-  VoiceAllocator& operator=(const VoiceAllocator&) = delete;
+  VoiceAllocatorT();
+  ~VoiceAllocatorT();
+
+  VoiceAllocatorT(const VoiceAllocatorT&) = delete;
+  VoiceAllocatorT& operator=(const VoiceAllocatorT&) = delete;
 
   void Clear();
 
@@ -116,7 +133,28 @@ public:
   /** Add a synth voice to the allocator. We do not take ownership ot the voice.
    @param pv Pointer to the voice to add.
    @param zone A zone can be specified to make multitimbral synths.*/
-  void AddVoice(SynthVoice* pv, uint8_t zone);
+  void AddVoice(VoiceT* pv, uint8_t zone);
+
+  /** Reserve contiguous storage for voices owned by the allocator. Must be called before the first EmplaceVoice(), since voices never move once constructed
+   @param nVoices The maximum number of voices that will be emplaced */
+  void ReserveVoices(int nVoices);
+
+  /** Construct a voice in the allocator's own storage, after ReserveVoices()
+   @param zone A zone can be specified to make multitimbral synths.
+   @param args Arguments for the VoiceT constructor
+   @return The new voice */
+  template <typename... Args>
+  VoiceT& EmplaceVoice(uint8_t zone, Args&&... args)
+  {
+    static_assert(!std::is_abstract<VoiceT>::value, "Only concrete voice types can be stored by value");
+
+    if (mOwnedVoices.size() == mOwnedVoices.capacity())
+      throw std::runtime_error{"VoiceAllocator: call ReserveVoices() before EmplaceVoice()"};
+
+    mOwnedVoices.emplace_back(std::forward<Args>(args)...);
+    AddVoice(&mOwnedVoices.back(), zone);
+    return mOwnedVoices.back();
+  }
 
   /** Add a single event to the input queue for the current processing block. */
   void AddEvent(VoiceInputEvent e) { mInputQueue.Push(e); }
@@ -137,13 +175,38 @@ public:
 
   void ProcessVoices(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIndex, int blockSize);
 
+  /** Rebuild the list of active voices by asking every voice if it is busy. Voices started by the allocator are added to the list as they start,
+   * this picks up voices that were triggered directly, and is called by MidiSynth once per block.
+   * @return The number of active voices */
+  int UpdateActiveVoices();
+
+  /** @return The number of voices in the active list, which may include voices that have finished during the last sub-block */
+  int GetNActiveVoices() const { return static_cast<int>(mActiveVoices.size()); }
+
   size_t GetNVoices() const {return mVoicePtrs.size();}
-  SynthVoice* GetVoice(int voiceIndex) const {return mVoicePtrs[voiceIndex];}
+  VoiceT* GetVoice(int voiceIndex) const {return mVoicePtrs[voiceIndex];}
   void SetPitchOffset(float offset) { mPitchOffset = offset; }
 
 private:
   using VoiceBitsArray = std::bitset<UCHAR_MAX>;
 
+  // Calls to voices are qualified with the voice type when it is known, so that they are not dispatched through the vtable
+  static constexpr bool kStaticDispatch = !std::is_same<VoiceT, SynthVoice>::value;
+
+  static bool VoiceBusy(const VoiceT& v) { if constexpr (kStaticDispatch) return v.VoiceT::GetBusy(); else return v.GetBusy(); }
+  static void VoiceTrigger(VoiceT& v, double level, bool retrig) { if constexpr (kStaticDispatch) v.VoiceT::Trigger(level, retrig); else v.Trigger(level, retrig); }
+  static void VoiceRelease(VoiceT& v) { if constexpr (kStaticDispatch) v.VoiceT::Release(); else v.Release(); }
+  static void VoiceSetControl(VoiceT& v, int ctl, float val) { if constexpr (kStaticDispatch) v.VoiceT::SetControl(ctl, val); else v.SetControl(ctl, val); }
+  static void VoiceSetProgram(VoiceT& v, int pgm) { if constexpr (kStaticDispatch) v.VoiceT::SetProgramNumber(pgm); else v.SetProgramNumber(pgm); }
+
+  static void VoiceProcess(VoiceT& v, sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIdx, int nFrames)
+  {
+    if constexpr (kStaticDispatch)
+      v.VoiceT::ProcessSamplesAccumulating(inputs, outputs, nInputs, nOutputs, startIdx, nFrames);
+    else
+      v.ProcessSamplesAccumulating(inputs, outputs, nInputs, nOutputs, startIdx, nFrames);
+  }
+
   VoiceBitsArray VoicesMatchingAddress(VoiceAddress va);
 
   void SendControlToVoiceInputs(VoiceBitsArray v, int ctlIdx, float val, int glideSamples);
@@ -157,7 +220,7 @@ private:
   void StopVoices(VoiceBitsArray voices, int sampleOffset);
 
   void CalcGlideTimesInSamples();
-  void ClearVoiceInputs(SynthVoice* pVoice);
+  void ClearVoiceInputs(VoiceT* pVoice);
   int FindFreeVoiceIndex(int startIndex) const;
   int FindVoiceIndexToSteal(int64_t sampleTime) const;
 
@@ -166,8 +229,12 @@ private:
 
   IPlugQueue<VoiceInputEvent> mInputQueue{1024};
 
-  std::vector<SynthVoice*> mVoicePtrs;
+  std::vector<VoiceT*> mVoicePtrs;
+  std::vector<typename std::conditional<std::is_abstract<VoiceT>::value, char, VoiceT>::type> mOwnedVoices; // contiguous voices from EmplaceVoice()
   std::vector<std::unique_ptr<VoiceControlRamps>> mVoiceGlides;
+  std::vector<int> mActiveVoices; // indices of the voices to render, in voice order
+  VoiceBitsArray mActiveBits;
+  VoiceBitsArray mGlidingBits; // voices with control ramps that are still changing
   std::vector<int> mHeldKeys; // The currently physically held keys on the keyboard
   std::vector<int> mSustainedNotes; // Any notes that are sustained, including those that are physically held
 
@@ -192,4 +259,611 @@ public:
   EATMode mATMode {kATModeChannel};
 };
 
+/** The voice allocator for SynthVoice pointers, with virtual dispatch */
+using VoiceAllocator = VoiceAllocatorT<SynthVoice>;
+
+#pragma mark - VoiceAllocator implementation
+
+template <typename VoiceT>
+VoiceAllocatorT<VoiceT>::VoiceAllocatorT()
+{
+  // setup default key->pitch fn
+  mKeyToPitchFn = [](int k){return (k - 69.f)/12.f;};
+
+  mSustainedNotes.reserve(128);
+  mHeldKeys.reserve(128);
+  mActiveVoices.reserve(UCHAR_MAX);
+}
+
+template <typename VoiceT>
+VoiceAllocatorT<VoiceT>::~VoiceAllocatorT()
+{
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::Clear()
+{
+  mHeldKeys.clear();
+  mSustainedNotes.clear();
+  HardKillAllVoices();
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::ClearVoiceInputs(VoiceT* pVoice)
+{
+  for(int i=0; i<kNumVoiceControlRamps; ++i)
+  {
+    pVoice->mInputs[i].Clear();
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::ReserveVoices(int nVoices)
+{
+  if(!mOwnedVoices.empty())
+  {
+    throw std::runtime_error{"VoiceAllocator: ReserveVoices() must be called before EmplaceVoice()"};
+  }
+
+  mOwnedVoices.reserve(nVoices);
+  mVoicePtrs.reserve(mVoicePtrs.size() + nVoices);
+  mVoiceGlides.reserve(mVoiceGlides.size() + nVoices);
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::AddVoice(VoiceT* pVoice, uint8_t zone)
+{
+  if(mVoicePtrs.size() + 1 < UCHAR_MAX)
+  {
+    mVoicePtrs.push_back(pVoice);
+    ClearVoiceInputs(pVoice);
+    pVoice->mKey = -1;
+    pVoice->mZone = zone;
+
+    // make a glides structures for the control ramps of the new voice
+    mVoiceGlides.emplace_back(ControlRampProcessor::Create(pVoice->mInputs));
+  }
+  else
+  {
+    throw std::runtime_error{"VoiceAllocator: max voices exceeded!"};
+  }
+}
+
+template <typename VoiceT>
+typename VoiceAllocatorT<VoiceT>::VoiceBitsArray VoiceAllocatorT<VoiceT>::VoicesMatchingAddress(VoiceAddress addr)
+{
+  const int n = static_cast<int>(mVoicePtrs.size());
+  VoiceBitsArray v;
+
+  // set all bits to true
+  for(int i=0; i<n; ++i)
+  {
+    v[i] = true;
+  }
+
+  // for each criterion present in address, clear any voice bits not matching
+
+  // zone
+  if(addr.mZone != kAllZones)
+  {
+    for(int i=0; i<n; ++i)
+    {
+      v[i] = v[i] & (mVoicePtrs[i]->mZone == addr.mZone);
+    }
+  }
+
+  // setting the flag kVoicesAll returns all voices matching the zone of the address.
+  if(addr.mFlags & kVoicesAll) return v;
+
+  // channel
+  if(addr.mChannel != kAllChannels)
+  {
+    for(int i=0; i<n; ++i)
+    {
+      v[i] = v[i] & (mVoicePtrs[i]->mChannel == addr.mChannel);
+    }
+  }
+
+  // Key
+  if(addr.mKey != kAllKeys)
+  {
+    for(int i=0; i<n; ++i)
+    {
+      v[i] = v[i] & (mVoicePtrs[i]->mKey == addr.mKey);
+    }
+  }
+
+  // busy flag
+  if(addr.mFlags & kVoicesBusy)
+  {
+    for(int i=0; i<n; ++i)
+    {
+      v[i] = v[i] & VoiceBusy(*mVoicePtrs[i]);
+    }
+  }
+
+  // most recent
+  if(addr.mFlags & kVoicesMostRecent)
+  {
+    int64_t maxT = -1;
+    int maxIdx = -1;
+    for(int i=0; i<n; ++i)
+    {
+      if(v[i])
+      {
+        int64_t vt = mVoicePtrs[i]->mLastTriggeredTime;
+        if(vt > maxT)
+        {
+          maxT = vt;
+          maxIdx = i;
+        }
+      }
+    }
+
+    // set all bits to false
+    //v.reset();
+    for(int i=0; i<n; ++i)
+    {
+      v[i] = 0;
+    }
+
+    if(maxIdx >= 0)
+    {
+      v[maxIdx] = true;
+    }
+  }
+  return v;
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::SendControlToVoiceInputs(VoiceBitsArray v, int ctlIdx, float val, int glideSamples)
+{
+  // send control change to all matched voices through glide generators
+  for(int i=0; i<static_cast<int>(mVoicePtrs.size()); ++i)
+  {
+    if(v[i])
+    {
+      mVoiceGlides[i]->at(ctlIdx).SetTarget(val, 0, glideSamples, mBlockSize);
+      mGlidingBits[i] = true;
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::SendControlToVoicesDirect(VoiceBitsArray v, int ctlIdx, float val)
+{
+  // send generic control change directly to voice
+  for(int i=0; i<static_cast<int>(mVoicePtrs.size()); ++i)
+  {
+    if(v[i])
+    {
+      VoiceSetControl(*mVoicePtrs[i], ctlIdx, val);
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::SendProgramChangeToVoices(VoiceBitsArray v, int pgm)
+{
+  for(int i=0; i<static_cast<int>(mVoicePtrs.size()); ++i)
+  {
+    if(v[i])
+    {
+      VoiceSetProgram(*mVoicePtrs[i], pgm);
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::ProcessEvents(int blockSize, int64_t sampleTime)
+{
+  while(mInputQueue.ElementsAvailable())
+  {
+    VoiceInputEvent event;
+    mInputQueue.Pop(event);
+    VoiceBitsArray voices = VoicesMatchingAddress(event.mAddress);
+
+    switch(event.mAction)
+    {
+      case kNoteOnAction:
+      {
+        NoteOn(event, sampleTime);
+        break;
+      }
+      case kNoteOffAction:
+      {
+        if(event.mAddress.mFlags == kVoicesAll)
+        {
+          SoftKillAllVoices();
+        }
+        else
+        {
+          NoteOff(event, sampleTime);
+        }
+        break;
+      }
+      case kPitchBendAction:
+      {
+        SendControlToVoiceInputs(voices, kVoiceControlPitchBend, event.mValue, mControlGlideSamples);
+        break;
+      }
+      case kPressureAction:
+      {
+        SendControlToVoiceInputs(voices, kVoiceControlPressure, event.mValue, mControlGlideSamples);
+        break;
+      }
+      case kTimbreAction:
+      {
+        SendControlToVoiceInputs(voices, kVoiceControlTimbre, event.mValue, mControlGlideSamples);
+        break;
+      }
+      case kSustainAction:
+      {
+        mSustainPedalDown = (bool) (event.mValue >= 0.5);
+        if (!mSustainPedalDown) // sustain pedal released
+        {
+          // if notes are sustaining, check that they're not still held and if not then stop voice
+          if (!mSustainedNotes.empty())
+          {
+            for (auto susNotesItr = mSustainedNotes.begin(); susNotesItr != mSustainedNotes.end();)
+            {
+              uint8_t key = *susNotesItr;
+              bool held = std::find(mHeldKeys.begin(), mHeldKeys.end(), key) != mHeldKeys.end();
+              if (!held)
+              {
+                StopVoices(VoicesMatchingAddress({event.mAddress.mZone, kAllChannels, key, 0}), event.mSampleOffset);
+                susNotesItr = mSustainedNotes.erase(susNotesItr);
+              }
+              else
+                susNotesItr++;
+            }
+          }
+        }
+        break;
+      }
+      case kControllerAction:
+      {
+        // called for any continuous controller other than the special #74 specified in MPE
+        SendControlToVoicesDirect(voices, event.mControllerNumber, event.mValue);
+        break;
+      }
+      case kProgramChangeAction:
+      {
+        SendProgramChangeToVoices(voices, event.mControllerNumber);
+        break;
+      }
+      case kNullAction:
+      default:
+      {
+        break;
+      }
+    }
+  }
+
+  // update any glides in progress, writing voice control outputs. Settled glides are skipped, since processing them doesn't change their outputs
+  for(int v=0; v<static_cast<int>(mVoiceGlides.size()); ++v)
+  {
+    if(mGlidingBits[v])
+    {
+      bool settled = true;
+
+      for(int i=0; i<kNumVoiceControlRamps; ++i)
+      {
+        auto& glide = mVoiceGlides[v]->at(i);
+        glide.Process(blockSize);
+        settled &= glide.IsSettled();
+      }
+
+      mGlidingBits[v] = !settled;
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::CalcGlideTimesInSamples()
+{
+  mNoteGlideSamples = static_cast<int>(mNoteGlideTime * mSampleRate);
+  mControlGlideSamples = static_cast<int>(mControlGlideTime * mSampleRate);
+}
+
+template <typename VoiceT>
+int VoiceAllocatorT<VoiceT>::FindFreeVoiceIndex(int startIndex) const
+{
+  const int voices = static_cast<int>(mVoicePtrs.size());
+  for(int i=0; i<voices; ++i)
+  {
+    int j = (startIndex + i)%voices;
+    VoiceT* pv = mVoicePtrs[j];
+    if(!VoiceBusy(*pv))
+    {
+      return j;
+    }
+  }
+  return -1;
+}
+
+template <typename VoiceT>
+int VoiceAllocatorT<VoiceT>::FindVoiceIndexToSteal(int64_t sampleTime) const
+{
+  const int voices = static_cast<int>(mVoicePtrs.size());
+  int64_t earliestTime = sampleTime;
+  int longestPlayingVoiceIdx = 0;
+  for(int i=0; i<voices; ++i)
+  {
+    VoiceT* pv = mVoicePtrs[i];
+    if(pv->mLastTriggeredTime < earliestTime)
+    {
+      earliestTime = pv->mLastTriggeredTime;
+      longestPlayingVoiceIdx = i;
+    }
+  }
+  return longestPlayingVoiceIdx;
+}
+
+// start a single voice and set its current channel and key.
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::StartVoice(int voiceIdx, int channel, int key, float pitch, float velocity, int sampleOffset, int64_t sampleTime, bool retrig)
+{
+  if(!retrig)
+  {
+    // add immediate sample-accurate change for trigger
+    mVoiceGlides[voiceIdx]->at(kVoiceControlGate).SetTarget(velocity, sampleOffset, 1, mBlockSize);
+  }
+
+  // add glide for pitch
+  mVoiceGlides[voiceIdx]->at(kVoiceControlPitch).SetTarget(pitch, sampleOffset, mNoteGlideSamples, mBlockSize);
+  mGlidingBits[voiceIdx] = true;
+
+  // set things directly in voice
+  VoiceT* pVoice = mVoicePtrs[voiceIdx];
+  pVoice->mLastTriggeredTime = sampleTime;
+  pVoice->mChannel = channel;
+  pVoice->mKey = key;
+  pVoice->mGain = 1.;
+
+  // call voice's Trigger method
+  VoiceTrigger(*pVoice, velocity, retrig);
+
+  if(!mActiveBits[voiceIdx])
+  {
+    mActiveBits[voiceIdx] = true;
+    mActiveVoices.insert(std::lower_bound(mActiveVoices.begin(), mActiveVoices.end(), voiceIdx), voiceIdx);
+  }
+}
+
+// start all of the voice indexes marked in the VoieBitsArray and set the current channel and key of each.
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::StartVoices(VoiceBitsArray vbits, int channel, int key, float pitch, float velocity, int sampleOffset, int64_t sampleTime, bool retrig)
+{
+  for(int i=0; i<static_cast<int>(mVoicePtrs.size()); ++i)
+  {
+    if(vbits[i])
+    {
+      StartVoice(i, channel, key, pitch, velocity, sampleOffset, sampleTime, retrig);
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::StopVoice(int voiceIdx, int sampleOffset)
+{
+  mVoiceGlides[voiceIdx]->at(kVoiceControlGate).SetTarget(0.0, sampleOffset, 1, mBlockSize);
+  mGlidingBits[voiceIdx] = true;
+  mVoicePtrs[voiceIdx]->mKey = -1;
+  VoiceRelease(*mVoicePtrs[voiceIdx]);
+}
+
+// stop all voices marked in the VoiceBitsArray.
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::StopVoices(VoiceBitsArray vbits, int sampleOffset)
+{
+  for(int i=0; i<static_cast<int>(mVoicePtrs.size()); ++i)
+  {
+    if(vbits[i])
+    {
+      StopVoice(i, sampleOffset);
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::SoftKillAllVoices()
+{
+  mHeldKeys.clear();
+  mSustainedNotes.clear();
+  mSustainPedalDown = false;
+
+  const int voices = static_cast<int>(mVoicePtrs.size());
+  for (int v = 0; v < voices; v++)
+  {
+    StopVoice(v, 0);
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::HardKillAllVoices()
+{
+  SoftKillAllVoices();
+  for (int v = 0; v < static_cast<int>(mVoicePtrs.size()); v++)
+  {
+    mVoicePtrs[v]->mGain = 0.;
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::NoteOn(VoiceInputEvent e, int64_t sampleTime)
+{
+  int channel = e.mAddress.mChannel;
+  int key = e.mAddress.mKey;
+  int offset = e.mSampleOffset;
+  float velocity = e.mValue;
+  float pitch = mKeyToPitchFn(key + static_cast<int>(mPitchOffset));
+
+  switch(mPolyMode)
+  {
+    case kPolyModeMono:
+    {
+      // TODO retrig / legato
+      bool retrig = false;
+
+      // trigger all voices in zone
+      StartVoices(VoicesMatchingAddress({e.mAddress.mZone, kAllChannels, kAllKeys, 0}), channel, key, pitch, velocity, offset, sampleTime, retrig);
+
+      // in mono modes only ever 1 sustained note
+      mSustainedNotes.clear();
+      break;
+    }
+    case kPolyModePoly:
+    {
+      int i = FindFreeVoiceIndex(mVoiceRotateIndex);
+      if(i < 0)
+      {
+        i = FindVoiceIndexToSteal(sampleTime);
+      }
+      if(mRotateVoices)
+      {
+        mVoiceRotateIndex = i + 1;
+      }
+      if(i >= 0)
+      {
+        bool retrig = false;
+        StartVoice(i, channel, key, pitch, velocity, offset, sampleTime, retrig);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+
+  // add to held keys
+  if(std::find(mHeldKeys.begin(), mHeldKeys.end(), key) == mHeldKeys.end())
+  {
+    mHeldKeys.push_back(key);
+    mMinHeldVelocity = std::min(velocity, mMinHeldVelocity);
+  }
+
+  // add to sustained notes
+  if(std::find(mSustainedNotes.begin(), mSustainedNotes.end(), key) == mSustainedNotes.end())
+  {
+    mSustainedNotes.push_back(key);
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::NoteOff(VoiceInputEvent e, int64_t sampleTime)
+{
+  int channel = e.mAddress.mChannel;
+  int key = e.mAddress.mKey;
+  int offset = e.mSampleOffset;
+
+  // remove from held keys
+  mHeldKeys.erase(std::remove(mHeldKeys.begin(), mHeldKeys.end(), key), mHeldKeys.end());
+  if(mHeldKeys.empty())
+  {
+    mMinHeldVelocity = 1.0f;
+  }
+
+  if(mPolyMode == kPolyModeMono)
+  {
+    bool doPlayQueuedKey = false;
+    int queuedKey = 0;
+
+    // if there are still held keys...
+    if(!mHeldKeys.empty())
+    {
+      queuedKey = mHeldKeys.back();
+      if (queuedKey != mVoicePtrs[0]->mKey)
+      {
+        doPlayQueuedKey = true;
+        if(mSustainPedalDown)
+        {
+          // in mono modes only ever 1 sustained note
+          mSustainedNotes.clear();
+          mSustainedNotes.push_back(queuedKey);
+        }
+      }
+    }
+    else if(mSustainPedalDown)
+    {
+      if(!mSustainedNotes.empty())
+      {
+        queuedKey = mSustainedNotes.back();
+        if (queuedKey != mVoicePtrs[0]->mKey)
+        {
+          doPlayQueuedKey = true;
+        }
+      }
+    }
+    else
+    {
+      // there are no held keys, so no voices in the zone should be playing.
+      StopVoices(VoicesMatchingAddress({e.mAddress.mZone, kAllChannels, kAllKeys, 0}), offset);
+    }
+
+    if(doPlayQueuedKey)
+    {
+      // trigger the queued key for all voices in the zone at the minimum held velocity.
+      // alternatively the release velocity of the note off could be used here.
+      float pitch = mKeyToPitchFn(queuedKey + static_cast<int>(mPitchOffset));
+      bool retrig = false;
+
+      StartVoices(VoicesMatchingAddress({e.mAddress.mZone, kAllChannels, kAllKeys, 0}), channel, queuedKey, pitch, mMinHeldVelocity, offset, sampleTime, retrig);
+    }
+  }
+  else // poly
+  {
+    if (!mSustainPedalDown)
+    {
+      StopVoices(VoicesMatchingAddress(e.mAddress), e.mSampleOffset);
+      mSustainedNotes.erase(std::remove(mSustainedNotes.begin(), mSustainedNotes.end(), key), mSustainedNotes.end());
+    }
+  }
+}
+
+template <typename VoiceT>
+void VoiceAllocatorT<VoiceT>::ProcessVoices(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIndex, int blockSize)
+{
+  // TODO distribute voices across cores
+  size_t nActive = 0;
+
+  for(auto voiceIdx : mActiveVoices)
+  {
+    VoiceT& voice = *mVoicePtrs[voiceIdx];
+
+    if(VoiceBusy(voice))
+    {
+      VoiceProcess(voice, inputs, outputs, nInputs, nOutputs, startIndex, blockSize);
+      mActiveVoices[nActive++] = voiceIdx;
+    }
+    else
+    {
+      mActiveBits[voiceIdx] = false;
+    }
+  }
+
+  mActiveVoices.resize(nActive);
+}
+
+template <typename VoiceT>
+int VoiceAllocatorT<VoiceT>::UpdateActiveVoices()
+{
+  mActiveVoices.clear();
+
+  for(int i=0; i<static_cast<int>(mVoicePtrs.size()); ++i)
+  {
+    mActiveBits[i] = VoiceBusy(*mVoicePtrs[i]);
+
+    if(mActiveBits[i])
+    {
+      mActiveVoices.push_back(i);
+    }
+  }
+
+  return static_cast<int>(mActiveVoices.size());
+}
+
+// VoiceAllocator is compiled once, in VoiceAllocator.cpp
+extern template class VoiceAllocatorT<SynthVoice>;
+
 END_IPLUG_NAMESPACE
@@ -111,6 +111,10 @@ static const int MAX_PARAM_DISPLAY_PRECISION = 6;
 #define IDLE_TIMER_RATE 20 // this controls the frequency of data going from processor to editor (and OnIdle calls)
 #endif
 
+#ifndef TIMER_MIN_HEARTBEAT_MS
+#define TIMER_MIN_HEARTBEAT_MS 5 // the shortest tick of the shared Linux timer service, timer intervals are rounded to a whole number of ticks
+#endif
+
 #ifndef MAX_SYSEX_SIZE
 #define MAX_SYSEX_SIZE 512
 #endif
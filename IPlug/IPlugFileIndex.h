@@ -0,0 +1,630 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IFileIndex
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#if !defined OS_WIN
+#include <sys/stat.h>
+#endif
+
+#include "dirscan.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugStructs.h"
+#include "IPlugUtilities.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A directory in an IFileIndex */
+struct IFileIndexDir
+{
+  std::string mPath; // Full path, without a trailing separator
+  int64_t mModTime = -1; // Modification time of the directory, which changes when an entry is added, removed or renamed
+  std::vector<std::string> mFiles; // Names of the files with the indexed extension, sorted
+  std::vector<std::string> mSubdirs; // Names of the sub-folders, sorted. Empty if the index is not recursive
+};
+
+/** Indexes the files with a given extension in one or more folders on a background thread, e.g. for a preset browser.
+ * Each directory is listed once and stored with its modification time. A rescan only stat()s the directories and lists
+ * again the ones that changed, so checking a large library that hasn't changed is cheap, even on a network drive.
+ * The index can be saved to a cache file and loaded from it, so that a library is available as soon as the UI opens,
+ * while the worker checks it for changes.
+ * Readers poll GetVersion(), which changes each time a directory is added, changed or removed, and access the directories inside Read().
+ * Results are committed one directory at a time, so a reader sees the tree grow while a library is scanned for the first time */
+class IFileIndex
+{
+public:
+  /** @param extension The extension of the files to index, without the dot, e.g. "fxp"
+   * @param recursive If \c true sub-folders are indexed as well */
+  IFileIndex(const char* extension, bool recursive = true)
+  : mExtension(extension ? extension : "")
+  , mRecursive(recursive)
+  {
+  }
+
+  ~IFileIndex() { Stop(); }
+
+  IFileIndex(const IFileIndex&) = delete;
+  IFileIndex& operator=(const IFileIndex&) = delete;
+
+  /** Add a folder to index. The folder is scanned on the next Start(), Rescan() or ScanNow()
+   * @param path The full path to the folder */
+  void AddRoot(const char* path)
+  {
+    std::string root(path ? path : "");
+
+    while (root.size() > 1 && (root.back() == '/' || root.back() == '\\'))
+      root.pop_back();
+
+    if (root.empty())
+      return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (std::find(mRoots.begin(), mRoots.end(), root) == mRoots.end())
+      mRoots.push_back(root);
+  }
+
+  /** Remove all the folders and forget the directories that have been indexed */
+  void ClearRoots()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRoots.clear();
+    mDirs.clear();
+    mVersion++;
+  }
+
+  /** @return The folders that are indexed, in the order they were added */
+  std::vector<std::string> GetRoots() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRoots;
+  }
+
+  /** Set a file to persist the index in. It is loaded by Start() and written when a scan has changed the index
+   * @param path The full path to the cache file. Its folder must exist */
+  void SetCachePath(const char* path)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCachePath = path ? path : "";
+  }
+
+  /** @return The path set with SetCachePath() */
+  std::string GetCachePath() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCachePath;
+  }
+
+  /** Load the cache file if the index is empty, then start scanning on the worker thread. The worker scans once, then waits for Rescan() */
+  void Start()
+  {
+    if (mThread.joinable())
+      return;
+
+    bool empty;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      empty = mDirs.empty();
+    }
+
+    if (empty)
+      LoadCache();
+
+    mStopRequested = false;
+    mRescanRequested = true;
+    mScanning = true;
+    mThread = std::thread(&IFileIndex::ThreadFunc, this);
+  }
+
+  /** Stop the worker thread. A scan in progress is abandoned, keeping the directories that have been committed so far */
+  void Stop()
+  {
+    if (!mThread.joinable())
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopRequested = true;
+    }
+
+    mWake.notify_one();
+    mThread.join();
+    mScanning = false;
+  }
+
+  /** Ask the worker to check the index for changes, e.g. when the editor is opened or a preset has been saved */
+  void Rescan()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mRescanRequested = true;
+      mScanning = mThread.joinable();
+    }
+
+    mWake.notify_one();
+  }
+
+  /** Scan on the calling thread, for when a complete index is needed straight away. Don't call while the worker is running */
+  void ScanNow()
+  {
+    assert(!mThread.joinable());
+    mStopRequested = false;
+    ScanAll();
+  }
+
+  /** @return \c true if the worker thread has been started */
+  bool IsRunning() const { return mThread.joinable(); }
+
+  /** @return \c true while the worker is scanning, or has been asked to */
+  bool IsScanning() const { return mScanning.load(); }
+
+  /** @return A number that changes every time the index changes */
+  uint32_t GetVersion() const { return mVersion.load(); }
+
+  /** Call func(const IFileIndex&) with the index locked, so that FindDir() and ForEachFile() can be used safely while the worker is running.
+   * Keep it short, the worker waits for it to commit the next directory */
+  template <typename F>
+  void Read(F&& func) const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    func(*this);
+  }
+
+  /** Only call inside Read()
+   * @param path The full path of a directory
+   * @return The directory, or \c nullptr if it hasn't been indexed */
+  const IFileIndexDir* FindDir(const std::string& path) const
+  {
+    auto it = mDirs.find(path);
+    return it != mDirs.end() ? &it->second : nullptr;
+  }
+
+  /** Only call inside Read(). Calls func(const IFileIndexDir& dir, const std::string& fileName) for every indexed file */
+  template <typename F>
+  void ForEachFile(F&& func) const
+  {
+    for (const auto& entry : mDirs)
+    {
+      for (const auto& file : entry.second.mFiles)
+        func(entry.second, file);
+    }
+  }
+
+  /** @return The number of indexed files */
+  int NFiles() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    int n = 0;
+
+    for (const auto& entry : mDirs)
+      n += static_cast<int>(entry.second.mFiles.size());
+
+    return n;
+  }
+
+  /** Find files by name, ignoring (ASCII) case
+   * @param query The text to look for
+   * @param results Cleared, then filled with the full paths of the matching files
+   * @param maxResults The maximum number of results
+   * @param prefixOnly If \c true only names that start with the query match, which is a binary search. Otherwise the query can be anywhere in the name
+   * @return The number of results */
+  int Search(const char* query, std::vector<std::string>& results, int maxResults = 100, bool prefixOnly = false)
+  {
+    results.clear();
+
+    const std::string key = ToLowerASCII(query ? query : "");
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mSearchVersion != mVersion.load())
+      BuildSearchTable();
+
+    if (prefixOnly)
+    {
+      auto it = std::lower_bound(mSearchTable.begin(), mSearchTable.end(), key, [](const SearchEntry& entry, const std::string& str) {
+        return entry.mKey < str;
+      });
+
+      for (; it != mSearchTable.end() && static_cast<int>(results.size()) < maxResults; ++it)
+      {
+        if (it->mKey.compare(0, key.size(), key) != 0)
+          break;
+
+        results.push_back(it->mPath);
+      }
+    }
+    else
+    {
+      for (auto it = mSearchTable.begin(); it != mSearchTable.end() && static_cast<int>(results.size()) < maxResults; ++it)
+      {
+        if (strstr(it->mKey.c_str(), key.c_str()))
+          results.push_back(it->mPath);
+      }
+    }
+
+    return static_cast<int>(results.size());
+  }
+
+  /** Write the index to the cache file
+   * @return \c true on success */
+  bool SaveCache()
+  {
+    const std::string cachePath = GetCachePath(); // SaveCache() runs on the worker thread
+
+    if (cachePath.empty())
+      return false;
+
+    IByteChunk chunk;
+    const int magic = kCacheMagic;
+    const int version = kCacheVersion;
+    const int recursive = mRecursive;
+
+    chunk.Put(&magic);
+    chunk.Put(&version);
+    chunk.PutStr(mExtension.c_str());
+    chunk.Put(&recursive);
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      const int nDirs = static_cast<int>(mDirs.size());
+      chunk.Put(&nDirs);
+
+      for (const auto& entry : mDirs)
+      {
+        const IFileIndexDir& dir = entry.second;
+        const int nFiles = static_cast<int>(dir.mFiles.size());
+        const int nSubdirs = static_cast<int>(dir.mSubdirs.size());
+
+        chunk.PutStr(dir.mPath.c_str());
+        chunk.Put(&dir.mModTime);
+        chunk.Put(&nFiles);
+
+        for (const auto& file : dir.mFiles)
+          chunk.PutStr(file.c_str());
+
+        chunk.Put(&nSubdirs);
+
+        for (const auto& subdir : dir.mSubdirs)
+          chunk.PutStr(subdir.c_str());
+      }
+
+      mCacheIsStale = false;
+    }
+
+    FILE* fp = fopenUTF8(cachePath.c_str(), "wb");
+
+    if (!fp)
+      return false;
+
+    const bool success = fwrite(chunk.GetData(), chunk.Size(), 1, fp) == 1;
+    fclose(fp);
+    return success;
+  }
+
+  /** Replace the index with the contents of the cache file. Directories that are no longer under a root are removed by the next scan
+   * @return \c true if the cache file was loaded */
+  bool LoadCache()
+  {
+    const std::string cachePath = GetCachePath();
+
+    if (cachePath.empty())
+      return false;
+
+    FILE* fp = fopenUTF8(cachePath.c_str(), "rb");
+
+    if (!fp)
+      return false;
+
+    IByteChunk chunk;
+    fseek(fp, 0, SEEK_END);
+    const long fileSize = ftell(fp);
+    rewind(fp);
+
+    chunk.Resize(static_cast<int>(std::max(fileSize, 0L)));
+    const bool read = fileSize > 0 && fread(chunk.GetData(), fileSize, 1, fp) == 1;
+    fclose(fp);
+
+    if (!read)
+      return false;
+
+    int magic = 0, version = 0, recursive = 0, nDirs = 0;
+    WDL_String str;
+    int pos = chunk.Get(&magic, 0);
+    pos = chunk.Get(&version, pos);
+    pos = chunk.GetStr(str, pos);
+
+    if (pos < 0 || magic != kCacheMagic || version != kCacheVersion || mExtension != str.Get())
+      return false;
+
+    pos = chunk.Get(&recursive, pos);
+    pos = chunk.Get(&nDirs, pos);
+
+    if (pos < 0 || recursive != static_cast<int>(mRecursive) || nDirs < 0)
+      return false;
+
+    std::map<std::string, IFileIndexDir> dirs;
+
+    auto getStrings = [&](std::vector<std::string>& strings) {
+      int n = 0;
+      pos = chunk.Get(&n, pos);
+
+      for (int i = 0; i < n && pos >= 0; i++)
+      {
+        pos = chunk.GetStr(str, pos);
+        strings.emplace_back(str.Get());
+      }
+    };
+
+    for (int d = 0; d < nDirs && pos >= 0; d++)
+    {
+      IFileIndexDir dir;
+      pos = chunk.GetStr(str, pos);
+      dir.mPath = str.Get();
+      pos = pos >= 0 ? chunk.Get(&dir.mModTime, pos) : pos;
+
+      if (pos >= 0)
+        getStrings(dir.mFiles);
+
+      if (pos >= 0)
+        getStrings(dir.mSubdirs);
+
+      if (pos >= 0)
+        dirs[dir.mPath] = std::move(dir);
+    }
+
+    if (pos < 0)
+      return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirs = std::move(dirs);
+    mVersion++;
+    return true;
+  }
+
+  /** @return \c true if a file name ends with an extension, e.g. "Init.fxp" and "fxp". The extension must not be the whole name */
+  static bool MatchesExtension(const char* fileName, const char* extension)
+  {
+    const size_t nameLen = strlen(fileName);
+    const size_t extLen = strlen(extension);
+    return extLen && nameLen > extLen && !strcmp(fileName + nameLen - extLen, extension);
+  }
+
+  /** @return The modification time of a file or directory in nanoseconds, or -1 if it doesn't exist */
+  static int64_t GetModTime(const char* path)
+  {
+#if defined OS_WIN
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    if (!GetFileAttributesExW(UTF8AsUTF16(path).Get(), GetFileExInfoStandard, &data))
+      return -1;
+
+    return ((static_cast<int64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime) * 100;
+#else
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+      return -1;
+
+  #if defined OS_MAC || defined OS_IOS
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+  #elif defined OS_LINUX
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  #else
+    return static_cast<int64_t>(st.st_mtime) * 1000000000;
+  #endif
+#endif
+  }
+
+private:
+  static constexpr int kCacheMagic = 'IPfi';
+  static constexpr int kCacheVersion = 1;
+  static constexpr int kMaxDepth = 64; // guards against symbolic link cycles
+
+  struct SearchEntry
+  {
+    std::string mKey; // lower case file name
+    std::string mPath;
+  };
+
+  static std::string ToLowerASCII(const char* str)
+  {
+    std::string lower(str);
+
+    for (auto& c : lower)
+    {
+      if (c >= 'A' && c <= 'Z')
+        c += 'a' - 'A';
+    }
+
+    return lower;
+  }
+
+  void ThreadFunc()
+  {
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWake.wait(lock, [this]() { return mStopRequested.load() || mRescanRequested; });
+
+        if (mStopRequested)
+          return;
+
+        mRescanRequested = false;
+      }
+
+      if (ScanAll() && mCacheIsStale)
+        SaveCache();
+    }
+  }
+
+  /** @return \c false if the scan was abandoned */
+  bool ScanAll()
+  {
+    mScanning = true;
+
+    std::vector<std::string> roots = GetRoots();
+    std::unordered_set<std::string> visited;
+
+    for (const auto& root : roots)
+      ScanDir(root, visited, 0);
+
+    const bool completed = !mStopRequested;
+
+    // Forget directories that have been removed, unless the scan was abandoned
+    if (completed)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      bool removed = false;
+
+      for (auto it = mDirs.begin(); it != mDirs.end();)
+      {
+        if (!visited.count(it->first))
+        {
+          it = mDirs.erase(it);
+          removed = true;
+        }
+        else
+          ++it;
+      }
+
+      if (removed)
+      {
+        mVersion++;
+        mCacheIsStale = true;
+      }
+    }
+
+    mScanning = false;
+    return completed;
+  }
+
+  void ScanDir(const std::string& path, std::unordered_set<std::string>& visited, int depth)
+  {
+    if (mStopRequested || depth > kMaxDepth || !visited.insert(path).second)
+      return;
+
+    const int64_t modTime = GetModTime(path.c_str());
+
+    if (modTime < 0)
+      return;
+
+    std::vector<std::string> subdirs;
+    bool unchanged = false;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      const IFileIndexDir* pDir = FindDir(path);
+
+      if (pDir && pDir->mModTime == modTime)
+      {
+        subdirs = pDir->mSubdirs;
+        unchanged = true;
+      }
+    }
+
+    if (!unchanged)
+    {
+      IFileIndexDir dir;
+      dir.mPath = path;
+      dir.mModTime = modTime;
+
+      WDL_DirScan d;
+
+      if (!d.First(path.c_str()))
+      {
+        do
+        {
+          const char* f = d.GetCurrentFN();
+
+          if (f && f[0] != '.')
+          {
+            if (d.GetCurrentIsDirectory())
+            {
+              if (mRecursive)
+                dir.mSubdirs.emplace_back(f);
+            }
+            else if (MatchesExtension(f, mExtension.c_str()))
+            {
+              dir.mFiles.emplace_back(f);
+            }
+          }
+        } while (!d.Next());
+      }
+
+      std::sort(dir.mFiles.begin(), dir.mFiles.end());
+      std::sort(dir.mSubdirs.begin(), dir.mSubdirs.end());
+      subdirs = dir.mSubdirs;
+
+      std::lock_guard<std::mutex> lock(mMutex);
+      mDirs[path] = std::move(dir);
+      mVersion++;
+      mCacheIsStale = true;
+    }
+
+    for (const auto& subdir : subdirs)
+      ScanDir(path + WDL_DIRCHAR_STR + subdir, visited, depth + 1);
+  }
+
+  void BuildSearchTable()
+  {
+    mSearchTable.clear();
+
+    for (const auto& entry : mDirs)
+    {
+      for (const auto& file : entry.second.mFiles)
+        mSearchTable.push_back({ToLowerASCII(file.c_str()), entry.first + WDL_DIRCHAR_STR + file});
+    }
+
+    std::sort(mSearchTable.begin(), mSearchTable.end(), [](const SearchEntry& a, const SearchEntry& b) {
+      return a.mKey < b.mKey;
+    });
+
+    mSearchVersion = mVersion.load();
+  }
+
+  const std::string mExtension;
+  const bool mRecursive;
+  std::string mCachePath; // guarded by mMutex
+
+  mutable std::mutex mMutex;
+  std::condition_variable mWake;
+  std::thread mThread;
+  std::atomic<bool> mStopRequested {false};
+  std::atomic<bool> mScanning {false};
+  std::atomic<uint32_t> mVersion {0};
+  bool mRescanRequested = false;
+  std::atomic<bool> mCacheIsStale {false};
+
+  std::vector<std::string> mRoots;
+  std::map<std::string, IFileIndexDir> mDirs; // keyed by path
+  std::vector<SearchEntry> mSearchTable; // sorted by key
+  uint32_t mSearchVersion = ~0u;
+};
+
+END_IPLUG_NAMESPACE
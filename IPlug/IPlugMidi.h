@@ -599,6 +599,7 @@ struct ISysEx
 IMidiQueueBase is a template adapted by Alex Harker from the following source
 It has been adapted to allow different types (e.g. IMidiMsg or ISysEx)
 It is then mapped to IMidiQueue as an alias
+It has been altered so that Add() never allocates, and sorts lazily instead of on every insertion
  
  (c) Theo Niessink 2009-2011
 <http://www.taletn.com/>
@@ -676,52 +677,72 @@ void MyPlug::ProcessBlock(double** inputs, double** outputs, int nFrames)
 #endif
 
 /** A class to help with queuing timestamped MIDI messages
+  * Memory is only allocated by the constructor and Resize(), so Add() can be called on the audio thread.
+  * Add() appends in O(1). A message that is a few places out of order is inserted with a short, bounded shift, otherwise messages
+  * added out of order (e.g. when merging host, editor and generated MIDI) are sorted by a stable radix sort on mOffset the next time
+  * the front of the queue is accessed, rather than by an insertion per message
   * @ingroup IPlugUtilities */
 template <class T>
 class IMidiQueueBase
 {
 public:
   IMidiQueueBase(int size = DEFAULT_BLOCK_SIZE)
-  : mBuf(NULL), mSize(0), mGrow(Granulize(size)), mFront(0), mBack(0)
+  : mBuf(NULL), mTmp(NULL), mCounts((int*) calloc(kMaxBuckets + 1, sizeof(int))), mSize(0), mFront(0), mBack(0), mSorted(true), mDropped(0)
   {
-    Expand();
+    Resize(size);
   }
   
   ~IMidiQueueBase()
   {
     free(mBuf);
+    free(mTmp);
+    free(mCounts);
   }
 
-  // Adds a MIDI message at the back of the queue. If the queue is full,
-  // it will automatically expand itself.
+  IMidiQueueBase(const IMidiQueueBase&) = delete;
+  IMidiQueueBase& operator=(const IMidiQueueBase&) = delete;
+
+  // Adds a MIDI message at the back of the queue. The queue does not grow
+  // here, if it is full the message is dropped (see Resize() and NumDropped()).
   void Add(const T& msg)
   {
     if (mBack >= mSize)
     {
       if (mFront > 0)
         Compact();
-      else if (!Expand()) return;
+      else
+      {
+        ++mDropped;
+        return;
+      }
     }
 
 #ifndef DONT_SORT_IMIDIQUEUE
-    // Insert the MIDI message at the right offset.
-    if (mBack > mFront && msg.mOffset < mBuf[mBack - 1].mOffset)
+    if (mSorted && mBack > mFront && msg.mOffset < mBuf[mBack - 1].mOffset)
     {
-      int i = mBack - 2;
-      while (i >= mFront && msg.mOffset < mBuf[i].mOffset) --i;
-      i++;
-      memmove(&mBuf[i + 1], &mBuf[i], (mBack - i) * sizeof(T));
-      mBuf[i] = msg;
+      // A message that is only a few places out of order (e.g. sources taking turns) is inserted straight away,
+      // the shift is bounded, and cheaper than sorting the whole queue later
+      int i = mBack - 1;
+      const int stop = std::max(mFront, mBack - kMaxInsertionShift);
+      while (i > stop && msg.mOffset < mBuf[i - 1].mOffset) --i;
+
+      if (i > mFront && msg.mOffset < mBuf[i - 1].mOffset)
+        mSorted = false;
+      else
+      {
+        memmove(&mBuf[i + 1], &mBuf[i], (mBack - i) * sizeof(T));
+        mBuf[i] = msg;
+        ++mBack;
+        return;
+      }
     }
-    else
 #endif
-      mBuf[mBack] = msg;
-    ++mBack;
+    mBuf[mBack++] = msg;
   }
 
   // Removes a MIDI message from the front of the queue (but does *not*
   // free up its space until Compact() is called).
-  inline void Remove() { ++mFront; }
+  inline void Remove() { Sort(); ++mFront; }
 
   // Returns true if the queue is empty.
   inline bool Empty() const { return mFront == mBack; }
@@ -733,9 +754,13 @@ public:
   // allocated.
   inline int GetSize() const { return mSize; }
 
+  // Returns the number of MIDI messages that were dropped because the
+  // queue was full.
+  inline int NumDropped() const { return mDropped; }
+
   // Returns the "next" MIDI message (all the way in the front of the
   // queue), but does *not* remove it from the queue.
-  inline T& Peek() const { return mBuf[mFront]; }
+  inline T& Peek() const { Sort(); return mBuf[mFront]; }
 
   // Moves back MIDI messages all the way to the front of the queue, thus
   // freeing up space at the back, and updates the sample offset of the
@@ -750,40 +775,32 @@ public:
   }
 
   // Clears the queue.
-  inline void Clear() { mFront = mBack = 0; }
+  inline void Clear() { mFront = mBack = 0; mSorted = true; }
 
-  // Resizes (grows or shrinks) the queue, returns the new size.
+  // Resizes (grows or shrinks) the queue, returns the new size. Call this
+  // outside of the audio thread, e.g. from OnReset(), with the largest number
+  // of messages that can be queued at once.
   int Resize(int size)
   {
     if (mFront > 0) Compact();
-    mGrow = size = Granulize(size);
+    size = Granulize(size);
     // Don't shrink below the number of currently queued MIDI messages.
     if (size < mBack) size = Granulize(mBack);
     if (size == mSize) return mSize;
 
     void* buf = realloc(mBuf, size * sizeof(T));
     if (!buf) return mSize;
-
     mBuf = (T*)buf;
-    mSize = size;
-    return size;
-  }
 
-protected:
-  // Automatically expands the queue.
-  bool Expand()
-  {
-    if (!mGrow) return false;
-    int size = (mSize / mGrow + 1) * mGrow;
+    void* tmp = realloc(mTmp, size * sizeof(T));
+    if (!tmp) return mSize;
+    mTmp = (T*)tmp;
 
-    void* buf = realloc(mBuf, size * sizeof(T));
-    if (!buf) return false;
-
-    mBuf = (T*)buf;
     mSize = size;
-    return true;
+    return size;
   }
 
+protected:
   // Moves everything all the way to the front.
   inline void Compact()
   {
@@ -792,6 +809,92 @@ protected:
     mFront = 0;
   }
 
+  inline void Sort() const
+  {
+    if (!mSorted)
+      SortQueued();
+  }
+
+  // Stable sort of the queued messages by mOffset: insertion sort for a
+  // handful of messages, a single counting sort pass when the offsets span
+  // less than kMaxBuckets samples (the usual case, as offsets are within a
+  // block or two), otherwise an LSD radix sort with one pass per byte of the
+  // range of offsets.
+  void SortQueued() const
+  {
+    mSorted = true;
+
+    const int n = mBack - mFront;
+
+    if (n <= kMaxInsertionSort)
+    {
+      for (int i = mFront + 1; i < mBack; ++i)
+      {
+        if (mBuf[i].mOffset < mBuf[i - 1].mOffset)
+        {
+          const T msg = mBuf[i];
+          int j = i - 1;
+          while (j >= mFront && msg.mOffset < mBuf[j].mOffset)
+          {
+            mBuf[j + 1] = mBuf[j];
+            --j;
+          }
+          mBuf[j + 1] = msg;
+        }
+      }
+      return;
+    }
+
+    T* pSrc = mBuf + mFront;
+    T* pDst = mTmp + mFront;
+
+    int minOffset = pSrc[0].mOffset, maxOffset = pSrc[0].mOffset;
+    for (int i = 1; i < n; ++i)
+    {
+      minOffset = std::min(minOffset, pSrc[i].mOffset);
+      maxOffset = std::max(maxOffset, pSrc[i].mOffset);
+    }
+
+    const unsigned int range = (unsigned int) maxOffset - (unsigned int) minOffset;
+    int* counts = mCounts;
+
+    if (range < kMaxBuckets)
+    {
+      memset(counts, 0, (range + 2) * sizeof(int));
+
+      for (int i = 0; i < n; ++i)
+        ++counts[pSrc[i].mOffset - minOffset + 1];
+
+      for (unsigned int b = 1; b <= range; ++b)
+        counts[b] += counts[b - 1];
+
+      for (int i = 0; i < n; ++i)
+        pDst[counts[pSrc[i].mOffset - minOffset]++] = pSrc[i];
+
+      memcpy(pSrc, pDst, n * sizeof(T));
+      return;
+    }
+
+    for (int shift = 0; shift < 32 && (range >> shift); shift += 8)
+    {
+      memset(counts, 0, 257 * sizeof(int));
+
+      for (int i = 0; i < n; ++i)
+        ++counts[((((unsigned int) pSrc[i].mOffset - (unsigned int) minOffset) >> shift) & 0xFF) + 1];
+
+      for (int b = 1; b < 257; ++b)
+        counts[b] += counts[b - 1];
+
+      for (int i = 0; i < n; ++i)
+        pDst[counts[(((unsigned int) pSrc[i].mOffset - (unsigned int) minOffset) >> shift) & 0xFF]++] = pSrc[i];
+
+      std::swap(pSrc, pDst);
+    }
+
+    if (pSrc != mBuf + mFront)
+      memcpy(mBuf + mFront, pSrc, n * sizeof(T));
+  }
+
   // Rounds the MIDI queue size up to the next 4 kB memory page size.
   inline int Granulize(int size) const
   {
@@ -801,10 +904,18 @@ protected:
     return size;
   }
 
+  static constexpr int kMaxInsertionSort = 32;
+  static constexpr int kMaxInsertionShift = 8; // how far back Add() inserts an out of order message, rather than leaving it to SortQueued()
+  static constexpr unsigned int kMaxBuckets = 4096;
+
   T* mBuf;
+  T* mTmp; // scratch space for sorting
+  int* mCounts; // kMaxBuckets + 1 counters for sorting, allocated once rather than on the audio thread's stack
 
-  int mSize, mGrow;
+  int mSize;
   int mFront, mBack;
+  mutable bool mSorted;
+  int mDropped;
 };
 
 using IMidiQueue = IMidiQueueBase<IMidiMsg>;
@@ -33,6 +33,15 @@ double IParam::ShapeLinear::ValueToNormalized(double value, const IParam& param)
   return (value - param.mMin) / (param.mMax - param.mMin);
 }
 
+void IParam::ShapeLinear::NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const
+{
+  const double min = param.mMin;
+  const double range = param.mMax - param.mMin;
+  
+  for (int i = 0; i < nValues; i++)
+    pValues[i] = min + pNormalized[i] * range;
+}
+
 IParam::ShapePowCurve::ShapePowCurve(double shape)
 : mShape(shape)
 {
@@ -58,6 +67,16 @@ double IParam::ShapePowCurve::ValueToNormalized(double value, const IParam& para
   return std::pow((value - param.GetMin()) / (param.GetMax() - param.GetMin()), 1.0 / mShape);
 }
 
+void IParam::ShapePowCurve::NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const
+{
+  const double min = param.GetMin();
+  const double range = param.GetMax() - param.GetMin();
+  const double shape = mShape;
+  
+  for (int i = 0; i < nValues; i++)
+    pValues[i] = min + std::pow(pNormalized[i], shape) * range;
+}
+
 void IParam::ShapeExp::Init(const IParam& param)
 {
   double min = param.GetMin();
@@ -79,6 +98,15 @@ double IParam::ShapeExp::ValueToNormalized(double value, const IParam& param) co
   return (std::log(value) - mAdd) / mMul;
 }
 
+void IParam::ShapeExp::NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const
+{
+  const double add = mAdd;
+  const double mul = mMul;
+  
+  for (int i = 0; i < nValues; i++)
+    pValues[i] = std::exp(add + pNormalized[i] * mul);
+}
+
 #pragma mark -
 
 IParam::IParam()
@@ -355,6 +383,25 @@ bool IParam::MapDisplayText(const char* str, double* pValue) const
   return false;
 }
 
+void IParam::FromNormalized(const double* pNormalized, double* pValues, int nValues) const
+{
+  mShape->NormalizedToValues(pNormalized, pValues, nValues, *this);
+  
+  if (mFlags & kFlagStepped)
+  {
+    for (int i = 0; i < nValues; i++)
+      pValues[i] = Constrain(pValues[i]);
+  }
+  else
+  {
+    const double min = mMin;
+    const double max = mMax;
+    
+    for (int i = 0; i < nValues; i++)
+      pValues[i] = std::min(std::max(pValues[i], min), max);
+  }
+}
+
 double IParam::StringToValue(const char* str) const
 {
   double v = 0.;
@@ -97,6 +97,17 @@ public:
      * @param param The IParam to do the calculation against
      * @return double The normalized value */
     virtual double ValueToNormalized(double value, const IParam& param) const = 0;
+
+    /** Converts a buffer of normalized values to real values. Override this with a loop that doesn't make a virtual call per value
+     * @param pNormalized The normalized values
+     * @param pValues Buffer to be filled with the real values, which may be the same as pNormalized
+     * @param nValues The number of values
+     * @param param The IParam to do the calculation against */
+    virtual void NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const
+    {
+      for (int i = 0; i < nValues; i++)
+        pValues[i] = NormalizedToValue(pNormalized[i], param);
+    }
   };
 
   /** Linear parameter shaping */
@@ -106,6 +117,7 @@ public:
     IParam::EDisplayType GetDisplayType() const override { return kDisplayLinear; }
     double NormalizedToValue(double value, const IParam& param) const override;
     double ValueToNormalized(double value, const IParam& param) const override;
+    void NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const override;
   
     double mShape;
   };
@@ -118,6 +130,7 @@ public:
     IParam::EDisplayType GetDisplayType() const override;
     double NormalizedToValue(double value, const IParam& param) const override;
     double ValueToNormalized(double value, const IParam& param) const override;
+    void NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const override;
     
     double mShape;
   };
@@ -130,6 +143,7 @@ public:
     IParam::EDisplayType GetDisplayType() const override { return kDisplayLog; }
     double NormalizedToValue(double value, const IParam& param) const override;
     double ValueToNormalized(double value, const IParam& param) const override;
+    void NormalizedToValues(const double* pNormalized, double* pValues, int nValues, const IParam& param) const override;
     
     double mMul = 1.0;
     double mAdd = 1.0;
@@ -305,6 +319,12 @@ public:
     return Constrain(mShape->NormalizedToValue(normalizedValue, *this));
   }
 
+  /** Convert a buffer of normalized values to real values for this parameter, with one call to the Shape
+   * @param pNormalized The normalized input values in the range 0. to 1.
+   * @param pValues Buffer to be filled with the corresponding real values, which may be the same as pNormalized
+   * @param nValues The number of values */
+  void FromNormalized(const double* pNormalized, double* pValues, int nValues) const;
+
   /** Sets the parameter value
    * @param value Value to be set. Will be stepped and clamped between \c mMin and \c mMax */
   void Set(double value) { mValue.store(Constrain(value)); }
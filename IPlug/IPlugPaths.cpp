@@ -23,6 +23,11 @@
 #include <windows.h>
 #include <Shlobj.h>
 #include <Shlwapi.h>
+#elif defined OS_LINUX
+#include <climits>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
 #endif
 
 BEGIN_IPLUG_NAMESPACE
@@ -232,6 +237,135 @@ const void* LoadWinResource(const char* resid, const char* type, int& sizeInByte
   }
 }
 
+#elif defined OS_LINUX
+#pragma mark - OS_LINUX
+
+static bool FileExists(const char* path)
+{
+  struct stat st;
+  return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// Helper for getting an XDG base directory, falling back to a folder in the user's home
+static void GetXDGFolder(WDL_String& path, const char* envVar, const char* homeSubPath)
+{
+  const char* pEnv = getenv(envVar);
+
+  if (CStringHasContents(pEnv))
+  {
+    path.Set(pEnv);
+  }
+  else
+  {
+    UserHomePath(path);
+    path.Append(homeSubPath);
+  }
+}
+
+void HostPath(WDL_String& path, const char* bundleID)
+{
+  char exePath[PATH_MAX];
+  const ssize_t len = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+
+  path.Set("");
+
+  if (len > 0)
+  {
+    exePath[len] = '\0';
+    path.Set(exePath);
+    path.remove_filepart(true);
+  }
+}
+
+void DesktopPath(WDL_String& path)
+{
+  UserHomePath(path);
+  path.Append("/Desktop");
+}
+
+void UserHomePath(WDL_String& path)
+{
+  const char* pHome = getenv("HOME");
+  path.Set(pHome ? pHome : "");
+}
+
+void AppSupportPath(WDL_String& path, bool isSystem)
+{
+  if (isSystem)
+    path.Set("/usr/local/share");
+  else
+    GetXDGFolder(path, "XDG_DATA_HOME", "/.local/share");
+}
+
+void VST3PresetsPath(WDL_String& path, const char* mfrName, const char* pluginName, bool isSystem)
+{
+  if (isSystem)
+  {
+    path.Set("/usr/local/share/vst3/presets");
+  }
+  else
+  {
+    UserHomePath(path);
+    path.Append("/.vst3/presets");
+  }
+
+  path.AppendFormatted(PATH_MAX, "/%s/%s", mfrName, pluginName);
+}
+
+void INIPath(WDL_String& path, const char* pluginName)
+{
+  GetXDGFolder(path, "XDG_CONFIG_HOME", "/.config");
+  path.AppendFormatted(PATH_MAX, "/%s", pluginName);
+}
+
+EResourceLocation LocateResource(const char* name, const char* type, WDL_String& result, const char*, void*, const char* sharedResourcesSubPath)
+{
+  if (CStringHasContents(name))
+  {
+    if (FileExists(name))
+    {
+      result.Set(name);
+      return EResourceLocation::kAbsolutePath;
+    }
+
+    WDL_String file(name);
+    const char* subFolder = (strcmp(type, "ttf") == 0 || strcmp(type, "TTF") == 0) ? "fonts" : "img";
+
+    // Resources are expected in the same layout as the project's resources folder, next to the binary or in a shared folder
+    WDL_String searchDirs[2];
+    HostPath(searchDirs[0]);
+
+    if (CStringHasContents(sharedResourcesSubPath))
+      searchDirs[1].Set(sharedResourcesSubPath);
+
+    for (auto& dir : searchDirs)
+    {
+      if (!dir.GetLength())
+        continue;
+
+      WDL_String candidates[2];
+      candidates[0].SetFormatted(PATH_MAX, "%s/resources/%s/%s", dir.Get(), subFolder, file.get_filepart());
+      candidates[1].SetFormatted(PATH_MAX, "%s/%s", dir.Get(), file.get_filepart());
+
+      for (auto& candidate : candidates)
+      {
+        if (FileExists(candidate.Get()))
+        {
+          result.Set(candidate.Get());
+          return EResourceLocation::kAbsolutePath;
+        }
+      }
+    }
+  }
+  return EResourceLocation::kNotFound;
+}
+
+const void* LoadWinResource(const char* resid, const char* type, int& sizeInBytes, void* pHInstance)
+{
+  sizeInBytes = 0;
+  return nullptr;
+}
+
 #elif defined OS_WEB
 #pragma mark - OS_WEB
 
@@ -111,6 +111,7 @@ bool IPluginBase::SerializeParams(IByteChunk& chunk) const
   TRACE
   bool savedOK = true;
   int i, n = mParams.GetSize();
+  chunk.Reserve(n * sizeof(double));
   for (i = 0; i < n && savedOK; ++i)
   {
     IParam* pParam = mParams.Get(i);
@@ -290,6 +291,7 @@ void IPluginBase::MakeDefaultPreset(const char* name, int nPresets)
       SerializeState(pPreset->mChunk);
     }
   }
+  mPresetNameIndex.clear();
 }
 
 void IPluginBase::MakePreset(const char* name, ...)
@@ -299,6 +301,7 @@ void IPluginBase::MakePreset(const char* name, ...)
   {
     pPreset->mInitialized = true;
     strcpy(pPreset->mName, name);
+    mPresetNameIndex.clear();
     
     int i, n = NParams();
     
@@ -321,6 +324,7 @@ void IPluginBase::MakePresetFromNamedParams(const char* name, int nParamsNamed,
   {
     pPreset->mInitialized = true;
     strcpy(pPreset->mName, name);
+    mPresetNameIndex.clear();
     
     int i = 0, n = NParams();
     
@@ -363,6 +367,7 @@ void IPluginBase::MakePresetFromChunk(const char* name, IByteChunk& chunk)
   {
     pPreset->mInitialized = true;
     strcpy(pPreset->mName, name);
+    mPresetNameIndex.clear();
     
     pPreset->mChunk.PutChunk(&chunk);
   }
@@ -414,6 +419,7 @@ void IPluginBase::PruneUninitializedPresets()
       mPresets.Delete(i, true);
     }
   }
+  mPresetNameIndex.clear();
 }
 
 bool IPluginBase::RestorePreset(int idx)
@@ -429,6 +435,15 @@ bool IPluginBase::RestorePreset(int idx)
       pPreset->mInitialized = true;
       MakeDefaultUserPresetName(&mPresets, pPreset->mName);
       restoredOK = SerializeState(pPreset->mChunk);
+      mPresetNameIndex.clear();
+    }
+    else if (pPreset->mBankIdx > -1)
+    {
+      int size;
+      const uint8_t* pData = mFactoryBank->GetData(pPreset->mBankIdx, size);
+      mPresetScratch.Clear();
+      mPresetScratch.PutBytes(pData, size);
+      restoredOK = (UnserializeState(mPresetScratch, 0) > 0);
     }
     else
     {
@@ -447,19 +462,49 @@ bool IPluginBase::RestorePreset(int idx)
 
 bool IPluginBase::RestorePreset(const char* name)
 {
-  if (CStringHasContents(name))
+  int idx = GetPresetIdx(name);
+  return idx > -1 && RestorePreset(idx);
+}
+
+int IPluginBase::GetPresetIdx(const char* name) const
+{
+  if (!CStringHasContents(name))
+    return -1;
+  
+  auto find = [&]() {
+    auto it = mPresetNameIndex.find(name);
+    if (it != mPresetNameIndex.end() && it->second < mPresets.GetSize() && !strcmp(mPresets.Get(it->second)->mName, name))
+      return it->second;
+    return -1;
+  };
+  
+  int idx = find();
+  
+  if (idx < 0) // the names may have changed since the index was built
   {
+    mPresetNameIndex.clear();
     int n = mPresets.GetSize();
+    mPresetNameIndex.reserve(n);
     for (int i = 0; i < n; ++i)
     {
-      IPreset* pPreset = mPresets.Get(i);
-      if (!strcmp(pPreset->mName, name))
-      {
-        return RestorePreset(i);
-      }
+      mPresetNameIndex.emplace(mPresets.Get(i)->mName, i); // keeps the first of duplicate names
     }
+    idx = find();
+  }
+  
+  return idx;
+}
+
+void IPluginBase::LoadPresetChunk(IPreset* pPreset) const
+{
+  if (pPreset->mBankIdx > -1)
+  {
+    int size;
+    const uint8_t* pData = mFactoryBank->GetData(pPreset->mBankIdx, size);
+    pPreset->mChunk.Clear();
+    pPreset->mChunk.PutBytes(pData, size);
+    pPreset->mBankIdx = -1;
   }
-  return false;
 }
 
 const char* IPluginBase::GetPresetName(int idx) const
@@ -477,6 +522,7 @@ void IPluginBase::ModifyCurrentPreset(const char* name)
   {
     IPreset* pPreset = mPresets.Get(mCurrentPresetIdx);
     pPreset->mChunk.Clear();
+    pPreset->mBankIdx = -1;
     
     Trace(TRACELOC, "%d %s", mCurrentPresetIdx, pPreset->mName);
     
@@ -485,6 +531,7 @@ void IPluginBase::ModifyCurrentPreset(const char* name)
     if (CStringHasContents(name))
     {
       strcpy(pPreset->mName, name);
+      mPresetNameIndex.clear();
     }
   }
 }
@@ -494,6 +541,16 @@ bool IPluginBase::SerializePresets(IByteChunk& chunk) const
   TRACE
   bool savedOK = true;
   int n = mPresets.GetSize();
+  int totalSize = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    IPreset* pPreset = mPresets.Get(i);
+    int size = pPreset->mChunk.Size();
+    if (pPreset->mBankIdx > -1)
+      mFactoryBank->GetData(pPreset->mBankIdx, size);
+    totalSize += sizeof(int) + (int) strlen(pPreset->mName) + sizeof(bool) + (pPreset->mInitialized ? size : 0);
+  }
+  chunk.Reserve(totalSize);
   for (int i = 0; i < n && savedOK; ++i)
   {
     IPreset* pPreset = mPresets.Get(i);
@@ -502,7 +559,13 @@ bool IPluginBase::SerializePresets(IByteChunk& chunk) const
     Trace(TRACELOC, "%d %s", i, pPreset->mName);
     
     chunk.Put(&pPreset->mInitialized);
-    if (pPreset->mInitialized)
+    if (pPreset->mInitialized && pPreset->mBankIdx > -1)
+    {
+      int size;
+      const uint8_t* pData = mFactoryBank->GetData(pPreset->mBankIdx, size);
+      savedOK &= (chunk.PutBytes(pData, size) > 0);
+    }
+    else if (pPreset->mInitialized)
     {
       savedOK &= (chunk.PutChunk(&(pPreset->mChunk)) > 0);
     }
@@ -518,6 +581,7 @@ int IPluginBase::UnserializePresets(const IByteChunk& chunk, int startPos)
   for (int i = 0; i < n && pos >= 0; ++i)
   {
     IPreset* pPreset = mPresets.Get(i);
+    LoadPresetChunk(pPreset);
     pos = chunk.GetStr(name, pos);
     strcpy(pPreset->mName, name.Get());
     
@@ -534,6 +598,7 @@ int IPluginBase::UnserializePresets(const IByteChunk& chunk, int startPos)
       }
     }
   }
+  mPresetNameIndex.clear();
   RestorePreset(mCurrentPresetIdx);
   return pos;
 }
@@ -636,6 +701,7 @@ void IPluginBase::DumpPresetBlob(const char* filename) const
   
   char buf[MAX_BLOB_LENGTH];
   
+  LoadPresetChunk(mPresets.Get(mCurrentPresetIdx));
   IByteChunk* pPresetChunk = &mPresets.Get(mCurrentPresetIdx)->mChunk;
   uint8_t* byteStart = pPresetChunk->GetData();
   
@@ -788,6 +854,7 @@ bool IPluginBase::SaveBankAsFXB(const char* file) const
       for (int p = 0; p < NPresets(); p++)
       {
         IPreset* pPreset = mPresets.Get(p);
+        LoadPresetChunk(pPreset);
         
         char prgName[28];
         memset(prgName, 0, 28);
@@ -1053,3 +1120,71 @@ bool IPluginBase::LoadBankFromFXB(const char* file)
   
   return false;
 }
+
+bool IPluginBase::LoadFactoryBank(const char* file)
+{
+  if (!CStringHasContents(file))
+    return false;
+  
+  std::shared_ptr<const IPresetBank> pBank = IPresetBank::Open(file);
+  
+  if (!pBank || pBank->GetPluginID() != GetUniqueID())
+    return false;
+  
+  if (mFactoryBank) // presets may still refer to the previous bank
+  {
+    for (int i = 0; i < mPresets.GetSize(); ++i)
+    {
+      LoadPresetChunk(mPresets.Get(i));
+    }
+  }
+  
+  mFactoryBank = pBank;
+  
+  for (int b = 0; b < pBank->NPresets(); ++b)
+  {
+    IPreset* pPreset = GetNextUninitializedPreset(&mPresets);
+    
+    if (!pPreset)
+    {
+      pPreset = new IPreset();
+      mPresets.Add(pPreset);
+    }
+    
+    pPreset->mInitialized = true;
+    strncpy(pPreset->mName, pBank->GetName(b), MAX_PRESET_NAME_LEN - 1);
+    pPreset->mName[MAX_PRESET_NAME_LEN - 1] = '\0';
+    pPreset->mChunk.Clear();
+    pPreset->mBankIdx = b;
+  }
+  
+  mPresetNameIndex.clear();
+  OnPresetsModified();
+  return true;
+}
+
+bool IPluginBase::SaveFactoryBank(const char* file) const
+{
+  if (!CStringHasContents(file))
+    return false;
+  
+  std::vector<IPresetBank::Entry> entries;
+  entries.reserve(mPresets.GetSize());
+  
+  for (int i = 0; i < mPresets.GetSize(); ++i)
+  {
+    IPreset* pPreset = mPresets.Get(i);
+    
+    if (!pPreset->mInitialized)
+      continue;
+    
+    IPresetBank::Entry entry { pPreset->mName, pPreset->mChunk.GetData(), pPreset->mChunk.Size() };
+    
+    if (pPreset->mBankIdx > -1)
+      entry.mData = mFactoryBank->GetData(pPreset->mBankIdx, entry.mSize);
+    
+    entries.push_back(entry);
+  }
+  
+  return IPresetBank::Write(file, GetUniqueID(), entries);
+}
@@ -19,6 +19,11 @@
 #include "IPlugParameter.h"
 #include "IPlugStructs.h"
 #include "IPlugLogger.h"
+#include "IPlugPresetBank.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -175,9 +180,14 @@ public:
 
 #pragma mark - Preset Manipulation
   
-  /** Get a ptr to a factory preset
+  /** Get a ptr to a factory preset. If the preset is in the factory bank its data is copied into IPreset::mChunk
    * @ param idx The index number of the preset you are referring to */
-  IPreset* GetPreset(int idx) { return mPresets.Get(idx); }
+  IPreset* GetPreset(int idx)
+  {
+    IPreset* pPreset = mPresets.Get(idx);
+    if (pPreset) LoadPresetChunk(pPreset);
+    return pPreset;
+  }
   
   /** This method should update the current preset with current values
    * NOTE: This is only relevant for VST2 plug-ins, which is the only format to have the notion of banks?
@@ -198,6 +208,11 @@ public:
    * @return \c true on success */
   bool RestorePreset(const char* name);
 
+  /** Find a preset by name, using a hash of the preset names
+   * @param name CString name of the preset
+   * @return The index of the first preset with this name, or -1 if there is none */
+  int GetPresetIdx(const char* name) const;
+
   /** Get the name a preset
    * @param idx The index of the preset whose name to get
    * @return CString preset name */
@@ -210,10 +225,13 @@ public:
   {
     IPreset* pDst = mPresets.Get(destIdx);
 
+    LoadPresetChunk(pSrc);
     pDst->mChunk.Clear();
     pDst->mChunk.PutChunk(&pSrc->mChunk);
     pDst->mInitialized = true;
+    pDst->mBankIdx = -1;
     strncpy(pDst->mName, pSrc->mName, MAX_PRESET_NAME_LEN - 1);
+    mPresetNameIndex.clear();
   }
   
   /** This method can be used to initialize baked-in factory presets with the default parameter values. It finds the first uninitialized preset and initializes 
@@ -306,6 +324,18 @@ public:
    * @return /c true on success */
   bool LoadBankFromFXB(const char* file);
 
+  /** Load a factory bank written with SaveFactoryBank(). The bank file is memory mapped and shared between all instances that load it,
+   * only the preset names are read here. A preset's data is read from the file when it is restored.
+   * The bank's presets fill the uninitialized presets, and are added to the end of the list if there are more of them
+   * @param file The full path of the file to load
+   * @return /c true on success */
+  bool LoadFactoryBank(const char* file);
+
+  /** Save all initialized presets as a factory bank, see LoadFactoryBank()
+   * @param file The full path of the file to write or overwrite
+   * @return /c true on success */
+  bool SaveFactoryBank(const char* file) const;
+
   
 #pragma mark - Parameter manipulation
     
@@ -432,6 +462,15 @@ private:
   WDL_PtrList<const char> mParamGroups;
   /** "Baked in" Factory presets */
   WDL_PtrList<IPreset> mPresets;
+  /** Shared, memory mapped presets loaded with LoadFactoryBank() */
+  std::shared_ptr<const IPresetBank> mFactoryBank;
+  /** Used to restore presets from mFactoryBank without copying them into each IPreset */
+  IByteChunk mPresetScratch;
+  /** Preset name to index, rebuilt lazily when a lookup misses, so must be cleared whenever presets are renamed */
+  mutable std::unordered_map<std::string, int> mPresetNameIndex;
+
+  /** Copy a preset's data from mFactoryBank into IPreset::mChunk, if it is in the bank */
+  void LoadPresetChunk(IPreset* pPreset) const;
 
 #ifdef PARAMS_MUTEX
   friend class IPlugVST3ProcessorBase;
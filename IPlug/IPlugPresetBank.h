@@ -0,0 +1,325 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IPresetBank
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined OS_WIN
+  #include <windows.h>
+#elif !defined OS_WEB
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include "IPlugPlatform.h"
+#include "IPlugStructs.h"
+#include "IPlugUtilities.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A read-only bank of factory presets in a file, which is memory mapped so that preset data is only paged in when a preset is restored.
+ * Banks are shared: opening a file that another instance (of any plug-in in the same binary) already has open returns the same bank.
+ * Preset names are hashed when the bank is opened, so a preset can be found by name in constant time.
+ *
+ * The file is little endian:
+ * - a header: int32 magic ('IPpb'), int32 version, int32 plug-in unique ID, int32 number of presets
+ * - a table with one entry per preset: uint32 name offset, uint32 data offset, uint32 data size (offsets from the start of the file)
+ * - the names, null terminated, then the preset data as written by IPluginBase::SerializeState()
+ *
+ * Use IPluginBase::SaveFactoryBank() to write a bank, and IPluginBase::LoadFactoryBank() to use it */
+class IPresetBank
+{
+public:
+  static constexpr int kMagic = 'IPpb';
+  static constexpr int kVersion = 1;
+
+  /** A preset to write with Write() */
+  struct Entry
+  {
+    const char* mName;
+    const uint8_t* mData;
+    int mSize;
+  };
+
+  ~IPresetBank()
+  {
+#if defined OS_WIN
+    if (mpData) UnmapViewOfFile(mpData);
+    if (mMapping) CloseHandle(mMapping);
+#elif !defined OS_WEB
+    if (mpData) munmap(const_cast<uint8_t*>(mpData), mSize);
+#endif
+  }
+
+  IPresetBank(const IPresetBank&) = delete;
+  IPresetBank& operator=(const IPresetBank&) = delete;
+
+  /** Open a bank file, or share the bank if it is already open
+   * @param path The full path to the file
+   * @return The bank, or \c nullptr if the file can't be opened or is not a valid bank */
+  static std::shared_ptr<const IPresetBank> Open(const char* path)
+  {
+    std::lock_guard<std::mutex> lock(GetRegistryMutex());
+    auto& registry = GetRegistry();
+    auto it = registry.find(path);
+
+    if (it != registry.end())
+    {
+      if (auto pBank = it->second.lock())
+        return pBank;
+    }
+
+    std::shared_ptr<IPresetBank> pBank(new IPresetBank());
+
+    if (!pBank->Map(path) || !pBank->Parse())
+      return nullptr;
+
+    registry[path] = pBank;
+    return pBank;
+  }
+
+  /** Write a bank file
+   * @param path The full path of the file to write or overwrite
+   * @param pluginID The unique ID of the plug-in the presets belong to
+   * @param entries The presets
+   * @return \c true on success */
+  static bool Write(const char* path, int pluginID, const std::vector<Entry>& entries)
+  {
+    const int n = static_cast<int>(entries.size());
+    const int header[4] = { kMagic, kVersion, pluginID, n };
+    uint32_t offset = sizeof(header) + n * 3 * sizeof(uint32_t);
+    std::vector<uint32_t> table(n * 3);
+
+    for (int i = 0; i < n; i++)
+    {
+      table[i * 3] = offset;
+      offset += static_cast<uint32_t>(strlen(entries[i].mName) + 1);
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+      table[i * 3 + 1] = offset;
+      table[i * 3 + 2] = static_cast<uint32_t>(entries[i].mSize);
+      offset += static_cast<uint32_t>(entries[i].mSize);
+    }
+
+    IByteChunk chunk;
+    chunk.Reserve(static_cast<int>(offset));
+    chunk.PutBytes(header, sizeof(header));
+
+    for (auto v : table)
+      chunk.Put(&v);
+
+    for (const auto& entry : entries)
+      chunk.PutBytes(entry.mName, static_cast<int>(strlen(entry.mName) + 1));
+
+    for (const auto& entry : entries)
+      chunk.PutBytes(entry.mData, entry.mSize);
+
+    FILE* fp = fopenUTF8(path, "wb");
+
+    if (!fp)
+      return false;
+
+    const bool success = fwrite(chunk.GetData(), chunk.Size(), 1, fp) == 1;
+    fclose(fp);
+    return success;
+  }
+
+  /** @return The number of presets in the bank */
+  int NPresets() const { return mNPresets; }
+
+  /** @return The unique ID of the plug-in the presets belong to */
+  int GetPluginID() const { return mPluginID; }
+
+  /** @return The name of a preset */
+  const char* GetName(int idx) const
+  {
+    return (idx >= 0 && idx < mNPresets) ? reinterpret_cast<const char*>(mpData + ReadTable(idx, 0)) : "";
+  }
+
+  /** Get the data of a preset, which is read from the file when it is first accessed
+   * @param idx The index of the preset
+   * @param size Set to the size of the data in bytes
+   * @return A pointer to the data, which stays valid as long as the bank */
+  const uint8_t* GetData(int idx, int& size) const
+  {
+    if (idx < 0 || idx >= mNPresets)
+    {
+      size = 0;
+      return nullptr;
+    }
+
+    size = static_cast<int>(ReadTable(idx, 2));
+    return mpData + ReadTable(idx, 1);
+  }
+
+  /** @return The index of the first preset with a name, or -1 if there is none */
+  int Find(const char* name) const
+  {
+    auto it = mNameIndex.find(name);
+    return it != mNameIndex.end() ? it->second : -1;
+  }
+
+private:
+  IPresetBank() = default;
+
+  static std::mutex& GetRegistryMutex()
+  {
+    static std::mutex sMutex;
+    return sMutex;
+  }
+
+  static std::map<std::string, std::weak_ptr<IPresetBank>>& GetRegistry()
+  {
+    static std::map<std::string, std::weak_ptr<IPresetBank>> sRegistry;
+    return sRegistry;
+  }
+
+  uint32_t ReadTable(int idx, int field) const
+  {
+    uint32_t v;
+    memcpy(&v, mpData + 4 * sizeof(int) + (idx * 3 + field) * sizeof(uint32_t), sizeof(v));
+    return v;
+  }
+
+  bool Map(const char* path)
+  {
+#if defined OS_WIN
+    HANDLE file = CreateFileW(UTF8AsUTF16(path).Get(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER fileSize;
+
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart < INT32_MAX)
+    {
+      mSize = static_cast<size_t>(fileSize.QuadPart);
+      mMapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+      if (mMapping)
+        mpData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    CloseHandle(file); // the mapping keeps the file open
+    return mpData != nullptr;
+#elif defined OS_WEB
+    FILE* fp = fopenUTF8(path, "rb");
+
+    if (!fp)
+      return false;
+
+    fseek(fp, 0, SEEK_END);
+    const long fileSize = ftell(fp);
+    rewind(fp);
+
+    if (fileSize > 0)
+    {
+      mBuffer.resize(fileSize);
+
+      if (fread(mBuffer.data(), fileSize, 1, fp) == 1)
+      {
+        mpData = mBuffer.data();
+        mSize = mBuffer.size();
+      }
+    }
+
+    fclose(fp);
+    return mpData != nullptr;
+#else
+    const int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size < INT32_MAX)
+    {
+      void* pData = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (pData != MAP_FAILED)
+      {
+        mpData = static_cast<const uint8_t*>(pData);
+        mSize = st.st_size;
+      }
+    }
+
+    close(fd); // the mapping keeps the file open
+    return mpData != nullptr;
+#endif
+  }
+
+  /** Validates the header, table and names, so that the accessors don't need to */
+  bool Parse()
+  {
+    int header[4];
+
+    if (mSize < sizeof(header))
+      return false;
+
+    memcpy(header, mpData, sizeof(header));
+
+    if (header[0] != kMagic || header[1] != kVersion || header[3] < 0)
+      return false;
+
+    mPluginID = header[2];
+    mNPresets = header[3];
+
+    if (sizeof(header) + static_cast<uint64_t>(mNPresets) * 3 * sizeof(uint32_t) > mSize)
+      return false;
+
+    mNameIndex.reserve(mNPresets);
+
+    for (int i = 0; i < mNPresets; i++)
+    {
+      const uint32_t nameOffset = ReadTable(i, 0);
+      const uint32_t dataOffset = ReadTable(i, 1);
+      const uint32_t dataSize = ReadTable(i, 2);
+
+      if (nameOffset >= mSize || !memchr(mpData + nameOffset, 0, mSize - nameOffset)
+          || dataOffset > mSize || dataSize > mSize - dataOffset || dataSize > INT32_MAX)
+        return false;
+
+      mNameIndex.emplace(GetName(i), i); // keeps the first of duplicate names
+    }
+
+    return true;
+  }
+
+  const uint8_t* mpData = nullptr;
+  size_t mSize = 0;
+  int mNPresets = 0;
+  int mPluginID = 0;
+  std::unordered_map<std::string, int> mNameIndex;
+#if defined OS_WIN
+  HANDLE mMapping = NULL;
+#elif defined OS_WEB
+  std::vector<uint8_t> mBuffer;
+#endif
+};
+
+END_IPLUG_NAMESPACE
@@ -279,8 +279,9 @@ void IPlugProcessor::SetLatency(int samples)
 {
   mLatency = samples;
 
-  if (mLatencyDelay)
-    mLatencyDelay->SetDelayTime(mLatency);
+  // The delay follows mLatency without reallocating, unless it is longer than the buffer
+  if (mLatencyDelay && mLatency > mLatencyDelay->GetMaxDelay())
+    mLatencyDelay->Allocate(mLatency, mLatencyDelay->GetMaxBlockSize());
 }
 
 //static
@@ -443,6 +444,7 @@ void IPlugProcessor::SetChannelConnections(ERoute direction, int idx, int n, boo
   {
     IChannelData<>* pChannel = channelData.Get(i);
     pChannel->mConnected = connected;
+    pChannel->mSilent = false;
 
     if (!connected)
       *(pChannel->mData) = pChannel->mScratchBuf.Get();
@@ -451,10 +453,13 @@ void IPlugProcessor::SetChannelConnections(ERoute direction, int idx, int n, boo
 
 void IPlugProcessor::InitLatencyDelay()
 {
-  if (MaxNChannels(ERoute::kInput))
+  const int nChans = std::min(MaxNChannels(ERoute::kInput), MaxNChannels(ERoute::kOutput));
+
+  if (nChans)
   {
-    mLatencyDelay = std::unique_ptr<NChanDelayLine<PLUG_SAMPLE_DST>>(new NChanDelayLine<PLUG_SAMPLE_DST>(MaxNChannels(ERoute::kInput), MaxNChannels(ERoute::kOutput)));
-    mLatencyDelay->SetDelayTime(GetLatency());
+    // The block size is not known yet, so the delay processes larger blocks in chunks
+    mLatencyDelay = std::unique_ptr<NChanModDelayLine<PLUG_SAMPLE_DST>>(new NChanModDelayLine<PLUG_SAMPLE_DST>(nChans, NChanModDelayLine<PLUG_SAMPLE_DST>::EInterp::None));
+    mLatencyDelay->Allocate(GetLatency(), 512);
   }
 }
 
@@ -469,7 +474,10 @@ void IPlugProcessor::AttachBuffers(ERoute direction, int idx, int n, PLUG_SAMPLE
     IChannelData<>* pChannel = channelData.Get(i);
 
     if (pChannel->mConnected)
+    {
       *(pChannel->mData) = *(ppData++);
+      pChannel->mSilent = false;
+    }
   }
 }
 
@@ -488,8 +496,9 @@ void IPlugProcessor::AttachBuffers(ERoute direction, int idx, int n, PLUG_SAMPLE
       if (direction == ERoute::kInput)
       {
         PLUG_SAMPLE_DST* pScratch = pChannel->mScratchBuf.Get();
-        CastCopy(pScratch, *(ppData++), nFrames);
+        ConvertSamples(pScratch, *(ppData++), nFrames);
         *(pChannel->mData) = pScratch;
+        pChannel->mSilent = false;
       }
       else // output
       {
@@ -503,7 +512,7 @@ void IPlugProcessor::AttachBuffers(ERoute direction, int idx, int n, PLUG_SAMPLE
 void IPlugProcessor::PassThroughBuffers(PLUG_SAMPLE_DST type, int nFrames)
 {
   if (mLatency && mLatencyDelay)
-    mLatencyDelay->ProcessBlock(mScratchData[ERoute::kInput].Get(), mScratchData[ERoute::kOutput].Get(), nFrames);
+    mLatencyDelay->ProcessBlock(mScratchData[ERoute::kInput].Get(), mScratchData[ERoute::kOutput].Get(), nFrames, static_cast<PLUG_SAMPLE_DST>(mLatency));
   else
     IPlugProcessor::ProcessBlock(mScratchData[ERoute::kInput].Get(), mScratchData[ERoute::kOutput].Get(), nFrames);
 }
@@ -521,14 +530,39 @@ void IPlugProcessor::PassThroughBuffers(PLUG_SAMPLE_SRC type, int nFrames)
     IChannelData<>* pOutChannel = *ppOutChannel;
     if (pOutChannel->mConnected)
     {
-      CastCopy(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
+      ConvertSamples(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
     }
   }
 }
 
 void IPlugProcessor::ProcessBuffers(PLUG_SAMPLE_DST type, int nFrames)
 {
+  mSmoothedParams.Process(nFrames); // also when ProcessBlock() is skipped, so that ramps finish
+
+  const bool inputsSilent = UpdateInputSilence(nFrames);
+  const bool canSkip = mSilenceSkipping && mPlugType == EIPlugPluginType::kEffect && !mDoesMIDIIn && !GetTailIsInfinite() && MaxNChannels(ERoute::kInput);
+  const int64_t decayFrames = static_cast<int64_t>(mTailSize) + mLatency;
+
+  // The tail has decayed if the inputs were silent for long enough before this block
+  mProcessingSkipped = canSkip && inputsSilent && mSilentFrames >= decayFrames;
+  mSilentFrames = inputsSilent ? std::min(mSilentFrames + nFrames, decayFrames) : 0;
+
+  if (mProcessingSkipped)
+  {
+    const int nOut = MaxNChannels(ERoute::kOutput);
+
+    for (int i = 0; i < nOut; ++i)
+    {
+      IChannelData<>* pOutChannel = mChannelData[ERoute::kOutput].Get(i);
+      memset(*(pOutChannel->mData), 0, nFrames * sizeof(PLUG_SAMPLE_DST));
+      pOutChannel->mSilent = true;
+    }
+
+    return;
+  }
+
   ProcessBlock(mScratchData[ERoute::kInput].Get(), mScratchData[ERoute::kOutput].Get(), nFrames);
+  UpdateOutputSilence(nFrames);
 }
 
 void IPlugProcessor::ProcessBuffers(PLUG_SAMPLE_SRC type, int nFrames)
@@ -543,7 +577,7 @@ void IPlugProcessor::ProcessBuffers(PLUG_SAMPLE_SRC type, int nFrames)
 
     if (pOutChannel->mConnected)
     {
-      CastCopy(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
+      ConvertSamples(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
     }
   }
 }
@@ -569,6 +603,70 @@ void IPlugProcessor::ProcessBuffersAccumulating(int nFrames)
   }
 }
 
+bool IPlugProcessor::UpdateInputSilence(int nFrames)
+{
+  const int nIn = MaxNChannels(ERoute::kInput);
+  bool allSilent = true;
+
+  for (int i = 0; i < nIn; ++i)
+  {
+    IChannelData<>* pInChannel = mChannelData[ERoute::kInput].Get(i);
+
+    if (!pInChannel->mSilent)
+      pInChannel->mSilent = IsSilent(*(pInChannel->mData), nFrames);
+
+    allSilent &= pInChannel->mSilent;
+  }
+
+  return allSilent;
+}
+
+void IPlugProcessor::UpdateOutputSilence(int nFrames)
+{
+  const int nOut = MaxNChannels(ERoute::kOutput);
+
+  for (int i = 0; i < nOut; ++i)
+  {
+    IChannelData<>* pOutChannel = mChannelData[ERoute::kOutput].Get(i);
+    pOutChannel->mSilent = IsSilent(*(pOutChannel->mData), nFrames);
+  }
+}
+
+bool IPlugProcessor::GetInputIsSilent(int chIdx) const
+{
+  const IChannelData<>* pChannel = mChannelData[ERoute::kInput].Get(chIdx);
+  return pChannel ? pChannel->mSilent : true;
+}
+
+bool IPlugProcessor::GetOutputIsSilent(int chIdx) const
+{
+  const IChannelData<>* pChannel = mChannelData[ERoute::kOutput].Get(chIdx);
+  return pChannel ? pChannel->mSilent : true;
+}
+
+bool IPlugProcessor::GetOutputsAreSilent() const
+{
+  const int nOut = MaxNChannels(ERoute::kOutput);
+
+  for (int i = 0; i < nOut; ++i)
+  {
+    const IChannelData<>* pOutChannel = mChannelData[ERoute::kOutput].Get(i);
+
+    if (pOutChannel->mConnected && !pOutChannel->mSilent)
+      return false;
+  }
+
+  return true;
+}
+
+void IPlugProcessor::SetInputIsSilent(int chIdx, bool silent)
+{
+  IChannelData<>* pChannel = mChannelData[ERoute::kInput].Get(chIdx);
+
+  if (pChannel)
+    pChannel->mSilent = silent;
+}
+
 void IPlugProcessor::ZeroScratchBuffers()
 {
   int i, nIn = MaxNChannels(ERoute::kInput), nOut = MaxNChannels(ERoute::kOutput);
@@ -606,6 +704,7 @@ void IPlugProcessor::SetBlockSize(int blockSize)
       memset(pOutChannel->mScratchBuf.Get(), 0, blockSize * sizeof(PLUG_SAMPLE_DST));
     }
 
+    mSmoothedParams.SetMaxBlockSize(blockSize);
     mBlockSize = blockSize;
   }
 }
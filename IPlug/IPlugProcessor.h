@@ -26,6 +26,8 @@
 #include "IPlugConstants.h"
 #include "IPlugStructs.h"
 #include "IPlugUtilities.h"
+#include "IPlugTaskGraph.h"
+#include "IPlugSmoothedParams.h"
 #include "NChanDelay.h"
 
 /**
@@ -134,6 +136,46 @@ public:
   /** @return \c true if the plugin is currently rendering off-line */
   bool GetRenderingOffline() const { return mRenderingOffline; };
 
+  /** @param chIdx The index of the input channel
+   * @return \c true if the channel is silent in the block being processed, either because the host flagged it as silent or because all its samples are zero.
+   * Only valid during ProcessBlock() */
+  bool GetInputIsSilent(int chIdx) const;
+
+  /** @param chIdx The index of the output channel
+   * @return \c true if the output channel was silent in the last processed block. This is reported back to hosts that support it, so that they can skip processing downstream */
+  bool GetOutputIsSilent(int chIdx) const;
+
+  /** @return \c true if ProcessBlock() was not called for the last block, see SetSilenceSkipping() */
+  bool GetProcessingSkipped() const { return mProcessingSkipped; }
+
+  /** Opt in to skipping ProcessBlock() for effects without MIDI input: once all inputs have been silent for longer than the tail size plus the latency,
+   * ProcessBlock() is not called and the outputs are silent. Processing resumes as soon as an input is not silent.
+   * This is off by default, since the tail size is 0 unless set. Enable it only once SetTailSize() covers everything your effect outputs after its input stops,
+   * and not for effects that make sound or update state without an input (e.g. a signal generator with an audio input, or an analyser)
+   * @param enable \c true to skip ProcessBlock() once the tail has decayed */
+  void SetSilenceSkipping(bool enable) { mSilenceSkipping = enable; }
+
+  /** @return The task graph, for splitting ProcessBlock() into nodes that can run in parallel, see IPlugTaskGraph.
+   * Add the nodes and Start() the workers outside of ProcessBlock(), e.g. in the constructor or OnReset() */
+  IPlugTaskGraph& GetTaskGraph() { return mTaskGraph; }
+
+  /** Run the nodes of the task graph for the current block, call this from ProcessBlock().
+   * The nodes run in parallel when rendering in real time, and one after the other on the calling thread when rendering offline
+   * @param nFrames The number of frames in the block */
+  void ProcessTaskGraph(int nFrames) { mTaskGraph.Process(nFrames, GetRenderingOffline()); }
+
+  /** Have a buffer of smoothed values filled for a parameter before each ProcessBlock(), see ISmoothedParam.
+   * Call this outside of ProcessBlock(), e.g. in the constructor. Calling it again changes the ramp time
+   * @param paramIdx The index of the parameter
+   * @param param The parameter, e.g. *GetParam(paramIdx)
+   * @param rampTimeMs How long the value takes to ramp to a new value */
+  void EnableParamSmoothing(int paramIdx, const IParam& param, double rampTimeMs = 20.) { mSmoothedParams.Add(paramIdx, param, rampTimeMs); }
+
+  /** @param paramIdx The index of the parameter
+   * @return The smoothed values of the parameter for the current block, or \c nullptr if EnableParamSmoothing() was not called for it.
+   * Only valid during ProcessBlock() */
+  const ISmoothedParam* GetSmoothedParam(int paramIdx) const { return mSmoothedParams.Get(paramIdx); }
+
 #pragma mark -
   /** @return The number of samples elapsed since start of project timeline. */
   double GetSamplePos() const { return mTimeInfo.mSamplePos; }
@@ -287,15 +329,25 @@ protected:
   void ProcessBuffers(PLUG_SAMPLE_DST type, int nFrames);
   void ProcessBuffersAccumulating(int nFrames); // only for VST2 deprecated method single precision
   void ZeroScratchBuffers();
-  void SetSampleRate(double sampleRate) { mSampleRate = sampleRate; }
+  void SetSampleRate(double sampleRate) { mSampleRate = sampleRate; mSmoothedParams.SetSampleRate(sampleRate); }
   void SetBlockSize(int blockSize);
   void SetBypassed(bool bypassed) { mBypassed = bypassed; }
   void SetTimeInfo(const ITimeInfo& timeInfo) { mTimeInfo = timeInfo; }
   void SetRenderingOffline(bool renderingOffline) { mRenderingOffline = renderingOffline; }
+  /** Call after AttachBuffers() if the host has flagged an input channel as silent (e.g. a CLAP constant_mask or VST3 silenceFlags), so that it is not scanned */
+  void SetInputIsSilent(int chIdx, bool silent);
+  /** @return \c true if all the connected output channels were silent in the last processed block */
+  bool GetOutputsAreSilent() const;
   const WDL_String& GetChannelLabel(ERoute direction, int idx) { return mChannelData[direction].Get(idx)->mLabel; }
   sample** GetScratchData(ERoute direction) { return mScratchData[direction].Get(); }
 
 private:
+  /** Updates the silence flags of the inputs, scanning the channels that the host didn't flag
+   * @return \c true if all the inputs are silent */
+  bool UpdateInputSilence(int nFrames);
+  /** Updates the silence flags of the outputs, after ProcessBlock() */
+  void UpdateOutputSilence(int nFrames);
+
   /** See EIPlugPluginTypes */
   EIPlugPluginType mPlugType;
   /** \c true if the plug-in accepts MIDI input */
@@ -316,6 +368,12 @@ private:
   bool mBypassed = false;
   /** \c true if the plug-in is rendering off-line*/
   bool mRenderingOffline = false;
+  /** \c true if ProcessBlock() may be skipped once the inputs are silent and the tail has decayed */
+  bool mSilenceSkipping = false;
+  /** \c true if ProcessBlock() was skipped for the last block */
+  bool mProcessingSkipped = false;
+  /** The number of frames for which all the inputs have been silent, up to the tail size plus the latency */
+  int64_t mSilentFrames = 0;
   /** A list of IOConfig structures populated by ParseChannelIOStr in the IPlugProcessor constructor */
   WDL_PtrList<IOConfig> mIOConfigs;
   /* Manages pointers to the actual data for each channel */
@@ -323,7 +381,11 @@ private:
   /* A list of IChannelData structures corresponding to every input/output channel */
   WDL_PtrList<IChannelData<>> mChannelData[2];
   /** A multi-channel delay line used to delay the bypassed signal when a plug-in with latency is bypassed. */
-  std::unique_ptr<NChanDelayLine<sample>> mLatencyDelay = nullptr;
+  std::unique_ptr<NChanModDelayLine<sample>> mLatencyDelay = nullptr;
+  /** Nodes of ProcessBlock() that can run in parallel, see GetTaskGraph() */
+  IPlugTaskGraph mTaskGraph;
+  /** Parameters with smoothed value buffers, see EnableParamSmoothing() */
+  ISmoothedParams mSmoothedParams;
 protected: // protected because it needs to be access by the API classes, and don't want a setter/getter
   /** Contains detailed information about the transport state */
   ITimeInfo mTimeInfo;
@@ -0,0 +1,214 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc ISmoothedParam
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "heapbuf.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugParameter.h"
+#include "IPlugUtilities.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A buffer of smoothed values for one parameter, filled once per block before ProcessBlock(), see IPlugProcessor::EnableParamSmoothing().
+ * When the parameter changes, its normalized value ramps linearly to the new value over the ramp time, and the ramp is mapped to real values
+ * through the parameter's Shape, in one call per block. So a ShapeExp frequency sweeps exponentially and a ShapePowCurve gain follows its curve.
+ * Once the ramp has finished the buffer is filled with the value once, and IsConstant() is \c true, so DSP can take a fast path.
+ * A parameter that doesn't change only costs an atomic load and a comparison per block. */
+class ISmoothedParam
+{
+public:
+  ISmoothedParam(int paramIdx, const IParam& param)
+  : mParamIdx(paramIdx)
+  , mParam(param)
+  {
+    Snap();
+  }
+
+  ISmoothedParam(const ISmoothedParam&) = delete;
+  ISmoothedParam& operator=(const ISmoothedParam&) = delete;
+
+  /** @return The smoothed real values for the current block */
+  const double* Get() const { return mValues.Get(); }
+
+  /** @return \c true if every value in the current block is the same, which is then Get()[0] */
+  bool IsConstant() const { return mConstant; }
+
+  /** @return The index of the parameter */
+  int GetParamIdx() const { return mParamIdx; }
+
+  /** @return How long the value takes to ramp to a new value */
+  double GetRampTime() const { return mRampTimeMs; }
+
+  /** Set how long the value takes to ramp to a new value. This should not be called during ProcessBlock() */
+  void SetRampTime(double rampTimeMs, double sampleRate)
+  {
+    mRampTimeMs = rampTimeMs;
+    mRampFrames = std::max(static_cast<int>(rampTimeMs * 0.001 * sampleRate), 0);
+  }
+
+  /** Allocate the buffers and jump to the current value of the parameter. This should not be called during ProcessBlock() */
+  void SetMaxBlockSize(int maxBlockSize)
+  {
+    mNormalized.Resize(maxBlockSize);
+    mValues.Resize(maxBlockSize);
+    Snap();
+  }
+
+  /** Jump to the current value of the parameter, without a ramp */
+  void Snap()
+  {
+    mTarget = mParam.Value();
+    mNormTarget = mNormCurrent = mParam.ToNormalized(mTarget);
+    mRampRemaining = 0;
+    std::fill(mValues.Get(), mValues.Get() + mValues.GetSize(), mTarget);
+    mConstant = true;
+  }
+
+  /** Fill the buffer for the next block
+   * @param nFrames The block size, which should not be larger than the max block size */
+  void Process(int nFrames)
+  {
+    const double value = mParam.Value();
+
+    if (value != mTarget)
+    {
+      mTarget = value;
+      mNormTarget = mParam.ToNormalized(value);
+
+      if (mRampFrames > 1)
+      {
+        mRampRemaining = mRampFrames;
+        mNormInc = (mNormTarget - mNormCurrent) / mRampFrames;
+      }
+      else
+      {
+        mNormCurrent = mNormTarget;
+        mRampRemaining = 0;
+        mConstant = false; // so that the new value is filled below
+      }
+    }
+
+    if (mRampRemaining == 0)
+    {
+      if (!mConstant)
+      {
+        std::fill(mValues.Get(), mValues.Get() + mValues.GetSize(), mTarget);
+        mConstant = true;
+      }
+
+      return;
+    }
+
+    assert(nFrames <= mValues.GetSize());
+    nFrames = std::min(nFrames, mValues.GetSize());
+
+    double* pNormalized = mNormalized.Get();
+    const int nRamp = std::min(nFrames, mRampRemaining);
+
+    FillRamp(pNormalized, mNormCurrent + mNormInc, mNormInc, nRamp);
+    mRampRemaining -= nRamp;
+
+    if (mRampRemaining == 0)
+    {
+      mNormCurrent = mNormTarget;
+      std::fill(pNormalized + nRamp - 1, pNormalized + nFrames, mNormTarget);
+    }
+    else
+      mNormCurrent += mNormInc * nRamp;
+
+    mParam.FromNormalized(pNormalized, mValues.Get(), nFrames);
+    mConstant = false;
+  }
+
+private:
+  const int mParamIdx;
+  const IParam& mParam;
+  double mRampTimeMs = 0.;
+  int mRampFrames = 0;
+  int mRampRemaining = 0;
+  double mTarget = 0.; // The real value that the ramp is heading to
+  double mNormTarget = 0.;
+  double mNormCurrent = 0.;
+  double mNormInc = 0.;
+  bool mConstant = true;
+  WDL_TypedBuf<double> mNormalized;
+  WDL_TypedBuf<double> mValues;
+};
+
+/** The smoothed parameters of a processor, see IPlugProcessor::EnableParamSmoothing() */
+class ISmoothedParams
+{
+public:
+  /** Enable smoothing for a parameter, or change its ramp time if it is already enabled. This should not be called during ProcessBlock() */
+  void Add(int paramIdx, const IParam& param, double rampTimeMs)
+  {
+    assert(paramIdx >= 0);
+
+    if (paramIdx >= static_cast<int>(mIndex.size()))
+      mIndex.resize(paramIdx + 1, -1);
+
+    if (mIndex[paramIdx] < 0)
+    {
+      mIndex[paramIdx] = static_cast<int>(mParams.size());
+      mParams.push_back(std::make_unique<ISmoothedParam>(paramIdx, param));
+      mParams.back()->SetMaxBlockSize(mMaxBlockSize);
+    }
+
+    mParams[mIndex[paramIdx]]->SetRampTime(rampTimeMs, mSampleRate);
+  }
+
+  /** @return The smoothed parameter, or \c nullptr if smoothing is not enabled for it */
+  const ISmoothedParam* Get(int paramIdx) const
+  {
+    return (paramIdx >= 0 && paramIdx < static_cast<int>(mIndex.size()) && mIndex[paramIdx] > -1) ? mParams[mIndex[paramIdx]].get() : nullptr;
+  }
+
+  void SetSampleRate(double sampleRate)
+  {
+    mSampleRate = sampleRate;
+
+    for (auto& pParam : mParams)
+      pParam->SetRampTime(pParam->GetRampTime(), sampleRate);
+  }
+
+  void SetMaxBlockSize(int maxBlockSize)
+  {
+    mMaxBlockSize = maxBlockSize;
+
+    for (auto& pParam : mParams)
+      pParam->SetMaxBlockSize(maxBlockSize);
+  }
+
+  void Process(int nFrames)
+  {
+    for (auto& pParam : mParams)
+      pParam->Process(nFrames);
+  }
+
+private:
+  std::vector<std::unique_ptr<ISmoothedParam>> mParams;
+  std::vector<int> mIndex; // paramIdx to an index in mParams, or -1
+  double mSampleRate = DEFAULT_SAMPLE_RATE;
+  int mMaxBlockSize = 0;
+};
+
+END_IPLUG_NAMESPACE
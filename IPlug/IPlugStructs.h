@@ -210,6 +210,13 @@ public:
     return PutBytes(pRHS->GetData(), pRHS->Size());
   }
   
+  /** Preallocates memory for data that is about to be added, so that the following Put() calls don't reallocate
+   * @param nBytes The number of bytes that will be added after the end of the chunk */
+  inline void Reserve(int nBytes)
+  {
+    mBytes.Prealloc(mBytes.GetSize() + nBytes);
+  }
+  
   /** Clears the chunk (resizes to 0) */
   inline void Clear()
   {
@@ -476,6 +483,7 @@ struct IChannelData
   bool mConnected = false;
   TOUT** mData = nullptr; // If this is for an input channel, points into IPlugProcessor::mInData, if it's for an output channel points into IPlugProcessor::mOutData
   TIN* mIncomingData = nullptr;
+  bool mSilent = false; // For an input channel, true if the host flagged it as silent or all its samples are zero. For an output channel, true if the last block was silent
   WDL_TypedBuf<TOUT> mScratchBuf;
   WDL_String mLabel;
 };
@@ -602,6 +610,8 @@ struct IPreset
 {
   bool mInitialized = false;
   char mName[MAX_PRESET_NAME_LEN];
+  /** If > -1, the preset data is in the factory IPresetBank at this index and mChunk is empty until the preset is materialised */
+  int mBankIdx = -1;
 
   IByteChunk mChunk;
 
@@ -0,0 +1,461 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief IPlugTaskGraph implementation, and the worker pool shared by the graphs of all instances
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "IPlugTaskGraph.h"
+
+#if defined OS_WIN
+  #include <windows.h>
+#elif defined OS_LINUX
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #include <immintrin.h>
+#elif defined(_M_ARM64)
+  #include <intrin.h>
+#endif
+
+using namespace iplug;
+
+namespace
+{
+  constexpr int kSpinCount = 1000; // pauses before a thread that has nothing to do sleeps, a few tens of microseconds
+
+  /** Tell the core that this is a spin-wait loop, which saves power and frees resources for its other hardware thread */
+  inline void CPUPause()
+  {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(_M_ARM64)
+    __yield();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+  }
+}
+
+/** The worker threads shared by every IPlugTaskGraph in the process. Graphs register in a slot when started, and the workers
+ * look through the slots for graphs with a block in progress when a block starts. The threads are started with the first graph,
+ * and joined when the last one stops, so none are left running when a plug-in binary is unloaded */
+class IPlugTaskGraph::WorkerPool
+{
+public:
+  static WorkerPool& Get()
+  {
+    static WorkerPool sPool;
+    return sPool;
+  }
+
+  ~WorkerPool()
+  {
+    StopThreads();
+  }
+
+  /** Register a graph, starting the threads if it is the first one
+   * @return The graph's slot, or -1 if no worker can help with it */
+  int Register(IPlugTaskGraph* pGraph, int nWorkers, bool pinThreads)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    int slot = 0;
+
+    while (slot < kMaxGraphs && mSlots[slot].mGraph.load(std::memory_order_relaxed))
+      slot++;
+
+    if (slot == kMaxGraphs)
+      return -1;
+
+    if (mThreads.empty())
+      StartThreads(nWorkers, pinThreads);
+
+    const int nThreads = static_cast<int>(mThreads.size());
+    pGraph->mNWorkers = nWorkers < 0 ? nThreads : std::min(nWorkers, nThreads);
+
+    if (!pGraph->mNWorkers)
+    {
+      if (!mNGraphs)
+        StopThreads();
+
+      return -1;
+    }
+
+    // The state has to be allocated for the workers before the graph is visible to them
+    pGraph->AllocateState();
+    mNGraphs++;
+    mNSlots.store(std::max(mNSlots.load(std::memory_order_relaxed), slot + 1), std::memory_order_release);
+    mSlots[slot].mGraph.store(pGraph, std::memory_order_seq_cst);
+
+    return slot;
+  }
+
+  /** Unregister a graph, returning once no worker uses it, and stopping the threads if it was the last one */
+  void Unregister(int slot)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    Slot& s = mSlots[slot];
+    s.mGraph.store(nullptr, std::memory_order_seq_cst);
+
+    while (s.mNUsers.load(std::memory_order_seq_cst))
+      std::this_thread::yield();
+
+    if (!--mNGraphs)
+      StopThreads();
+  }
+
+  /** Let the workers know that a block has started, called from Process() */
+  void Wake()
+  {
+    mGeneration.fetch_add(1, std::memory_order_release);
+
+    if (mNSleepingWorkers.load(std::memory_order_acquire))
+      mWakeCV.notify_all();
+  }
+
+private:
+  static constexpr int kDefaultMaxWorkers = 3;
+  static constexpr int kMaxGraphs = 1024;
+  static constexpr int kWorkerSleepTimeoutMs = 1;
+
+  struct Slot
+  {
+    std::atomic<IPlugTaskGraph*> mGraph {nullptr};
+    std::atomic<int> mNUsers {0}; // workers looking at the graph, which can't be unregistered until they are done
+  };
+
+  WorkerPool() {}
+
+  void StartThreads(int nWorkers, bool pinThreads)
+  {
+    const int nCores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    if (nWorkers < 0)
+      nWorkers = std::min(kDefaultMaxWorkers, nCores - 1);
+
+    mRunning = true;
+
+    for (int i = 0; i < nWorkers; i++)
+    {
+      mThreads.emplace_back(&WorkerPool::WorkerThread, this, i + 1);
+
+      if (pinThreads)
+        PinThread(mThreads.back(), (i + 1) % nCores);
+    }
+  }
+
+  void StopThreads()
+  {
+    if (mThreads.empty())
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mRunning = false;
+    }
+
+    mWakeCV.notify_all();
+
+    for (auto& thread : mThreads)
+      thread.join();
+
+    mThreads.clear();
+  }
+
+  /** Run nodes of every graph that has a block in progress
+   * @param threadIdx The worker's index, from 1, which is also the index of its deque in each graph */
+  void HelpGraphs(int threadIdx)
+  {
+    const int nSlots = mNSlots.load(std::memory_order_acquire);
+
+    for (int i = 0; i < nSlots; i++)
+    {
+      Slot& s = mSlots[i];
+
+      if (!s.mGraph.load(std::memory_order_relaxed))
+        continue;
+
+      s.mNUsers.fetch_add(1, std::memory_order_seq_cst);
+      IPlugTaskGraph* pGraph = s.mGraph.load(std::memory_order_seq_cst);
+
+      if (pGraph && threadIdx <= pGraph->mNWorkers)
+        pGraph->Help(threadIdx);
+
+      s.mNUsers.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  void WorkerThread(int threadIdx)
+  {
+    uint32_t lastGeneration = mGeneration.load(std::memory_order_acquire);
+    int nIdle = 0;
+
+    while (mRunning.load(std::memory_order_acquire))
+    {
+      const uint32_t generation = mGeneration.load(std::memory_order_acquire);
+
+      if (generation != lastGeneration)
+      {
+        lastGeneration = generation;
+        HelpGraphs(threadIdx);
+        nIdle = 0;
+      }
+      else if (nIdle < kSpinCount)
+      {
+        nIdle++;
+        CPUPause();
+      }
+      else
+      {
+        // The audio thread notifies without locking, so a wake up can be missed: the timeout bounds the delay,
+        // and the audio thread processes the nodes itself in the meantime
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mNSleepingWorkers.fetch_add(1, std::memory_order_acq_rel);
+        mWakeCV.wait_for(lock, std::chrono::milliseconds(kWorkerSleepTimeoutMs), [&]() {
+          return !mRunning.load(std::memory_order_acquire) || mGeneration.load(std::memory_order_acquire) != lastGeneration;
+        });
+        mNSleepingWorkers.fetch_sub(1, std::memory_order_acq_rel);
+      }
+    }
+  }
+
+  static void PinThread(std::thread& thread, int core)
+  {
+#if defined OS_WIN
+    if (core < static_cast<int>(sizeof(DWORD_PTR) * 8))
+      SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core);
+#elif defined OS_LINUX
+    if (core < CPU_SETSIZE)
+    {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(core, &cpuSet);
+      pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+    }
+#else
+    // Thread affinity is not available on Apple platforms, the scheduler places the threads
+    (void) thread; (void) core;
+#endif
+  }
+
+  Slot mSlots[kMaxGraphs];
+  std::atomic<int> mNSlots {0}; // one past the highest slot that has been used
+  int mNGraphs = 0;
+  std::mutex mMutex; // registration
+  std::vector<std::thread> mThreads;
+  std::atomic<bool> mRunning {false};
+  std::atomic<uint32_t> mGeneration {0};
+  std::atomic<int> mNSleepingWorkers {0};
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCV;
+};
+
+int IPlugTaskGraph::AddNode(NodeFunc func, std::initializer_list<int> dependencies)
+{
+  const int idx = static_cast<int>(mNodes.size());
+
+  for (int dependency : dependencies)
+  {
+    if (dependency < 0 || dependency >= idx)
+      return -1;
+  }
+
+  // A worker may still be leaving the last block, let it go before the nodes and their state are reallocated
+  while (mNActiveWorkers.load(std::memory_order_acquire))
+    std::this_thread::yield();
+
+  mNodes.emplace_back();
+  mNodes.back().mFunc = std::move(func);
+
+  for (int dependency : dependencies)
+  {
+    auto& successors = mNodes[dependency].mSuccessors;
+
+    if (std::find(successors.begin(), successors.end(), idx) == successors.end())
+    {
+      successors.push_back(idx);
+      mNodes.back().mNDependencies++;
+    }
+  }
+
+  if (!mNodes.back().mNDependencies)
+    mRoots.push_back(idx);
+
+  AllocateState();
+  return idx;
+}
+
+void IPlugTaskGraph::Clear()
+{
+  while (mNActiveWorkers.load(std::memory_order_acquire))
+    std::this_thread::yield();
+
+  mNodes.clear();
+  mRoots.clear();
+  AllocateState();
+}
+
+bool IPlugTaskGraph::Start(int nWorkers, bool pinThreads)
+{
+  Stop();
+
+  if (nWorkers == 0)
+    return false;
+
+  mSlot = WorkerPool::Get().Register(this, nWorkers, pinThreads);
+
+  if (mSlot < 0)
+  {
+    mNWorkers = 0;
+    AllocateState();
+  }
+
+  return mSlot >= 0;
+}
+
+void IPlugTaskGraph::Stop()
+{
+  if (mSlot < 0)
+    return;
+
+  WorkerPool::Get().Unregister(mSlot);
+  mSlot = -1;
+  mNWorkers = 0;
+  AllocateState();
+}
+
+void IPlugTaskGraph::Process(int nFrames, bool singleThreaded)
+{
+  const int nNodes = static_cast<int>(mNodes.size());
+
+  if (!nNodes)
+    return;
+
+  // A worker that is still leaving the last block could still look at its deques, so rather than waiting for it,
+  // which could be waiting for a preempted thread, the calling thread runs this block on its own
+  if (singleThreaded || !mNWorkers || mNActiveWorkers.load(std::memory_order_seq_cst))
+  {
+    for (auto& node : mNodes)
+      node.mFunc(nFrames);
+
+    return;
+  }
+
+  // No worker is active here, and any that joins from now on sees mRemaining at 0 until the block state has been reset
+  mFrames = nFrames;
+
+  for (int i = 0; i < nNodes; i++)
+    mPending[i].store(mNodes[i].mNDependencies, std::memory_order_relaxed);
+
+  for (auto& deque : mDeques)
+    deque.Reset();
+
+  for (int root : mRoots)
+    mDeques[0].Push(root);
+
+  mRemaining.store(nNodes, std::memory_order_release);
+  WorkerPool::Get().Wake();
+
+  WorkLoop(0);
+}
+
+void IPlugTaskGraph::AllocateState()
+{
+  const int nNodes = static_cast<int>(mNodes.size());
+
+  mPending.reset(nNodes ? new std::atomic<int>[nNodes] : nullptr);
+  mDeques = std::vector<Deque>(1 + mNWorkers);
+
+  for (auto& deque : mDeques)
+    deque.Allocate(nNodes);
+}
+
+void IPlugTaskGraph::RunNode(int threadIdx, int nodeIdx)
+{
+  const Node& node = mNodes[nodeIdx];
+  node.mFunc(mFrames);
+
+  for (int successor : node.mSuccessors)
+  {
+    if (mPending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+      mDeques[threadIdx].Push(successor);
+  }
+
+  mRemaining.fetch_sub(1, std::memory_order_seq_cst);
+
+  if (mNWaiting.load(std::memory_order_seq_cst))
+  {
+    // Taking the mutex means a thread that has just seen no progress is already waiting, so it can't miss the notification
+    { std::lock_guard<std::mutex> lock(mProgressMutex); }
+    mProgressCV.notify_all();
+  }
+}
+
+void IPlugTaskGraph::WorkLoop(int threadIdx)
+{
+  const int nThreads = static_cast<int>(mDeques.size());
+  int nIdle = 0;
+
+  for (int remaining; (remaining = mRemaining.load(std::memory_order_acquire)) > 0; )
+  {
+    int nodeIdx = mDeques[threadIdx].Pop();
+
+    for (int i = 1; i < nThreads && nodeIdx < 0; i++)
+      nodeIdx = mDeques[(threadIdx + i) % nThreads].Steal();
+
+    if (nodeIdx >= 0)
+    {
+      RunNode(threadIdx, nodeIdx);
+      nIdle = 0;
+    }
+    else if (nIdle < kSpinCount)
+    {
+      nIdle++;
+      CPUPause();
+    }
+    else
+    {
+      // The nodes left are running on other threads, sleep until one of them finishes
+      std::unique_lock<std::mutex> lock(mProgressMutex);
+      mNWaiting.fetch_add(1, std::memory_order_seq_cst);
+      mProgressCV.wait(lock, [&]() { return mRemaining.load(std::memory_order_seq_cst) != remaining; });
+      mNWaiting.fetch_sub(1, std::memory_order_relaxed);
+      nIdle = 0;
+    }
+  }
+}
+
+bool IPlugTaskGraph::Help(int threadIdx)
+{
+  if (mRemaining.load(std::memory_order_acquire) <= 0)
+    return false;
+
+  mNActiveWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+  // Checked again once active, Process() doesn't reset the block state while a worker is
+  const bool inBlock = mRemaining.load(std::memory_order_seq_cst) > 0;
+
+  if (inBlock)
+    WorkLoop(threadIdx);
+
+  mNActiveWorkers.fetch_sub(1, std::memory_order_release);
+  return inBlock;
+}
@@ -0,0 +1,200 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IPlugTaskGraph
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Runs the independent parts of a plug-in's DSP in parallel, for example the bands of a multiband split, per-bus side-chain analysis
+ * or the channel groups of a surround effect.
+ * The graph is made of nodes, each a function processing one block, which may depend on nodes added before them.
+ * Process() runs every node once per block, starting each node once all of its dependencies have finished, and returns when all nodes have finished.
+ *
+ * The calling (audio) thread always takes part, helped by a small pool of worker threads that is shared by every graph in the process,
+ * so that sessions with many instances don't start threads per instance. Ready nodes are pushed onto per-thread lock-free
+ * work-stealing deques: a thread runs the nodes it made ready itself first, and steals from the others when it runs out.
+ * Process() doesn't allocate or wait for the workers, it only waits for the nodes they are running to finish: it spins for a few
+ * tens of microseconds, then sleeps until one of them finishes. Between blocks, the workers also spin briefly and then sleep until the next block.
+ *
+ * With singleThreaded set, or without workers, the nodes run on the calling thread in the order they were added,
+ * which is deterministic, e.g. for offline rendering.
+ *
+ * Nodes and workers must be set up outside of Process(), e.g. in the constructor or OnReset() @see IPlugProcessor::GetTaskGraph() */
+class IPlugTaskGraph final
+{
+public:
+  /** A function processing one block, it is passed the number of frames in the block */
+  using NodeFunc = std::function<void(int nFrames)>;
+
+  IPlugTaskGraph() {}
+
+  ~IPlugTaskGraph()
+  {
+    Stop();
+  }
+
+  IPlugTaskGraph(const IPlugTaskGraph&) = delete;
+  IPlugTaskGraph& operator=(const IPlugTaskGraph&) = delete;
+
+  /** Add a node to the graph. This allocates, don't call it concurrently with Process()
+   * @param func The function processing one block, called on any of the threads
+   * @param dependencies Indexes of nodes that must finish before this one starts, which must have been added before it
+   * @return The index of the new node, or -1 if a dependency is not valid */
+  int AddNode(NodeFunc func, std::initializer_list<int> dependencies = {});
+
+  /** Remove all nodes. Don't call it concurrently with Process() */
+  void Clear();
+
+  /** @return The number of nodes in the graph */
+  int NNodes() const { return static_cast<int>(mNodes.size()); }
+
+  /** Have the shared worker threads help with this graph, starting them if this is the first graph to do so. Don't call it concurrently with Process()
+   * @param nWorkers The maximum number of workers helping with this graph, in addition to the thread calling Process(), -1 for all the workers of the shared pool.
+   * The call that starts the shared pool also sets its number of threads, -1 uses a default based on the number of cores
+   * @param pinThreads Pin each worker to its own core, on platforms that support it (Windows and Linux). This only applies if the shared pool is started by this call
+   * @return \c true if workers are helping with this graph */
+  bool Start(int nWorkers = -1, bool pinThreads = false);
+
+  /** Stop the workers helping with this graph, the shared threads are joined once no graph uses them. Don't call it concurrently with Process() */
+  void Stop();
+
+  /** @return The number of worker threads helping with this graph */
+  int NWorkers() const { return mNWorkers; }
+
+  /** Run every node of the graph once, returning when they have all finished. Call this from ProcessBlock()
+   * @param nFrames The number of frames in the block, passed to each node
+   * @param singleThreaded Run the nodes on the calling thread, in the order they were added */
+  void Process(int nFrames, bool singleThreaded = false);
+
+private:
+  class WorkerPool;
+
+  struct Node
+  {
+    NodeFunc mFunc;
+    std::vector<int> mSuccessors;
+    int mNDependencies = 0;
+  };
+
+  /** A bounded Chase-Lev work-stealing deque of node indexes. Each node is pushed at most once per block,
+   * so with a capacity of the number of nodes it never wraps, and Reset() rewinds it between blocks */
+  class Deque
+  {
+  public:
+    void Allocate(int capacity)
+    {
+      mItems.reset(capacity ? new std::atomic<int>[capacity] : nullptr);
+      Reset();
+    }
+
+    void Reset()
+    {
+      mTop.store(0, std::memory_order_relaxed);
+      mBottom.store(0, std::memory_order_relaxed);
+    }
+
+    /** Owner only */
+    void Push(int item)
+    {
+      const int b = mBottom.load(std::memory_order_relaxed);
+      mItems[b].store(item, std::memory_order_relaxed);
+      mBottom.store(b + 1, std::memory_order_release);
+    }
+
+    /** Owner only, takes the most recently pushed item */
+    int Pop()
+    {
+      const int b = mBottom.load(std::memory_order_relaxed) - 1;
+      mBottom.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int t = mTop.load(std::memory_order_relaxed);
+
+      if (t > b)
+      {
+        mBottom.store(b + 1, std::memory_order_relaxed);
+        return -1;
+      }
+
+      int item = mItems[b].load(std::memory_order_relaxed);
+
+      if (t == b)
+      {
+        // Last item, race against thieves
+        if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+          item = -1;
+
+        mBottom.store(b + 1, std::memory_order_relaxed);
+      }
+
+      return item;
+    }
+
+    /** Any thread, takes the least recently pushed item */
+    int Steal()
+    {
+      int t = mTop.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const int b = mBottom.load(std::memory_order_acquire);
+
+      if (t >= b)
+        return -1;
+
+      const int item = mItems[t].load(std::memory_order_relaxed);
+
+      if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return -1;
+
+      return item;
+    }
+
+  private:
+    std::unique_ptr<std::atomic<int>[]> mItems;
+    std::atomic<int> mTop {0};
+    std::atomic<int> mBottom {0};
+  };
+
+  void AllocateState();
+  void RunNode(int threadIdx, int nodeIdx);
+  void WorkLoop(int threadIdx);
+
+  /** Called by the worker threadIdx of the shared pool, runs nodes of the current block if it has one
+   * @return \c true if the worker took part in a block */
+  bool Help(int threadIdx);
+
+  std::vector<Node> mNodes;
+  std::vector<int> mRoots;
+  std::unique_ptr<std::atomic<int>[]> mPending; // dependencies left to finish, per node
+  std::vector<Deque> mDeques; // one per thread, 0 is the thread calling Process()
+  int mNWorkers = 0;
+  int mSlot = -1; // in the shared pool, while started
+  int mFrames = 0;
+  std::atomic<int> mRemaining {0};
+  std::atomic<int> mNActiveWorkers {0};
+  std::atomic<int> mNWaiting {0}; // threads sleeping in WorkLoop() until a node finishes
+  std::mutex mProgressMutex;
+  std::condition_variable mProgressCV;
+};
+
+END_IPLUG_NAMESPACE
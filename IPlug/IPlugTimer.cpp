@@ -143,4 +143,396 @@ void Timer_impl::TimerProc(void* userData)
   Timer_impl* itimer = (Timer_impl*) userData;
   itimer->mTimerFunc(*itimer);
 }
+#elif defined OS_LINUX
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+#include <numeric>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace
+{
+  int64_t NowNs()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+  /** Read (and so reset) the counter of an eventfd or timerfd
+   * @return The counter, or 0 if it wasn't readable */
+  uint64_t ReadCounter(int fd)
+  {
+    uint64_t count = 0;
+    return read(fd, &count, sizeof(count)) == sizeof(count) ? count : 0;
+  }
+
+  void Signal(int fd)
+  {
+    const uint64_t one = 1;
+    (void) !write(fd, &one, sizeof(one));
+  }
+}
+
+Timer* Timer::Create(ITimerFunction func, uint32_t intervalMs)
+{
+  return new Timer_impl(func, intervalMs);
+}
+
+Timer_impl::Timer_impl(ITimerFunction func, uint32_t intervalMs)
+: mTimerFunc(func)
+, mIntervalMs(std::max(intervalMs, 1u))
+{
+  TimerService::Get().Add(this);
+}
+
+Timer_impl::~Timer_impl()
+{
+  Stop();
+}
+
+void Timer_impl::Stop()
+{
+  TimerService::Get().Remove(this);
+}
+
+TimerService& TimerService::Get()
+{
+  static TimerService sService;
+  return sService;
+}
+
+TimerService::TimerService()
+{
+  mEpollFD = epoll_create1(EPOLL_CLOEXEC);
+  mTimerFD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  mWakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  mDispatchFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  for (int fd : { mTimerFD, mWakeFD })
+  {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(mEpollFD, EPOLL_CTL_ADD, fd, &event);
+  }
+
+  // The thread is started when a run loop is first attached, polling doesn't need it
+}
+
+TimerService::~TimerService()
+{
+  mQuit = true;
+  Signal(mWakeFD);
+
+  if (mThread.joinable())
+    mThread.join();
+
+  for (int fd : { mEpollFD, mTimerFD, mWakeFD, mDispatchFD })
+  {
+    if (fd >= 0)
+      close(fd);
+  }
+}
+
+void TimerService::Add(Timer_impl* pTimer)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  pTimer->mRunning = true;
+  pTimer->mDue = false;
+  pTimer->mNextDueNs = NowNs() + static_cast<int64_t>(pTimer->mIntervalMs) * 1000000;
+  mEarliestDueNs = std::min(mEarliestDueNs.load(), pTimer->mNextDueNs);
+  mTimers.Add(pTimer);
+  UpdateHeartbeat();
+}
+
+void TimerService::Remove(Timer_impl* pTimer)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (pTimer->mRunning)
+  {
+    pTimer->mRunning = false;
+    mTimers.DeletePtr(pTimer);
+
+    // A timer that is stopped before its turn in the batch that is running
+    const int batchIdx = mBatch.Find(pTimer);
+
+    if (batchIdx >= 0)
+      mBatch.GetList()[batchIdx] = nullptr;
+
+    UpdateHeartbeat();
+  }
+
+  // If its function is running on another thread, wait for it to return, so that the timer can be deleted.
+  // A timer stopped by itself, or by another timer of the same batch, is stopped on the thread running the batch
+  mTimerDone.wait(lock, [&]() { return mRunningTimer != pTimer || mBatchThread == std::this_thread::get_id(); });
+}
+
+void TimerService::UpdateHeartbeat()
+{
+  uint32_t heartbeatMs = 0;
+
+  for (int i = 0; i < mTimers.GetSize(); i++)
+    heartbeatMs = std::gcd(heartbeatMs, mTimers.Get(i)->mIntervalMs);
+
+  if (heartbeatMs)
+    heartbeatMs = std::max(heartbeatMs, static_cast<uint32_t>(TIMER_MIN_HEARTBEAT_MS));
+
+  // The timers keep their next due times, so only the tick changes
+  if (heartbeatMs == mHeartbeatMs)
+    return;
+
+  mHeartbeatMs = heartbeatMs;
+  mStats.mHeartbeatMs = heartbeatMs;
+  ArmTimerFD();
+}
+
+void TimerService::ArmTimerFD()
+{
+  // Disarmed when there are no timers or no run loop to dispatch them, so that the service thread doesn't wake
+  const uint32_t periodMs = mRunLoopCount ? mHeartbeatMs.load() : 0;
+
+  itimerspec spec = {};
+  spec.it_interval.tv_sec = periodMs / 1000;
+  spec.it_interval.tv_nsec = static_cast<long>(periodMs % 1000) * 1000000;
+  spec.it_value = spec.it_interval;
+  timerfd_settime(mTimerFD, 0, &spec, nullptr);
+
+  mNextTickNs = NowNs() + static_cast<int64_t>(periodMs) * 1000000;
+}
+
+bool TimerService::CollectDue(int64_t nowNs)
+{
+  // A tick or poll that is early by less than half a heartbeat still counts, so that timers due around the same time run in one batch
+  const int64_t dueNs = nowNs + static_cast<int64_t>(mHeartbeatMs) * 500000;
+  int64_t earliestNs = INT64_MAX;
+  bool anyDue = false;
+
+  for (int i = 0; i < mTimers.GetSize(); i++)
+  {
+    Timer_impl* pTimer = mTimers.Get(i);
+
+    if (pTimer->mNextDueNs <= dueNs)
+    {
+      // A timer that missed some of its intervals is only due once, and stays in phase
+      const int64_t intervalNs = static_cast<int64_t>(pTimer->mIntervalMs) * 1000000;
+      pTimer->mNextDueNs += ((dueNs - pTimer->mNextDueNs) / intervalNs + 1) * intervalNs;
+      pTimer->mDue = true;
+      anyDue = true;
+    }
+
+    earliestNs = std::min(earliestNs, pTimer->mNextDueNs);
+  }
+
+  mEarliestDueNs = earliestNs;
+  return anyDue;
+}
+
+void TimerService::ThreadProc()
+{
+  epoll_event events[2];
+
+  while (!mQuit)
+  {
+    const int nEvents = epoll_wait(mEpollFD, events, 2, -1);
+
+    if (nEvents < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      break;
+    }
+
+    for (int i = 0; i < nEvents; i++)
+    {
+      if (events[i].data.fd == mTimerFD)
+      {
+        if (const uint64_t expirations = ReadCounter(mTimerFD))
+          OnTick(expirations);
+      }
+      else
+        ReadCounter(mWakeFD);
+    }
+  }
+}
+
+void TimerService::OnTick(uint64_t expirations)
+{
+  const int64_t now = NowNs();
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!mHeartbeatMs)
+      return;
+
+    // More than one expiration means that ticks were missed, the last one is the one that woke us
+    const int64_t periodNs = static_cast<int64_t>(mHeartbeatMs) * 1000000;
+    const int64_t expectedNs = mNextTickNs + static_cast<int64_t>(expirations - 1) * periodNs;
+    const double jitterMs = std::fabs(static_cast<double>(now - expectedNs)) / 1e6;
+    mNextTickNs = expectedNs + periodNs;
+
+    mStats.mTicks++;
+    mStats.mMissedTicks += expirations - 1;
+    mJitterSumMs += jitterMs;
+    mStats.mMeanJitterMs = mJitterSumMs / static_cast<double>(mStats.mTicks);
+    mStats.mMaxJitterMs = std::max(mStats.mMaxJitterMs, jitterMs);
+
+    // The timers only run on the run loop, a tick that comes after the last one detached leaves them alone
+    if (!mRunLoopCount || !CollectDue(now))
+      return;
+
+    // If the last batch is still waiting for the run loop, these timers join it
+    if (!mBatchPostedNs)
+    {
+      mBatchPostedNs = now;
+      Signal(mDispatchFD);
+    }
+  }
+}
+
+void TimerService::RunBatch()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  // One batch at a time, e.g. when a timer runs a nested run loop, or a host timer polls while a run loop dispatches.
+  // The timers that are due stay due, and run in the next batch
+  if (mBatchThread != std::thread::id())
+    return;
+
+  mBatch.Empty();
+
+  for (int i = 0; i < mTimers.GetSize(); i++)
+  {
+    Timer_impl* pTimer = mTimers.Get(i);
+
+    if (pTimer->mDue)
+    {
+      pTimer->mDue = false;
+      mBatch.Add(pTimer);
+    }
+  }
+
+  if (!mBatch.GetSize())
+    return;
+
+  mStats.mBatches++;
+  mBatchThread = std::this_thread::get_id();
+
+  for (int i = 0; i < mBatch.GetSize(); i++)
+  {
+    // nullptr if it was stopped since the batch started
+    Timer_impl* pTimer = mBatch.Get(i);
+
+    if (!pTimer)
+      continue;
+
+    mRunningTimer = pTimer;
+    lock.unlock();
+    pTimer->mTimerFunc(*pTimer);
+    lock.lock();
+    mRunningTimer = nullptr;
+    mTimerDone.notify_all();
+  }
+
+  mBatch.Empty();
+  mBatchThread = std::thread::id();
+}
+
+int TimerService::AttachToRunLoop()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mRunLoopCount++ == 0)
+  {
+    if (!mThread.joinable())
+      mThread = std::thread(&TimerService::ThreadProc, this);
+
+    ArmTimerFD();
+  }
+
+  return mDispatchFD;
+}
+
+void TimerService::DetachFromRunLoop()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mRunLoopCount == 0 || --mRunLoopCount > 0)
+    return;
+
+  // Timers that were due for the run loop stay due, and run when a run loop is attached again or the service is polled
+  ArmTimerFD();
+  mBatchPostedNs = 0;
+  ReadCounter(mDispatchFD);
+}
+
+void TimerService::Dispatch()
+{
+  ReadCounter(mDispatchFD);
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mBatchPostedNs)
+    {
+      const double latencyMs = static_cast<double>(NowNs() - mBatchPostedNs) / 1e6;
+      mLatencySumMs += latencyMs;
+      mLatencyCount++;
+      mStats.mMeanLatencyMs = mLatencySumMs / static_cast<double>(mLatencyCount);
+      mStats.mMaxLatencyMs = std::max(mStats.mMaxLatencyMs, latencyMs);
+      mBatchPostedNs = 0;
+    }
+  }
+
+  RunBatch();
+}
+
+void TimerService::Poll()
+{
+  const int64_t now = NowNs();
+
+  // Most polls are between the ticks, or after another instance ran the batch
+  if (now + static_cast<int64_t>(mHeartbeatMs) * 500000 < mEarliestDueNs)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!CollectDue(now))
+      return;
+  }
+
+  RunBatch();
+}
+
+uint32_t TimerService::GetHeartbeatMs() const
+{
+  return mHeartbeatMs;
+}
+
+TimerStats TimerService::GetStats() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  TimerStats stats = mStats;
+  stats.mNumTimers = mTimers.GetSize();
+  return stats;
+}
+
+void TimerService::ResetStats()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStats = TimerStats();
+  mStats.mHeartbeatMs = mHeartbeatMs;
+  mJitterSumMs = 0.;
+  mLatencySumMs = 0.;
+  mLatencyCount = 0;
+}
 #endif
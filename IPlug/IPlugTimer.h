@@ -26,11 +26,17 @@
 #include "mutex.h"
 
 #include "IPlugPlatform.h"
+#include "IPlugConstants.h"
 
 #if defined OS_MAC || defined OS_IOS
 #include <CoreFoundation/CoreFoundation.h>
 #elif defined OS_WEB
 #include <emscripten/html5.h>
+#elif defined OS_LINUX
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #endif
 
 BEGIN_IPLUG_NAMESPACE
@@ -95,6 +101,133 @@ private:
   long ID = 0;
   ITimerFunction mTimerFunc;
 };
+#elif defined OS_LINUX
+/** Timer jitter statistics, see TimerService::GetStats() */
+struct TimerStats
+{
+  uint32_t mHeartbeatMs = 0; // The period of the shared tick, 0 when no timers are running
+  int mNumTimers = 0;
+  uint64_t mTicks = 0; // Ticks since the statistics were reset
+  uint64_t mMissedTicks = 0; // Ticks that were a whole period or more late, and skipped
+  uint64_t mBatches = 0; // Batches of due timers that were dispatched
+  double mMeanJitterMs = 0.; // How late the ticks woke the service thread
+  double mMaxJitterMs = 0.;
+  double mMeanLatencyMs = 0.; // How long batches waited for the run loop to dispatch them, when attached to a run loop
+  double mMaxLatencyMs = 0.;
+};
+
+class Timer_impl;
+
+/** The shared Linux timer service. Rather than one OS timer per Timer, the timers share a heartbeat: the greatest common divisor of their intervals,
+ * and at least TIMER_MIN_HEARTBEAT_MS. Each timer keeps its own phase, and is due on the tick nearest to its next due time,
+ * so hundreds of plug-in instances wake the process once per tick, rather than once per timer.
+ *
+ * Timer functions such as IPlugAPIBase::OnTimer() expect to run on the main thread, so the timers only run on a main thread dispatcher,
+ * and not at all while there is none:
+ * - A run loop that can watch a file descriptor calls AttachToRunLoop() (e.g. with VST3's IRunLoop::registerEventHandler(), as the VST3 API does),
+ *   and calls Dispatch() when it is readable. While a run loop is attached, a service thread waits with epoll on a timerfd that ticks at the heartbeat,
+ *   and signals the run loop when timers are due. If the run loop is slow, due timers are merged into the next batch, rather than queued up.
+ * - A host that calls the plug-in back periodically on the main thread (e.g. CLAP's timer-support, as the CLAP API does) calls Poll() at the heartbeat,
+ *   which needs no thread.
+ *
+ * The timer functions are called without the service's lock held, so they can create and stop timers. Stopping a timer from another thread
+ * waits for its function to return if it is running, so a timer can be deleted once Stop() has returned. */
+class TimerService
+{
+public:
+  /** @return The service, which is created with its thread when it is first used */
+  static TimerService& Get();
+
+  TimerService(const TimerService&) = delete;
+  TimerService& operator=(const TimerService&) = delete;
+
+  /** Dispatch the timers on a run loop. Each call must be matched by a call to DetachFromRunLoop(),
+   * the timers are dispatched on the run loop(s) while any is attached
+   * @return A file descriptor that is readable when timers are due, after which the run loop should call Dispatch() */
+  int AttachToRunLoop();
+
+  /** Stop signalling the file descriptor, once every run loop that was attached has been detached. Timers that were due stay due */
+  void DetachFromRunLoop();
+
+  /** Run the timers that are due, on the calling thread. Called by the run loop, see AttachToRunLoop() */
+  void Dispatch();
+
+  /** Run the timers that are due by now, on the calling thread. Called periodically by a host's main thread timer, see GetHeartbeatMs().
+   * Returns straight away when no timer is due, so that every plug-in instance can poll */
+  void Poll();
+
+  /** @return The period of the shared tick, at which Poll() should be called, or 0 when there are no timers */
+  uint32_t GetHeartbeatMs() const;
+
+  /** @return The jitter statistics since the service started or ResetStats() was called */
+  TimerStats GetStats() const;
+
+  void ResetStats();
+
+private:
+  friend class Timer_impl;
+
+  TimerService();
+  ~TimerService();
+
+  void Add(Timer_impl* pTimer);
+  void Remove(Timer_impl* pTimer);
+
+  /** Set the heartbeat for the timers that are running, and re-arm the timerfd if it has changed. Called with mMutex locked */
+  void UpdateHeartbeat();
+
+  /** Arm the timerfd at the heartbeat while a run loop is attached, disarm it otherwise. Called with mMutex locked */
+  void ArmTimerFD();
+
+  /** Mark the timers whose next due time is within half a heartbeat of now as due, and move their next due times on by whole intervals.
+   * Called with mMutex locked
+   * @return \c true if any timer is due */
+  bool CollectDue(int64_t nowNs);
+
+  void ThreadProc();
+  void OnTick(uint64_t expirations);
+
+  /** Run the timers that are due, unless a batch is already running. Called with mMutex unlocked, which is only held between the calls to the timers */
+  void RunBatch();
+
+  mutable std::mutex mMutex;
+  std::condition_variable mTimerDone; // Notified when a timer function returns, for Remove() to wait on
+  WDL_PtrList<Timer_impl> mTimers;
+  WDL_PtrList<Timer_impl> mBatch; // Reused for each batch, entries are cleared when their timer is stopped while the batch runs
+  Timer_impl* mRunningTimer = nullptr; // The timer whose function is running
+  std::thread::id mBatchThread; // The thread running the batch, empty if none is
+  std::thread mThread;
+  std::atomic<bool> mQuit {false};
+  int mEpollFD = -1;
+  int mTimerFD = -1;
+  int mWakeFD = -1;
+  int mDispatchFD = -1;
+  int mRunLoopCount = 0; // Attached run loops
+  std::atomic<uint32_t> mHeartbeatMs {0}; // Read by Poll() without locking
+  std::atomic<int64_t> mEarliestDueNs {INT64_MAX}; // The earliest next due time of the timers, for Poll() to return early without locking
+  int64_t mNextTickNs = 0; // When the next tick is due
+  int64_t mBatchPostedNs = 0; // When a batch was posted to the run loop, 0 if there is none waiting
+  TimerStats mStats;
+  double mJitterSumMs = 0.;
+  double mLatencySumMs = 0.;
+  uint64_t mLatencyCount = 0;
+};
+
+class Timer_impl : public Timer
+{
+public:
+  Timer_impl(ITimerFunction func, uint32_t intervalMs);
+  ~Timer_impl();
+  void Stop() override;
+
+private:
+  friend class TimerService;
+  ITimerFunction mTimerFunc;
+  uint32_t mIntervalMs;
+  int64_t mNextDueNs = 0; // Kept when the heartbeat changes, so that the timer keeps its phase
+  bool mRunning = false;
+  bool mDue = false;
+};
 #else
   #error NOT IMPLEMENTED
 #endif
@@ -24,6 +24,19 @@
 #include <cstdlib>
 #include <cstring>
 #include <cctype>
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define IPLUG_CONVERT_SSE2 1
+  #if defined(__AVX__)
+    #include <immintrin.h>
+    #define IPLUG_CONVERT_AVX 1
+  #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define IPLUG_CONVERT_NEON 1
+#endif
 
 #include "heapbuf.h"
 #include "wdlstring.h"
@@ -154,6 +167,232 @@ void CastCopy(DEST* pDest, SRC* pSrc, int n)
   }
 }
 
+/** Converts a buffer of single precision samples to double precision, with SSE2/AVX or NEON.
+ * Denormal inputs are flushed to zero (as with DAZ), whatever the floating point mode of the calling thread.
+ * NaNs are also flushed to zero
+ * @param pDest Ptr to the destination buffer
+ * @param pSrc Ptr to the source buffer, which may have any alignment
+ * @param n The number of samples */
+static inline void ConvertSamples(double* pDest, const float* pSrc, int n)
+{
+  int i = 0;
+#if defined IPLUG_CONVERT_SSE2
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  const __m128 minNormal = _mm_set1_ps(FLT_MIN);
+
+#if defined IPLUG_CONVERT_AVX
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128 v0 = _mm_loadu_ps(pSrc + i);
+    __m128 v1 = _mm_loadu_ps(pSrc + i + 4);
+    v0 = _mm_and_ps(v0, _mm_cmpge_ps(_mm_and_ps(v0, absMask), minNormal));
+    v1 = _mm_and_ps(v1, _mm_cmpge_ps(_mm_and_ps(v1, absMask), minNormal));
+    _mm256_storeu_pd(pDest + i, _mm256_cvtps_pd(v0));
+    _mm256_storeu_pd(pDest + i + 4, _mm256_cvtps_pd(v1));
+  }
+#endif
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128 v0 = _mm_loadu_ps(pSrc + i);
+    __m128 v1 = _mm_loadu_ps(pSrc + i + 4);
+    v0 = _mm_and_ps(v0, _mm_cmpge_ps(_mm_and_ps(v0, absMask), minNormal));
+    v1 = _mm_and_ps(v1, _mm_cmpge_ps(_mm_and_ps(v1, absMask), minNormal));
+    _mm_storeu_pd(pDest + i, _mm_cvtps_pd(v0));
+    _mm_storeu_pd(pDest + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v0, v0)));
+    _mm_storeu_pd(pDest + i + 4, _mm_cvtps_pd(v1));
+    _mm_storeu_pd(pDest + i + 6, _mm_cvtps_pd(_mm_movehl_ps(v1, v1)));
+  }
+#elif defined IPLUG_CONVERT_NEON
+  const float32x4_t minNormal = vdupq_n_f32(FLT_MIN);
+
+  for (; i + 4 <= n; i += 4)
+  {
+    float32x4_t v = vld1q_f32(pSrc + i);
+    v = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), vcgeq_f32(vabsq_f32(v), minNormal)));
+    vst1q_f64(pDest + i, vcvt_f64_f32(vget_low_f32(v)));
+    vst1q_f64(pDest + i + 2, vcvt_high_f64_f32(v));
+  }
+#endif
+  for (; i < n; ++i)
+    pDest[i] = std::fabs(pSrc[i]) >= FLT_MIN ? (double) pSrc[i] : 0.;
+}
+
+/** Converts a buffer of double precision samples to single precision, with SSE2/AVX or NEON.
+ * Results that would be denormal in single precision are flushed to zero (as with FTZ), whatever the floating point mode of the calling thread.
+ * NaNs are also flushed to zero
+ * @param pDest Ptr to the destination buffer
+ * @param pSrc Ptr to the source buffer, which may have any alignment
+ * @param n The number of samples */
+static inline void ConvertSamples(float* pDest, const double* pSrc, int n)
+{
+  int i = 0;
+#if defined IPLUG_CONVERT_SSE2
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  const __m128 minNormal = _mm_set1_ps(FLT_MIN);
+
+#if defined IPLUG_CONVERT_AVX
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 v = _mm256_cvtpd_ps(_mm256_loadu_pd(pSrc + i));
+    v = _mm_and_ps(v, _mm_cmpge_ps(_mm_and_ps(v, absMask), minNormal));
+    _mm_storeu_ps(pDest + i, v);
+  }
+#endif
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 v = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(pSrc + i)), _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i + 2)));
+    v = _mm_and_ps(v, _mm_cmpge_ps(_mm_and_ps(v, absMask), minNormal));
+    _mm_storeu_ps(pDest + i, v);
+  }
+#elif defined IPLUG_CONVERT_NEON
+  const float32x4_t minNormal = vdupq_n_f32(FLT_MIN);
+
+  for (; i + 4 <= n; i += 4)
+  {
+    float32x4_t v = vcvt_high_f32_f64(vcvt_f32_f64(vld1q_f64(pSrc + i)), vld1q_f64(pSrc + i + 2));
+    v = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), vcgeq_f32(vabsq_f32(v), minNormal)));
+    vst1q_f32(pDest + i, v);
+  }
+#endif
+  for (; i < n; ++i)
+  {
+    const float v = (float) pSrc[i];
+    pDest[i] = std::fabs(v) >= FLT_MIN ? v : 0.f;
+  }
+}
+
+/** Checks whether a buffer of single precision samples is silent, with SSE2 or NEON.
+ * Positive and negative zero are silent, denormals and NaNs are not. The scan stops at the first chunk of 16 samples that isn't silent,
+ * so a buffer of audio is usually rejected after the first few samples
+ * @param pData Ptr to the buffer, which may have any alignment
+ * @param n The number of samples
+ * @return \c true if all the samples are zero */
+static inline bool IsSilent(const float* pData, int n)
+{
+  int i = 0;
+#if defined IPLUG_CONVERT_SSE2
+  const __m128i absMask = _mm_set1_epi32(0x7FFFFFFF);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i* p = reinterpret_cast<const __m128i*>(pData + i);
+    const __m128i v = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)), _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, absMask), zero)) != 0xFFFF)
+      return false;
+  }
+#elif defined IPLUG_CONVERT_NEON
+  const uint32x4_t absMask = vdupq_n_u32(0x7FFFFFFF);
+
+  for (; i + 16 <= n; i += 16)
+  {
+    const uint32_t* p = reinterpret_cast<const uint32_t*>(pData + i);
+    const uint32x4_t v = vorrq_u32(vorrq_u32(vld1q_u32(p), vld1q_u32(p + 4)), vorrq_u32(vld1q_u32(p + 8), vld1q_u32(p + 12)));
+
+    if (vmaxvq_u32(vandq_u32(v, absMask)))
+      return false;
+  }
+#endif
+  for (; i < n; ++i)
+  {
+    if (pData[i] != 0.f)
+      return false;
+  }
+
+  return true;
+}
+
+/** Checks whether a buffer of double precision samples is silent, with SSE2 or NEON.
+ * Positive and negative zero are silent, denormals and NaNs are not. The scan stops at the first chunk of 8 samples that isn't silent
+ * @param pData Ptr to the buffer, which may have any alignment
+ * @param n The number of samples
+ * @return \c true if all the samples are zero */
+static inline bool IsSilent(const double* pData, int n)
+{
+  int i = 0;
+#if defined IPLUG_CONVERT_SSE2
+  const __m128i absMask = _mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m128i* p = reinterpret_cast<const __m128i*>(pData + i);
+    const __m128i v = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)), _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, absMask), zero)) != 0xFFFF)
+      return false;
+  }
+#elif defined IPLUG_CONVERT_NEON
+  const uint64x2_t absMask = vdupq_n_u64(0x7FFFFFFFFFFFFFFFULL);
+
+  for (; i + 8 <= n; i += 8)
+  {
+    const uint64_t* p = reinterpret_cast<const uint64_t*>(pData + i);
+    const uint64x2_t v = vorrq_u64(vorrq_u64(vld1q_u64(p), vld1q_u64(p + 2)), vorrq_u64(vld1q_u64(p + 4), vld1q_u64(p + 6)));
+
+    if (vmaxvq_u32(vreinterpretq_u32_u64(vandq_u64(v, absMask))))
+      return false;
+  }
+#endif
+  for (; i < n; ++i)
+  {
+    if (pData[i] != 0.)
+      return false;
+  }
+
+  return true;
+}
+
+/** Fills a buffer with a linear ramp, with SSE2/AVX or NEON. Each value is computed from its index rather than accumulated, so the ramp doesn't drift
+ * @param pDest Ptr to the destination buffer, which may have any alignment
+ * @param start The first value
+ * @param inc The difference between consecutive values
+ * @param n The number of values */
+static inline void FillRamp(double* pDest, double start, double inc, int n)
+{
+  int i = 0;
+#if defined IPLUG_CONVERT_AVX
+  const __m256d vStart = _mm256_set1_pd(start);
+  const __m256d vInc = _mm256_set1_pd(inc);
+  const __m256d vFour = _mm256_set1_pd(4.);
+  __m256d vIdx = _mm256_set_pd(3., 2., 1., 0.);
+
+  for (; i + 4 <= n; i += 4)
+  {
+    _mm256_storeu_pd(pDest + i, _mm256_add_pd(vStart, _mm256_mul_pd(vIdx, vInc)));
+    vIdx = _mm256_add_pd(vIdx, vFour);
+  }
+#elif defined IPLUG_CONVERT_SSE2
+  const __m128d vStart = _mm_set1_pd(start);
+  const __m128d vInc = _mm_set1_pd(inc);
+  const __m128d vFour = _mm_set1_pd(4.);
+  __m128d vIdx0 = _mm_set_pd(1., 0.);
+  __m128d vIdx1 = _mm_set_pd(3., 2.);
+
+  for (; i + 4 <= n; i += 4)
+  {
+    _mm_storeu_pd(pDest + i, _mm_add_pd(vStart, _mm_mul_pd(vIdx0, vInc)));
+    _mm_storeu_pd(pDest + i + 2, _mm_add_pd(vStart, _mm_mul_pd(vIdx1, vInc)));
+    vIdx0 = _mm_add_pd(vIdx0, vFour);
+    vIdx1 = _mm_add_pd(vIdx1, vFour);
+  }
+#elif defined IPLUG_CONVERT_NEON
+  const float64x2_t vStart = vdupq_n_f64(start);
+  const float64x2_t vTwo = vdupq_n_f64(2.);
+  const double idx[2] = { 0., 1. };
+  float64x2_t vIdx = vld1q_f64(idx);
+
+  for (; i + 2 <= n; i += 2)
+  {
+    vst1q_f64(pDest + i, vfmaq_n_f64(vStart, vIdx, inc));
+    vIdx = vaddq_f64(vIdx, vTwo);
+  }
+#endif
+  for (; i < n; ++i)
+    pDest[i] = start + inc * i;
+}
+
 /** \todo  
  * @param cDest \todo
  * @param cSrc \todo */
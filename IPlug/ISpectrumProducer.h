@@ -0,0 +1,543 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc ISpectrumProducer
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fft.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugConstants.h"
+#include "IPlugUtilities.h"
+#include "IPlugEditorDelegate.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** The start of a message sent by ISpectrumProducer. It is followed by nChans * nBands floats, one row of nBands values per channel.
+ * Bands are log-spaced between freqLo and freqHi, values are smoothed levels in dB mapped from [dBLo, dBHi] to [0, 1] */
+struct ISpectrumFrameHeader
+{
+  int nChans = 0;
+  int nBands = 0;
+  float freqLo = 20.f;
+  float freqHi = 20000.f;
+  float dBLo = -90.f;
+  float dBHi = 0.f;
+  uint32_t frameIdx = 0;
+};
+
+/** ISpectrumProducer analyses audio for spectrum displays away from the audio thread.
+ * ProcessBlock() copies samples into a lock-free ring buffer and does nothing else. At a fixed frame rate, the analysis takes the latest
+ * FFT-size window from the ring, applies the window function, runs WDL_real_fft(), reduces the bins to log-spaced bands
+ * (the loudest bin in a band, or an interpolated value where bands are narrower than bins) and applies attack/release smoothing.
+ * Finished frames are published through a triple buffer, and TransmitData() sends the latest one to every subscribed control, so that several displays share one analysis.
+ *
+ * The analysis runs on a worker thread between Start() and Stop(). Otherwise TransmitData() runs it on the calling thread when a frame is due,
+ * which suits hosts where an extra thread is not wanted. Only the ring buffer is touched by the audio thread in either case.
+ * @tparam MAXNC The maximum number of channels
+ * @tparam MAX_FFT_SIZE The maximum FFT size, a power of two
+ * @tparam MAX_BANDS The maximum number of bands per channel */
+template <int MAXNC = 2, int MAX_FFT_SIZE = 4096, int MAX_BANDS = 512>
+class ISpectrumProducer
+{
+public:
+  static_assert((MAX_FFT_SIZE & (MAX_FFT_SIZE - 1)) == 0, "MAX_FFT_SIZE must be a power of two");
+
+  /** The msgTag of the messages sent to subscribed controls, see IControl::OnMsgFromDelegate() */
+  static constexpr int kFrameMessage = 16;
+
+  enum class EWindowType {
+    Hann = 0,
+    BlackmanHarris,
+    Hamming,
+    Flattop,
+    Rectangular
+  };
+
+  /** @param fftSize The FFT size, a power of two up to MAX_FFT_SIZE
+   * @param nBands The number of log-spaced bands per channel, up to MAX_BANDS
+   * @param frameRateHz The number of frames analysed per second */
+  ISpectrumProducer(int fftSize = 2048, int nBands = 256, double frameRateHz = 60.)
+  : mRing(kRingSize * MAXNC, 0.f)
+  {
+    WDL_fft_init();
+    mSettings.fftSize = fftSize;
+    mSettings.nBands = nBands;
+    mSettings.frameRate = frameRateHz;
+    ValidateSettings(mSettings);
+    mFrameRate.store(mSettings.frameRate);
+  }
+
+  ~ISpectrumProducer()
+  {
+    Stop();
+  }
+
+  ISpectrumProducer(const ISpectrumProducer&) = delete;
+  ISpectrumProducer& operator=(const ISpectrumProducer&) = delete;
+
+#pragma mark - Settings, from any thread except the audio thread
+
+  void SetSampleRate(double sampleRate) { ChangeSettings([&](Settings& s) { s.sampleRate = sampleRate; }); }
+
+  void SetFFTSize(int fftSize) { ChangeSettings([&](Settings& s) { s.fftSize = fftSize; }); }
+
+  void SetWindowType(EWindowType windowType) { ChangeSettings([&](Settings& s) { s.windowType = windowType; }); }
+
+  /** @param nBands The number of bands per channel, up to MAX_BANDS
+   * @param freqLo The lower edge of the first band in Hz
+   * @param freqHi The upper edge of the last band in Hz, limited to the Nyquist frequency */
+  void SetBands(int nBands, float freqLo = 20.f, float freqHi = 20000.f)
+  {
+    ChangeSettings([&](Settings& s) { s.nBands = nBands; s.freqLo = freqLo; s.freqHi = freqHi; });
+  }
+
+  /** @param dBLo The level that is mapped to 0
+   * @param dBHi The level that is mapped to 1 */
+  void SetLevelRange(float dBLo, float dBHi) { ChangeSettings([&](Settings& s) { s.dBLo = dBLo; s.dBHi = dBHi; }); }
+
+  /** @param attackTimeMs Smoothing time of rising levels in milliseconds
+   * @param releaseTimeMs Smoothing time of falling levels in milliseconds */
+  void SetSmoothing(float attackTimeMs, float releaseTimeMs)
+  {
+    ChangeSettings([&](Settings& s) { s.attackTimeMs = attackTimeMs; s.releaseTimeMs = releaseTimeMs; });
+  }
+
+  /** Tilt the spectrum around 500Hz, e.g. 4.5dB per octave makes pink noise look flat */
+  void SetTilt(float dBPerOctave) { ChangeSettings([&](Settings& s) { s.tiltDBPerOctave = dBPerOctave; }); }
+
+  void SetFrameRate(double frameRateHz) { ChangeSettings([&](Settings& s) { s.frameRate = frameRateHz; }); }
+
+  int GetFFTSize() const
+  {
+    std::lock_guard<std::mutex> lock(mSettingsMutex);
+    return mSettings.fftSize;
+  }
+
+#pragma mark - Subscribers and delivery, on the main thread
+
+  /** Send frames to a control. Any number of controls can subscribe to the same producer */
+  void Subscribe(int ctrlTag)
+  {
+    if (std::find(mSubscribers.begin(), mSubscribers.end(), ctrlTag) == mSubscribers.end())
+      mSubscribers.push_back(ctrlTag);
+  }
+
+  void Unsubscribe(int ctrlTag)
+  {
+    mSubscribers.erase(std::remove(mSubscribers.begin(), mSubscribers.end(), ctrlTag), mSubscribers.end());
+  }
+
+  /** Sends the latest frame to the subscribed controls, if a new one is ready. Without a worker thread, this also runs the analysis when a frame is due.
+   *  This must be called on the main thread - typically in MyPlugin::OnIdle()
+   * @return \c true if a frame was sent */
+  bool TransmitData(IEditorDelegate& dlg)
+  {
+    if (!IsRunning())
+    {
+      const auto now = std::chrono::steady_clock::now();
+
+      if (now >= mNextInlineFrame)
+      {
+        Analyse();
+        mNextInlineFrame = now + FramePeriod();
+      }
+    }
+
+    if (!(mPublished.load(std::memory_order_acquire) & kNewFrame))
+      return false;
+
+    mFront = mPublished.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+
+    const Frame& frame = mFrames[mFront];
+    const int dataSize = static_cast<int>(sizeof(ISpectrumFrameHeader) + frame.header.nChans * frame.header.nBands * sizeof(float));
+
+    for (auto tag : mSubscribers)
+      dlg.SendControlMsgFromDelegate(tag, kFrameMessage, dataSize, &frame);
+
+    return true;
+  }
+
+#pragma mark - Worker thread
+
+  /** Start analysing on a worker thread */
+  void Start()
+  {
+    if (mRunning.exchange(true))
+      return;
+
+    mThread = std::thread([this]() { ThreadFunc(); });
+  }
+
+  /** Stop the worker thread, after which TransmitData() analyses on the main thread again */
+  void Stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+
+      if (!mRunning.exchange(false))
+        return;
+    }
+
+    mWakeCV.notify_one();
+
+    if (mThread.joinable())
+      mThread.join();
+  }
+
+  bool IsRunning() const { return mRunning.load(); }
+
+#pragma mark - Audio thread
+
+  /** Copy sample buffers into the ring buffer. This can be called on the realtime audio thread, it doesn't lock or allocate
+   @param inputs the sample buffers
+   @param nFrames the number of sample frames in the input buffers
+   @param nChans the number of channels to analyse, up to MAXNC
+   @param chanOffset the first channel in inputs */
+  void ProcessBlock(sample** inputs, int nFrames, int nChans = MAXNC, int chanOffset = 0)
+  {
+    nChans = std::min(nChans, MAXNC);
+    const int skip = std::max(0, nFrames - kRingSize); // only the last kRingSize frames can be kept
+    const uint32_t writePos = mWritePos.load(std::memory_order_relaxed);
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      const sample* pIn = inputs[chanOffset + c] + skip;
+      float* pRing = mRing.data() + c * kRingSize;
+      uint32_t pos = writePos;
+
+      for (auto s = skip; s < nFrames; s++, pos++)
+        pRing[pos & kRingMask] = static_cast<float>(*pIn++);
+    }
+
+    mNumChans.store(nChans, std::memory_order_relaxed);
+    mWritePos.store(writePos + static_cast<uint32_t>(nFrames - skip), std::memory_order_release);
+  }
+
+private:
+  static constexpr int kRingSize = 4 * MAX_FFT_SIZE;
+  static constexpr uint32_t kRingMask = kRingSize - 1;
+  static constexpr int kNewFrame = 4;
+  static constexpr int kIndexMask = 3;
+
+  struct Settings
+  {
+    double sampleRate = 44100.;
+    double frameRate = 60.;
+    int fftSize = 2048;
+    int nBands = 256;
+    float freqLo = 20.f;
+    float freqHi = 20000.f;
+    float dBLo = -90.f;
+    float dBHi = 0.f;
+    float attackTimeMs = 3.f;
+    float releaseTimeMs = 150.f;
+    float tiltDBPerOctave = 0.f;
+    EWindowType windowType = EWindowType::Hann;
+  };
+
+  /** A band covers the bins [binLo, binHi], or interpolates between binLo and binLo + 1 if it is narrower than a bin (binHi < binLo) */
+  struct Band
+  {
+    int binLo = 0;
+    int binHi = 0;
+    float frac = 0.f;
+    float tiltDB = 0.f;
+  };
+
+  struct Frame
+  {
+    ISpectrumFrameHeader header;
+    std::array<float, MAXNC * MAX_BANDS> values;
+  };
+
+  static_assert(offsetof(Frame, values) == sizeof(ISpectrumFrameHeader), "The values must directly follow the header");
+
+  template <typename F>
+  void ChangeSettings(F&& func)
+  {
+    std::lock_guard<std::mutex> lock(mSettingsMutex);
+    func(mSettings);
+    ValidateSettings(mSettings);
+    mFrameRate.store(mSettings.frameRate);
+    mSettingsVersion.fetch_add(1, std::memory_order_release);
+  }
+
+  static void ValidateSettings(Settings& s)
+  {
+    int fftSize = 16;
+    while (fftSize < s.fftSize && fftSize < MAX_FFT_SIZE)
+      fftSize *= 2;
+
+    s.fftSize = fftSize;
+    s.nBands = Clip(s.nBands, 1, MAX_BANDS);
+    s.sampleRate = std::max(s.sampleRate, 1000.);
+    s.frameRate = Clip(s.frameRate, 1., 1000.);
+    s.freqHi = Clip(s.freqHi, 1.f, static_cast<float>(s.sampleRate * 0.5));
+    s.freqLo = Clip(s.freqLo, 0.001f, s.freqHi * 0.999f);
+
+    if (s.dBHi <= s.dBLo)
+      s.dBHi = s.dBLo + 1.f;
+  }
+
+  std::chrono::steady_clock::duration FramePeriod() const
+  {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1. / mFrameRate.load()));
+  }
+
+  void ThreadFunc()
+  {
+    auto next = std::chrono::steady_clock::now();
+
+    while (mRunning.load())
+    {
+      Analyse();
+
+      const auto now = std::chrono::steady_clock::now();
+      next += FramePeriod();
+
+      if (next < now) // don't try to catch up after a stall
+        next = now;
+
+      std::unique_lock<std::mutex> lock(mWakeMutex);
+      mWakeCV.wait_until(lock, next, [this]() { return !mRunning.load(); });
+    }
+  }
+
+  /** Called on the analysis thread when the settings have changed. Rebuilds the tables in place, without allocating */
+  void ApplySettings()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mSettingsMutex);
+      mApplied = mSettings;
+    }
+
+    const int n = mApplied.fftSize;
+    const float M = static_cast<float>(n - 1);
+    float windowSum = 0.f;
+
+    for (auto i = 0; i < n; i++)
+    {
+      float w = 1.f;
+
+      switch (mApplied.windowType)
+      {
+        case EWindowType::Hann:
+          w = 0.5f * (1.f - std::cos(2.f * PI * i / M));
+          break;
+        case EWindowType::BlackmanHarris:
+          w = 0.35875f - 0.48829f * std::cos(2.f * PI * i / M) + 0.14128f * std::cos(4.f * PI * i / M) - 0.01168f * std::cos(6.f * PI * i / M);
+          break;
+        case EWindowType::Hamming:
+          w = 0.54f - 0.46f * std::cos(2.f * PI * i / M);
+          break;
+        case EWindowType::Flattop:
+          w = 0.21557895f - 0.41663158f * std::cos(2.f * PI * i / M) + 0.277263158f * std::cos(4.f * PI * i / M)
+            - 0.083578947f * std::cos(6.f * PI * i / M) + 0.006947368f * std::cos(8.f * PI * i / M);
+          break;
+        case EWindowType::Rectangular:
+        default:
+          break;
+      }
+
+      mWindow[i] = w;
+      windowSum += w;
+    }
+
+    // A sinusoid of amplitude A peaks at |X| = A * windowSum / 2, and WDL_real_fft() returns twice the DFT
+    mPowerScale = 1.f / (windowSum * windowSum);
+
+    const int nBins = n / 2;
+    const double binHz = mApplied.sampleRate / n;
+    const double ratio = static_cast<double>(mApplied.freqHi) / mApplied.freqLo;
+
+    for (auto b = 0; b < mApplied.nBands; b++)
+    {
+      const double edgeLo = mApplied.freqLo * std::pow(ratio, static_cast<double>(b) / mApplied.nBands);
+      const double edgeHi = mApplied.freqLo * std::pow(ratio, static_cast<double>(b + 1) / mApplied.nBands);
+      const double centre = std::sqrt(edgeLo * edgeHi);
+      Band& band = mBands[b];
+
+      band.binLo = static_cast<int>(std::ceil(edgeLo / binHz));
+      band.binHi = std::min(static_cast<int>(std::ceil(edgeHi / binHz)) - 1, nBins);
+      band.tiltDB = mApplied.tiltDBPerOctave * static_cast<float>(std::log2(centre / 500.));
+
+      if (band.binHi < band.binLo)
+      {
+        const double bin = std::min(centre / binHz, nBins - 1.);
+        band.binLo = static_cast<int>(bin);
+        band.binHi = band.binLo - 1;
+        band.frac = static_cast<float>(bin - band.binLo);
+      }
+    }
+
+    const double period = 1. / mApplied.frameRate;
+    mAttackCoeff = mApplied.attackTimeMs > 0.f ? static_cast<float>(std::exp(-period / (mApplied.attackTimeMs * 0.001))) : 0.f;
+    mReleaseCoeff = mApplied.releaseTimeMs > 0.f ? static_cast<float>(std::exp(-period / (mApplied.releaseTimeMs * 0.001))) : 0.f;
+
+    for (auto& env : mEnvelopes)
+      env.fill(0.f);
+  }
+
+  /** Analyse the latest window and publish a frame
+   * @return \c true if a frame was published, \c false if there were no new samples since the last frame */
+  bool Analyse()
+  {
+    const uint32_t version = mSettingsVersion.load(std::memory_order_acquire);
+    const bool settingsChanged = version != mAppliedVersion;
+
+    if (settingsChanged)
+    {
+      mAppliedVersion = version;
+      ApplySettings();
+    }
+
+    const uint32_t writePos = mWritePos.load(std::memory_order_acquire);
+
+    if (writePos == mLastWritePos && !settingsChanged)
+      return false;
+
+    const int n = mApplied.fftSize;
+    const int nBins = n / 2;
+    const int nBands = mApplied.nBands;
+    const int nChans = mNumChans.load(std::memory_order_relaxed);
+    const uint32_t readPos = writePos - static_cast<uint32_t>(n);
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      const float* pRing = mRing.data() + c * kRingSize;
+      float* pBuf = mFFTBuffers[c].data();
+
+      for (auto i = 0; i < n; i++)
+        pBuf[i] = pRing[(readPos + i) & kRingMask] * mWindow[i];
+    }
+
+    // The audio thread is allowed to lap the analysis, in which case the copy is torn and this frame is skipped
+    if (mWritePos.load(std::memory_order_acquire) - readPos > static_cast<uint32_t>(kRingSize))
+      return false;
+
+    mLastWritePos = writePos;
+
+    Frame& frame = mFrames[mBack];
+    const float dBLo = mApplied.dBLo;
+    const float dBRange = mApplied.dBHi - mApplied.dBLo;
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      float* pBuf = mFFTBuffers[c].data();
+      WDL_real_fft(pBuf, n, false);
+
+      // Unpack the permuted output, bin nBins (Nyquist) is stored in the imaginary part of bin 0
+      const WDL_FFT_COMPLEX* pBins = reinterpret_cast<const WDL_FFT_COMPLEX*>(pBuf);
+      const int* pPermute = WDL_fft_permute_tab(nBins);
+      mPower[0] = pBins[0].re * pBins[0].re * mPowerScale * 0.25f;
+      mPower[nBins] = pBins[0].im * pBins[0].im * mPowerScale * 0.25f;
+
+      for (auto k = 1; k < nBins; k++)
+      {
+        const WDL_FFT_COMPLEX& bin = pBins[pPermute[k]];
+        mPower[k] = (bin.re * bin.re + bin.im * bin.im) * mPowerScale;
+      }
+
+      float* pEnv = mEnvelopes[c].data();
+      float* pOut = frame.values.data() + c * nBands;
+
+      for (auto b = 0; b < nBands; b++)
+      {
+        const Band& band = mBands[b];
+        float power;
+
+        if (band.binHi >= band.binLo)
+        {
+          power = mPower[band.binLo];
+          for (auto k = band.binLo + 1; k <= band.binHi; k++)
+            power = std::max(power, mPower[k]);
+        }
+        else
+          power = mPower[band.binLo] + band.frac * (mPower[band.binLo + 1] - mPower[band.binLo]);
+
+        const float dB = 10.f * std::log10(power + 1e-30f) + band.tiltDB;
+        const float level = Clip((dB - dBLo) / dBRange, 0.f, 1.f);
+        const float coeff = level > pEnv[b] ? mAttackCoeff : mReleaseCoeff;
+        pEnv[b] = level + coeff * (pEnv[b] - level);
+        pOut[b] = pEnv[b];
+      }
+    }
+
+    frame.header.nChans = nChans;
+    frame.header.nBands = nBands;
+    frame.header.freqLo = mApplied.freqLo;
+    frame.header.freqHi = mApplied.freqHi;
+    frame.header.dBLo = mApplied.dBLo;
+    frame.header.dBHi = mApplied.dBHi;
+    frame.header.frameIdx = mFrameIdx++;
+
+    mBack = mPublished.exchange(mBack | kNewFrame, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  // Audio thread
+  std::vector<float> mRing;
+  std::atomic<uint32_t> mWritePos {0};
+  std::atomic<int> mNumChans {0};
+
+  // Settings, written by any non-audio thread
+  mutable std::mutex mSettingsMutex;
+  Settings mSettings;
+  std::atomic<uint32_t> mSettingsVersion {1};
+  std::atomic<double> mFrameRate {60.};
+
+  // Analysis, owned by the worker thread while it is running, otherwise by the caller of TransmitData()
+  Settings mApplied;
+  uint32_t mAppliedVersion = 0;
+  uint32_t mLastWritePos = 0;
+  uint32_t mFrameIdx = 0;
+  float mPowerScale = 1.f;
+  float mAttackCoeff = 0.f;
+  float mReleaseCoeff = 0.f;
+  std::array<float, MAX_FFT_SIZE> mWindow {};
+  std::array<float, MAX_FFT_SIZE / 2 + 1> mPower {};
+  std::array<std::array<WDL_FFT_REAL, MAX_FFT_SIZE>, MAXNC> mFFTBuffers {};
+  std::array<std::array<float, MAX_BANDS>, MAXNC> mEnvelopes {};
+  std::array<Band, MAX_BANDS> mBands {};
+  int mBack = 0;
+
+  // Triple buffer, the analysis writes mFrames[mBack], the main thread reads mFrames[mFront]
+  std::array<Frame, 3> mFrames {};
+  std::atomic<int> mPublished {1};
+  int mFront = 2;
+
+  // Main thread
+  std::vector<int> mSubscribers;
+  std::chrono::steady_clock::time_point mNextInlineFrame;
+
+  std::thread mThread;
+  std::atomic<bool> mRunning {false};
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCV;
+};
+
+END_IPLUG_NAMESPACE
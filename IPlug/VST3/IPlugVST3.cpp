@@ -54,6 +54,9 @@ tresult PLUGIN_API IPlugVST3::initialize(FUnknown* context)
     IPlugVST3ControllerBase::Initialize(this, IsInstrument(), DoesMIDIIn());
 
     IPlugVST3GetHost(this, context);
+#if defined OS_LINUX
+    mRunLoop.Attach(context);
+#endif
     OnHostIdentified();
     OnParamReset(kReset);
     
@@ -67,6 +70,10 @@ tresult PLUGIN_API IPlugVST3::terminate()
 {
   TRACE
 
+#if defined OS_LINUX
+  mRunLoop.Detach();
+#endif
+
   return SingleComponentEffect::terminate();
 }
 
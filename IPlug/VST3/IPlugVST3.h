@@ -168,6 +168,9 @@ public:
 
 private:
   ViewType* mView;
+#if defined OS_LINUX
+  IPlugVST3RunLoop mRunLoop;
+#endif
 };
 
 IPlugVST3* MakePlug(const InstanceInfo& info);
@@ -11,6 +11,10 @@
 #pragma once
 
 #include "pluginterfaces/base/ibstream.h"
+#if defined OS_LINUX
+#include "pluginterfaces/gui/iplugview.h"
+#include "base/source/fobject.h"
+#endif
 #
 #include "IPlugAPIBase.h"
 #include "IPlugVST3_Parameter.h"
@@ -101,4 +105,75 @@ static void IPlugVST3GetHost(IPlugAPIBase* pPlug, Steinberg::FUnknown* context)
   }
 }
 
+#if defined OS_LINUX
+/** Dispatches the shared TimerService on the host's run loop on Linux, so that timers such as the one calling IPlugAPIBase::OnTimer() run on the main thread.
+ * The run loop is queried from the view's IPlugFrame, or from the host context in hosts that provide it there.
+ * While no run loop is attached, the timers don't run */
+class IPlugVST3RunLoop
+{
+public:
+  IPlugVST3RunLoop() = default;
+  IPlugVST3RunLoop(const IPlugVST3RunLoop&) = delete;
+  IPlugVST3RunLoop& operator=(const IPlugVST3RunLoop&) = delete;
+
+  ~IPlugVST3RunLoop()
+  {
+    Detach();
+  }
+
+  /** Register the timer service's file descriptor with the run loop of the context, if it has one
+   * @param pContext The host context passed to initialize(), or an IPlugFrame */
+  void Attach(Steinberg::FUnknown* pContext)
+  {
+    Steinberg::FUnknownPtr<Steinberg::Linux::IRunLoop> pRunLoop(pContext);
+
+    if (!pRunLoop || pRunLoop == mRunLoop)
+      return;
+
+    Detach();
+
+    Steinberg::IPtr<EventHandler> pHandler = Steinberg::owned(new EventHandler());
+    const int fd = TimerService::Get().AttachToRunLoop();
+
+    if (fd >= 0 && pRunLoop->registerEventHandler(pHandler, fd) == Steinberg::kResultTrue)
+    {
+      mRunLoop = pRunLoop;
+      mHandler = pHandler;
+    }
+    else
+      TimerService::Get().DetachFromRunLoop();
+  }
+
+  void Detach()
+  {
+    if (!mRunLoop)
+      return;
+
+    mRunLoop->unregisterEventHandler(mHandler);
+    TimerService::Get().DetachFromRunLoop();
+    mRunLoop = nullptr;
+    mHandler = nullptr;
+  }
+
+private:
+  class EventHandler : public Steinberg::Linux::IEventHandler
+                     , public Steinberg::FObject
+  {
+  public:
+    void PLUGIN_API onFDIsSet(Steinberg::Linux::FileDescriptor /*fd*/) override
+    {
+      TimerService::Get().Dispatch();
+    }
+
+    DELEGATE_REFCOUNT(Steinberg::FObject)
+    DEFINE_INTERFACES
+      DEF_INTERFACE(Steinberg::Linux::IEventHandler)
+    END_DEFINE_INTERFACES(Steinberg::FObject)
+  };
+
+  Steinberg::IPtr<Steinberg::Linux::IRunLoop> mRunLoop;
+  Steinberg::IPtr<EventHandler> mHandler;
+};
+#endif
+
 END_IPLUG_NAMESPACE
@@ -43,6 +43,9 @@ tresult PLUGIN_API IPlugVST3Controller::initialize(FUnknown* context)
   {
     Initialize(this, mPlugIsInstrument, mDoesMidiIn);
     IPlugVST3GetHost(this, context);
+#if defined OS_LINUX
+    mRunLoop.Attach(context);
+#endif
     OnHostIdentified();
     OnParamReset(kReset);
     
@@ -57,6 +60,15 @@ tresult PLUGIN_API IPlugVST3Controller::initialize(FUnknown* context)
   return kResultFalse;
 }
 
+tresult PLUGIN_API IPlugVST3Controller::terminate()
+{
+#if defined OS_LINUX
+  mRunLoop.Detach();
+#endif
+
+  return EditControllerEx1::terminate();
+}
+
 IPlugView* PLUGIN_API IPlugVST3Controller::createView(const char* name)
 {
   if (HasUI() && name && strcmp(name, "editor") == 0)
@@ -50,6 +50,7 @@ public:
 
   // IEditController
   Steinberg::tresult PLUGIN_API initialize(Steinberg::FUnknown* context) override;
+  Steinberg::tresult PLUGIN_API terminate() override;
   Steinberg::IPlugView* PLUGIN_API createView(Steinberg::FIDString name) override;
   Steinberg::tresult PLUGIN_API setComponentState(Steinberg::IBStream* pState) override; // receives the processor's state
   Steinberg::tresult PLUGIN_API setState(Steinberg::IBStream* pState) override;
@@ -124,6 +125,9 @@ public:
 
 private:
   ViewType* mView = nullptr;
+#if defined OS_LINUX
+  IPlugVST3RunLoop mRunLoop;
+#endif
   bool mPlugIsInstrument;
   bool mDoesMidiIn;
   Steinberg::FUID mProcessorGUID;
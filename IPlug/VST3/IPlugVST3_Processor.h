@@ -82,7 +82,6 @@ private:
   Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) override;
   
 //  Steinberg::Vst::ParameterChanges mOutputParamChanges;
-  IMidiQueue mMidiOutputQueue;
 };
 
 Steinberg::FUnknown* MakeProcessor();
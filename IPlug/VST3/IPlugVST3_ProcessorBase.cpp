@@ -385,6 +385,12 @@ void IPlugVST3ProcessorBase::ProcessAudio(ProcessData& data, ProcessSetup& setup
         SetChannelConnections(ERoute::kInput, 0, data.inputs[0].numChannels, true);
         AttachBuffers(ERoute::kInput, 0, data.inputs[0].numChannels, data.inputs[0], data.numSamples, sampleSize);
       }
+
+      // Pass on the host's silence hints, so that these channels are not scanned
+      SetInputSilenceFlags(0, data.inputs[0]);
+
+      if (mSidechainActive && data.numInputs > 1)
+        SetInputSilenceFlags(mMaxNChansForMainInputBus, data.inputs[1]);
     }
     
     for (int outBus = 0, chanOffset = 0; outBus < data.numOutputs; outBus++)
@@ -416,6 +422,30 @@ void IPlugVST3ProcessorBase::ProcessAudio(ProcessData& data, ProcessSetup& setup
       mPlug.mParams_mutex.Leave();
 #endif
     }
+
+    // Report silent outputs to the host
+    for (int outBus = 0, chanOffset = 0; outBus < data.numOutputs; outBus++)
+    {
+      AudioBusBuffers& bus = data.outputs[outBus];
+      bus.silenceFlags = 0;
+
+      for (int c = 0; c < bus.numChannels; c++)
+      {
+        if (!GetBypassed() && c < 64 && GetOutputIsSilent(chanOffset + c))
+          bus.silenceFlags |= uint64(1) << c;
+      }
+
+      chanOffset += bus.numChannels;
+    }
+  }
+}
+
+void IPlugVST3ProcessorBase::SetInputSilenceFlags(int idx, const AudioBusBuffers& bus)
+{
+  for (int c = 0; c < bus.numChannels && c < 64; c++)
+  {
+    if (bus.silenceFlags & (uint64(1) << c))
+      SetInputIsSilent(idx + c, true);
   }
 }
 
@@ -14,6 +14,7 @@
 #include "pluginterfaces/base/keycodes.h"
 
 #include "IPlugStructs.h"
+#include "IPlugVST3_Common.h"
 
 /** IPlug VST3 View  */
 template <class T>
@@ -52,6 +53,19 @@ public:
     return Steinberg::kResultFalse;
   }
     
+#if defined OS_LINUX
+  Steinberg::tresult PLUGIN_API setFrame(Steinberg::IPlugFrame* pFrame) override
+  {
+    // Hosts provide their run loop with the frame, the timers run on it while the view is open
+    if (pFrame)
+      mRunLoop.Attach(pFrame);
+    else
+      mRunLoop.Detach();
+
+    return CPluginView::setFrame(pFrame);
+  }
+#endif
+
   Steinberg::tresult PLUGIN_API onSize(Steinberg::ViewRect* pSize) override
   {
     TRACE
@@ -341,4 +355,7 @@ public:
   }
 
   T& mOwner;
+#if defined OS_LINUX
+  iplug::IPlugVST3RunLoop mRunLoop;
+#endif
 };
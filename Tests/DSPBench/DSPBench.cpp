@@ -0,0 +1,678 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Benchmarks for the DSP building blocks in IPlug/Extras, at realistic block sizes, channel counts and sample rates.
+ * Each case processes a few seconds of audio (noise, or MIDI for the synth) several times, and reports the median time per
+ * sample frame and how many times faster than realtime that is. The results can be written as JSON, to compare commits with compare.py.
+ *
+ * Usage: DSPBench [options]
+ *   --seconds N         Seconds of audio to process per repeat (default 2)
+ *   --repeats N         Number of repeats, of which the median is reported (default 5)
+ *   --filter STR        Only run cases whose name contains STR
+ *   --json FILE         Write the results as JSON to FILE, or to stdout if FILE is -
+ *   --quick             Process a tenth of a second once per case, as a smoke test
+ *   --list              List the cases without running them
+ *
+ * Returns 0 if every case produced finite output
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ADSREnvelope.h"
+#include "DCBlocker.h"
+#include "LFO.h"
+#include "LanczosResampler.h"
+#include "NChanDelay.h"
+#include "NoiseGate.h"
+#include "Oscillator.h"
+#include "Oversampler.h"
+#include "RealtimeResampler.h"
+#include "SVF.h"
+#include "Smoothers.h"
+#include "MidiSynth.h"
+
+using namespace iplug;
+
+struct Options
+{
+  double seconds = 2.;
+  int repeats = 5;
+  const char* filter = nullptr;
+  const char* jsonPath = nullptr;
+  bool list = false;
+};
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--seconds") && hasValue) options.seconds = std::max(0.01, atof(argv[++i]));
+    else if (!strcmp(arg, "--repeats") && hasValue) options.repeats = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--filter") && hasValue) options.filter = argv[++i];
+    else if (!strcmp(arg, "--json") && hasValue) options.jsonPath = argv[++i];
+    else if (!strcmp(arg, "--quick")) { options.seconds = 0.1; options.repeats = 1; }
+    else if (!strcmp(arg, "--list")) options.list = true;
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** The configuration of a case */
+struct Config
+{
+  double sampleRate;
+  int blockSize;
+  int nChans;
+};
+
+/** Non-interleaved buffers, with the pointer arrays that the DSP classes take */
+template <typename T>
+struct Buffers
+{
+  Buffers(int nChans, int nFrames)
+  : mData(nChans, std::vector<T>(nFrames))
+  , mPtrs(nChans)
+  {
+    for (int c = 0; c < nChans; c++)
+      mPtrs[c] = mData[c].data();
+  }
+
+  void FillNoise()
+  {
+    for (auto& chan : mData)
+      for (auto& x : chan)
+        x = static_cast<T>(static_cast<double>(rand()) / RAND_MAX * 2. - 1.);
+  }
+
+  void Clear()
+  {
+    for (auto& chan : mData)
+      std::fill(chan.begin(), chan.end(), T(0));
+  }
+
+  /** @return \c true if every sample is finite, so that the compiler can't discard the processing */
+  bool IsFinite() const
+  {
+    for (auto& chan : mData)
+      for (auto x : chan)
+        if (!std::isfinite(x))
+          return false;
+
+    return true;
+  }
+
+  T** Get() { return mPtrs.data(); }
+
+  std::vector<std::vector<T>> mData;
+  std::vector<T*> mPtrs;
+};
+
+/** A case: set up with a config, and return a function that processes one block, and a check that the output is finite */
+struct Case
+{
+  const char* mName;
+  const char* mVariant;
+  Config mConfig;
+  std::function<std::pair<std::function<void()>, std::function<bool()>>(const Config&)> mSetup;
+};
+
+struct Result
+{
+  const Case* mCase;
+  double mNsPerFrame;
+  double mRealtime;
+  bool mFinite;
+};
+
+static Result Run(const Case& c, const Options& options)
+{
+  const Config& config = c.mConfig;
+  auto funcs = c.mSetup(config);
+  auto& process = funcs.first;
+
+  const int nBlocks = std::max(1, static_cast<int>(options.seconds * config.sampleRate / config.blockSize));
+  std::vector<double> times;
+
+  process(); // warm up
+
+  for (int r = 0; r < options.repeats; r++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int b = 0; b < nBlocks; b++)
+      process();
+
+    times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  const double seconds = times[times.size() / 2];
+  const double nFrames = static_cast<double>(nBlocks) * config.blockSize;
+
+  return { &c, seconds * 1e9 / nFrames, (nFrames / config.sampleRate) / seconds, funcs.second() };
+}
+
+#pragma mark - Cases
+
+static const double kSampleRates[] = { 44100., 96000. };
+static const int kBlockSizes[] = { 64, 512 };
+
+/** Add a case for each sample rate and block size */
+static void AddCases(std::vector<Case>& cases, const char* name, const char* variant, int nChans, decltype(Case::mSetup) setup)
+{
+  for (auto sampleRate : kSampleRates)
+    for (auto blockSize : kBlockSizes)
+      cases.push_back({ name, variant, { sampleRate, blockSize, nChans }, setup });
+}
+
+/** A voice with a table oscillator and an envelope, like the IPlugInstrument example */
+class BenchVoice : public SynthVoice
+{
+public:
+  bool GetBusy() const override { return mEnv.GetBusy(); }
+
+  void Trigger(double level, bool isRetrigger) override
+  {
+    mOsc.Reset();
+
+    if (isRetrigger)
+      mEnv.Retrigger(level);
+    else
+      mEnv.Start(level);
+  }
+
+  void Release() override { mEnv.Release(); }
+
+  void ProcessSamplesAccumulating(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIdx, int nFrames) override
+  {
+    const double freq = 440. * std::pow(2., mInputs[kVoiceControlPitch].endValue + mInputs[kVoiceControlPitchBend].endValue);
+
+    for (auto s = startIdx; s < startIdx + nFrames; s++)
+    {
+      const sample y = mOsc.Process(freq) * mEnv.Process(0.8) * mGain;
+
+      for (auto c = 0; c < nOutputs; c++)
+        outputs[c][s] += y;
+    }
+  }
+
+  void SetSampleRateAndBlockSize(double sampleRate, int blockSize) override
+  {
+    mOsc.SetSampleRate(sampleRate);
+    mEnv.SetSampleRate(sampleRate);
+    mEnv.SetStageTime(ADSREnvelope<sample>::kAttack, 5.);
+    mEnv.SetStageTime(ADSREnvelope<sample>::kDecay, 50.);
+    mEnv.SetStageTime(ADSREnvelope<sample>::kRelease, 100.);
+  }
+
+private:
+  FastSinOscillator<sample> mOsc;
+  ADSREnvelope<sample> mEnv;
+};
+
+/** Plays chords of nNotes notes, changing chord every 100ms, so voices are triggered, released and stolen */
+template <typename Synth>
+static std::pair<std::function<void()>, std::function<bool()>> SetupSynth(const Config& config, std::shared_ptr<Synth> pSynth, int nNotes)
+{
+  pSynth->SetSampleRateAndBlockSize(config.sampleRate, config.blockSize);
+  auto pOut = std::make_shared<Buffers<sample>>(config.nChans, config.blockSize);
+  auto pTime = std::make_shared<int64_t>(0);
+  const int64_t chordLength = static_cast<int64_t>(config.sampleRate * 0.1);
+
+  auto process = [=]() {
+    const int64_t start = *pTime;
+    const int64_t nextChord = ((start / chordLength) + 1) * chordLength;
+
+    if (start % chordLength == 0 || nextChord < start + config.blockSize)
+    {
+      const int offset = static_cast<int>(start % chordLength == 0 ? 0 : nextChord - start);
+      const int chord = static_cast<int>((start + offset) / chordLength);
+
+      for (int n = 0; n < nNotes; n++)
+      {
+        IMidiMsg msg;
+        msg.MakeNoteOffMsg(36 + ((chord - 1) * 5 + n * 7) % 60, offset);
+        pSynth->AddMidiMsgToQueue(msg);
+        msg.MakeNoteOnMsg(36 + (chord * 5 + n * 7) % 60, 100, offset);
+        pSynth->AddMidiMsgToQueue(msg);
+      }
+    }
+
+    pOut->Clear();
+    pSynth->ProcessBlock(nullptr, pOut->Get(), 0, config.nChans, config.blockSize);
+    *pTime += config.blockSize;
+  };
+
+  return { process, [=]() { return pOut->IsFinite(); } };
+}
+
+static std::vector<Case> MakeCases()
+{
+  std::vector<Case> cases;
+
+  for (auto factor : { k2x, k4x, k8x })
+  {
+    static const char* names[] = { "1x", "2x", "4x", "8x", "16x" };
+
+    AddCases(cases, "OverSampler", names[factor], 2, [factor](const Config& config) {
+      auto pOS = std::make_shared<OverSampler<double>>(factor, true, config.nChans, config.nChans);
+      pOS->Reset(config.blockSize);
+      auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      pIn->FillNoise();
+
+      // A soft clipper at the higher rate, which is what oversampling is for
+      auto clip = [](double** inputs, double** outputs, int nFrames) {
+        for (int c = 0; c < 2; c++)
+          for (int s = 0; s < nFrames; s++)
+            outputs[c][s] = inputs[c][s] / (1. + std::fabs(inputs[c][s]));
+      };
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() { pOS->ProcessBlock(pIn->Get(), pOut->Get(), config.blockSize, config.nChans, config.nChans, clip); },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  AddCases(cases, "LanczosResampler", "to 48k", 2, [](const Config& config) {
+    auto pResampler = std::make_shared<LanczosResampler<float, 2, 12>>(static_cast<float>(config.sampleRate), 48000.f);
+    auto pIn = std::make_shared<Buffers<float>>(config.nChans, config.blockSize);
+    auto pOut = std::make_shared<Buffers<float>>(config.nChans, config.blockSize * 3);
+    pIn->FillNoise();
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() {
+        pResampler->PushBlock(pIn->Get(), config.blockSize, config.nChans);
+        pResampler->PopBlock(pOut->Get(), pResampler->GetNumSamplesAvailable(), config.nChans);
+        pResampler->RenormalizePhases();
+      },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  using Resampler = RealtimeResampler<float, 2, 12>;
+
+  for (auto mode : { Resampler::ESRCMode::kLinearInterpolation, Resampler::ESRCMode::kLancsoz })
+  {
+    AddCases(cases, "RealtimeResampler", mode == Resampler::ESRCMode::kLancsoz ? "lanczos at 48k" : "linear at 48k", 2, [mode](const Config& config) {
+      auto pResampler = std::make_shared<Resampler>(48000., mode);
+      pResampler->Reset(config.sampleRate, config.blockSize);
+      auto pIn = std::make_shared<Buffers<float>>(config.nChans, config.blockSize);
+      auto pOut = std::make_shared<Buffers<float>>(config.nChans, config.blockSize);
+      pIn->FillNoise();
+
+      auto copy = [](float** inputs, float** outputs, int nFrames, int nChans) {
+        for (int c = 0; c < nChans; c++)
+          memcpy(outputs[c], inputs[c], nFrames * sizeof(float));
+      };
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() { pResampler->ProcessBlock(pIn->Get(), pOut->Get(), config.blockSize, config.nChans, copy); },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  for (auto modulated : { false, true })
+  {
+    AddCases(cases, "SVF", modulated ? "lowpass, new cutoff every block" : "lowpass", 2, [modulated](const Config& config) {
+      auto pSVF = std::make_shared<SVF<double, 2>>(SVF<double, 2>::kLowPass, 1000.);
+      pSVF->SetSampleRate(config.sampleRate);
+      pSVF->SetQ(2.);
+      auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pBlock = std::make_shared<int>(0);
+      pIn->FillNoise();
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() {
+          if (modulated)
+            pSVF->SetFreqCPS(1000. + 500. * std::sin(++(*pBlock) * 0.05));
+
+          pSVF->ProcessBlock(pIn->Get(), pOut->Get(), config.nChans, config.blockSize);
+        },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  AddCases(cases, "FastSinOscillator", "block", 1, [](const Config& config) {
+    auto pOsc = std::make_shared<FastSinOscillator<double>>(0., 440.);
+    pOsc->SetSampleRate(config.sampleRate);
+    auto pOut = std::make_shared<Buffers<double>>(1, config.blockSize);
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() { pOsc->ProcessBlock(pOut->Get()[0], config.blockSize); },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  for (auto sync : { false, true })
+  {
+    AddCases(cases, "LFO", sync ? "triangle, tempo sync" : "triangle", 1, [sync](const Config& config) {
+      auto pLFO = std::make_shared<LFO<double>>();
+      pLFO->SetSampleRate(config.sampleRate);
+      pLFO->SetFreqCPS(3.);
+      pLFO->SetShape(LFO<double>::kTriangle);
+      pLFO->SetRateMode(sync);
+      pLFO->SetQNScalarFromDivision(LFO<double>::k8th);
+      auto pOut = std::make_shared<Buffers<double>>(1, config.blockSize);
+      auto pQN = std::make_shared<double>(0.);
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() {
+          pLFO->ProcessBlock(pOut->Get()[0], config.blockSize, *pQN, sync, 120.);
+          *pQN += config.blockSize / (config.sampleRate * 0.5);
+        },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  AddCases(cases, "ADSREnvelope", "retriggered", 1, [](const Config& config) {
+    auto pEnv = std::make_shared<ADSREnvelope<double>>();
+    pEnv->SetSampleRate(config.sampleRate);
+    pEnv->SetStageTime(ADSREnvelope<double>::kAttack, 10.);
+    pEnv->SetStageTime(ADSREnvelope<double>::kDecay, 50.);
+    pEnv->SetStageTime(ADSREnvelope<double>::kRelease, 100.);
+    auto pOut = std::make_shared<Buffers<double>>(1, config.blockSize);
+    auto pTime = std::make_shared<int64_t>(0);
+    const int64_t period = static_cast<int64_t>(config.sampleRate * 0.25);
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() {
+        double* pData = pOut->Get()[0];
+
+        for (int s = 0; s < config.blockSize; s++, (*pTime)++)
+        {
+          // Start a note every quarter second and release it halfway through
+          const int64_t t = *pTime % period;
+
+          if (t == 0)
+            pEnv->Start(1.);
+          else if (t == period / 2)
+            pEnv->Release();
+
+          pData[s] = pEnv->Process(0.5);
+        }
+      },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  for (int nChans : { 2, 8 })
+  {
+    AddCases(cases, "NChanDelayLine", "100ms", nChans, [](const Config& config) {
+      auto pDelay = std::make_shared<NChanDelayLine<double>>(config.nChans, config.nChans);
+      pDelay->SetDelayTime(static_cast<int>(config.sampleRate * 0.1));
+      auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      pIn->FillNoise();
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() { pDelay->ProcessBlock(pIn->Get(), pOut->Get(), config.blockSize); },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  using ModDelay = NChanModDelayLine<double>;
+
+  for (auto interp : { ModDelay::EInterp::None, ModDelay::EInterp::Lagrange })
+  {
+    AddCases(cases, "NChanModDelayLine", interp == ModDelay::EInterp::None ? "100ms" : "lagrange, modulated 5-15ms", 2, [interp](const Config& config) {
+      auto pDelay = std::make_shared<ModDelay>(config.nChans, interp);
+      pDelay->Allocate(static_cast<int>(config.sampleRate * 0.1), config.blockSize);
+      auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pDelays = std::make_shared<std::vector<double>>(config.blockSize);
+      auto pPhase = std::make_shared<double>(0.);
+      pIn->FillNoise();
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() {
+          if (interp == ModDelay::EInterp::None)
+            pDelay->ProcessBlock(pIn->Get(), pOut->Get(), config.blockSize, config.sampleRate * 0.1);
+          else
+          {
+            // A chorus: a 0.5Hz sine sweeping the delay between 5 and 15ms
+            const double inc = 2. * PI * 0.5 / config.sampleRate;
+
+            for (auto& d : *pDelays)
+            {
+              d = config.sampleRate * (0.01 + 0.005 * std::sin(*pPhase));
+              *pPhase += inc;
+            }
+
+            pDelay->Write(pIn->Get(), config.blockSize);
+            pDelay->ReadModulated(pOut->Get(), pDelays->data(), config.blockSize);
+          }
+        },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  AddCases(cases, "NoiseGate", "sidechain", 2, [](const Config& config) {
+    auto pGate = std::make_shared<NoiseGate<double, 2>>();
+    pGate->SetSampleRate(config.sampleRate);
+    pGate->SetThreshold(-12.);
+    pGate->SetAttackTime(0.001);
+    pGate->SetHoldTime(0.01);
+    pGate->SetReleaseTime(0.05);
+    auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    pIn->FillNoise();
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() { pGate->ProcessBlock(pIn->Get(), pOut->Get(), pIn->Get()[0], config.nChans, config.blockSize); },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  AddCases(cases, "NoiseGate", "linked", 2, [](const Config& config) {
+    auto pGate = std::make_shared<NoiseGate<double, 2>>();
+    pGate->SetSampleRate(config.sampleRate);
+    pGate->SetThreshold(-12.);
+    pGate->SetAttackTime(0.001);
+    pGate->SetHoldTime(0.01);
+    pGate->SetReleaseTime(0.05);
+    auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    pIn->FillNoise();
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() { pGate->ProcessBlock(pIn->Get(), pOut->Get(), config.nChans, config.blockSize); },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  for (int nChans : {2, 8})
+  {
+    AddCases(cases, "DCBlocker", "", nChans, [](const Config& config) {
+      auto pBlocker = std::make_shared<DCBlocker<double, 8>>();
+      auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+      pIn->FillNoise();
+
+      return std::make_pair<std::function<void()>, std::function<bool()>>(
+        [=]() { pBlocker->ProcessBlock(pIn->Get(), pOut->Get(), config.nChans, config.blockSize); },
+        [=]() { return pOut->IsFinite(); });
+    });
+  }
+
+  AddCases(cases, "SmoothedGain", "ramping", 2, [](const Config& config) {
+    auto pGain = std::make_shared<SmoothedGain<double>>(20.);
+    pGain->SetSampleRate(config.sampleRate);
+    auto pIn = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    auto pBlock = std::make_shared<int>(0);
+    pIn->FillNoise();
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() {
+        // A new gain every block, as when the gain is automated
+        pGain->ProcessBlock(pIn->Get(), pOut->Get(), config.nChans, config.blockSize, 0.5 + 0.25 * std::sin(0.1 * (*pBlock)++));
+      },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  AddCases(cases, "LogParamSmooth", "4 params", 4, [](const Config& config) {
+    auto pSmooth = std::make_shared<LogParamSmooth<double, 4>>(20.);
+    pSmooth->SetSmoothTime(20., config.sampleRate);
+    auto pOut = std::make_shared<Buffers<double>>(config.nChans, config.blockSize);
+    auto pBlock = std::make_shared<int>(0);
+
+    return std::make_pair<std::function<void()>, std::function<bool()>>(
+      [=]() {
+        // New targets every block, as when parameters are automated
+        double targets[4];
+
+        for (int i = 0; i < 4; i++)
+          targets[i] = std::sin(++(*pBlock) * 0.1 + i);
+
+        pSmooth->ProcessBlock(targets, pOut->Get(), config.blockSize);
+      },
+      [=]() { return pOut->IsFinite(); });
+  });
+
+  for (int nNotes : { 4, 16 })
+  {
+    AddCases(cases, "MidiSynth", nNotes == 4 ? "4 note chords, virtual voices" : "16 note chords, virtual voices", 2, [nNotes](const Config& config) {
+      auto pSynth = std::make_shared<MidiSynth>(VoiceAllocatorBase::kPolyModePoly);
+
+      for (int v = 0; v < 32; v++)
+        pSynth->AddVoice(new BenchVoice(), 0);
+
+      return SetupSynth(config, pSynth, nNotes);
+    });
+
+    AddCases(cases, "MidiSynthT", nNotes == 4 ? "4 note chords, contiguous voices" : "16 note chords, contiguous voices", 2, [nNotes](const Config& config) {
+      auto pSynth = std::make_shared<MidiSynthT<BenchVoice>>(VoiceAllocatorBase::kPolyModePoly);
+      pSynth->ReserveVoices(32);
+
+      for (int v = 0; v < 32; v++)
+        pSynth->EmplaceVoice(0);
+
+      return SetupSynth(config, pSynth, nNotes);
+    });
+  }
+
+  return cases;
+}
+
+#pragma mark - Output
+
+static void WriteJSONString(FILE* fp, const char* str)
+{
+  fputc('"', fp);
+
+  for (; *str; str++)
+  {
+    if (*str == '"' || *str == '\\')
+      fputc('\\', fp);
+
+    fputc(*str, fp);
+  }
+
+  fputc('"', fp);
+}
+
+static bool WriteJSON(const char* path, const Options& options, const std::vector<Result>& results)
+{
+  FILE* fp = strcmp(path, "-") ? fopen(path, "w") : stdout;
+
+  if (!fp)
+  {
+    fprintf(stderr, "Couldn't write %s\n", path);
+    return false;
+  }
+
+  fprintf(fp, "{\n  \"benchmark\": \"DSPBench\",\n  \"version\": 1,\n");
+#if defined __VERSION__
+  fprintf(fp, "  \"compiler\": ");
+  WriteJSONString(fp, __VERSION__);
+  fprintf(fp, ",\n");
+#endif
+  fprintf(fp, "  \"seconds\": %g,\n  \"repeats\": %i,\n  \"results\": [\n", options.seconds, options.repeats);
+
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result& r = results[i];
+    const Config& config = r.mCase->mConfig;
+    fprintf(fp, "    { \"name\": ");
+    WriteJSONString(fp, r.mCase->mName);
+    fprintf(fp, ", \"variant\": ");
+    WriteJSONString(fp, r.mCase->mVariant);
+    fprintf(fp, ", \"sampleRate\": %g, \"blockSize\": %i, \"channels\": %i, \"nsPerFrame\": %.3f, \"realtime\": %.1f }%s\n",
+            config.sampleRate, config.blockSize, config.nChans, r.mNsPerFrame, r.mRealtime, i + 1 < results.size() ? "," : "");
+  }
+
+  fprintf(fp, "  ]\n}\n");
+
+  if (fp != stdout)
+    fclose(fp);
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  srand(1234);
+
+  const std::vector<Case> cases = MakeCases();
+  std::vector<Result> results;
+  int nFailed = 0;
+
+  // With the JSON on stdout, the table goes to stderr
+  FILE* table = options.jsonPath && !strcmp(options.jsonPath, "-") ? stderr : stdout;
+
+  fprintf(table, "%-20s %-34s %8s %6s %4s %12s %10s\n", "name", "variant", "rate", "block", "ch", "ns/frame", "realtime");
+
+  for (const auto& c : cases)
+  {
+    char fullName[128];
+    snprintf(fullName, sizeof(fullName), "%s %s", c.mName, c.mVariant);
+
+    if (options.filter && !strstr(fullName, options.filter))
+      continue;
+
+    if (options.list)
+    {
+      fprintf(table, "%-20s %-34s %8g %6i %4i\n", c.mName, c.mVariant, c.mConfig.sampleRate, c.mConfig.blockSize, c.mConfig.nChans);
+      continue;
+    }
+
+    results.push_back(Run(c, options));
+    const Result& r = results.back();
+    fprintf(table, "%-20s %-34s %8g %6i %4i %12.2f %9.0fx%s\n", c.mName, c.mVariant, c.mConfig.sampleRate, c.mConfig.blockSize, c.mConfig.nChans,
+            r.mNsPerFrame, r.mRealtime, r.mFinite ? "" : "  FAILED: output is not finite");
+
+    if (!r.mFinite)
+      nFailed++;
+  }
+
+  if (options.jsonPath && !options.list && !WriteJSON(options.jsonPath, options, results))
+    return 1;
+
+  return nFailed ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+# Compares two sets of DSPBench results, e.g. from before and after a change:
+#
+#   ./DSPBench --json before.json
+#   ./DSPBench --json after.json
+#   python3 compare.py before.json after.json [--threshold 5]
+#
+# Prints the change in time per sample frame for each case in both files, and returns 1 if any case is
+# slower by more than the threshold (a percentage, 5 by default)
+
+import argparse
+import json
+import sys
+
+def load(path):
+  with open(path) as f:
+    results = json.load(f)["results"]
+
+  return {(r["name"], r["variant"], r["sampleRate"], r["blockSize"], r["channels"]): r["nsPerFrame"] for r in results}
+
+def main():
+  parser = argparse.ArgumentParser(description="Compare two DSPBench JSON files")
+  parser.add_argument("before")
+  parser.add_argument("after")
+  parser.add_argument("--threshold", type=float, default=5.0, help="percentage slowdown that counts as a regression")
+  args = parser.parse_args()
+
+  before = load(args.before)
+  after = load(args.after)
+  regressions = 0
+
+  print("%-20s %-34s %8s %6s %4s %10s %10s %8s" % ("name", "variant", "rate", "block", "ch", "before", "after", "change"))
+
+  for key in before:
+    if key not in after:
+      continue
+
+    change = (after[key] / before[key] - 1.0) * 100.0 if before[key] else 0.0
+    flag = ""
+
+    if change > args.threshold:
+      flag = "  slower"
+      regressions += 1
+
+    print("%-20s %-34s %8g %6i %4i %10.2f %10.2f %+7.1f%%%s" % (key + (before[key], after[key], change, flag)))
+
+  return 1 if regressions else 0
+
+if __name__ == "__main__":
+  sys.exit(main())
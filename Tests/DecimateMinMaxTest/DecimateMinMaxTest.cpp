@@ -0,0 +1,139 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Test for DecimateMinMax(), which IGraphics::DrawData() and IVDisplayControl use to reduce lines to the pixel width.
+ * Checks that evenly spaced and ascending lines keep the min and max of each pixel column within 4 points per column,
+ * and that a line whose x positions go back and forth (an XY scope) is left alone, without writing past the output buffers
+ * (run with SANITIZE=1 to check with AddressSanitizer).
+ *
+ * Usage: DecimateMinMaxTest
+ *
+ * Returns 0 if the checks pass, 1 otherwise
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "IGraphicsPrivate.h"
+#include "IGraphicsUtilities.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+static constexpr int kNumPoints = 48000;
+static constexpr int kNumColumns = 300;
+
+static int sNumFailed = 0;
+
+static void Check(bool condition, const char* description)
+{
+  if (!condition)
+  {
+    printf("FAILED: %s\n", description);
+    sNumFailed++;
+  }
+}
+
+/** Decimate into buffers sized as DrawData() sizes them
+ * @return The number of points, or -1 if the line was not decimated */
+static int Decimate(const std::vector<float>& y, const std::vector<float>* pX, std::vector<float>& outY, std::vector<float>& outX)
+{
+  outY.assign(4 * kNumColumns, 0.f);
+  outX.assign(4 * kNumColumns, 0.f);
+  return DecimateMinMax(y.data(), pX ? pX->data() : nullptr, static_cast<int>(y.size()), kNumColumns, outY.data(), outX.data());
+}
+
+/** @return true if the min and max of the points in each column are kept */
+static bool KeepsEnvelope(const std::vector<float>& y, const std::vector<float>& x, const std::vector<float>& outY, const std::vector<float>& outX, int nOut)
+{
+  std::vector<float> lo(kNumColumns, 1e9f), hi(kNumColumns, -1e9f), outLo(kNumColumns, 1e9f), outHi(kNumColumns, -1e9f);
+
+  auto column = [](float pos) {
+    return std::min(std::max(static_cast<int>(pos * kNumColumns), 0), kNumColumns - 1);
+  };
+
+  for (size_t i = 0; i < y.size(); i++)
+  {
+    const int c = column(x[i]);
+    lo[c] = std::min(lo[c], y[i]);
+    hi[c] = std::max(hi[c], y[i]);
+  }
+
+  for (int i = 0; i < nOut; i++)
+  {
+    const int c = column(outX[i]);
+    outLo[c] = std::min(outLo[c], outY[i]);
+    outHi[c] = std::max(outHi[c], outY[i]);
+  }
+
+  return lo == outLo && hi == outHi;
+}
+
+int main()
+{
+  std::vector<float> y(kNumPoints), x(kNumPoints), outY, outX;
+
+  for (int i = 0; i < kNumPoints; i++)
+  {
+    y[i] = 0.5f + 0.5f * std::sin(i * 0.37f) * std::cos(i * 0.0011f);
+    x[i] = static_cast<float>(i) / (kNumPoints - 1);
+  }
+
+  // Evenly spaced, as IVDisplayControl draws
+  {
+    const int nOut = Decimate(y, nullptr, outY, outX);
+    Check(nOut > 0 && nOut <= 4 * kNumColumns, "an evenly spaced line is reduced to at most 4 points per column");
+    Check(nOut > 0 && KeepsEnvelope(y, x, outY, outX, nOut), "an evenly spaced line keeps the min and max of each column");
+  }
+
+  // Ascending, unevenly spaced x, as a log frequency axis
+  {
+    std::vector<float> logX(kNumPoints);
+
+    for (int i = 0; i < kNumPoints; i++)
+      logX[i] = std::log10(1.f + 9.f * x[i]);
+
+    const int nOut = Decimate(y, &logX, outY, outX);
+    Check(nOut > 0 && nOut <= 4 * kNumColumns, "an ascending line is reduced to at most 4 points per column");
+    Check(nOut > 0 && KeepsEnvelope(y, logX, outY, outX, nOut), "an ascending line keeps the min and max of each column");
+  }
+
+  // A Lissajous figure, as an XY scope draws, which changes column at almost every point
+  {
+    std::vector<float> xyX(kNumPoints), xyY(kNumPoints);
+
+    for (int i = 0; i < kNumPoints; i++)
+    {
+      xyX[i] = 0.5f + 0.5f * std::sin(i * 0.013f);
+      xyY[i] = 0.5f + 0.5f * std::sin(i * 0.017f);
+    }
+
+    const int nOut = Decimate(xyY, &xyX, outY, outX);
+    Check(nOut == -1, "a line whose x positions don't ascend is not decimated");
+  }
+
+  // Going back by a single column at the end
+  {
+    std::vector<float> backX = x;
+    backX.back() = 0.f;
+    Check(Decimate(y, &backX, outY, outX) == -1, "a line that goes back to an earlier column is not decimated");
+  }
+
+  if (sNumFailed)
+    printf("%d checks FAILED\n", sNumFailed);
+  else
+    printf("all checks passed\n");
+
+  return sNumFailed ? 1 : 0;
+}
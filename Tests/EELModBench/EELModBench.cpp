@@ -0,0 +1,346 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Benchmark for EELModMatrix, compared with the same modulation routes written in C++.
+ * Checks that the compiled code matches the C++ routes, that compile errors are reported without replacing the running code,
+ * and that recompiled code is picked up at the next block, also when it is compiled while another thread processes blocks, then times the @block and @sample sections.
+ *
+ * Usage: EELModBench [options]
+ *   --blocks N          Number of blocks to process (default 20000)
+ *   --block-size N      Block size in samples (default 512)
+ *
+ * Returns 0 if the checks pass, 1 otherwise
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "IPlugEEL.h"
+
+using namespace iplug;
+
+struct Options
+{
+  int blocks = 20000;
+  int blockSize = 512;
+};
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--blocks") && hasValue) options.blocks = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--block-size") && hasValue) options.blockSize = std::max(1, atoi(argv[++i]));
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static const char* kCode = R"(
+@init
+function curve(x, k) ( (exp(k * x) - 1) / (exp(k) - 1) );
+
+@block
+cutoff = 20 * 1000 ^ curve(macro1, 3);
+drive = macro2 < 0.5 ? macro2 * 2 : 1 + (macro2 - 0.5) * 8;
+
+@sample
+gain = 1 - depth * (0.5 + 0.5 * lfo);
+pan = min(max(0.5 + 0.5 * lfo * env * depth, 0), 1);
+)";
+
+enum ESource { kMacro1 = 0, kMacro2, kDepth, kLFO, kEnv, kNumSources };
+enum EDest { kCutoff = 0, kDrive, kGain, kPan, kNumDests };
+
+static double Curve(double x, double k) { return (std::exp(k * x) - 1.) / (std::exp(k) - 1.); }
+
+/** The routes of kCode in C++ */
+static void ProcessBlockCpp(const double* sources, double* dests)
+{
+  dests[kCutoff] = 20. * std::pow(1000., Curve(sources[kMacro1], 3.));
+  dests[kDrive] = sources[kMacro2] < 0.5 ? sources[kMacro2] * 2. : 1. + (sources[kMacro2] - 0.5) * 8.;
+}
+
+static void ProcessSamplesCpp(double depth, const double* lfo, const double* env, double* gain, double* pan, int nFrames)
+{
+  for (int s = 0; s < nFrames; s++)
+  {
+    gain[s] = 1. - depth * (0.5 + 0.5 * lfo[s]);
+    pan[s] = std::min(std::max(0.5 + 0.5 * lfo[s] * env[s] * depth, 0.), 1.);
+  }
+}
+
+static void SetupMatrix(EELModMatrix& matrix)
+{
+  const char* sources[kNumSources] = { "macro1", "macro2", "depth", "lfo", "env" };
+  const char* dests[kNumDests] = { "cutoff", "drive", "gain", "pan" };
+
+  for (auto name : sources)
+    matrix.AddSource(name);
+
+  for (auto name : dests)
+    matrix.AddDestination(name);
+
+  matrix.SetSampleRate(48000.);
+}
+
+/** Modulation signals for one block */
+struct Block
+{
+  Block(int blockSize)
+  : mLFO(blockSize), mEnv(blockSize), mGain(blockSize), mPan(blockSize), mGainCpp(blockSize), mPanCpp(blockSize)
+  {
+  }
+
+  void Fill(int blockIdx)
+  {
+    const int n = static_cast<int>(mLFO.size());
+
+    for (int s = 0; s < n; s++)
+    {
+      const double t = static_cast<double>(blockIdx * n + s) / 48000.;
+      mLFO[s] = std::sin(2. * 3.14159265358979323846 * 3. * t);
+      mEnv[s] = std::exp(-4. * std::fmod(t, 0.5));
+    }
+
+    mSources[kMacro1] = 0.5 + 0.5 * std::sin(0.37 * blockIdx);
+    mSources[kMacro2] = 0.5 + 0.5 * std::cos(0.23 * blockIdx);
+    mSources[kDepth] = 0.75;
+  }
+
+  std::vector<double> mLFO, mEnv, mGain, mPan, mGainCpp, mPanCpp;
+  double mSources[kNumSources] = {};
+};
+
+static void Process(EELModMatrix& matrix, Block& block)
+{
+  for (int i = 0; i < kNumSources; i++)
+    matrix.SetSource(i, block.mSources[i]);
+
+  const double* sources[kNumSources] = { nullptr, nullptr, nullptr, block.mLFO.data(), block.mEnv.data() };
+  double* dests[kNumDests] = { nullptr, nullptr, block.mGain.data(), block.mPan.data() };
+
+  matrix.ProcessBlock();
+  matrix.ProcessSamples(sources, dests, static_cast<int>(block.mLFO.size()));
+}
+
+/** @return The largest difference between the compiled code and the C++ routes */
+static double CompareWithCpp(const Options& options)
+{
+  EELModMatrix matrix;
+  SetupMatrix(matrix);
+  WDL_String error;
+
+  if (!matrix.Compile(kCode, error))
+  {
+    printf("compile error: %s\n", error.Get());
+    return 1e9;
+  }
+
+  Block block(options.blockSize);
+  double maxDiff = 0.;
+
+  for (int b = 0; b < 256; b++)
+  {
+    block.Fill(b);
+    Process(matrix, block);
+
+    double dests[kNumDests];
+    ProcessBlockCpp(block.mSources, dests);
+    ProcessSamplesCpp(block.mSources[kDepth], block.mLFO.data(), block.mEnv.data(), block.mGainCpp.data(), block.mPanCpp.data(), options.blockSize);
+
+    maxDiff = std::max(maxDiff, std::fabs(matrix.GetDestination(kCutoff) - dests[kCutoff]) / dests[kCutoff]);
+    maxDiff = std::max(maxDiff, std::fabs(matrix.GetDestination(kDrive) - dests[kDrive]));
+
+    for (int s = 0; s < options.blockSize; s++)
+    {
+      maxDiff = std::max(maxDiff, std::fabs(block.mGain[s] - block.mGainCpp[s]));
+      maxDiff = std::max(maxDiff, std::fabs(block.mPan[s] - block.mPanCpp[s]));
+    }
+  }
+
+  return maxDiff;
+}
+
+/** @return The number of failed checks of compile errors and recompiling */
+static int CheckRecompile()
+{
+  int nFailed = 0;
+  EELModMatrix matrix;
+  const int out = matrix.AddDestination("out");
+  WDL_String error;
+
+  matrix.Compile("out = 1;", error);
+  matrix.ProcessBlock();
+
+  for (auto code : { "@block\nout = 2;\nout = (3;\n", "@foo\nout = 2;" })
+  {
+    if (matrix.Compile(code, error))
+    {
+      printf("FAILED: invalid code compiled\n");
+      nFailed++;
+    }
+    else
+      printf("compile error: %s\n", error.Get());
+  }
+
+  matrix.ProcessBlock();
+
+  if (matrix.GetDestination(out) != 1.)
+  {
+    printf("FAILED: a compile error replaced the running code\n");
+    nFailed++;
+  }
+
+  // Several compiles between blocks, only the last one should run
+  for (int i = 2; i <= 4; i++)
+  {
+    WDL_String code;
+    code.SetFormatted(64, "@init\nk = %d;\n@block\nout = k;", i);
+    matrix.Compile(code.Get(), error);
+    matrix.ProcessBlock();
+
+    if (matrix.GetDestination(out) != i)
+    {
+      printf("FAILED: recompiled code was not picked up, got %g instead of %d\n", matrix.GetDestination(out), i);
+      nFailed++;
+    }
+  }
+
+  return nFailed;
+}
+
+/** @return The number of failed checks of compiling back to back while the audio thread processes blocks */
+static int CheckCompileWhileProcessing()
+{
+  int nFailed = 0;
+  EELModMatrix matrix;
+  const int out = matrix.AddDestination("out");
+  WDL_String error;
+
+  matrix.Compile("out = 0;", error);
+  matrix.ProcessBlock();
+
+  for (int i = 1; i <= 100; i++)
+  {
+    std::atomic<bool> stop {false};
+    std::thread audio([&]() {
+      while (!stop.load())
+        matrix.ProcessBlock();
+    });
+
+    // The audio thread can swap in the first program while the second one compiles
+    WDL_String code;
+    code.SetFormatted(64, "out = %d;", -i);
+    matrix.Compile(code.Get(), error);
+    code.SetFormatted(64, "@init\nk = %d;\n@block\nout = k;", i);
+    matrix.Compile(code.Get(), error);
+
+    stop.store(true);
+    audio.join();
+    matrix.ProcessBlock();
+
+    if (matrix.GetDestination(out) != i)
+    {
+      printf("FAILED: code compiled while processing was not picked up, got %g instead of %d\n", matrix.GetDestination(out), i);
+      nFailed++;
+      break;
+    }
+  }
+
+  return nFailed;
+}
+
+template <class F>
+static double Time(int nBlocks, F&& process)
+{
+  process(0); // warm up
+  const auto start = std::chrono::steady_clock::now();
+
+  for (int b = 0; b < nBlocks; b++)
+    process(b);
+
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  int nFailed = 0;
+
+  const double diff = CompareWithCpp(options);
+  printf("EEL vs C++: max difference %g\n", diff);
+
+  if (diff > 1e-12)
+  {
+    printf("FAILED: the compiled code is different to C++\n");
+    nFailed++;
+  }
+
+  nFailed += CheckRecompile();
+  nFailed += CheckCompileWhileProcessing();
+
+  EELModMatrix matrix;
+  SetupMatrix(matrix);
+  WDL_String error;
+  matrix.Compile(kCode, error);
+
+  Block block(options.blockSize);
+  block.Fill(0);
+
+  const double nsPerFrame = 1e6 / (static_cast<double>(options.blocks) * options.blockSize);
+
+  const double eelMs = Time(options.blocks, [&](int) { Process(matrix, block); });
+
+  const double cppMs = Time(options.blocks, [&](int) {
+    double dests[kNumDests];
+    ProcessBlockCpp(block.mSources, dests);
+    ProcessSamplesCpp(block.mSources[kDepth], block.mLFO.data(), block.mEnv.data(), block.mGainCpp.data(), block.mPanCpp.data(), options.blockSize);
+  });
+
+  const double blockMs = Time(options.blocks, [&](int) { matrix.ProcessBlock(); });
+
+#ifdef EEL_TARGET_PORTABLE
+  const char* mode = "portable";
+#else
+  const char* mode = "jit";
+#endif
+
+  printf("%d blocks of %d samples, EEL %s\n", options.blocks, options.blockSize, mode);
+  printf("%-24s %10s %12s\n", "", "ms", "ns/frame");
+  printf("%-24s %10.2f %12.3f\n", "EEL @block + @sample", eelMs, eelMs * nsPerFrame);
+  printf("%-24s %10.2f %12.3f\n", "C++", cppMs, cppMs * nsPerFrame);
+  printf("%-24s %10.2f %12.3f\n", "EEL @block only", blockMs, blockMs * nsPerFrame);
+
+  if (nFailed)
+    printf("%d checks FAILED\n", nFailed);
+
+  return nFailed ? 1 : 0;
+}
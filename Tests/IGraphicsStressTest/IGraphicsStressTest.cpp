@@ -2,6 +2,7 @@
 #include "IPlug_include_in_plug_src.h"
 
 #include "IControls.h"
+#include "IGraphicsStressTestScenes.h"
 
 IGraphicsStressTest::IGraphicsStressTest(const InstanceInfo& info)
 : Plugin(info, MakeConfig(kNumParams, 1))
@@ -58,7 +59,7 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
     }
     
     GetUI()->GetControlWithTag(kCtrlTagNumThings)->As<ITextControl>()->SetStrFmt(64, "Number of things = %i", mNumberOfThings);
-    GetUI()->GetControlWithTag(kCtrlTagTestNum)->As<ITextControl>()->SetStrFmt(64, "Test %i/%i", this->mKindOfThing, 32);
+    GetUI()->GetControlWithTag(kCtrlTagTestNum)->As<ITextControl>()->SetStrFmt(64, "Test %i/%i", this->mKindOfThing, kNumStressTestScenes - 1);
     GetUI()->SetAllControlsDirty();
   };
   
@@ -82,54 +83,7 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
     static IBitmap smiley = g.LoadBitmap(SMILEY_FN);
     static ISVG tiger = g.LoadSVG(TIGER_FN);
     
-    g.FillRect(COLOR_WHITE, r);
-    
-    if(this->mKindOfThing == 0)
-    {
-      g.DrawText(IText(30), "Press tab to go to next test", r);
-      g.DrawText(IText(30), "up/down to change the # of things", r.GetVShifted(40.f));
-    }
-    else
-    //      if (!g.CheckLayer(pCaller->mLayer))
-    {
-      //        g.StartLayer(r);
-      
-      for (int i=0; i<this->mNumberOfThings; i++)
-      {
-        IRECT rr = r.GetRandomSubRect();
-        IColor rc = IColor::GetRandomColor();
-        IBlend rb = {};
-        static bool dir = 0;
-        static float thickness = 5.f;
-        static float roundness = 5.f;
-        float rrad1 = static_cast<float>(rand() % 360);
-        float rrad2 = static_cast<float>(rand() % 360);
-        
-        switch (this->mKindOfThing)
-        {
-          case 1:  g.DrawRect(rc, rr, &rb); break;
-          case 2:  g.FillRect(rc, rr, &rb); break;
-          case 3:  g.DrawRoundRect(rc, rr, roundness, &rb); break;
-          case 4:  g.FillRoundRect(rc, rr, roundness, &rb); break;
-          case 5:  g.DrawEllipse(rc, rr, &rb); break;
-          case 6:  g.FillEllipse(rc, rr, &rb); break;
-          case 7:  g.DrawArc(rc, rr.MW(), rr.MH(), rr.W() > rr.H() ? rr.H() : rr.W(), rrad1, rrad2, &rb,thickness); break;
-          case 8:  g.FillArc(rc, rr.MW(), rr.MH(), rr.W() > rr.H() ? rr.H() : rr.W(), rrad1, rrad2, &rb); break;
-          case 9:  g.DrawLine(rc, dir == 0 ? rr.L : rr.R, rr.B, dir == 0 ? rr.R : rr.L, rr.T, &rb,thickness); break;
-          case 10: g.DrawDottedLine(rc, dir == 0 ? rr.L : rr.R, rr.B, dir == 0 ? rr.R : rr.L, rr.T, &rb, thickness); break;
-          case 11: g.DrawFittedBitmap(smiley, rr, &rb); break;
-          case 12: g.DrawSVG(tiger, rr); break;
-          default:
-            break;
-        }
-        
-        dir = !dir;
-      }
-      //        pCaller->mLayer = g.EndLayer();
-    }
-    
-    //      g.DrawLayer(pCaller->mLayer);
-    
+    DrawStressTestScene(g, r, this->mKindOfThing, this->mNumberOfThings, smiley, tiger);
   }, 10000, false, false));
   
   pGraphics->AttachControl(new ITextControl(labelsArea.GetGridCell(0, 1, 2), "", IText(20)), kCtrlTagNumThings);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdlib>
+
+#include "IGraphics.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+/** The things the stress test can draw, shared by the plug-in and the offscreen benchmark in offscreen/ */
+static const char* kStressTestSceneNames[] = {"Start", "DrawRect", "FillRect", "DrawRoundRect", "FillRoundRect", "DrawEllipse", "FillEllipse", "DrawArc", "FillArc", "DrawLine", "DrawDottedLine", "DrawFittedBitmap", "DrawSVG"};
+static constexpr int kNumStressTestScenes = sizeof(kStressTestSceneNames) / sizeof(kStressTestSceneNames[0]);
+
+/** Draw a stress test scene: numberOfThings primitives of one kind, with random bounds and colors.
+ * Positions and colors come from std::rand(), call std::srand() first to draw the same frame again */
+static void DrawStressTestScene(IGraphics& g, const IRECT& r, int kindOfThing, int numberOfThings, const IBitmap& smiley, const ISVG& tiger)
+{
+  g.FillRect(COLOR_WHITE, r);
+
+  if (kindOfThing == 0)
+  {
+    g.DrawText(IText(30), "Press tab to go to next test", r);
+    g.DrawText(IText(30), "up/down to change the # of things", r.GetVShifted(40.f));
+    return;
+  }
+
+  bool dir = false;
+  const float thickness = 5.f;
+  const float roundness = 5.f;
+
+  for (int i=0; i<numberOfThings; i++)
+  {
+    IRECT rr = r.GetRandomSubRect();
+    IColor rc = IColor::GetRandomColor();
+    IBlend rb = {};
+    float rrad1 = static_cast<float>(std::rand() % 360);
+    float rrad2 = static_cast<float>(std::rand() % 360);
+
+    switch (kindOfThing)
+    {
+      case 1:  g.DrawRect(rc, rr, &rb); break;
+      case 2:  g.FillRect(rc, rr, &rb); break;
+      case 3:  g.DrawRoundRect(rc, rr, roundness, &rb); break;
+      case 4:  g.FillRoundRect(rc, rr, roundness, &rb); break;
+      case 5:  g.DrawEllipse(rc, rr, &rb); break;
+      case 6:  g.FillEllipse(rc, rr, &rb); break;
+      case 7:  g.DrawArc(rc, rr.MW(), rr.MH(), rr.W() > rr.H() ? rr.H() : rr.W(), rrad1, rrad2, &rb,thickness); break;
+      case 8:  g.FillArc(rc, rr.MW(), rr.MH(), rr.W() > rr.H() ? rr.H() : rr.W(), rrad1, rrad2, &rb); break;
+      case 9:  g.DrawLine(rc, dir == 0 ? rr.L : rr.R, rr.B, dir == 0 ? rr.R : rr.L, rr.T, &rb,thickness); break;
+      case 10: g.DrawDottedLine(rc, dir == 0 ? rr.L : rr.R, rr.B, dir == 0 ? rr.R : rr.L, rr.T, &rb, thickness); break;
+      case 11: g.DrawFittedBitmap(smiley, rr, &rb); break;
+      case 12: g.DrawSVG(tiger, rr); break;
+      default:
+        break;
+    }
+
+    dir = !dir;
+  }
+}
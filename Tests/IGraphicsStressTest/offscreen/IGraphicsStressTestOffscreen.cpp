@@ -0,0 +1,326 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Offscreen benchmark and golden-image test for the IGraphicsStressTest scenes.
+ * Renders every scene with the headless IGraphicsLinux platform (IGRAPHICS_SKIA + IGRAPHICS_CPU), reports frame times,
+ * and compares one seeded frame per scene against the reference images in golden/.
+ *
+ * Usage: IGraphicsStressTestOffscreen [options]
+ *   --frames N          Timed frames per scene (default 100)
+ *   --things N          Number of things drawn per frame (default 64)
+ *   --golden DIR        Folder holding the reference images (default golden/ next to this file)
+ *   --update-golden     Write the reference images instead of comparing against them
+ *   --tolerance N       Per-channel difference below which pixels are considered equal (default 2)
+ *   --max-diff F        Fraction of pixels allowed to differ before a scene fails (default 0.001)
+ *   --max-median-ms F   Fail scenes whose median frame time is above this (default: no limit)
+ *   --csv FILE          Also write the frame time statistics as CSV
+ *
+ * Returns 0 if all scenes pass, 1 otherwise
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+#include "IGraphics_include_in_plug_hdr.h"
+#include "IGraphics_include_in_plug_src.h"
+#include "IGraphicsEditorDelegate.h"
+#include "IControls.h"
+
+#include "IGraphicsStressTestScenes.h"
+
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+
+#ifndef STRESS_TEST_ROOT
+  #define STRESS_TEST_ROOT ".."
+#endif
+
+static constexpr unsigned int kGoldenSeed = 1234;
+
+struct Options
+{
+  int frames = 100;
+  int things = 64;
+  std::string goldenDir = STRESS_TEST_ROOT "/offscreen/golden";
+  bool updateGolden = false;
+  int tolerance = 2;
+  double maxDiff = 0.001;
+  double maxMedianMs = 0.;
+  std::string csvPath;
+};
+
+struct FrameStats
+{
+  double mean = 0.;
+  double median = 0.;
+  double p95 = 0.;
+  double min = 0.;
+  double max = 0.;
+};
+
+/** Hosts the stress test scenes in an IGraphicsLinux context, without a plug-in */
+class StressTestDelegate final : public IGEditorDelegate
+{
+public:
+  StressTestDelegate()
+  : IGEditorDelegate(0)
+  {
+  }
+
+  IGraphics* CreateGraphics() override
+  {
+    IGraphics* pGraphics = MakeGraphics(*this, PLUG_WIDTH, PLUG_HEIGHT, PLUG_FPS);
+    pGraphics->SetSharedResourcesSubPath(STRESS_TEST_ROOT);
+    return pGraphics;
+  }
+
+  void LayoutUI(IGraphics* pGraphics) override
+  {
+    const IRECT bounds = pGraphics->GetBounds();
+
+    pGraphics->LoadFont("Roboto-Regular", ROBOTO_FN);
+    pGraphics->AttachPanelBackground(COLOR_GRAY);
+
+    mSmiley = pGraphics->LoadBitmap(SMILEY_FN);
+    mTiger = pGraphics->LoadSVG(TIGER_FN);
+
+    pGraphics->AttachControl(new ILambdaControl(bounds.GetReducedFromBottom(50.f), [&](ILambdaControl* pCaller, IGraphics& g, IRECT& r) {
+      DrawStressTestScene(g, r, mKindOfThing, mNumberOfThings, mSmiley, mTiger);
+    }));
+  }
+
+  IGraphicsLinux* GetOffscreenUI() { return static_cast<IGraphicsLinux*>(GetUI()); }
+
+  int mKindOfThing = 0;
+  int mNumberOfThings = 0;
+
+private:
+  IBitmap mSmiley;
+  ISVG mTiger {nullptr};
+};
+
+static FrameStats GetStats(std::vector<double>& times)
+{
+  FrameStats stats;
+
+  if (times.empty())
+    return stats;
+
+  std::sort(times.begin(), times.end());
+
+  double sum = 0.;
+  for (auto t : times)
+    sum += t;
+
+  stats.mean = sum / times.size();
+  stats.median = times[times.size() / 2];
+  stats.p95 = times[std::min(times.size() - 1, (times.size() * 95) / 100)];
+  stats.min = times.front();
+  stats.max = times.back();
+
+  return stats;
+}
+
+static bool LoadPNG(const char* path, RawBitmapData& data, int& width, int& height)
+{
+  sk_sp<SkData> encoded = SkData::MakeFromFileName(path);
+
+  if (!encoded)
+    return false;
+
+  sk_sp<SkImage> image = SkImages::DeferredFromEncodedData(encoded);
+
+  if (!image)
+    return false;
+
+  const SkImageInfo info = SkImageInfo::Make(image->width(), image->height(), kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+
+  width = image->width();
+  height = image->height();
+  data.Resize(static_cast<int>(info.computeMinByteSize()), false);
+
+  return image->readPixels(nullptr, info, data.Get(), info.minRowBytes(), 0, 0);
+}
+
+/** @return The fraction of pixels that differ by more than tolerance in any channel, or 1 if the sizes don't match */
+static double ComparePixels(const RawBitmapData& a, const RawBitmapData& b, int tolerance)
+{
+  if (a.GetSize() != b.GetSize() || !a.GetSize())
+    return 1.;
+
+  const int nPixels = a.GetSize() / 4;
+  const uint8_t* pA = a.Get();
+  const uint8_t* pB = b.Get();
+  int nDiffering = 0;
+
+  for (int i = 0; i < nPixels; i++, pA += 4, pB += 4)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      if (std::abs(pA[c] - pB[c]) > tolerance)
+      {
+        nDiffering++;
+        break;
+      }
+    }
+  }
+
+  return static_cast<double>(nDiffering) / nPixels;
+}
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--frames") && hasValue) options.frames = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--things") && hasValue) options.things = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--golden") && hasValue) options.goldenDir = argv[++i];
+    else if (!strcmp(arg, "--update-golden")) options.updateGolden = true;
+    else if (!strcmp(arg, "--tolerance") && hasValue) options.tolerance = atoi(argv[++i]);
+    else if (!strcmp(arg, "--max-diff") && hasValue) options.maxDiff = atof(argv[++i]);
+    else if (!strcmp(arg, "--max-median-ms") && hasValue) options.maxMedianMs = atof(argv[++i]);
+    else if (!strcmp(arg, "--csv") && hasValue) options.csvPath = argv[++i];
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  StressTestDelegate delegate;
+  delegate.OpenWindow(nullptr);
+  IGraphicsLinux* pGraphics = delegate.GetOffscreenUI();
+
+  if (!pGraphics)
+  {
+    fprintf(stderr, "Could not create the offscreen graphics context\n");
+    return 1;
+  }
+
+  FILE* pCSV = options.csvPath.empty() ? nullptr : fopen(options.csvPath.c_str(), "w");
+
+  if (pCSV)
+    fprintf(pCSV, "scene,things,frames,mean_ms,median_ms,p95_ms,min_ms,max_ms\n");
+
+  printf("%-18s %8s %8s %8s %8s %8s  %s\n", "scene", "mean", "median", "p95", "min", "max", "golden");
+
+  int nFailed = 0;
+  std::vector<double> times;
+  times.reserve(options.frames);
+
+  for (int scene = 0; scene < kNumStressTestScenes; scene++)
+  {
+    const char* sceneName = kStressTestSceneNames[scene];
+    delegate.mKindOfThing = scene;
+    delegate.mNumberOfThings = options.things;
+
+    // Golden frame: seeded, so that the same things are drawn on every run
+    std::srand(kGoldenSeed + scene);
+    pGraphics->RenderFrame(true);
+
+    std::string goldenPath = options.goldenDir + "/" + sceneName + ".png";
+    std::string goldenResult;
+    bool passed = true;
+
+    if (options.updateGolden)
+    {
+      passed = pGraphics->SaveSurfacePNG(goldenPath.c_str());
+      goldenResult = passed ? "updated" : "could not write " + goldenPath;
+    }
+    else
+    {
+      RawBitmapData actual, expected;
+      int w = 0, h = 0, expectedW = 0, expectedH = 0;
+
+      pGraphics->GetSurfacePixels(actual, w, h);
+
+      if (!LoadPNG(goldenPath.c_str(), expected, expectedW, expectedH))
+      {
+        passed = false;
+        goldenResult = "missing, run with --update-golden";
+      }
+      else
+      {
+        const double diff = (w == expectedW && h == expectedH) ? ComparePixels(actual, expected, options.tolerance) : 1.;
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.4f%% differ", diff * 100.);
+        goldenResult = buf;
+
+        if (diff > options.maxDiff)
+        {
+          passed = false;
+          std::string actualPath = options.goldenDir + "/" + sceneName + "-actual.png";
+          pGraphics->SaveSurfacePNG(actualPath.c_str());
+          goldenResult += ", FAILED (see " + actualPath + ")";
+        }
+      }
+    }
+
+    // Timed frames: every control redrawn, as when the stress test animates
+    for (int i = 0; i < 3; i++)
+      pGraphics->RenderFrame(true);
+
+    times.clear();
+
+    for (int i = 0; i < options.frames; i++)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      pGraphics->RenderFrame(true);
+      const auto end = std::chrono::steady_clock::now();
+      times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    const FrameStats stats = GetStats(times);
+
+    if (options.maxMedianMs > 0. && stats.median > options.maxMedianMs)
+    {
+      passed = false;
+      goldenResult += ", TOO SLOW";
+    }
+
+    printf("%-18s %8.3f %8.3f %8.3f %8.3f %8.3f  %s\n", sceneName, stats.mean, stats.median, stats.p95, stats.min, stats.max, goldenResult.c_str());
+
+    if (pCSV)
+      fprintf(pCSV, "%s,%i,%i,%f,%f,%f,%f,%f\n", sceneName, options.things, options.frames, stats.mean, stats.median, stats.p95, stats.min, stats.max);
+
+    if (!passed)
+      nFailed++;
+  }
+
+  if (pCSV)
+    fclose(pCSV);
+
+  delegate.CloseWindow();
+
+  printf("%i/%i scenes passed\n", kNumStressTestScenes - nFailed, kNumStressTestScenes);
+
+  return nFailed ? 1 : 0;
+}
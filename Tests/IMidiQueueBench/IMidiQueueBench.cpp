@@ -0,0 +1,224 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Microbenchmark for IMidiQueue, merging MIDI from several sources per block, as when host, editor and
+ * internally generated MIDI are combined. Each source adds its messages in order, either all at once (bursts)
+ * or taking turns with the other sources (interleaved), so most messages arrive out of order with respect to the queue.
+ * The queue is compared with the previous implementation, which kept the queue sorted with an insertion per message.
+ *
+ * Usage: IMidiQueueBench [options]
+ *   --blocks N          Number of blocks to process (default 20000)
+ *   --block-size N      Block size in samples (default 512)
+ *   --sources N         Number of interleaved sources (default 3)
+ *   --events N          Messages per source per block (default 64)
+ *
+ * Returns 0 if both queues deliver the same messages in the same order, 1 otherwise
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "IPlugMidi.h"
+
+using namespace iplug;
+
+static constexpr int kNumRuns = 5;
+
+struct Options
+{
+  int blocks = 20000;
+  int blockSize = 512;
+  int sources = 3;
+  int events = 64;
+};
+
+/** The previous IMidiQueue insertion strategy: backward scan and memmove for every out of order message */
+class LegacyMidiQueue
+{
+public:
+  LegacyMidiQueue(int size) { mBuf.resize(size); }
+
+  void Add(const IMidiMsg& msg)
+  {
+    if (mBack >= static_cast<int>(mBuf.size()))
+      mBuf.resize(mBuf.size() * 2);
+
+    if (mBack > 0 && msg.mOffset < mBuf[mBack - 1].mOffset)
+    {
+      int i = mBack - 2;
+      while (i >= 0 && msg.mOffset < mBuf[i].mOffset) --i;
+      i++;
+      memmove(&mBuf[i + 1], &mBuf[i], (mBack - i) * sizeof(IMidiMsg));
+      mBuf[i] = msg;
+    }
+    else
+      mBuf[mBack] = msg;
+
+    ++mBack;
+  }
+
+  bool Empty() const { return mFront == mBack; }
+  IMidiMsg& Peek() { return mBuf[mFront]; }
+  void Remove() { ++mFront; }
+  void Flush() { mFront = mBack = 0; }
+
+private:
+  std::vector<IMidiMsg> mBuf;
+  int mFront = 0, mBack = 0;
+};
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--blocks") && hasValue) options.blocks = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--block-size") && hasValue) options.blockSize = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--sources") && hasValue) options.sources = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--events") && hasValue) options.events = std::max(1, atoi(argv[++i]));
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** Builds the messages of one block, source after source, each source in order of offset */
+static void MakeBlock(const Options& options, std::vector<IMidiMsg>& msgs)
+{
+  msgs.clear();
+
+  for (int source = 0; source < options.sources; source++)
+  {
+    std::vector<int> offsets(options.events);
+
+    for (auto& offset : offsets)
+      offset = rand() % options.blockSize;
+
+    std::sort(offsets.begin(), offsets.end());
+
+    for (int i = 0; i < options.events; i++)
+    {
+      IMidiMsg msg;
+      msg.MakeNoteOnMsg(i & 127, source + 1, offsets[i], source);
+      msgs.push_back(msg);
+    }
+  }
+}
+
+/** Interleaves the sources, as if they were added by different callbacks during the block */
+static void Interleave(const Options& options, const std::vector<IMidiMsg>& src, std::vector<IMidiMsg>& dst)
+{
+  dst.clear();
+
+  for (int i = 0; i < options.events; i++)
+  {
+    for (int source = 0; source < options.sources; source++)
+      dst.push_back(src[source * options.events + i]);
+  }
+}
+
+template <class Q, class F>
+static double RunBlocks(Q& queue, const std::vector<std::vector<IMidiMsg>>& blocks, int nBlocks, F&& flush, uint32_t& checksum)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  for (int b = 0; b < nBlocks; b++)
+  {
+    const auto& block = blocks[b % blocks.size()];
+
+    for (const auto& msg : block)
+      queue.Add(msg);
+
+    while (!queue.Empty())
+    {
+      const IMidiMsg& msg = queue.Peek();
+      checksum = checksum * 31 + static_cast<uint32_t>(msg.mOffset * 1024 + msg.mStatus * 4 + msg.mData1);
+      queue.Remove();
+    }
+
+    flush(queue);
+  }
+
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  const int perBlock = options.sources * options.events;
+  const double nMsgs = static_cast<double>(options.blocks) * perBlock;
+
+  srand(1234);
+
+  // Pregenerate a set of blocks that fits in the cache, so that only the queues are timed
+  std::vector<std::vector<IMidiMsg>> bursts(std::min(options.blocks, 64));
+  std::vector<std::vector<IMidiMsg>> interleaved(bursts.size());
+
+  for (size_t i = 0; i < bursts.size(); i++)
+  {
+    MakeBlock(options, bursts[i]);
+    Interleave(options, bursts[i], interleaved[i]);
+  }
+
+  printf("%i blocks of %i samples, %i sources x %i messages per block\n", options.blocks, options.blockSize, options.sources, options.events);
+  printf("%-12s %14s %14s %8s\n", "sources", "IMidiQueue", "insertion", "speedup");
+
+  int nFailed = 0;
+
+  for (int arrangement = 0; arrangement < 2; arrangement++)
+  {
+    // Bursts: each source adds all of its messages at once (host, then editor, then generators),
+    // interleaved: the sources take turns
+    const auto& blocks = arrangement ? interleaved : bursts;
+
+    IMidiQueue queue(perBlock);
+    LegacyMidiQueue legacy(perBlock);
+    uint32_t checksum = 0, legacyChecksum = 0;
+
+    // Warm up both
+    RunBlocks(queue, blocks, options.blocks, [&](IMidiQueue& q) { q.Flush(options.blockSize); }, checksum);
+    RunBlocks(legacy, blocks, options.blocks, [](LegacyMidiQueue& q) { q.Flush(); }, legacyChecksum);
+
+    // Best of a few runs, alternating between the queues, so that other load on the machine affects both alike
+    double ms = 1e9, legacyMs = 1e9;
+
+    for (int run = 0; run < kNumRuns; run++)
+    {
+      checksum = legacyChecksum = 0;
+      ms = std::min(ms, RunBlocks(queue, blocks, options.blocks, [&](IMidiQueue& q) { q.Flush(options.blockSize); }, checksum));
+      legacyMs = std::min(legacyMs, RunBlocks(legacy, blocks, options.blocks, [](LegacyMidiQueue& q) { q.Flush(); }, legacyChecksum));
+    }
+
+    printf("%-12s %8.2f ns/msg %8.2f ns/msg %7.2fx\n", arrangement ? "interleaved" : "bursts", ms * 1e6 / nMsgs, legacyMs * 1e6 / nMsgs, legacyMs / ms);
+
+    if (checksum != legacyChecksum || queue.NumDropped())
+    {
+      printf("FAILED: the queues delivered different messages (%i dropped)\n", queue.NumDropped());
+      nFailed++;
+    }
+  }
+
+  return nFailed ? 1 : 0;
+}
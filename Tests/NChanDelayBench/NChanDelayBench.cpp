@@ -0,0 +1,267 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Microbenchmark for NChanModDelayLine, compared with NChanDelayLine, which it replaces for latency compensation.
+ * Checks that integer delays are identical to NChanDelayLine, and that the fractional interpolators delay a sine accurately,
+ * then times fixed and modulated reads with each interpolator.
+ *
+ * Usage: NChanDelayBench [options]
+ *   --blocks N          Number of blocks to process (default 20000)
+ *   --block-size N      Block size in samples (default 512)
+ *   --channels N        Number of channels (default 2)
+ *   --delay N           Delay time in samples (default 1000)
+ *
+ * Returns 0 if the checks pass, 1 otherwise
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "NChanDelay.h"
+
+using namespace iplug;
+
+using Delay = NChanModDelayLine<double>;
+using EInterp = Delay::EInterp;
+
+struct Options
+{
+  int blocks = 20000;
+  int blockSize = 512;
+  int channels = 2;
+  int delay = 1000;
+};
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--blocks") && hasValue) options.blocks = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--block-size") && hasValue) options.blockSize = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--channels") && hasValue) options.channels = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--delay") && hasValue) options.delay = std::max(1, atoi(argv[++i]));
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** Multichannel buffers, with the pointer arrays that the delays take */
+struct Buffers
+{
+  Buffers(int nChans, int nFrames)
+  : mData(nChans, std::vector<double>(nFrames))
+  , mPtrs(nChans)
+  {
+    for (int c = 0; c < nChans; c++)
+      mPtrs[c] = mData[c].data();
+  }
+
+  std::vector<std::vector<double>> mData;
+  std::vector<double*> mPtrs;
+};
+
+static void FillNoise(Buffers& buffers)
+{
+  for (auto& chan : buffers.mData)
+    for (auto& x : chan)
+      x = static_cast<double>(rand()) / RAND_MAX * 2. - 1.;
+}
+
+static const char* GetName(EInterp interp)
+{
+  switch (interp)
+  {
+    case EInterp::None: return "none";
+    case EInterp::Linear: return "linear";
+    case EInterp::Lagrange: return "lagrange";
+    default: return "allpass";
+  }
+}
+
+/** @return The largest difference between NChanDelayLine and NChanModDelayLine without interpolation */
+static double CompareWithLegacy(const Options& options)
+{
+  NChanDelayLine<double> legacy(options.channels, options.channels);
+  legacy.SetDelayTime(options.delay);
+  Delay delay(options.channels, EInterp::None);
+  delay.Allocate(options.delay, options.blockSize);
+
+  Buffers in(options.channels, options.blockSize), out(options.channels, options.blockSize), legacyOut(options.channels, options.blockSize);
+  double maxDiff = 0.;
+
+  for (int b = 0; b < 64; b++)
+  {
+    FillNoise(in);
+    legacy.ProcessBlock(in.mPtrs.data(), legacyOut.mPtrs.data(), options.blockSize);
+    delay.ProcessBlock(in.mPtrs.data(), out.mPtrs.data(), options.blockSize, options.delay);
+
+    for (int c = 0; c < options.channels; c++)
+      for (int s = 0; s < options.blockSize; s++)
+        maxDiff = std::max(maxDiff, std::fabs(out.mData[c][s] - legacyOut.mData[c][s]));
+  }
+
+  return maxDiff;
+}
+
+/** @return The largest error delaying a sine at a tenth of the sample rate by a fractional delay, either fixed or modulated */
+static double MeasureSineError(const Options& options, EInterp interp, bool modulated)
+{
+  const double w = 2. * 3.14159265358979323846 * 0.1;
+  const double baseDelay = options.delay + 0.37;
+  Delay delay(1, interp);
+  delay.Allocate(options.delay + 16, options.blockSize);
+
+  Buffers in(1, options.blockSize), out(1, options.blockSize);
+  std::vector<double> delays(options.blockSize);
+  double maxError = 0.;
+  int n = 0;
+
+  for (int b = 0; b < 64 + options.delay / options.blockSize; b++)
+  {
+    for (int s = 0; s < options.blockSize; s++)
+    {
+      in.mData[0][s] = std::sin(w * (n + s));
+      delays[s] = modulated ? baseDelay + 4. * std::sin(0.001 * (n + s)) : baseDelay;
+    }
+
+    delay.Write(in.mPtrs.data(), options.blockSize);
+
+    if (modulated)
+      delay.ReadModulated(out.mPtrs.data(), delays.data(), options.blockSize);
+    else
+      delay.Read(out.mPtrs.data(), options.blockSize, baseDelay);
+
+    for (int s = 0; s < options.blockSize; s++, n++)
+    {
+      if (n > options.delay + 64) // after the delay has filled and the all-pass has settled
+        maxError = std::max(maxError, std::fabs(out.mData[0][s] - std::sin(w * (n - delays[s]))));
+    }
+  }
+
+  return maxError;
+}
+
+template <class F>
+static double Time(int nBlocks, F&& process)
+{
+  process(); // warm up
+  const auto start = std::chrono::steady_clock::now();
+
+  for (int b = 0; b < nBlocks; b++)
+    process();
+
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  srand(1234);
+
+  int nFailed = 0;
+
+  const double legacyDiff = CompareWithLegacy(options);
+  printf("integer delay vs NChanDelayLine: max difference %g\n", legacyDiff);
+
+  if (legacyDiff != 0.)
+  {
+    printf("FAILED: the output is different to NChanDelayLine\n");
+    nFailed++;
+  }
+
+  // The worst case errors for a sine at 0.1 fs, with a small margin
+  const double maxErrors[] = { 0.6, 0.06, 0.01, 0.05 };
+
+  printf("%-12s %14s %14s\n", "sine error", "fixed", "modulated");
+
+  for (auto interp : { EInterp::Linear, EInterp::Lagrange, EInterp::Allpass })
+  {
+    const double fixed = MeasureSineError(options, interp, false);
+    const double modulated = MeasureSineError(options, interp, true);
+    printf("%-12s %14.6f %14.6f\n", GetName(interp), fixed, modulated);
+
+    if (fixed > maxErrors[static_cast<int>(interp)] || modulated > maxErrors[static_cast<int>(interp)])
+    {
+      printf("FAILED: the %s interpolator is inaccurate\n", GetName(interp));
+      nFailed++;
+    }
+  }
+
+  // Noise that fits in the cache, so that only the delays are timed
+  Buffers in(options.channels, options.blockSize), out(options.channels, options.blockSize);
+  FillNoise(in);
+  std::vector<double> delays(options.blockSize);
+
+  for (int s = 0; s < options.blockSize; s++)
+    delays[s] = options.delay + 8. * std::sin(s * 0.01);
+
+  const double nSamples = static_cast<double>(options.blocks) * options.blockSize * options.channels;
+
+  printf("%i blocks of %i samples, %i channels, delay %i\n", options.blocks, options.blockSize, options.channels, options.delay);
+  printf("%-24s %14s %8s\n", "", "time", "speedup");
+
+  NChanDelayLine<double> legacy(options.channels, options.channels);
+  legacy.SetDelayTime(options.delay);
+  const double legacyMs = Time(options.blocks, [&]() { legacy.ProcessBlock(in.mPtrs.data(), out.mPtrs.data(), options.blockSize); });
+  printf("%-24s %8.3f ns/smp\n", "NChanDelayLine", legacyMs * 1e6 / nSamples);
+
+  for (auto interp : { EInterp::None, EInterp::Linear, EInterp::Lagrange, EInterp::Allpass })
+  {
+    Delay delay(options.channels, interp);
+    delay.Allocate(options.delay + 16, options.blockSize);
+
+    char name[64];
+    snprintf(name, sizeof(name), "fixed %s", GetName(interp));
+    const double fractionalDelay = interp == EInterp::None ? options.delay : options.delay + 0.37;
+
+    const double ms = Time(options.blocks, [&]() {
+      delay.Write(in.mPtrs.data(), options.blockSize);
+      delay.Read(out.mPtrs.data(), options.blockSize, fractionalDelay);
+    });
+
+    printf("%-24s %8.3f ns/smp %7.2fx\n", name, ms * 1e6 / nSamples, legacyMs / ms);
+  }
+
+  for (auto interp : { EInterp::Linear, EInterp::Lagrange, EInterp::Allpass })
+  {
+    Delay delay(options.channels, interp);
+    delay.Allocate(options.delay + 16, options.blockSize);
+
+    char name[64];
+    snprintf(name, sizeof(name), "modulated %s", GetName(interp));
+
+    const double ms = Time(options.blocks, [&]() {
+      delay.Write(in.mPtrs.data(), options.blockSize);
+      delay.ReadModulated(out.mPtrs.data(), delays.data(), options.blockSize);
+    });
+
+    printf("%-24s %8.3f ns/smp %7.2fx\n", name, ms * 1e6 / nSamples, legacyMs / ms);
+  }
+
+  return nFailed ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Loopback benchmark for OSCReceiverThread.
+ * Sends OSC messages and bundles to 127.0.0.1 as fast as possible, consumes the events on a simulated audio thread with
+ * ProcessEvents(), and reports throughput, drops and the latency from send to delivery.
+ *
+ * Usage: OSCLoopbackBench [options]
+ *   --port N            UDP port to use (default 9123)
+ *   --messages N        Number of messages to send (default 200000)
+ *   --addresses N       Number of addresses in the address space (default 256)
+ *   --bundle N          Messages per bundle, 1 sends plain messages (default 8)
+ *   --rate N            Messages per second to send, 0 for as fast as possible (default 0)
+ *   --block N           Block size of the simulated audio thread (default 64)
+ *
+ * Returns 0 if every message was delivered to the right address, 1 otherwise
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "IPlugOSC_thread.h"
+
+using namespace iplug;
+
+static constexpr double kSampleRate = 48000.;
+
+struct Options
+{
+  int port = 9123;
+  int messages = 200000;
+  int addresses = 256;
+  int bundle = 8;
+  int rate = 0;
+  int block = 64;
+};
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--port") && hasValue) options.port = atoi(argv[++i]);
+    else if (!strcmp(arg, "--messages") && hasValue) options.messages = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--addresses") && hasValue) options.addresses = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--bundle") && hasValue) options.bundle = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--rate") && hasValue) options.rate = std::max(0, atoi(argv[++i]));
+    else if (!strcmp(arg, "--block") && hasValue) options.block = std::max(1, atoi(argv[++i]));
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void GetAddress(int idx, char* buf, int bufSize)
+{
+  snprintf(buf, bufSize, "/bench/%i/param/%i", idx / 16, idx % 16);
+}
+
+static double Percentile(std::vector<double>& sorted, int percent)
+{
+  return sorted.empty() ? 0. : sorted[std::min(sorted.size() - 1, (sorted.size() * percent) / 100)];
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  OSCReceiverThread receiver(8192);
+
+  for (int i = 0; i < options.addresses; i++)
+  {
+    char address[64];
+    GetAddress(i, address, sizeof(address));
+    receiver.AddAddress(address);
+  }
+
+  WDL_String log;
+
+  if (!receiver.Start(options.port, log))
+  {
+    fprintf(stderr, "%s", log.Get());
+    return 1;
+  }
+
+  // Send times, indexed by the sequence number sent as the first argument
+  std::vector<double> sendTimes(options.messages, 0.);
+  std::vector<double> latencies;
+  latencies.reserve(options.messages);
+
+  std::atomic<bool> sending {true};
+  int nDelivered = 0, nMisrouted = 0;
+
+  // Simulated audio thread: consumes events once per block, at the pace of a real device
+  std::thread audioThread([&]() {
+    const auto blockDuration = std::chrono::duration<double>(options.block / kSampleRate);
+    auto nextBlock = std::chrono::steady_clock::now();
+    double lastEvent = OSCReceiverThread::Now();
+
+    while (sending || OSCReceiverThread::Now() - lastEvent < 0.5)
+    {
+      receiver.ProcessEvents(options.block, kSampleRate, [&](int offset, const OSCEvent& event) {
+        const int seq = static_cast<int>(event.mArgs[0]);
+        const int addressIdx = static_cast<int>(event.mArgs[1]);
+
+        if (event.mNumArgs != 2 || seq < 0 || seq >= options.messages || event.mAddressID != addressIdx)
+        {
+          nMisrouted++;
+          return;
+        }
+
+        // Latency to the start of the block that renders the event, plus its offset within the block
+        latencies.push_back((OSCReceiverThread::Now() - sendTimes[seq]) * 1000. + offset * 1000. / kSampleRate);
+        nDelivered++;
+        lastEvent = OSCReceiverThread::Now();
+      });
+
+      nextBlock += std::chrono::duration_cast<std::chrono::steady_clock::duration>(blockDuration);
+      std::this_thread::sleep_until(nextBlock);
+    }
+  });
+
+  JNL::open_socketlib();
+  SOCKET sendSocket = socket(AF_INET, SOCK_DGRAM, 0);
+
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dest.sin_port = htons(options.port);
+
+  WDL_Queue bundle;
+  const double sendStart = OSCReceiverThread::Now();
+
+  for (int seq = 0; seq < options.messages; )
+  {
+    bundle.Clear();
+
+    const int nInBundle = std::min(options.bundle, options.messages - seq);
+
+    if (options.bundle > 1)
+    {
+      bundle.Add("#bundle", 8);
+      const unsigned char immediately[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+      bundle.Add(immediately, 8);
+    }
+
+    for (int i = 0; i < nInBundle; i++, seq++)
+    {
+      const int addressIdx = seq % options.addresses;
+      char address[64];
+      GetAddress(addressIdx, address, sizeof(address));
+
+      OscMessageWrite msg;
+      msg.PushWord(address);
+      msg.PushIntArg(seq);
+      msg.PushIntArg(addressIdx);
+
+      int len = 0;
+      const char* pData = msg.GetBuffer(&len);
+
+      if (options.bundle > 1)
+      {
+        const unsigned char size[4] = {(unsigned char)(len >> 24), (unsigned char)(len >> 16), (unsigned char)(len >> 8), (unsigned char)len};
+        bundle.Add(size, 4);
+      }
+
+      bundle.Add(pData, len);
+      sendTimes[seq] = OSCReceiverThread::Now();
+    }
+
+    sendto(sendSocket, (const char*) bundle.Get(), bundle.Available(), 0, (struct sockaddr*) &dest, sizeof(dest));
+
+    if (options.rate > 0)
+    {
+      const double due = sendStart + static_cast<double>(seq) / options.rate;
+      while (OSCReceiverThread::Now() < due)
+        std::this_thread::yield();
+    }
+  }
+
+  const double sendDuration = OSCReceiverThread::Now() - sendStart;
+  sending = false;
+  audioThread.join();
+  receiver.Stop();
+  closesocket(sendSocket);
+
+  std::sort(latencies.begin(), latencies.end());
+
+  const uint64_t nReceived = receiver.NumMessagesReceived();
+  const uint64_t nDropped = receiver.NumEventsDropped();
+
+  printf("sent       %i messages in %.3f s (%.0f msgs/s, %i per datagram)\n", options.messages, sendDuration, options.messages / sendDuration, options.bundle);
+  printf("received   %llu messages, %i delivered, %llu dropped by the queue, %i lost by the network\n",
+         (unsigned long long) nReceived, nDelivered, (unsigned long long) nDropped, options.messages - static_cast<int>(nReceived));
+  printf("latency    p50 %.3f ms, p99 %.3f ms, max %.3f ms (block %i @ %.0f Hz)\n",
+         Percentile(latencies, 50), Percentile(latencies, 99), latencies.empty() ? 0. : latencies.back(), options.block, kSampleRate);
+
+  if (nMisrouted)
+    printf("FAILED     %i events had the wrong address or arguments\n", nMisrouted);
+
+  return (nMisrouted || !nDelivered) ? 1 : 0;
+}
@@ -0,0 +1,408 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Test for persistent graphics contexts (IGEditorDelegate::SetPersistentGraphics()) with IGraphicsNanoVG on OpenGL 2.
+ * Renders a UI into a headless EGL pbuffer, then closes and reopens the window several times, each time with a new GL context,
+ * and checks that every frame matches the first one. The UI draws a bitmap loaded from memory whose buffer is freed straight
+ * after loading, a bitmap that was drawn into a framebuffer by ScaleBitmap(), and text in a font loaded from memory.
+ * Run with SANITIZE=1 to check the bitmaps and fonts with AddressSanitizer.
+ *
+ * Needs an EGL implementation with EGL_MESA_platform_surfaceless (e.g. Mesa's llvmpipe), no display is required.
+ *
+ * Usage: PersistentGraphicsTest
+ *
+ * Returns 0 if the checks pass, 1 otherwise
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "IGraphics_select.h"
+#include "IGraphicsEditorDelegate.h"
+#include "IControls.h"
+
+#ifndef TEST_RESOURCES_PATH
+  #define TEST_RESOURCES_PATH "../IGraphicsTest/resources"
+#endif
+
+using namespace iplug;
+using namespace igraphics;
+
+static constexpr int kWidth = 200;
+static constexpr int kHeight = 100;
+static constexpr int kNumReopens = 3;
+static constexpr int kTolerance = 2;
+
+static int sNumFailed = 0;
+
+static void Check(bool condition, const char* description)
+{
+  if (!condition)
+  {
+    printf("FAILED: %s\n", description);
+    sNumFailed++;
+  }
+}
+
+static bool ReadFile(const char* path, std::vector<uint8_t>& data)
+{
+  FILE* fp = fopen(path, "rb");
+
+  if (!fp)
+    return false;
+
+  fseek(fp, 0, SEEK_END);
+  data.resize(ftell(fp));
+  fseek(fp, 0, SEEK_SET);
+  const bool ok = fread(data.data(), 1, data.size(), fp) == data.size();
+  fclose(fp);
+  return ok && data.size();
+}
+
+/** A headless IGraphics platform, which renders with IGraphicsNanoVG into an EGL pbuffer.
+ * Every time the window opens, a new GL context is created, as when a host opens a plug-in editor in a new window */
+class EGLGraphics final : public IGraphicsNanoVG
+{
+  class MemoryFont : public PlatformFont
+  {
+  public:
+    MemoryFont(const void* pData, int dataSize)
+    : PlatformFont(false)
+    {
+      mData.Set((const uint8_t*) pData, dataSize);
+    }
+
+    IFontDataPtr GetFontData() override
+    {
+      return IFontDataPtr(new IFontData(mData.Get(), mData.GetSize(), 0));
+    }
+
+  private:
+    WDL_TypedBuf<uint8_t> mData;
+  };
+
+public:
+  EGLGraphics(IGEditorDelegate& dlg, int w, int h)
+  : IGraphicsNanoVG(dlg, w, h, 60, 1.f)
+  {
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (getPlatformDisplay)
+      mDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+    if (mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, nullptr, nullptr))
+      return;
+
+    const EGLint configAttribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+      EGL_STENCIL_SIZE, 8,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_NONE
+    };
+
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, w, EGL_HEIGHT, h, EGL_NONE };
+
+    EGLint nConfigs = 0;
+
+    if (eglChooseConfig(mDisplay, configAttribs, &mConfig, 1, &nConfigs) && nConfigs == 1)
+    {
+      mSurface = eglCreatePbufferSurface(mDisplay, mConfig, surfaceAttribs);
+      eglBindAPI(EGL_OPENGL_API);
+    }
+  }
+
+  ~EGLGraphics()
+  {
+    CloseWindow();
+
+    if (mSurface != EGL_NO_SURFACE)
+      eglDestroySurface(mDisplay, mSurface);
+
+    if (mDisplay != EGL_NO_DISPLAY)
+      eglTerminate(mDisplay);
+  }
+
+  bool IsAvailable() const { return mSurface != EGL_NO_SURFACE; }
+
+  void* OpenWindow(void* pParent) override
+  {
+    mContext = eglCreateContext(mDisplay, mConfig, EGL_NO_CONTEXT, nullptr);
+
+    if (mContext == EGL_NO_CONTEXT)
+      return nullptr;
+
+    ActivateGLContext();
+
+    if (!gladLoadGL())
+      return nullptr;
+
+    mWindowOpen = true;
+
+    OnViewInitialized(nullptr /* not used */);
+    SetScreenScale(1.f);
+    LayoutUIOnOpen();
+    GetDelegate()->OnUIOpen();
+
+    return GetWindow();
+  }
+
+  void CloseWindow() override
+  {
+    if (mWindowOpen)
+    {
+      ActivateGLContext();
+      OnViewDestroyed();
+      eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext(mDisplay, mContext);
+      mContext = EGL_NO_CONTEXT;
+      mWindowOpen = false;
+    }
+  }
+
+  void* GetWindow() override { return mWindowOpen ? this : nullptr; }
+  bool WindowIsOpen() override { return mWindowOpen; }
+
+  /** Draw the whole UI and read it back
+   * @param data Receives kWidth * kHeight RGBA pixels */
+  void RenderFrame(std::vector<uint8_t>& data)
+  {
+    ActivateGLContext();
+    SetAllControlsDirty();
+
+    IRECTList rects;
+
+    if (IsDirty(rects))
+    {
+      SetAllControlsClean();
+      Draw(rects);
+    }
+
+    data.assign(WindowWidth() * WindowHeight() * 4, 0);
+    glReadPixels(0, 0, WindowWidth(), WindowHeight(), GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+  }
+
+  void HideMouseCursor(bool hide, bool lock) override {}
+  void MoveMouseCursor(float x, float y) override {}
+  void GetMouseLocation(float& x, float&y) const override { x = mCursorX; y = mCursorY; }
+  EMsgBoxResult ShowMessageBox(const char* str, const char* title, EMsgBoxType type, IMsgBoxCompletionHandlerFunc completionHandler) override { return kNoResult; }
+  void ForceEndUserEdit() override {}
+  const char* GetPlatformAPIStr() override { return "EGL (offscreen)"; }
+  void UpdateTooltips() override {}
+  void PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext, IFileDialogCompletionHandlerFunc completionHandler) override {}
+  void PromptForDirectory(WDL_String& path, IFileDialogCompletionHandlerFunc completionHandler) override {}
+  bool PromptForColor(IColor& color, const char* str, IColorPickerHandlerFunc func) override { return false; }
+  bool OpenURL(const char* url, const char* msgWindowTitle, const char* confirmMsg, const char* errMsgOnFailure) override { return false; }
+  bool GetTextFromClipboard(WDL_String& str) override { return false; }
+  bool SetTextInClipboard(const char* str) override { return false; }
+
+protected:
+  void ActivateGLContext() override { eglMakeCurrent(mDisplay, mSurface, mSurface, mContext); }
+  void DeactivateGLContext() override {}
+
+  IPopupMenu* CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT bounds, bool& isAsync) override { return nullptr; }
+  void CreatePlatformTextEntry(int paramIdx, const IText& text, const IRECT& bounds, int length, const char* str) override {}
+
+private:
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fileNameOrResID) override { return nullptr; }
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style) override { return nullptr; }
+  PlatformFontPtr LoadPlatformFont(const char* fontID, void* pData, int dataSize) override { return PlatformFontPtr(new MemoryFont(pData, dataSize)); }
+  void CachePlatformFont(const char* fontID, const PlatformFontPtr& font) override {}
+
+  EGLDisplay mDisplay = EGL_NO_DISPLAY;
+  EGLConfig mConfig = nullptr;
+  EGLSurface mSurface = EGL_NO_SURFACE;
+  EGLContext mContext = EGL_NO_CONTEXT;
+  bool mWindowOpen = false;
+};
+
+/** Lays out the UI, loading everything from buffers that are freed as soon as they have been loaded */
+class TestDelegate final : public IGEditorDelegate
+{
+public:
+  TestDelegate()
+  : IGEditorDelegate(0)
+  {
+    SetPersistentGraphics(true);
+  }
+
+  IGraphics* CreateGraphics() override
+  {
+    return new EGLGraphics(*this, kWidth, kHeight);
+  }
+
+  void LayoutUI(IGraphics* pGraphics) override
+  {
+    mNumLayouts++;
+
+    std::vector<uint8_t> data;
+
+    if (ReadFile(TEST_RESOURCES_PATH "/img/smiley.png", data))
+    {
+      mSmiley = pGraphics->LoadBitmap("smiley.png", data.data(), static_cast<int>(data.size()), 1, false, 1);
+      // Loading at another scale draws the bitmap into a framebuffer
+      mSmiley2x = pGraphics->LoadBitmap("smiley.png", data.data(), static_cast<int>(data.size()), 1, false, 2);
+    }
+
+    std::fill(data.begin(), data.end(), 0);
+
+    if (ReadFile(TEST_RESOURCES_PATH "/fonts/Roboto-Regular.ttf", data))
+      mFontLoaded = pGraphics->LoadFont("Roboto-Regular", data.data(), static_cast<int>(data.size()));
+
+    std::fill(data.begin(), data.end(), 0);
+    data.clear();
+    data.shrink_to_fit();
+
+    if (mSmiley.IsValid())
+      mScaled = pGraphics->ScaleBitmap(mSmiley, "smiley-scaled", 2);
+
+    pGraphics->AttachControl(new ILambdaControl(pGraphics->GetBounds(), [&](ILambdaControl* pCaller, IGraphics& g, IRECT& r) {
+      g.FillRect(COLOR_GRAY, r);
+
+      if (mSmiley.IsValid())
+        g.DrawBitmap(mSmiley, IRECT(10, 10, 42, 42), 0, 0);
+
+      if (mSmiley2x.IsValid())
+        g.DrawBitmap(mSmiley2x, IRECT(50, 10, 82, 42), 0, 0);
+
+      if (mScaled.IsValid())
+        g.DrawBitmap(mScaled, IRECT(90, 10, 122, 42), 0, 0);
+
+      if (mFontLoaded)
+        g.DrawText(IText(20.f, COLOR_WHITE, "Roboto-Regular"), "Persistent", IRECT(0, 50, kWidth, kHeight));
+    }));
+  }
+
+  void BeginInformHostOfParamChangeFromUI(int paramIdx) override {}
+  void EndInformHostOfParamChangeFromUI(int paramIdx) override {}
+
+  EGLGraphics* GetEGLUI() { return static_cast<EGLGraphics*>(GetUI()); }
+
+  IBitmap mSmiley;
+  IBitmap mSmiley2x;
+  IBitmap mScaled;
+  bool mFontLoaded = false;
+  int mNumLayouts = 0;
+};
+
+/** @return The number of pixels that differ by more than kTolerance in any channel */
+static int CountDifferentPixels(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+  if (a.size() != b.size())
+    return static_cast<int>(std::max(a.size(), b.size()) / 4);
+
+  int nDiffering = 0;
+
+  for (size_t i = 0; i < a.size(); i += 4)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      if (std::abs(a[i + c] - b[i + c]) > kTolerance)
+      {
+        nDiffering++;
+        break;
+      }
+    }
+  }
+
+  return nDiffering;
+}
+
+/** @return true if the pixels in the rectangle (top row first) are not all the same */
+static bool HasDetail(const std::vector<uint8_t>& data, const IRECT& r)
+{
+  const int x0 = static_cast<int>(r.L), x1 = static_cast<int>(r.R);
+  const int y0 = static_cast<int>(r.T), y1 = static_cast<int>(r.B);
+  const uint8_t* pFirst = nullptr;
+
+  for (int y = y0; y < y1; y++)
+  {
+    for (int x = x0; x < x1; x++)
+    {
+      const uint8_t* pPixel = &data[((kHeight - 1 - y) * kWidth + x) * 4]; // glReadPixels() reads the bottom row first
+
+      if (!pFirst)
+        pFirst = pPixel;
+      else if (memcmp(pFirst, pPixel, 4))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+int main()
+{
+  TestDelegate delegate;
+
+  if (!delegate.OpenWindow(nullptr))
+  {
+    printf("FAILED: could not open the window (is there an EGL implementation with EGL_MESA_platform_surfaceless?)\n");
+    return 1;
+  }
+
+  Check(delegate.mSmiley.IsValid() && delegate.mSmiley2x.IsValid() && delegate.mScaled.IsValid(), "the bitmaps are loaded");
+  Check(delegate.mFontLoaded, "the font is loaded");
+
+  const APIBitmap* pSmiley = delegate.mSmiley.GetAPIBitmap();
+
+  std::vector<uint8_t> first, frame;
+  delegate.GetEGLUI()->RenderFrame(first);
+
+  Check(HasDetail(first, IRECT(10, 10, 42, 42)), "the bitmap loaded from memory is drawn");
+  Check(HasDetail(first, IRECT(50, 10, 82, 42)), "the bitmap loaded from memory at another scale is drawn");
+  Check(HasDetail(first, IRECT(90, 10, 122, 42)), "the bitmap from ScaleBitmap() is drawn");
+  Check(HasDetail(first, IRECT(0, 50, kWidth, kHeight)), "the text is drawn");
+
+  for (int i = 0; i < kNumReopens; i++)
+  {
+    delegate.CloseWindow();
+    Check(delegate.GetUI() != nullptr, "the persistent graphics context is kept when the window closes");
+
+    if (!delegate.OpenWindow(nullptr))
+    {
+      Check(false, "the window opens again");
+      break;
+    }
+
+    delegate.GetEGLUI()->RenderFrame(frame);
+
+    const int nDiffering = CountDifferentPixels(first, frame);
+
+    if (nDiffering)
+      printf("reopen %i: %i pixels differ from the first frame\n", i + 1, nDiffering);
+
+    Check(nDiffering == 0, "a reopened window draws the same as the first time");
+  }
+
+  Check(delegate.mNumLayouts == 1, "the UI is only laid out once");
+  Check(delegate.mSmiley.GetAPIBitmap() == pSmiley, "the bitmaps are kept");
+
+  // Free everything with the context alive, as a plug-in does when it is destroyed with its editor open
+  delegate.SetPersistentGraphics(false);
+  delegate.CloseWindow();
+  Check(delegate.GetUI() == nullptr, "the graphics context is freed when it is no longer persistent");
+
+  if (sNumFailed)
+    printf("%d checks FAILED\n", sNumFailed);
+  else
+    printf("all checks passed\n");
+
+  return sNumFailed ? 1 : 0;
+}
+
+// As a platform class does, this file builds the drawing backend
+#include "IGraphicsNanoVG.cpp"
@@ -0,0 +1,205 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Test for SharedImpulseStore: instances asking for the same key share one entry, which is built once, and freed when the last instance releases it.
+ * Also checks that an engine sharing an entry's partitions matches one that owns its impulse, and that an engine can move to another entry,
+ * or be cleared when an acquire fails, before the entry it pointed to is released (run with SANITIZE=1 to check for use after free).
+ *
+ * Usage: SharedImpulseStoreTest
+ *
+ * Returns 0 if the checks pass, 1 otherwise
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "SharedImpulseStore.h"
+
+using namespace iplug;
+
+static constexpr int kIRLength = 2048;
+static constexpr int kBlockSize = 256;
+static constexpr int kNumBlocks = 32;
+
+static int sNumFailed = 0;
+
+static void Check(bool condition, const char* description)
+{
+  if (!condition)
+  {
+    printf("FAILED: %s\n", description);
+    sNumFailed++;
+  }
+}
+
+/** A decaying noise burst, seeded so that different seeds give different IRs */
+static std::vector<WDL_FFT_REAL> MakeIR(unsigned int seed)
+{
+  std::vector<WDL_FFT_REAL> ir(kIRLength);
+
+  for (int i = 0; i < kIRLength; i++)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    ir[i] = (static_cast<double>(seed >> 8) / 8388608. - 1.) * std::exp(-6. * i / kIRLength);
+  }
+
+  return ir;
+}
+
+/** Fill function for Acquire(), counting how often the store builds an entry */
+static SharedImpulseStore::FillFunc MakeFill(const std::vector<WDL_FFT_REAL>& ir, int& nFills)
+{
+  return [&ir, &nFills](WDL_ImpulseBuffer& impulse) {
+    nFills++;
+    impulse.SetNumChannels(1);
+
+    if (impulse.SetLength(static_cast<int>(ir.size())))
+      std::copy(ir.begin(), ir.end(), impulse.impulses[0].Get());
+  };
+}
+
+/** Run an impulse then silence through an engine
+ * @return The output */
+static std::vector<WDL_FFT_REAL> Process(WDL_ConvolutionEngine& engine)
+{
+  std::vector<WDL_FFT_REAL> output;
+  std::vector<WDL_FFT_REAL> input(kBlockSize);
+
+  engine.Reset();
+
+  for (int b = 0; b < kNumBlocks; b++)
+  {
+    std::fill(input.begin(), input.end(), 0.);
+
+    if (b == 0)
+      input[0] = 1.;
+
+    WDL_FFT_REAL* pInput = input.data();
+    engine.Add(&pInput, kBlockSize, 1);
+
+    const int nAvailable = std::min(engine.Avail(kBlockSize), kBlockSize);
+
+    if (nAvailable > 0)
+    {
+      output.insert(output.end(), engine.Get()[0], engine.Get()[0] + nAvailable);
+      engine.Advance(nAvailable);
+    }
+  }
+
+  return output;
+}
+
+static double MaxDifference(const std::vector<WDL_FFT_REAL>& a, const std::vector<WDL_FFT_REAL>& b)
+{
+  if (a.size() != b.size())
+    return 1e9;
+
+  double maxDiff = 0.;
+
+  for (size_t i = 0; i < a.size(); i++)
+    maxDiff = std::max(maxDiff, std::fabs(a[i] - b[i]));
+
+  return maxDiff;
+}
+
+int main()
+{
+  SharedImpulseStore& store = SharedImpulseStore::Get();
+  const std::vector<WDL_FFT_REAL> irA = MakeIR(1);
+  const std::vector<WDL_FFT_REAL> irB = MakeIR(2);
+  const uint64_t hashA = SharedImpulseStore::Hash(irA.data(), irA.size() * sizeof(WDL_FFT_REAL));
+  const uint64_t hashB = SharedImpulseStore::Hash(irB.data(), irB.size() * sizeof(WDL_FFT_REAL));
+  int nFillsA = 0;
+  int nFillsB = 0;
+
+  // Reference counting
+  {
+    SharedImpulseStore::EntryPtr pFirst = store.Acquire(hashA, 48000., -1, MakeFill(irA, nFillsA));
+    SharedImpulseStore::EntryPtr pSecond = store.Acquire(hashA, 48000., -1, MakeFill(irA, nFillsA));
+
+    Check(pFirst && pFirst == pSecond, "instances acquiring the same key share one entry");
+    Check(nFillsA == 1, "an entry is built once");
+    Check(store.NumEntries() == 1, "one entry is held");
+
+    SharedImpulseStore::EntryPtr pOtherRate = store.Acquire(hashA, 44100., -1, MakeFill(irA, nFillsA));
+    Check(pOtherRate && pOtherRate != pFirst && nFillsA == 2, "another sample rate is another entry");
+    Check(store.NumEntries() == 2, "two entries are held");
+
+    pFirst = nullptr;
+    Check(store.NumEntries() == 2, "an entry is kept while an instance still holds it");
+
+    pSecond = nullptr;
+    Check(store.NumEntries() == 1, "an entry is freed when the last instance releases it");
+  }
+
+  Check(store.NumEntries() == 0, "all entries are freed");
+
+  {
+    SharedImpulseStore::EntryPtr pAgain = store.Acquire(hashA, 48000., -1, MakeFill(irA, nFillsA));
+    Check(pAgain && nFillsA == 3, "a released entry is built again");
+  }
+
+  {
+    int nEmptyFills = 0;
+    const std::vector<WDL_FFT_REAL> emptyIR;
+    Check(!store.Acquire(hashB, 48000., -1, MakeFill(emptyIR, nEmptyFills)), "an empty impulse is not stored");
+    Check(store.NumEntries() == 0, "a failed acquire doesn't hold an entry");
+  }
+
+  // Sharing, then moving an engine to another entry, or clearing it, before the entry it used is released, as IPlugConvoEngine::OnReset() does
+  {
+    WDL_ImpulseBuffer impulseA;
+    MakeFill(irA, nFillsA)(impulseA);
+    WDL_ConvolutionEngine ownedA;
+    ownedA.SetImpulse(&impulseA);
+    const std::vector<WDL_FFT_REAL> expectedA = Process(ownedA);
+
+    WDL_ImpulseBuffer impulseB;
+    MakeFill(irB, nFillsB)(impulseB);
+    WDL_ConvolutionEngine ownedB;
+    ownedB.SetImpulse(&impulseB);
+    const std::vector<WDL_FFT_REAL> expectedB = Process(ownedB);
+
+    WDL_ConvolutionEngine engine;
+    SharedImpulseStore::EntryPtr pHeld = store.Acquire(hashA, 48000., -1, MakeFill(irA, nFillsA));
+    engine.SetImpulseShared(pHeld->GetEngine());
+    const double diffA = MaxDifference(Process(engine), expectedA);
+    printf("shared vs owned impulse: max difference %g\n", diffA);
+    Check(diffA < 1e-9, "an engine sharing an entry matches one that owns the impulse");
+
+    SharedImpulseStore::EntryPtr pNext = store.Acquire(hashB, 48000., -1, MakeFill(irB, nFillsB));
+    engine.SetImpulseShared(pNext->GetEngine());
+    pHeld = std::move(pNext);
+    Check(store.NumEntries() == 1, "the previous entry is freed once the engine has moved on");
+    Check(MaxDifference(Process(engine), expectedB) < 1e-9, "an engine that moved to another entry uses its impulse");
+
+    int nEmptyFills = 0;
+    const std::vector<WDL_FFT_REAL> emptyIR;
+    SharedImpulseStore::EntryPtr pFailed = store.Acquire(hashA, 96000., -1, MakeFill(emptyIR, nEmptyFills));
+    Check(!pFailed, "an empty impulse is not stored");
+
+    WDL_ImpulseBuffer empty;
+    engine.SetImpulse(&empty);
+    pHeld = pFailed;
+    Check(store.NumEntries() == 0, "the entry is freed once the engine has been cleared");
+    Check(!engine.IsImpulseShared(), "a cleared engine doesn't point to the released entry");
+    Process(engine);
+  }
+
+  if (sNumFailed)
+    printf("%d checks FAILED\n", sNumFailed);
+  else
+    printf("all checks passed\n");
+
+  return sNumFailed ? 1 : 0;
+}
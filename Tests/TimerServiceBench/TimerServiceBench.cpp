@@ -0,0 +1,334 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * Benchmark for the shared Linux timer service, with the timers of a session with many plug-in instances:
+ * an idle timer per instance (IDLE_TIMER_RATE) and an OSC timer (100 ms) for some of them.
+ * The main thread acts as the host's, either watching the dispatch file descriptor as a run loop does, or polling the service at the heartbeat
+ * as a host timer does. Checks that the timers don't run before there is a dispatcher, that each timer runs at its interval on the main thread,
+ * also while the heartbeat keeps changing, that timers can create, stop and delete timers while a batch is running, and that stopping a timer
+ * from another thread waits for its function to return, then reports the wakeups and the timer jitter statistics.
+ *
+ * Usage: TimerServiceBench [options]
+ *   --instances N       Number of plug-in instances (default 256)
+ *   --seconds N         How long to run (default 2)
+ *   --poll              Poll the service at the heartbeat, rather than watching its file descriptor
+ *
+ * Returns 0 if the checks pass, 1 otherwise
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+
+#include "IPlugTimer.h"
+
+using namespace iplug;
+
+static constexpr uint32_t kOSCTimerMs = 100;
+static constexpr int kInstancesPerOSC = 16;
+
+struct Options
+{
+  int instances = 256;
+  int seconds = 2;
+  bool poll = false;
+};
+
+static bool ParseArgs(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (!strcmp(arg, "--instances") && hasValue) options.instances = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--seconds") && hasValue) options.seconds = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(arg, "--poll")) options.poll = true;
+    else
+    {
+      fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** A timer that counts its calls, and the calls that were not on the dispatching thread */
+struct CountedTimer
+{
+  CountedTimer(uint32_t intervalMs, std::thread::id dispatchThread)
+  : mIntervalMs(intervalMs)
+  , mDispatchThread(dispatchThread)
+  {
+    mTimer.reset(Timer::Create([this](Timer&) {
+      mCount++;
+
+      if (std::this_thread::get_id() != mDispatchThread)
+        mWrongThread++;
+    }, intervalMs));
+  }
+
+  uint32_t mIntervalMs;
+  std::thread::id mDispatchThread;
+  std::atomic<int> mCount {0};
+  std::atomic<int> mWrongThread {0};
+  std::unique_ptr<Timer> mTimer;
+};
+
+/** Run the timers on the calling thread until the deadline, as a host's main thread would
+ * @param dispatchFD The file descriptor from TimerService::AttachToRunLoop(), or -1 to poll the service at the heartbeat */
+static void Run(int dispatchFD, std::chrono::steady_clock::time_point deadline)
+{
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    if (dispatchFD < 0)
+    {
+      const uint32_t heartbeatMs = TimerService::Get().GetHeartbeatMs();
+      std::this_thread::sleep_for(std::chrono::milliseconds(heartbeatMs ? heartbeatMs : TIMER_MIN_HEARTBEAT_MS));
+      TimerService::Get().Poll();
+      continue;
+    }
+
+    pollfd pfd = { dispatchFD, POLLIN, 0 };
+
+    if (poll(&pfd, 1, 10) > 0 && (pfd.revents & POLLIN))
+      TimerService::Get().Dispatch();
+  }
+}
+
+/** @return The number of failed checks of a timer running before there is a dispatcher, which would call it on a thread that isn't the main thread */
+static int CheckNoDispatcher()
+{
+  std::atomic<int> count {0};
+  std::unique_ptr<Timer> pTimer(Timer::Create([&](Timer&) { count++; }, IDLE_TIMER_RATE));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_TIMER_RATE * 5));
+  pTimer = nullptr;
+
+  if (count)
+  {
+    printf("FAILED: a timer ran %d times before there was a dispatcher\n", count.load());
+    return 1;
+  }
+
+  return 0;
+}
+
+/** @return The number of failed checks of timers stopping themselves and each other while a batch is running */
+static int CheckStopInBatch(int dispatchFD)
+{
+  int nFailed = 0;
+  std::atomic<int> selfCount {0};
+  std::atomic<int> victimCount {0};
+  std::unique_ptr<Timer> pVictim;
+  std::unique_ptr<Timer> pSelf;
+
+  // Both are due on the same ticks. Whichever runs first on the third tick stops itself and deletes the other
+  pVictim.reset(Timer::Create([&](Timer&) { victimCount++; }, IDLE_TIMER_RATE));
+  pSelf.reset(Timer::Create([&](Timer& t) {
+    if (++selfCount == 3)
+    {
+      t.Stop();
+      pVictim = nullptr;
+    }
+  }, IDLE_TIMER_RATE));
+
+  Run(dispatchFD, std::chrono::steady_clock::now() + std::chrono::milliseconds(IDLE_TIMER_RATE * 10));
+
+  pSelf->Stop();
+
+  if (selfCount != 3)
+  {
+    printf("FAILED: a timer that stopped itself ran %d times instead of 3\n", selfCount.load());
+    nFailed++;
+  }
+
+  if (pVictim || victimCount > 3)
+  {
+    printf("FAILED: a timer that was deleted by another one ran %d times\n", victimCount.load());
+    nFailed++;
+  }
+
+  return nFailed;
+}
+
+/** @return The number of failed checks of a timer creating and deleting another one in its function, which is called without the service locked,
+ * and of stopping a timer from another thread while its function runs on the dispatching thread */
+static int CheckStopWhileRunning(int dispatchFD)
+{
+  int nFailed = 0;
+  std::atomic<bool> inFunc {false};
+  std::atomic<bool> started {false};
+  std::atomic<bool> stopped {false};
+
+  std::unique_ptr<Timer> pSlow(Timer::Create([&](Timer&) {
+    std::unique_ptr<Timer> pNested(Timer::Create([](Timer&) {}, IDLE_TIMER_RATE));
+    pNested = nullptr;
+
+    inFunc = true;
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_TIMER_RATE * 2));
+    inFunc = false;
+  }, IDLE_TIMER_RATE));
+
+  // The "main thread" dispatches, while this thread stops the timer
+  std::thread mainThread([&]() {
+    while (!stopped)
+      Run(dispatchFD, std::chrono::steady_clock::now() + std::chrono::milliseconds(IDLE_TIMER_RATE));
+  });
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+  while (!started && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::yield();
+
+  pSlow->Stop();
+  const bool returnedAfterFunc = !inFunc;
+  pSlow = nullptr;
+  stopped = true;
+  mainThread.join();
+
+  if (!started)
+  {
+    printf("FAILED: a timer that creates and deletes another one in its function did not run\n");
+    nFailed++;
+  }
+  else if (!returnedAfterFunc)
+  {
+    printf("FAILED: stopping a timer from another thread returned while its function was running\n");
+    nFailed++;
+  }
+
+  return nFailed;
+}
+
+/** @return The number of failed checks of a timer keeping its interval while other timers keep changing the heartbeat */
+static int CheckHeartbeatChanges(int dispatchFD)
+{
+  static constexpr int kDurationMs = 500;
+  std::atomic<int> count {0};
+  std::unique_ptr<Timer> pFast;
+
+  std::unique_ptr<Timer> pTimer(Timer::Create([&](Timer&) { count++; }, IDLE_TIMER_RATE));
+
+  // Every 10 ms, adding or removing a 5 ms timer changes the heartbeat between 5 and 10 ms
+  std::unique_ptr<Timer> pToggle(Timer::Create([&](Timer&) {
+    pFast.reset(pFast ? nullptr : Timer::Create([](Timer&) {}, 5));
+  }, 10));
+
+  Run(dispatchFD, std::chrono::steady_clock::now() + std::chrono::milliseconds(kDurationMs));
+  pToggle = nullptr;
+  pFast = nullptr;
+  pTimer = nullptr;
+
+  const int expected = kDurationMs / IDLE_TIMER_RATE;
+
+  if (count < expected * 8 / 10 || count > expected + 2)
+  {
+    printf("FAILED: a %d ms timer ran %d times in %d ms while the heartbeat kept changing, instead of %d\n", IDLE_TIMER_RATE, count.load(), kDurationMs, expected);
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+
+  if (!ParseArgs(argc, argv, options))
+    return 1;
+
+  int nFailed = CheckNoDispatcher();
+  const int dispatchFD = options.poll ? -1 : TimerService::Get().AttachToRunLoop();
+  const std::thread::id dispatchThread = std::this_thread::get_id();
+
+  nFailed += CheckStopInBatch(dispatchFD);
+  nFailed += CheckStopWhileRunning(dispatchFD);
+  nFailed += CheckHeartbeatChanges(dispatchFD);
+
+  std::vector<std::unique_ptr<CountedTimer>> timers;
+
+  for (int i = 0; i < options.instances; i++)
+  {
+    timers.push_back(std::make_unique<CountedTimer>(IDLE_TIMER_RATE, dispatchThread));
+
+    if (i % kInstancesPerOSC == 0)
+      timers.push_back(std::make_unique<CountedTimer>(kOSCTimerMs, dispatchThread));
+  }
+
+  TimerService::Get().ResetStats();
+  const auto start = std::chrono::steady_clock::now();
+  Run(dispatchFD, start + std::chrono::seconds(options.seconds));
+  const TimerStats stats = TimerService::Get().GetStats();
+
+  for (auto& pTimer : timers)
+    pTimer->mTimer->Stop();
+
+  const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  int64_t nCalls = 0;
+  int nWrongRate = 0;
+  int nWrongThread = 0;
+
+  for (auto& pTimer : timers)
+  {
+    const double expected = elapsedMs / pTimer->mIntervalMs;
+    const int count = pTimer->mCount;
+    nCalls += count;
+
+    if (count < expected * 0.8 || count > expected + 2)
+      nWrongRate++;
+
+    nWrongThread += pTimer->mWrongThread;
+  }
+
+  if (nWrongRate)
+  {
+    printf("FAILED: %d of %d timers did not run at their interval\n", nWrongRate, static_cast<int>(timers.size()));
+    nFailed++;
+  }
+
+  if (nWrongThread)
+  {
+    printf("FAILED: %d timer calls were not on the main thread\n", nWrongThread);
+    nFailed++;
+  }
+
+  const double seconds = elapsedMs / 1000.;
+
+  printf("%d timers (%d instances) for %.2f s, dispatched on the %s\n", stats.mNumTimers, options.instances, seconds, options.poll ? "main thread, polling" : "main thread's run loop");
+  printf("%-28s %10u ms\n", "heartbeat", stats.mHeartbeatMs);
+  printf("%-28s %10.1f /s\n", "timer calls", nCalls / seconds);
+  printf("%-28s %10.1f /s\n", "batches", stats.mBatches / seconds);
+
+  // The service thread only ticks for a run loop
+  if (!options.poll)
+  {
+    printf("%-28s %10.1f /s\n", "service wakeups", stats.mTicks / seconds);
+    printf("%-28s %10llu\n", "missed ticks", static_cast<unsigned long long>(stats.mMissedTicks));
+    printf("%-28s %10.3f ms (max %.3f)\n", "tick jitter", stats.mMeanJitterMs, stats.mMaxJitterMs);
+    printf("%-28s %10.3f ms (max %.3f)\n", "run loop latency", stats.mMeanLatencyMs, stats.mMaxLatencyMs);
+  }
+
+  if (nFailed)
+    printf("%d checks FAILED\n", nFailed);
+
+  return nFailed ? 1 : 0;
+}
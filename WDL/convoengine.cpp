@@ -167,6 +167,7 @@ int WDL_ConvolutionEngine::SetImpulse(WDL_ImpulseBuffer *impulse, int fft_size,
     m_impdata.Delete(m_impdata.GetSize()-1,true);
   while (m_impdata.GetSize() < nch)
     m_impdata.Add(new ImpChannelInfo);
+  for (x = 0; x < m_impdata.GetSize(); x ++) m_impdata.Get(x)->Unshare();
 
   if (forceBrute)
   {
@@ -278,6 +279,47 @@ int WDL_ConvolutionEngine::SetImpulse(WDL_ImpulseBuffer *impulse, int fft_size,
 }
 
 
+int WDL_ConvolutionEngine::SetImpulseShared(const WDL_ConvolutionEngine *src)
+{
+  if (WDL_NOT_NORMALLY(!src || src == this || src->IsImpulseShared())) return 0;
+
+  m_impulse_len=src->m_impulse_len;
+  m_fft_size=src->m_fft_size;
+  m_proc_nch=-1;
+
+  const int nch = src->m_impdata.GetSize();
+  while (m_impdata.GetSize() > nch)
+    m_impdata.Delete(m_impdata.GetSize()-1,true);
+  while (m_impdata.GetSize() < nch)
+    m_impdata.Add(new ImpChannelInfo);
+
+  for (int x = 0; x < nch; x ++)
+  {
+    const ImpChannelInfo *s = src->m_impdata.Get(x);
+    ImpChannelInfo *d = m_impdata.Get(x);
+    d->imp.Resize(0,false);
+    d->zflag.Resize(0,false);
+    d->shared_imp = s->imp.Get();
+    d->shared_imp_len = s->imp.GetSize();
+    d->shared_zflag = s->zflag.Get();
+    d->shared_zflag_len = s->zflag.GetSize();
+  }
+
+  if (!m_fft_size)
+  {
+    for (int x = 0; x < m_proc.GetSize(); x ++)
+    {
+      ProcChannelInfo *inf = m_proc.Get(x);
+      inf->samplesin.Clear();
+      inf->samplesin2.Clear();
+      inf->samplesout.Clear();
+    }
+    return 0;
+  }
+  return m_fft_size/2;
+}
+
+
 void WDL_ConvolutionEngine::Reset() // clears out any latent samples
 {
   for (int x = 0; x < m_proc.GetSize(); x ++)
@@ -305,8 +347,8 @@ void WDL_ConvolutionEngine::Add(WDL_FFT_REAL **bufs, int len, int nch)
     for (int ch = 0; ch < nch; ch ++)
     {
       int wch = ch % m_impdata.GetSize();
-      WDL_CONVO_IMPULSEBUFf *imp=m_impdata.Get(wch)->imp.Get();
-      int imp_len = m_impdata.Get(wch)->imp.GetSize();
+      const WDL_CONVO_IMPULSEBUFf *imp=m_impdata.Get(wch)->GetImp();
+      int imp_len = m_impdata.Get(wch)->GetImpSize();
       ProcChannelInfo *pinf = m_proc.Get(ch);
 
       if (imp_len>0) 
@@ -334,7 +376,7 @@ void WDL_ConvolutionEngine::Add(WDL_FFT_REAL **bufs, int len, int nch)
           int i=imp_len;
           double sum=0.0,sum2=0.0;
           WDL_FFT_REAL *sp=psrc+x-imp_len + 1;
-          WDL_CONVO_IMPULSEBUFf *ip=imp;
+          const WDL_CONVO_IMPULSEBUFf *ip=imp;
           int j=i/4; i&=3;
           while (j--) // produce 2 samples, 4 impulse samples at a time
           {
@@ -361,7 +403,7 @@ void WDL_ConvolutionEngine::Add(WDL_FFT_REAL **bufs, int len, int nch)
           int i=imp_len;
           double sum=0.0;
           WDL_FFT_REAL *sp=psrc+x-imp_len + 1;
-          WDL_CONVO_IMPULSEBUFf *ip=imp;
+          const WDL_CONVO_IMPULSEBUFf *ip=imp;
           int j=i/4; i&=3;
           while (j--)
           {
@@ -597,9 +639,15 @@ int WDL_ConvolutionEngine::Avail(int want)
       }
 
       int applycnt=0;
-      char *useImpSilentList=m_impdata.Get(srcc)->zflag.GetSize() == nblocks ? m_impdata.Get(srcc)->zflag.Get() : NULL;
+      const char *useImpSilentList=m_impdata.Get(srcc)->GetZFlagSize() == nblocks ? m_impdata.Get(srcc)->GetZFlag() : NULL;
+
+#ifdef WDL_CONVO_IMPULSEBUF_IS_FFT_COMPLEX
+      // gather the non-silent partitions from the frequency-domain delay line, then multiply-accumulate them in one pass
+      WDL_FFT_COMPLEX **histptrs = m_mac_ptrs.ResizeOK(nblocks*2,false);
+      WDL_FFT_COMPLEX **impptrs = histptrs ? histptrs + nblocks : NULL;
+#endif
 
-      WDL_CONVO_IMPULSEBUFf *impulseptr=m_impdata.Get(srcc)->imp.Get();
+      const WDL_CONVO_IMPULSEBUFf *impulseptr=m_impdata.Get(srcc)->GetImp();
       for (int i = 0; i < nblocks; i ++, impulseptr+=m_fft_size*2)
       {
         int srchistpos = histpos-i;
@@ -610,12 +658,24 @@ int WDL_ConvolutionEngine::Avail(int want)
 
         WDL_FFT_REAL *samplehist=pinf->samplehist.Get() + m_fft_size*srchistpos*2;
 
+#ifdef WDL_CONVO_IMPULSEBUF_IS_FFT_COMPLEX
+        if (WDL_NORMALLY(histptrs))
+        {
+          histptrs[applycnt] = (WDL_FFT_COMPLEX*)samplehist;
+          impptrs[applycnt++] = (WDL_FFT_COMPLEX*)impulseptr;
+          continue;
+        }
+#endif
         if (applycnt++) // add to output
           WDL_CONVO_CplxMul3((WDL_FFT_COMPLEX*)workbuf2,(WDL_FFT_COMPLEX*)samplehist,(WDL_CONVO_IMPULSEBUFCPLXf*)impulseptr,m_fft_size);   
         else // replace output
           WDL_CONVO_CplxMul2((WDL_FFT_COMPLEX*)workbuf2,(WDL_FFT_COMPLEX*)samplehist,(WDL_CONVO_IMPULSEBUFCPLXf*)impulseptr,m_fft_size);  
 
       }
+#ifdef WDL_CONVO_IMPULSEBUF_IS_FFT_COMPLEX
+      if (applycnt && histptrs)
+        WDL_fft_complexmul_acc((WDL_FFT_COMPLEX*)workbuf2,histptrs,impptrs,applycnt,m_fft_size,0);
+#endif
       if (!applycnt)
         memset(workbuf2,0,m_fft_size*2*sizeof(WDL_FFT_REAL));
       else
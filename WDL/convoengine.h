@@ -40,6 +40,7 @@
 
 typedef WDL_FFT_REAL WDL_CONVO_IMPULSEBUFf;
 typedef WDL_FFT_COMPLEX WDL_CONVO_IMPULSEBUFCPLXf;
+#define WDL_CONVO_IMPULSEBUF_IS_FFT_COMPLEX
 
 #else
 typedef float WDL_CONVO_IMPULSEBUFf;
@@ -48,6 +49,9 @@ typedef struct
   WDL_CONVO_IMPULSEBUFf re, im;
 }
 WDL_CONVO_IMPULSEBUFCPLXf;
+#if WDL_FFT_REALSIZE == 4
+#define WDL_CONVO_IMPULSEBUF_IS_FFT_COMPLEX // impulse partitions can be passed straight to WDL_fft_complexmul_acc()
+#endif
 #endif
 
 class WDL_ImpulseBuffer
@@ -89,6 +93,11 @@ public:
   ~WDL_ConvolutionEngine();
 
   int SetImpulse(WDL_ImpulseBuffer *impulse, int fft_size=-1, int impulse_sample_offset=0, int max_imp_size=0, bool forceBrute=false);
+
+  // uses the (FFT'd) impulse partitions of src read-only rather than keeping a copy. src must outlive this engine,
+  // and must not have SetImpulse() called on it while shared. returns the same value as src's SetImpulse() did
+  int SetImpulseShared(const WDL_ConvolutionEngine *src);
+  bool IsImpulseShared() const { return m_impdata.GetSize() && m_impdata.Get(0)->shared_imp != NULL; }
  
   int GetFFTSize() { return m_fft_size; }
   int GetLatency() { return m_fft_size/2; }
@@ -104,8 +113,21 @@ public:
 private:
 
   struct ImpChannelInfo {
+    ImpChannelInfo() : shared_imp(NULL), shared_zflag(NULL), shared_imp_len(0), shared_zflag_len(0) { }
+
     WDL_TypedBuf<WDL_CONVO_IMPULSEBUFf> imp;
     WDL_TypedBuf<char> zflag;
+
+    // set by SetImpulseShared(), points into another engine's imp/zflag
+    const WDL_CONVO_IMPULSEBUFf *shared_imp;
+    const char *shared_zflag;
+    int shared_imp_len, shared_zflag_len;
+
+    const WDL_CONVO_IMPULSEBUFf *GetImp() const { return shared_imp ? shared_imp : imp.Get(); }
+    int GetImpSize() const { return shared_imp ? shared_imp_len : imp.GetSize(); }
+    const char *GetZFlag() const { return shared_imp ? shared_zflag : zflag.Get(); }
+    int GetZFlagSize() const { return shared_imp ? shared_zflag_len : zflag.GetSize(); }
+    void Unshare() { shared_imp=NULL; shared_zflag=NULL; shared_imp_len=shared_zflag_len=0; }
   };
 
   struct ProcChannelInfo {
@@ -132,6 +154,7 @@ private:
 
   WDL_TypedBuf<WDL_FFT_REAL> m_combinebuf;
   WDL_TypedBuf<WDL_FFT_REAL *> m_get_tmpptrs;
+  WDL_TypedBuf<WDL_FFT_COMPLEX *> m_mac_ptrs; // active (history, impulse) partition pairs for the current block
 
 public:
 
@@ -34,6 +34,16 @@
 #include <math.h>
 #include "fft.h"
 
+#if !defined(WDL_FFT_NO_SSE) && !defined(WDL_FFT_USE_SSE)
+  #if defined(__SSE2__) || _M_IX86_FP >= 2 || (defined(_M_X64) && (_MSC_VER > 1400 || __INTEL_COMPILER > 0))
+    #define WDL_FFT_USE_SSE
+  #endif
+#endif
+
+#ifdef WDL_FFT_USE_SSE
+  #include <emmintrin.h>
+#endif
+
 
 #define FFT_MAXBITLEN 15
 
@@ -576,6 +586,102 @@ static void c32768(register WDL_FFT_COMPLEX *a)
 }
 
 
+#ifdef WDL_FFT_USE_SSE
+
+/* complex products of interleaved {re,im} pairs, two (float) or one (double) per register */
+#if WDL_FFT_REALSIZE == 4
+
+#define WDL_FFT_CPLX_PER_VEC 2
+#define WDL_FFT_VEC __m128
+#define WDL_FFT_VEC_LOAD(p) _mm_loadu_ps((const float *)(p))
+#define WDL_FFT_VEC_STORE(p,v) _mm_storeu_ps((float *)(p),(v))
+#define WDL_FFT_VEC_ADD(a,b) _mm_add_ps((a),(b))
+#define WDL_FFT_VEC_ZERO() _mm_setzero_ps()
+
+static inline __m128 WDL_fft_cplxmul_vec(__m128 a, __m128 b)
+{
+  const __m128 neg_re = _mm_castsi128_ps(_mm_set_epi32(0,(int)0x80000000,0,(int)0x80000000));
+  const __m128 bre = _mm_shuffle_ps(b,b,_MM_SHUFFLE(2,2,0,0));
+  const __m128 bim = _mm_shuffle_ps(b,b,_MM_SHUFFLE(3,3,1,1));
+  const __m128 aswap = _mm_shuffle_ps(a,a,_MM_SHUFFLE(2,3,0,1));
+  return _mm_add_ps(_mm_mul_ps(a,bre),_mm_xor_ps(_mm_mul_ps(aswap,bim),neg_re));
+}
+
+#else
+
+#define WDL_FFT_CPLX_PER_VEC 1
+#define WDL_FFT_VEC __m128d
+#define WDL_FFT_VEC_LOAD(p) _mm_loadu_pd((const double *)(p))
+#define WDL_FFT_VEC_STORE(p,v) _mm_storeu_pd((double *)(p),(v))
+#define WDL_FFT_VEC_ADD(a,b) _mm_add_pd((a),(b))
+#define WDL_FFT_VEC_ZERO() _mm_setzero_pd()
+
+static inline __m128d WDL_fft_cplxmul_vec(__m128d a, __m128d b)
+{
+  const __m128d neg_re = _mm_set_pd(0.0,-0.0);
+  const __m128d bre = _mm_unpacklo_pd(b,b);
+  const __m128d bim = _mm_unpackhi_pd(b,b);
+  const __m128d aswap = _mm_shuffle_pd(a,a,1);
+  return _mm_add_pd(_mm_mul_pd(a,bre),_mm_xor_pd(_mm_mul_pd(aswap,bim),neg_re));
+}
+
+#endif
+
+/* n even, n > 0 */
+void WDL_fft_complexmul(WDL_FFT_COMPLEX *a,WDL_FFT_COMPLEX *b,int n)
+{
+  if (n<2 || (n&1)) return;
+  do {
+    WDL_FFT_VEC_STORE(a,WDL_fft_cplxmul_vec(WDL_FFT_VEC_LOAD(a),WDL_FFT_VEC_LOAD(b)));
+    a += WDL_FFT_CPLX_PER_VEC;
+    b += WDL_FFT_CPLX_PER_VEC;
+  } while (n -= WDL_FFT_CPLX_PER_VEC);
+}
+
+void WDL_fft_complexmul2(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX *a, WDL_FFT_COMPLEX *b, int n)
+{
+  if (n<2 || (n&1)) return;
+  do {
+    WDL_FFT_VEC_STORE(c,WDL_fft_cplxmul_vec(WDL_FFT_VEC_LOAD(a),WDL_FFT_VEC_LOAD(b)));
+    a += WDL_FFT_CPLX_PER_VEC;
+    b += WDL_FFT_CPLX_PER_VEC;
+    c += WDL_FFT_CPLX_PER_VEC;
+  } while (n -= WDL_FFT_CPLX_PER_VEC);
+}
+
+void WDL_fft_complexmul3(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX *a, WDL_FFT_COMPLEX *b, int n)
+{
+  if (n<2 || (n&1)) return;
+  do {
+    WDL_FFT_VEC_STORE(c,WDL_FFT_VEC_ADD(WDL_FFT_VEC_LOAD(c),WDL_fft_cplxmul_vec(WDL_FFT_VEC_LOAD(a),WDL_FFT_VEC_LOAD(b))));
+    a += WDL_FFT_CPLX_PER_VEC;
+    b += WDL_FFT_CPLX_PER_VEC;
+    c += WDL_FFT_CPLX_PER_VEC;
+  } while (n -= WDL_FFT_CPLX_PER_VEC);
+}
+
+/* bins outer, partitions inner: each output bin is summed in a register and stored once */
+void WDL_fft_complexmul_acc(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX **a, WDL_FFT_COMPLEX **b, int npart, int n, int add)
+{
+  int i, k;
+  if (n<2 || (n&1)) return;
+  if (npart<1)
+  {
+    if (!add) for (i = 0; i < n; i ++) c[i].re = c[i].im = 0;
+    return;
+  }
+
+  for (i = 0; i < n; i += WDL_FFT_CPLX_PER_VEC)
+  {
+    WDL_FFT_VEC acc = add ? WDL_FFT_VEC_LOAD(c+i) : WDL_FFT_VEC_ZERO();
+    for (k = 0; k < npart; k ++)
+      acc = WDL_FFT_VEC_ADD(acc,WDL_fft_cplxmul_vec(WDL_FFT_VEC_LOAD(a[k]+i),WDL_FFT_VEC_LOAD(b[k]+i)));
+    WDL_FFT_VEC_STORE(c+i,acc);
+  }
+}
+
+#else /* !WDL_FFT_USE_SSE */
+
 /* n even, n > 0 */
 void WDL_fft_complexmul(WDL_FFT_COMPLEX *a,WDL_FFT_COMPLEX *b,int n)
 {
@@ -659,6 +765,24 @@ void WDL_fft_complexmul3(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX *a, WDL_FFT_COMPLEX
   } while (n -= 2);
 }
 
+void WDL_fft_complexmul_acc(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX **a, WDL_FFT_COMPLEX **b, int npart, int n, int add)
+{
+  int k;
+  if (n<2 || (n&1)) return;
+  if (npart<1)
+  {
+    if (!add) for (k = 0; k < n; k ++) c[k].re = c[k].im = 0;
+    return;
+  }
+  for (k = 0; k < npart; k ++)
+  {
+    if (k || add) WDL_fft_complexmul3(c,a[k],b[k],n);
+    else WDL_fft_complexmul2(c,a[k],b[k],n);
+  }
+}
+
+#endif /* WDL_FFT_USE_SSE */
+
 
 static inline void u4(register WDL_FFT_COMPLEX *a)
 {
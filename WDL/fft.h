@@ -57,6 +57,11 @@ extern void WDL_fft_complexmul(WDL_FFT_COMPLEX *dest, WDL_FFT_COMPLEX *src, int
 extern void WDL_fft_complexmul2(WDL_FFT_COMPLEX *dest, WDL_FFT_COMPLEX *src, WDL_FFT_COMPLEX *src2, int len);
 extern void WDL_fft_complexmul3(WDL_FFT_COMPLEX *destAdd, WDL_FFT_COMPLEX *src, WDL_FFT_COMPLEX *src2, int len);
 
+/* dest[] (+)= sum over k of src[k][] * src2[k][], for npart partitions in a single pass over dest.
+   src/src2 are per-partition pointers, so callers can index a frequency-domain delay line directly.
+   if add is zero dest is overwritten, len must be even. */
+extern void WDL_fft_complexmul_acc(WDL_FFT_COMPLEX *dest, WDL_FFT_COMPLEX **src, WDL_FFT_COMPLEX **src2, int npart, int len, int add);
+
 /* Expects WDL_FFT_COMPLEX input[0..len-1] scaled by 1.0/len, returns
 WDL_FFT_COMPLEX output[0..len-1] order by WDL_fft_permute(len). */
 extern void WDL_fft(WDL_FFT_COMPLEX *, int len, int isInverse);